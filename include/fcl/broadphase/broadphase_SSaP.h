@@ -40,6 +40,8 @@
 
 #include <vector>
 #include "fcl/broadphase/broadphase_collision_manager.h"
+#include "fcl/broadphase/detail/parallel_self_collision.h"
+#include "fcl/common/detail/parallel.h"
 
 namespace fcl
 {
@@ -78,6 +80,18 @@ public:
   /// @brief perform collision test for the objects belonging to the manager (i.e., N^2 self collision)
   void collide(void* cdata, CollisionCallBack<S> callback) const;
 
+  /// @brief perform self collision test using cdata.size() threads, one
+  /// callback data per thread. The sweep along the chosen axis is cut into
+  /// independent ranges of objects that collect the candidate pairs in
+  /// parallel, and the callbacks then run as in detail::parallelSelfCollide():
+  /// thread t calls callback only with cdata[t], and sees its pairs in the
+  /// order of the serial sweep. The callback must be safe to call concurrently
+  /// with distinct cdata. Each cdata has its own stop criterion, so that the
+  /// merged results only match the serial collide() when no callback returns
+  /// true. All the candidate pairs are collected before the first callback
+  /// runs.
+  void collide(const std::vector<void*>& cdata, CollisionCallBack<S> callback) const;
+
   /// @brief perform distance test for the objects belonging to the manager (i.e., N^2 self distance)
   void distance(void* cdata, DistanceCallBack<S> callback) const;
 
@@ -93,6 +107,11 @@ public:
   /// @brief the number of objects managed by the manager
   size_t size() const;
 
+  /// @brief Number of threads used by setup() to sort the objects along the
+  /// three axes, the hardware concurrency if non-positive. The three axes are
+  /// sorted concurrently, each with a share of the threads.
+  int num_threads;
+
 protected:
   /// @brief check collision between one object and a list of objects, return value is whether stop is possible
   bool checkColl(typename std::vector<CollisionObject<S>*>::const_iterator pos_start, typename std::vector<CollisionObject<S>*>::const_iterator pos_end,
@@ -103,6 +122,11 @@ protected:
                 CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist) const;
 
   bool collide_(CollisionObject<S>* obj, void* cdata, CollisionCallBack<S> callback) const;
+
+  /// @brief sweep the objects from begin to end in the list sorted along axis
+  /// against the objects following them in that list, return value is whether
+  /// stop is possible
+  bool sweepColl(size_t axis, size_t begin, size_t end, void* cdata, CollisionCallBack<S> callback) const;
   
   bool distance_(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist) const;
 
@@ -234,7 +258,7 @@ void SSaPCollisionManager<S>::unregisterObject(CollisionObject<S>* obj)
 
 //==============================================================================
 template <typename S>
-SSaPCollisionManager<S>::SSaPCollisionManager() : setup_(false)
+SSaPCollisionManager<S>::SSaPCollisionManager() : num_threads(1), setup_(false)
 {
   // Do nothing
 }
@@ -255,9 +279,24 @@ void SSaPCollisionManager<S>::setup()
 {
   if(!setup_)
   {
-    std::sort(objs_x.begin(), objs_x.end(), SortByXLow<S>());
-    std::sort(objs_y.begin(), objs_y.end(), SortByYLow<S>());
-    std::sort(objs_z.begin(), objs_z.end(), SortByZLow<S>());
+    const int total_threads = detail::resolveNumThreads(num_threads);
+    const int axis_threads = std::max(1, total_threads / 3);
+
+    detail::parallelFor(3, total_threads, [&](std::size_t axis, int)
+    {
+      switch(axis)
+      {
+      case 0:
+        detail::parallelSort(objs_x.begin(), objs_x.end(), SortByXLow<S>(), axis_threads);
+        break;
+      case 1:
+        detail::parallelSort(objs_y.begin(), objs_y.end(), SortByYLow<S>(), axis_threads);
+        break;
+      case 2:
+        detail::parallelSort(objs_z.begin(), objs_z.end(), SortByZLow<S>(), axis_threads);
+        break;
+      }
+    });
     setup_ = true;
   }
 }
@@ -536,59 +575,72 @@ size_t SSaPCollisionManager<S>::selectOptimalAxis(
 
 //==============================================================================
 template <typename S>
-void SSaPCollisionManager<S>::collide(void* cdata, CollisionCallBack<S> callback) const
+bool SSaPCollisionManager<S>::sweepColl(size_t axis, size_t begin, size_t end, void* cdata, CollisionCallBack<S> callback) const
 {
-  if(size() == 0) return;
-
-  typename std::vector<CollisionObject<S>*>::const_iterator pos, run_pos, pos_end;
-  size_t axis = selectOptimalAxis(objs_x, objs_y, objs_z,
-                                  pos, pos_end);
+  const std::vector<CollisionObject<S>*>& objs
+      = (axis == 0) ? objs_x : ((axis == 1) ? objs_y : objs_z);
   size_t axis2 = (axis + 1 > 2) ? 0 : (axis + 1);
   size_t axis3 = (axis2 + 1 > 2) ? 0 : (axis2 + 1);
 
-  run_pos = pos;
-
-  while((run_pos < pos_end) && (pos < pos_end))
+  for(size_t i = begin; i < end; ++i)
   {
-    CollisionObject<S>* obj = *(pos++);
+    CollisionObject<S>* obj = objs[i];
 
-    while(1)
+    // the objects are sorted by their lower bound along axis, so only the
+    // ones following obj up to its upper bound can overlap it
+    for(size_t j = i + 1; j < objs.size(); ++j)
     {
-      if((*run_pos)->getAABB().min_[axis] < obj->getAABB().min_[axis])
-      {
-        run_pos++;
-        if(run_pos == pos_end) break;
-        continue;
-      }
-      else
-      {
-        run_pos++;
+      CollisionObject<S>* obj2 = objs[j];
+      if(obj2->getAABB().min_[axis] > obj->getAABB().max_[axis])
         break;
-      }
-    }
-
-    if(run_pos < pos_end)
-    {
-      typename std::vector<CollisionObject<S>*>::const_iterator run_pos2 = run_pos;
 
-      while((*run_pos2)->getAABB().min_[axis] <= obj->getAABB().max_[axis])
+      if((obj->getAABB().max_[axis2] >= obj2->getAABB().min_[axis2]) && (obj2->getAABB().max_[axis2] >= obj->getAABB().min_[axis2]))
       {
-        CollisionObject<S>* obj2 = *run_pos2;
-        run_pos2++;
-
-        if((obj->getAABB().max_[axis2] >= obj2->getAABB().min_[axis2]) && (obj2->getAABB().max_[axis2] >= obj->getAABB().min_[axis2]))
+        if((obj->getAABB().max_[axis3] >= obj2->getAABB().min_[axis3]) && (obj2->getAABB().max_[axis3] >= obj->getAABB().min_[axis3]))
         {
-          if((obj->getAABB().max_[axis3] >= obj2->getAABB().min_[axis3]) && (obj2->getAABB().max_[axis3] >= obj->getAABB().min_[axis3]))
-          {
-            if(callback(obj, obj2, cdata))
-              return;
-          }
+          if(callback(obj, obj2, cdata))
+            return true;
         }
-
-        if(run_pos2 == pos_end) break;
       }
     }
   }
+
+  return false;
+}
+
+//==============================================================================
+template <typename S>
+void SSaPCollisionManager<S>::collide(void* cdata, CollisionCallBack<S> callback) const
+{
+  if(size() == 0) return;
+
+  typename std::vector<CollisionObject<S>*>::const_iterator pos, pos_end;
+  size_t axis = selectOptimalAxis(objs_x, objs_y, objs_z,
+                                  pos, pos_end);
+
+  sweepColl(axis, 0, size(), cdata, callback);
+}
+
+//==============================================================================
+template <typename S>
+void SSaPCollisionManager<S>::collide(
+    const std::vector<void*>& cdata, CollisionCallBack<S> callback) const
+{
+  if(size() == 0 || cdata.empty()) return;
+
+  typename std::vector<CollisionObject<S>*>::const_iterator pos, pos_end;
+  size_t axis = selectOptimalAxis(objs_x, objs_y, objs_z,
+                                  pos, pos_end);
+
+  // Sweep a few ranges of objects per thread, so that ranges in dense regions
+  // are picked up by idle threads
+  const size_t n = size();
+  const size_t num_tasks = std::min(n, 16 * cdata.size());
+  detail::parallelSelfCollide<S>(num_tasks, [&](std::size_t i, void* pairs)
+  {
+    sweepColl(axis, n * i / num_tasks, n * (i + 1) / num_tasks,
+              pairs, detail::collectPairs<S>);
+  }, cdata, callback);
 }
 
 //==============================================================================
@@ -612,7 +664,12 @@ void SSaPCollisionManager<S>::distance(void* cdata, DistanceCallBack<S> callback
 template <typename S>
 void SSaPCollisionManager<S>::collide(BroadPhaseCollisionManager<S>* other_manager_, void* cdata, CollisionCallBack<S> callback) const
 {
-  SSaPCollisionManager* other_manager = static_cast<SSaPCollisionManager*>(other_manager_);
+  SSaPCollisionManager* other_manager = dynamic_cast<SSaPCollisionManager*>(other_manager_);
+  if(!other_manager)
+  {
+    this->collideHierarchies(other_manager_, cdata, callback);
+    return;
+  }
 
   if((size() == 0) || (other_manager->size() == 0)) return;
 
@@ -38,10 +38,12 @@
 #ifndef FCL_BROAD_PHASE_SAP_H
 #define FCL_BROAD_PHASE_SAP_H
 
-#include <map>
-#include <list>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
 
 #include "fcl/broadphase/broadphase_collision_manager.h"
+#include "fcl/broadphase/detail/flat_hash_set.h"
 
 namespace fcl
 {
@@ -107,50 +109,86 @@ public:
   /// @brief the number of objects managed by the manager
   size_t size() const;
 
+  /// @brief enable or disable the persistent overlap pairs
+  void enablePersistentPairs(bool enable);
+
+  /// @brief report the pairs of objects whose AABBs started or stopped
+  /// overlapping since the previous call. The overlap pairs are already kept
+  /// up to date by update(), so this only walks the pairs that changed. As in
+  /// BroadPhaseCollisionManager::collideIncremental(), the pointers of
+  /// unregistered objects in stopped pairs must not be dereferenced.
+  void collideIncremental(void* cdata, OverlapEventCallBack<S> callback);
+
+  /// @brief return the persistent pairs as of the last collideIncremental()
+  void getPersistentPairs(
+      std::vector<std::pair<CollisionObject<S>*, CollisionObject<S>*>>& pairs) const;
+
 protected:
 
   /// @brief SAP interval for one object
   struct SaPAABB;
 
-  /// @brief End point for an interval
-  struct EndPoint;
+  /// @brief Sorted end points of all the intervals along one axis
+  struct EndPointList;
 
   /// @brief A pair of objects that are not culling away and should further check collision
   struct SaPPair;
 
+  /// @brief Hash functor for SaPPair
+  struct SaPPairHash;
+
   /// @brief Functor to help unregister one object
   class isUnregistered;
 
-  /// @brief Functor to help remove collision pairs no longer valid (i.e., should be culled away)
-  class isNotValidPair;
+  void update_(size_t id);
 
-  void update_(SaPAABB* updated_aabb);
+  /// @brief Move the end point at position pos of the given axis to value,
+  /// shifting the end points it passes over. If report is set, pairs whose
+  /// intervals start or stop overlapping on the way are added to or removed
+  /// from the overlap pairs, testing additions against new_aabb.
+  void moveEndPoint(size_t axis, size_t pos, S value, const AABB<S>& new_aabb, bool report);
 
-  void updateVelist();
+  /// @brief Add a pair to the overlap pairs, recording the change if the
+  /// persistent pairs are enabled
+  void addToOverlapPairs(const SaPPair& p);
 
-  /// @brief End point list for x, y, z coordinates
-  EndPoint* elist[3];
-  
-  /// @brief vector version of elist, for acceleration
-  std::vector<EndPoint*> velist[3];
+  /// @brief Remove a pair from the overlap pairs, recording the change if the
+  /// persistent pairs are enabled
+  void removeFromOverlapPairs(const SaPPair& p);
+
+  /// @brief Record that a pair started or stopped overlapping. A pair that
+  /// changes twice between two collideIncremental() calls is back where it
+  /// was, so its record is dropped again.
+  void togglePairChange(const SaPPair& p);
+
+  /// @brief Store the end point with the given tag at position pos
+  void setEndPoint(size_t axis, size_t pos, S value, size_t tag);
 
-  /// @brief SAP interval list
-  std::list<SaPAABB*> AABB_arr;
+  /// @brief Position of the first end point whose value is larger than value
+  size_t upperBound(size_t axis, S value) const;
+
+  /// @brief SAP intervals, indexed by the id encoded in the end point tags
+  std::vector<SaPAABB> AABB_arr;
+
+  /// @brief End point lists for x, y, z coordinates
+  EndPointList elist[3];
 
   /// @brief The pair of objects that should further check for collision
-  std::list<SaPPair> overlap_pairs;
+  detail::FlatHashSet<SaPPair, SaPPairHash> overlap_pairs;
 
-  size_t optimal_axis;
+  /// @brief The pairs that started or stopped overlapping since the last
+  /// collideIncremental(), only kept while the persistent pairs are enabled
+  detail::FlatHashSet<SaPPair, SaPPairHash> changed_pairs;
 
-  std::map<CollisionObject<S>*, SaPAABB*> obj_aabb_map;
+  size_t optimal_axis;
 
-  bool distance_(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist) const;
+  std::unordered_map<CollisionObject<S>*, size_t> obj_aabb_map;
 
-  bool collide_(CollisionObject<S>* obj, void* cdata, CollisionCallBack<S> callback) const;
+  using TestedSet = typename BroadPhaseCollisionManager<S>::TestedSet;
 
-  void addToOverlapPairs(const SaPPair& p);
+  bool distance_(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist, TestedSet* tested_set = nullptr) const;
 
-  void removeFromOverlapPairs(const SaPPair& p);
+  bool collide_(CollisionObject<S>* obj, void* cdata, CollisionCallBack<S> callback) const;
 };
 
 using SaPCollisionManagerf = SaPCollisionManager<float>;
@@ -163,48 +201,35 @@ struct SaPCollisionManager<S>::SaPAABB
   /// @brief object
   CollisionObject<S>* obj;
 
-  /// @brief lower bound end point of the interval
-  typename SaPCollisionManager<S>::EndPoint* lo;
+  /// @brief position of the lower bound end point in each end point list
+  size_t lo[3];
 
-  /// @brief higher bound end point of the interval
-  typename SaPCollisionManager<S>::EndPoint* hi;
+  /// @brief position of the higher bound end point in each end point list
+  size_t hi[3];
 
   /// @brief cached AABB<S> value
   AABB<S> cached;
 };
 
-/// @brief End point for an interval
+/// @brief Sorted end points of all the intervals along one axis, stored as
+/// parallel arrays. The tag of an end point is 2 * id + minmax, where id
+/// indexes AABB_arr and minmax is 0 for lo and 1 for hi. At equal values a lo
+/// end point sorts before a hi end point, so that touching intervals overlap
+/// as in AABB::overlap().
 template <typename S>
-struct SaPCollisionManager<S>::EndPoint
+struct SaPCollisionManager<S>::EndPointList
 {
-  /// @brief tag for whether it is a lower bound or higher bound of an interval, 0 for lo, and 1 for hi
-  char minmax;
-
-  /// @brief back pointer to SAP interval
-  typename SaPCollisionManager<S>::SaPAABB* aabb;
-
-  /// @brief the previous end point in the end point list
-  EndPoint* prev[3];
-
-  /// @brief the next end point in the end point list
-  EndPoint* next[3];
-
-  /// @brief get the value of the end point
-  const Vector3<S>& getVal() const;
-
-  /// @brief set the value of the end point
-  Vector3<S>& getVal();
-
-  S getVal(size_t i) const;
-
-  S& getVal(size_t i);
+  std::vector<S> values;
 
+  std::vector<size_t> tags;
 };
 
 /// @brief A pair of objects that are not culling away and should further check collision
 template <typename S>
 struct SaPCollisionManager<S>::SaPPair
 {
+  SaPPair() = default;
+
   SaPPair(CollisionObject<S>* a, CollisionObject<S>* b);
 
   CollisionObject<S>* obj1;
@@ -213,6 +238,13 @@ struct SaPCollisionManager<S>::SaPPair
   bool operator == (const SaPPair& other) const;
 };
 
+/// @brief Hash functor for SaPPair
+template <typename S>
+struct SaPCollisionManager<S>::SaPPairHash
+{
+  std::size_t operator() (const SaPPair& pair) const;
+};
+
 /// @brief Functor to help unregister one object
 template <typename S>
 class SaPCollisionManager<S>::isUnregistered
@@ -225,19 +257,6 @@ public:
   bool operator() (const SaPPair& pair) const;
 };
 
-/// @brief Functor to help remove collision pairs no longer valid (i.e., should be culled away)
-template <typename S>
-class SaPCollisionManager<S>::isNotValidPair
-{
-  CollisionObject<S>* obj1;
-  CollisionObject<S>* obj2;
-
-public:
-  isNotValidPair(CollisionObject<S>* obj1_, CollisionObject<S>* obj2_);
-
-  bool operator() (const SaPPair& pair);
-};
-
 //============================================================================//
 //                                                                            //
 //                              Implementations                               //
@@ -248,57 +267,66 @@ public:
 template <typename S>
 void SaPCollisionManager<S>::unregisterObject(CollisionObject<S>* obj)
 {
-  auto it = AABB_arr.begin();
-  for(auto end = AABB_arr.end(); it != end; ++it)
-  {
-    if((*it)->obj == obj)
-      break;
-  }
+  auto map_it = obj_aabb_map.find(obj);
+  if(map_it == obj_aabb_map.end())
+    return;
 
-  AABB_arr.erase(it);
-  obj_aabb_map.erase(obj);
+  const size_t id = map_it->second;
+  obj_aabb_map.erase(map_it);
 
-  if(it == AABB_arr.end())
-    return;
+  for(size_t coord = 0; coord < 3; ++coord)
+  {
+    EndPointList& list = elist[coord];
+    const size_t lo = AABB_arr[id].lo[coord];
+    const size_t hi = AABB_arr[id].hi[coord];
+
+    // hi comes after lo, so erasing it first keeps lo in place
+    list.values.erase(list.values.begin() + hi);
+    list.tags.erase(list.tags.begin() + hi);
+    list.values.erase(list.values.begin() + lo);
+    list.tags.erase(list.tags.begin() + lo);
 
-  SaPAABB* curr = *it;
-  *it = nullptr;
+    for(size_t i = lo; i < list.tags.size(); ++i)
+    {
+      const size_t tag = list.tags[i];
+      if(tag & 1)
+        AABB_arr[tag >> 1].hi[coord] = i;
+      else
+        AABB_arr[tag >> 1].lo[coord] = i;
+    }
+  }
 
-  for(int coord = 0; coord < 3; ++coord)
+  // Move the last interval into the freed id
+  const size_t last = AABB_arr.size() - 1;
+  if(id != last)
   {
-    //first delete the lo endpoint of the interval.
-    if(curr->lo->prev[coord] == nullptr)
-      elist[coord] = curr->lo->next[coord];
-    else
-      curr->lo->prev[coord]->next[coord] = curr->lo->next[coord];
-
-    curr->lo->next[coord]->prev[coord] = curr->lo->prev[coord];
-
-    //then, delete the "hi" endpoint.
-    if(curr->hi->prev[coord] == nullptr)
-      elist[coord] = curr->hi->next[coord];
-    else
-      curr->hi->prev[coord]->next[coord] = curr->hi->next[coord];
-
-    if(curr->hi->next[coord] != nullptr)
-      curr->hi->next[coord]->prev[coord] = curr->hi->prev[coord];
+    AABB_arr[id] = AABB_arr[last];
+    for(size_t coord = 0; coord < 3; ++coord)
+    {
+      elist[coord].tags[AABB_arr[id].lo[coord]] = 2 * id;
+      elist[coord].tags[AABB_arr[id].hi[coord]] = 2 * id + 1;
+    }
+    obj_aabb_map[AABB_arr[id].obj] = id;
   }
+  AABB_arr.pop_back();
 
-  delete curr->lo;
-  delete curr->hi;
-  delete curr;
+  if(this->enable_persistent_pairs_)
+  {
+    isUnregistered pred(obj);
+    for(auto it = overlap_pairs.begin(), end = overlap_pairs.end(); it != end; ++it)
+    {
+      if(pred(*it))
+        togglePairChange(*it);
+    }
+  }
 
-  overlap_pairs.remove_if(isUnregistered(obj));
+  overlap_pairs.eraseIf(isUnregistered(obj));
 }
-\
+
 //==============================================================================
 template <typename S>
 SaPCollisionManager<S>::SaPCollisionManager()
 {
-  elist[0] = nullptr;
-  elist[1] = nullptr;
-  elist[2] = nullptr;
-
   optimal_axis = 0;
 }
 
@@ -319,183 +347,94 @@ void SaPCollisionManager<S>::registerObjects(const std::vector<CollisionObject<S
     BroadPhaseCollisionManager<S>::registerObjects(other_objs);
   else
   {
-    std::vector<EndPoint*> endpoints(2 * other_objs.size());
-
-    for(size_t i = 0; i < other_objs.size(); ++i)
+    const size_t n = other_objs.size();
+    AABB_arr.resize(n);
+    obj_aabb_map.reserve(n);
+    for(size_t i = 0; i < n; ++i)
     {
-      SaPAABB* sapaabb = new SaPAABB();
-      sapaabb->obj = other_objs[i];
-      sapaabb->lo = new EndPoint();
-      sapaabb->hi = new EndPoint();
-      sapaabb->cached = other_objs[i]->getAABB();
-      endpoints[2 * i] = sapaabb->lo;
-      endpoints[2 * i + 1] = sapaabb->hi;
-      sapaabb->lo->minmax = 0;
-      sapaabb->hi->minmax = 1;
-      sapaabb->lo->aabb = sapaabb;
-      sapaabb->hi->aabb = sapaabb;
-      AABB_arr.push_back(sapaabb);
-      obj_aabb_map[other_objs[i]] = sapaabb;
+      AABB_arr[i].obj = other_objs[i];
+      AABB_arr[i].cached = other_objs[i]->getAABB();
+      obj_aabb_map[other_objs[i]] = i;
     }
 
-
+    std::vector<size_t> tags(2 * n);
     S scale[3];
     for(size_t coord = 0; coord < 3; ++coord)
     {
-      std::sort(endpoints.begin(), endpoints.end(),
-                std::bind(std::less<S>(),
-                            std::bind(static_cast<S (EndPoint::*)(size_t) const >(&EndPoint::getVal), std::placeholders::_1, coord),
-                            std::bind(static_cast<S (EndPoint::*)(size_t) const >(&EndPoint::getVal), std::placeholders::_2, coord)));
-
-      endpoints[0]->prev[coord] = nullptr;
-      endpoints[0]->next[coord] = endpoints[1];
-      for(size_t i = 1; i < endpoints.size() - 1; ++i)
-      {
-        endpoints[i]->prev[coord] = endpoints[i-1];
-        endpoints[i]->next[coord] = endpoints[i+1];
-      }
-      endpoints[endpoints.size() - 1]->prev[coord] = endpoints[endpoints.size() - 2];
-      endpoints[endpoints.size() - 1]->next[coord] = nullptr;
-
-      elist[coord] = endpoints[0];
-
-      scale[coord] = endpoints.back()->aabb->cached.max_[coord] - endpoints[0]->aabb->cached.min_[coord];
+      for(size_t i = 0; i < 2 * n; ++i)
+        tags[i] = i;
+
+      const auto value = [&](size_t tag) {
+        const AABB<S>& aabb = AABB_arr[tag >> 1].cached;
+        return (tag & 1) ? aabb.max_[coord] : aabb.min_[coord];
+      };
+      std::sort(tags.begin(), tags.end(), [&](size_t a, size_t b) {
+        const S va = value(a);
+        const S vb = value(b);
+        return (va < vb) || ((va == vb) && ((a & 1) < (b & 1)));
+      });
+
+      EndPointList& list = elist[coord];
+      list.values.resize(2 * n);
+      list.tags.resize(2 * n);
+      for(size_t i = 0; i < 2 * n; ++i)
+        setEndPoint(coord, i, value(tags[i]), tags[i]);
+
+      scale[coord] = list.values.back() - list.values.front();
     }
 
-    int axis = 0;
+    size_t axis = 0;
     if(scale[axis] < scale[1]) axis = 1;
     if(scale[axis] < scale[2]) axis = 2;
 
-    EndPoint* pos = elist[axis];
-
-    while(pos != nullptr)
+    // Every overlapping pair has the lo end point of one interval between the
+    // end points of the other along any axis
+    const EndPointList& list = elist[axis];
+    for(size_t i = 0; i < 2 * n; ++i)
     {
-      EndPoint* pos_next = nullptr;
-      SaPAABB* aabb = pos->aabb;
-      EndPoint* pos_it = pos->next[axis];
+      const size_t tag = list.tags[i];
+      if(tag & 1) continue;
 
-      while(pos_it != nullptr)
+      const SaPAABB& aabb = AABB_arr[tag >> 1];
+      for(size_t j = i + 1; j < aabb.hi[axis]; ++j)
       {
-        if(pos_it->aabb == aabb)
-        {
-          if(pos_next == nullptr) pos_next = pos_it;
-          break;
-        }
+        const size_t other_tag = list.tags[j];
+        if(other_tag & 1) continue;
 
-        if(pos_it->minmax == 0)
-        {
-          if(pos_next == nullptr) pos_next = pos_it;
-          if(pos_it->aabb->cached.overlap(aabb->cached))
-            overlap_pairs.emplace_back(pos_it->aabb->obj, aabb->obj);
-        }
-        pos_it = pos_it->next[axis];
+        const SaPAABB& other = AABB_arr[other_tag >> 1];
+        if(other.cached.overlap(aabb.cached))
+          addToOverlapPairs(SaPPair(other.obj, aabb.obj));
       }
-
-      pos = pos_next;
     }
   }
-
-  updateVelist();
 }
 
 //==============================================================================
 template <typename S>
 void SaPCollisionManager<S>::registerObject(CollisionObject<S>* obj)
 {
-  SaPAABB* curr = new SaPAABB;
-  curr->cached = obj->getAABB();
-  curr->obj = obj;
-  curr->lo = new EndPoint;
-  curr->lo->minmax = 0;
-  curr->lo->aabb = curr;
-
-  curr->hi = new EndPoint;
-  curr->hi->minmax = 1;
-  curr->hi->aabb = curr;
-
-  for(int coord = 0; coord < 3; ++coord)
-  {
-    EndPoint* current = elist[coord];
-
-    // first insert the lo end point
-    if(current == nullptr) // empty list
-    {
-      elist[coord] = curr->lo;
-      curr->lo->prev[coord] = curr->lo->next[coord] = nullptr;
-    }
-    else // otherwise, find the correct location in the list and insert
-    {
-      EndPoint* curr_lo = curr->lo;
-      S curr_lo_val = curr_lo->getVal()[coord];
-      while((current->getVal()[coord] < curr_lo_val) && (current->next[coord] != nullptr))
-        current = current->next[coord];
-
-      if(current->getVal()[coord] >= curr_lo_val)
-      {
-        curr_lo->prev[coord] = current->prev[coord];
-        curr_lo->next[coord] = current;
-        if(current->prev[coord] == nullptr)
-          elist[coord] = curr_lo;
-        else
-          current->prev[coord]->next[coord] = curr_lo;
-
-        current->prev[coord] = curr_lo;
-      }
-      else
-      {
-        curr_lo->prev[coord] = current;
-        curr_lo->next[coord] = nullptr;
-        current->next[coord] = curr_lo;
-      }
-    }
-
-    // now insert hi end point
-    current = curr->lo;
-
-    EndPoint* curr_hi = curr->hi;
-    S curr_hi_val = curr_hi->getVal()[coord];
-
-    if(coord == 0)
-    {
-      while((current->getVal()[coord] < curr_hi_val) && (current->next[coord] != nullptr))
-      {
-        if(current != curr->lo)
-          if(current->aabb->cached.overlap(curr->cached))
-            overlap_pairs.emplace_back(current->aabb->obj, obj);
-
-        current = current->next[coord];
-      }
-    }
-    else
-    {
-      while((current->getVal()[coord] < curr_hi_val) && (current->next[coord] != nullptr))
-        current = current->next[coord];
-    }
-
-    if(current->getVal()[coord] >= curr_hi_val)
-    {
-      curr_hi->prev[coord] = current->prev[coord];
-      curr_hi->next[coord] = current;
-      if(current->prev[coord] == nullptr)
-        elist[coord] = curr_hi;
-      else
-        current->prev[coord]->next[coord] = curr_hi;
-
-      current->prev[coord] = curr_hi;
-    }
-    else
-    {
-      curr_hi->prev[coord] = current;
-      curr_hi->next[coord] = nullptr;
-      current->next[coord] = curr_hi;
-    }
-  }
-
+  const size_t id = AABB_arr.size();
+  SaPAABB curr{};
+  curr.obj = obj;
+  curr.cached = obj->getAABB();
   AABB_arr.push_back(curr);
+  obj_aabb_map[obj] = id;
 
-  obj_aabb_map[obj] = curr;
-
-  updateVelist();
+  // Append the end points past the current end and move them into place.
+  // Moving lo down over the hi end points of all the intervals reaching past
+  // it finds every overlap, so pairs are only reported along the first axis.
+  for(size_t coord = 0; coord < 3; ++coord)
+  {
+    EndPointList& list = elist[coord];
+    const size_t end = list.values.size();
+    list.values.resize(end + 2);
+    list.tags.resize(end + 2);
+    setEndPoint(coord, end, curr.cached.min_[coord], 2 * id);
+    setEndPoint(coord, end + 1, curr.cached.max_[coord], 2 * id + 1);
+
+    moveEndPoint(coord, end, curr.cached.min_[coord], curr.cached, coord == 0);
+    moveEndPoint(coord, end + 1, curr.cached.max_[coord], curr.cached, false);
+  }
 }
 
 //==============================================================================
@@ -505,9 +444,9 @@ void SaPCollisionManager<S>::setup()
   if(size() == 0) return;
 
   S scale[3];
-  scale[0] = (velist[0].back())->getVal(0) - velist[0][0]->getVal(0);
-  scale[1] = (velist[1].back())->getVal(1) - velist[1][0]->getVal(1);;
-  scale[2] = (velist[2].back())->getVal(2) - velist[2][0]->getVal(2);
+  scale[0] = elist[0].values.back() - elist[0].values.front();
+  scale[1] = elist[1].values.back() - elist[1].values.front();
+  scale[2] = elist[2].values.back() - elist[2].values.front();
   size_t axis = 0;
   if(scale[axis] < scale[1]) axis = 1;
   if(scale[axis] < scale[2]) axis = 2;
@@ -516,164 +455,151 @@ void SaPCollisionManager<S>::setup()
 
 //==============================================================================
 template <typename S>
-void SaPCollisionManager<S>::update_(SaPAABB* updated_aabb)
+void SaPCollisionManager<S>::update_(size_t id)
 {
-  if(updated_aabb->cached.equal(updated_aabb->obj->getAABB()))
+  const AABB<S> new_aabb = AABB_arr[id].obj->getAABB();
+  const AABB<S> old_aabb = AABB_arr[id].cached;
+
+  if(new_aabb.equal(old_aabb))
     return;
 
-  SaPAABB* current = updated_aabb;
+  // Growing moves come first and shrinking ones last, so that the lo end
+  // point never has to pass its own hi end point. Pairs are added when the
+  // intervals start to overlap on some axis and the new AABB overlaps the
+  // other one, and removed when the intervals stop overlapping on some axis.
+  for(size_t coord = 0; coord < 3; ++coord)
+  {
+    const S new_min = new_aabb.min_[coord];
+    const S new_max = new_aabb.max_[coord];
+    const S old_min = old_aabb.min_[coord];
+    const S old_max = old_aabb.max_[coord];
+
+    if(new_min < old_min)
+      moveEndPoint(coord, AABB_arr[id].lo[coord], new_min, new_aabb, true);
+    if(new_max > old_max)
+      moveEndPoint(coord, AABB_arr[id].hi[coord], new_max, new_aabb, true);
+    if(new_max < old_max)
+      moveEndPoint(coord, AABB_arr[id].hi[coord], new_max, new_aabb, true);
+    if(new_min > old_min)
+      moveEndPoint(coord, AABB_arr[id].lo[coord], new_min, new_aabb, true);
+  }
 
-  Vector3<S> new_min = current->obj->getAABB().min_;
-  Vector3<S> new_max = current->obj->getAABB().max_;
+  AABB_arr[id].cached = new_aabb;
+}
 
-  SaPAABB dummy;
-  dummy.cached = current->obj->getAABB();
+//==============================================================================
+template <typename S>
+void SaPCollisionManager<S>::moveEndPoint(
+    size_t axis, size_t pos, S value, const AABB<S>& new_aabb, bool report)
+{
+  EndPointList& list = elist[axis];
+  const size_t tag = list.tags[pos];
+  const size_t minmax = tag & 1;
+  CollisionObject<S>* obj = AABB_arr[tag >> 1].obj;
 
-  for(int coord = 0; coord < 3; ++coord)
+  // Move down while the previous end point sorts after (value, minmax)
+  while(pos > 0)
   {
-    int direction; // -1 reverse, 0 nochange, 1 forward
-    EndPoint* temp;
-
-    if(current->lo->getVal(coord) > new_min[coord])
-      direction = -1;
-    else if(current->lo->getVal(coord) < new_min[coord])
-      direction = 1;
-    else direction = 0;
+    const S prev_value = list.values[pos - 1];
+    const size_t prev_tag = list.tags[pos - 1];
+    if(!((prev_value > value)
+         || ((prev_value == value) && ((prev_tag & 1) > minmax))))
+      break;
 
-    if(direction == -1)
+    if(report && (prev_tag & 1) != minmax)
     {
-      //first update the "lo" endpoint of the interval
-      if(current->lo->prev[coord] != nullptr)
+      const SaPAABB& other = AABB_arr[prev_tag >> 1];
+      if(minmax == 0)
       {
-        temp = current->lo;
-        while((temp != nullptr) && (temp->getVal(coord) > new_min[coord]))
-        {
-          if(temp->minmax == 1)
-            if(temp->aabb->cached.overlap(dummy.cached))
-              addToOverlapPairs(SaPPair(temp->aabb->obj, current->obj));
-          temp = temp->prev[coord];
-        }
-
-        if(temp == nullptr)
-        {
-          current->lo->prev[coord]->next[coord] = current->lo->next[coord];
-          current->lo->next[coord]->prev[coord] = current->lo->prev[coord];
-          current->lo->prev[coord] = nullptr;
-          current->lo->next[coord] = elist[coord];
-          elist[coord]->prev[coord] = current->lo;
-          elist[coord] = current->lo;
-        }
-        else
-        {
-          current->lo->prev[coord]->next[coord] = current->lo->next[coord];
-          current->lo->next[coord]->prev[coord] = current->lo->prev[coord];
-          current->lo->prev[coord] = temp;
-          current->lo->next[coord] = temp->next[coord];
-          temp->next[coord]->prev[coord] = current->lo;
-          temp->next[coord] = current->lo;
-        }
+        // lo moves below the other hi
+        if(new_aabb.overlap(other.cached))
+          addToOverlapPairs(SaPPair(obj, other.obj));
       }
-
-      current->lo->getVal(coord) = new_min[coord];
-
-      // update hi end point
-      temp = current->hi;
-      while(temp->getVal(coord) > new_max[coord])
+      else
       {
-        if((temp->minmax == 0) && (temp->aabb->cached.overlap(current->cached)))
-          removeFromOverlapPairs(SaPPair(temp->aabb->obj, current->obj));
-        temp = temp->prev[coord];
+        // hi moves below the other lo
+        removeFromOverlapPairs(SaPPair(obj, other.obj));
       }
-
-      current->hi->prev[coord]->next[coord] = current->hi->next[coord];
-      if(current->hi->next[coord] != nullptr)
-        current->hi->next[coord]->prev[coord] = current->hi->prev[coord];
-      current->hi->prev[coord] = temp;
-      current->hi->next[coord] = temp->next[coord];
-      if(temp->next[coord] != nullptr)
-        temp->next[coord]->prev[coord] = current->hi;
-      temp->next[coord] = current->hi;
-
-      current->hi->getVal(coord) = new_max[coord];
     }
-    else if(direction == 1)
-    {
-      //here, we first update the "hi" endpoint.
-      if(current->hi->next[coord] != nullptr)
-      {
-        temp = current->hi;
-        while((temp->next[coord] != nullptr) && (temp->getVal(coord) < new_max[coord]))
-        {
-          if(temp->minmax == 0)
-            if(temp->aabb->cached.overlap(dummy.cached))
-              addToOverlapPairs(SaPPair(temp->aabb->obj, current->obj));
-          temp = temp->next[coord];
-        }
 
-        if(temp->getVal(coord) < new_max[coord])
-        {
-          current->hi->prev[coord]->next[coord] = current->hi->next[coord];
-          current->hi->next[coord]->prev[coord] = current->hi->prev[coord];
-          current->hi->prev[coord] = temp;
-          current->hi->next[coord] = nullptr;
-          temp->next[coord] = current->hi;
-        }
-        else
-        {
-          current->hi->prev[coord]->next[coord] = current->hi->next[coord];
-          current->hi->next[coord]->prev[coord] = current->hi->prev[coord];
-          current->hi->prev[coord] = temp->prev[coord];
-          current->hi->next[coord] = temp;
-          temp->prev[coord]->next[coord] = current->hi;
-          temp->prev[coord] = current->hi;
-        }
-      }
-
-      current->hi->getVal(coord) = new_max[coord];
+    setEndPoint(axis, pos, prev_value, prev_tag);
+    --pos;
+  }
 
-      //then, update the "lo" endpoint of the interval.
-      temp = current->lo;
+  // Move up while the next end point sorts before (value, minmax)
+  while(pos + 1 < list.values.size())
+  {
+    const S next_value = list.values[pos + 1];
+    const size_t next_tag = list.tags[pos + 1];
+    if(!((next_value < value)
+         || ((next_value == value) && ((next_tag & 1) < minmax))))
+      break;
 
-      while(temp->getVal(coord) < new_min[coord])
+    if(report && (next_tag & 1) != minmax)
+    {
+      const SaPAABB& other = AABB_arr[next_tag >> 1];
+      if(minmax == 1)
       {
-        if((temp->minmax == 1) && (temp->aabb->cached.overlap(current->cached)))
-          removeFromOverlapPairs(SaPPair(temp->aabb->obj, current->obj));
-        temp = temp->next[coord];
+        // hi moves above the other lo
+        if(new_aabb.overlap(other.cached))
+          addToOverlapPairs(SaPPair(obj, other.obj));
       }
-
-      if(current->lo->prev[coord] != nullptr)
-        current->lo->prev[coord]->next[coord] = current->lo->next[coord];
       else
-        elist[coord] = current->lo->next[coord];
-      current->lo->next[coord]->prev[coord] = current->lo->prev[coord];
-      current->lo->prev[coord] = temp->prev[coord];
-      current->lo->next[coord] = temp;
-      if(temp->prev[coord] != nullptr)
-        temp->prev[coord]->next[coord] = current->lo;
-      else
-        elist[coord] = current->lo;
-      temp->prev[coord] = current->lo;
-      current->lo->getVal(coord) = new_min[coord];
+      {
+        // lo moves above the other hi
+        removeFromOverlapPairs(SaPPair(obj, other.obj));
+      }
     }
+
+    setEndPoint(axis, pos, next_value, next_tag);
+    ++pos;
   }
+
+  setEndPoint(axis, pos, value, tag);
 }
 
 //==============================================================================
 template <typename S>
-void SaPCollisionManager<S>::updateVelist()
+void SaPCollisionManager<S>::addToOverlapPairs(const SaPPair& p)
 {
-  for(int coord = 0; coord < 3; ++coord)
-  {
-    velist[coord].resize(size() * 2);
-    EndPoint* current = elist[coord];
-    size_t id = 0;
-    while(current)
-    {
-      velist[coord][id] = current;
-      current = current->next[coord];
-      id++;
-    }
-  }
+  if(overlap_pairs.insert(p) && this->enable_persistent_pairs_)
+    togglePairChange(p);
+}
+
+//==============================================================================
+template <typename S>
+void SaPCollisionManager<S>::removeFromOverlapPairs(const SaPPair& p)
+{
+  if(overlap_pairs.erase(p) && this->enable_persistent_pairs_)
+    togglePairChange(p);
+}
+
+//==============================================================================
+template <typename S>
+void SaPCollisionManager<S>::togglePairChange(const SaPPair& p)
+{
+  if(!changed_pairs.erase(p))
+    changed_pairs.insert(p);
+}
+
+//==============================================================================
+template <typename S>
+void SaPCollisionManager<S>::setEndPoint(size_t axis, size_t pos, S value, size_t tag)
+{
+  elist[axis].values[pos] = value;
+  elist[axis].tags[pos] = tag;
+  if(tag & 1)
+    AABB_arr[tag >> 1].hi[axis] = pos;
+  else
+    AABB_arr[tag >> 1].lo[axis] = pos;
+}
+
+//==============================================================================
+template <typename S>
+size_t SaPCollisionManager<S>::upperBound(size_t axis, S value) const
+{
+  const std::vector<S>& values = elist[axis].values;
+  return std::upper_bound(values.begin(), values.end(), value) - values.begin();
 }
 
 //==============================================================================
@@ -682,8 +608,6 @@ void SaPCollisionManager<S>::update(CollisionObject<S>* updated_obj)
 {
   update_(obj_aabb_map[updated_obj]);
 
-  updateVelist();
-
   setup();
 }
 
@@ -694,8 +618,6 @@ void SaPCollisionManager<S>::update(const std::vector<CollisionObject<S>*>& upda
   for(size_t i = 0; i < updated_objs.size(); ++i)
     update_(obj_aabb_map[updated_objs[i]]);
 
-  updateVelist();
-
   setup();
 }
 
@@ -703,12 +625,8 @@ void SaPCollisionManager<S>::update(const std::vector<CollisionObject<S>*>& upda
 template <typename S>
 void SaPCollisionManager<S>::update()
 {
-  for(auto it = AABB_arr.cbegin(), end = AABB_arr.cend(); it != end; ++it)
-  {
-    update_(*it);
-  }
-
-  updateVelist();
+  for(size_t i = 0; i < AABB_arr.size(); ++i)
+    update_(i);
 
   setup();
 }
@@ -717,24 +635,20 @@ void SaPCollisionManager<S>::update()
 template <typename S>
 void SaPCollisionManager<S>::clear()
 {
-  for(auto it = AABB_arr.begin(), end = AABB_arr.end(); it != end; ++it)
+  if(this->enable_persistent_pairs_)
   {
-    delete (*it)->hi;
-    delete (*it)->lo;
-    delete *it;
-    *it = nullptr;
+    for(auto it = overlap_pairs.begin(), end = overlap_pairs.end(); it != end; ++it)
+      togglePairChange(*it);
   }
 
   AABB_arr.clear();
   overlap_pairs.clear();
 
-  elist[0] = nullptr;
-  elist[1] = nullptr;
-  elist[2] = nullptr;
-
-  velist[0].clear();
-  velist[1].clear();
-  velist[2].clear();
+  for(size_t coord = 0; coord < 3; ++coord)
+  {
+    elist[coord].values.clear();
+    elist[coord].tags.clear();
+  }
 
   obj_aabb_map.clear();
 }
@@ -744,11 +658,8 @@ template <typename S>
 void SaPCollisionManager<S>::getObjects(std::vector<CollisionObject<S>*>& objs) const
 {
   objs.resize(AABB_arr.size());
-  int i = 0;
-  for(auto it = AABB_arr.cbegin(), end = AABB_arr.cend(); it != end; ++it, ++i)
-  {
-    objs[i] = (*it)->obj;
-  }
+  for(size_t i = 0; i < AABB_arr.size(); ++i)
+    objs[i] = AABB_arr[i].obj;
 }
 
 //==============================================================================
@@ -759,81 +670,32 @@ bool SaPCollisionManager<S>::collide_(CollisionObject<S>* obj, void* cdata, Coll
   const AABB<S>& obj_aabb = obj->getAABB();
 
   S min_val = obj_aabb.min_[axis];
-  //  S max_val = obj_aabb.max_[axis];
-
-  EndPoint dummy;
-  SaPAABB dummy_aabb;
-  dummy_aabb.cached = obj_aabb;
-  dummy.minmax = 1;
-  dummy.aabb = &dummy_aabb;
+  S max_val = obj_aabb.max_[axis];
 
   // compute stop_pos by binary search, this is cheaper than check it in while iteration linearly
-  const auto res_it = std::upper_bound(velist[axis].begin(), velist[axis].end(), &dummy,
-                                                                   std::bind(std::less<S>(),
-                                                                               std::bind(static_cast<S (EndPoint::*)(size_t) const>(&EndPoint::getVal), std::placeholders::_1, axis),
-                                                                               std::bind(static_cast<S (EndPoint::*)(size_t) const>(&EndPoint::getVal), std::placeholders::_2, axis)));
-
-  EndPoint* end_pos = nullptr;
-  if(res_it != velist[axis].end())
-    end_pos = *res_it;
+  const size_t end_pos = upperBound(axis, max_val);
 
-  EndPoint* pos = elist[axis];
-
-  while(pos != end_pos)
+  const EndPointList& list = elist[axis];
+  for(size_t pos = 0; pos < end_pos; ++pos)
   {
-    if(pos->aabb->obj != obj)
+    const size_t tag = list.tags[pos];
+    if(tag & 1) continue;
+
+    const SaPAABB& aabb = AABB_arr[tag >> 1];
+    if(aabb.obj != obj)
     {
-      if((pos->minmax == 0) && (pos->aabb->hi->getVal(axis) >= min_val))
+      if(list.values[aabb.hi[axis]] >= min_val)
       {
-        if(pos->aabb->cached.overlap(obj->getAABB()))
-          if(callback(obj, pos->aabb->obj, cdata))
+        if(aabb.cached.overlap(obj_aabb))
+          if(callback(obj, aabb.obj, cdata))
             return true;
       }
     }
-    pos = pos->next[axis];
   }
 
   return false;
 }
 
-//==============================================================================
-template <typename S>
-void SaPCollisionManager<S>::addToOverlapPairs(
-    const typename SaPCollisionManager<S>::SaPPair& p)
-{
-  bool repeated = false;
-  for(auto it = overlap_pairs.begin(), end = overlap_pairs.end(); it != end; ++it)
-  {
-    if(*it == p)
-    {
-      repeated = true;
-      break;
-    }
-  }
-
-  if(!repeated)
-    overlap_pairs.push_back(p);
-}
-
-//==============================================================================
-template <typename S>
-void SaPCollisionManager<S>::removeFromOverlapPairs(
-    const typename SaPCollisionManager<S>::SaPPair& p)
-{
-  for(auto it = overlap_pairs.begin(), end = overlap_pairs.end();
-      it != end;
-      ++it)
-  {
-    if(*it == p)
-    {
-      overlap_pairs.erase(it);
-      break;
-    }
-  }
-
-  // or overlap_pairs.remove_if(isNotValidPair(p));
-}
-
 //==============================================================================
 template <typename S>
 void SaPCollisionManager<S>::collide(CollisionObject<S>* obj, void* cdata, CollisionCallBack<S> callback) const
@@ -845,7 +707,7 @@ void SaPCollisionManager<S>::collide(CollisionObject<S>* obj, void* cdata, Colli
 
 //==============================================================================
 template <typename S>
-bool SaPCollisionManager<S>::distance_(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist) const
+bool SaPCollisionManager<S>::distance_(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist, TestedSet* tested_set) const
 {
   Vector3<S> delta = (obj->getAABB().max_ - obj->getAABB().min_) * 0.5;
   AABB<S> aabb = obj->getAABB();
@@ -861,44 +723,32 @@ bool SaPCollisionManager<S>::distance_(CollisionObject<S>* obj, void* cdata, Dis
   int status = 1;
   S old_min_distance;
 
-  EndPoint* start_pos = elist[axis];
+  const EndPointList& list = elist[axis];
 
   while(1)
   {
     old_min_distance = min_dist;
     S min_val = aabb.min_[axis];
-    //    S max_val = aabb.max_[axis];
-
-    EndPoint dummy;
-    SaPAABB dummy_aabb;
-    dummy_aabb.cached = aabb;
-    dummy.minmax = 1;
-    dummy.aabb = &dummy_aabb;
-
+    S max_val = aabb.max_[axis];
 
-    const auto res_it = std::upper_bound(velist[axis].begin(), velist[axis].end(), &dummy,
-                                                                     std::bind(std::less<S>(),
-                                                                                 std::bind(static_cast<S (EndPoint::*)(size_t) const>(&EndPoint::getVal), std::placeholders::_1, axis),
-                                                                                 std::bind(static_cast<S (EndPoint::*)(size_t) const>(&EndPoint::getVal), std::placeholders::_2, axis)));
+    const size_t end_pos = upperBound(axis, max_val);
 
-    EndPoint* end_pos = nullptr;
-    if(res_it != velist[axis].end())
-      end_pos = *res_it;
-
-    EndPoint* pos = start_pos;
-
-    while(pos != end_pos)
+    for(size_t pos = 0; pos < end_pos; ++pos)
     {
-      // can change to pos->aabb->hi->getVal(axis) >= min_val - min_dist, and then update start_pos to end_pos.
+      const size_t tag = list.tags[pos];
+      if(tag & 1) continue;
+
+      // can change to hi >= min_val - min_dist, and then update start_pos to end_pos.
       // but this seems slower.
-      if((pos->minmax == 0) && (pos->aabb->hi->getVal(axis) >= min_val))
+      const SaPAABB& curr = AABB_arr[tag >> 1];
+      if(list.values[curr.hi[axis]] >= min_val)
       {
-        CollisionObject<S>* curr_obj = pos->aabb->obj;
+        CollisionObject<S>* curr_obj = curr.obj;
         if(curr_obj != obj)
         {
-          if(!this->enable_tested_set_)
+          if(!tested_set)
           {
-            if(pos->aabb->cached.distance(obj->getAABB()) < min_dist)
+            if(curr.cached.distance(obj->getAABB()) < min_dist)
             {
               if(callback(curr_obj, obj, cdata, min_dist))
                 return true;
@@ -906,21 +756,19 @@ bool SaPCollisionManager<S>::distance_(CollisionObject<S>* obj, void* cdata, Dis
           }
           else
           {
-            if(!this->inTestedSet(curr_obj, obj))
+            if(!this->inTestedSet(*tested_set, curr_obj, obj))
             {
-              if(pos->aabb->cached.distance(obj->getAABB()) < min_dist)
+              if(curr.cached.distance(obj->getAABB()) < min_dist)
               {
                 if(callback(curr_obj, obj, cdata, min_dist))
                   return true;
               }
 
-              this->insertTestedSet(curr_obj, obj);
+              this->insertTestedSet(*tested_set, curr_obj, obj);
             }
           }
         }
       }
-
-      pos = pos->next[axis];
     }
 
     if(status == 1)
@@ -968,10 +816,23 @@ void SaPCollisionManager<S>::collide(void* cdata, CollisionCallBack<S> callback)
 {
   if(size() == 0) return;
 
-  for(auto it = overlap_pairs.cbegin(), end = overlap_pairs.cend(); it != end; ++it)
+  // The hash set iterates in an order that depends on the object addresses,
+  // so report the pairs by the ids of their intervals instead, which only
+  // depend on the order of registration, as the other managers do
+  std::vector<std::pair<size_t, size_t>> pairs;
+  pairs.reserve(overlap_pairs.size());
+  for(auto it = overlap_pairs.begin(), end = overlap_pairs.end(); it != end; ++it)
+  {
+    const size_t id1 = obj_aabb_map.find(it->obj1)->second;
+    const size_t id2 = obj_aabb_map.find(it->obj2)->second;
+    pairs.emplace_back(std::min(id1, id2), std::max(id1, id2));
+  }
+  std::sort(pairs.begin(), pairs.end());
+
+  for(const auto& pair : pairs)
   {
-    CollisionObject<S>* obj1 = it->obj1;
-    CollisionObject<S>* obj2 = it->obj2;
+    CollisionObject<S>* obj1 = AABB_arr[pair.first].obj;
+    CollisionObject<S>* obj2 = AABB_arr[pair.second].obj;
 
     if(callback(obj1, obj2, cdata))
       return;
@@ -984,26 +845,27 @@ void SaPCollisionManager<S>::distance(void* cdata, DistanceCallBack<S> callback)
 {
   if(size() == 0) return;
 
-  this->enable_tested_set_ = true;
-  this->tested_set.clear();
+  TestedSet tested_set;
 
   S min_dist = std::numeric_limits<S>::max();
 
-  for(auto it = AABB_arr.cbegin(), end = AABB_arr.cend(); it != end; ++it)
+  for(size_t i = 0; i < AABB_arr.size(); ++i)
   {
-    if(distance_((*it)->obj, cdata, callback, min_dist))
+    if(distance_(AABB_arr[i].obj, cdata, callback, min_dist, &tested_set))
       break;
   }
-
-  this->enable_tested_set_ = false;
-  this->tested_set.clear();
 }
 
 //==============================================================================
 template <typename S>
 void SaPCollisionManager<S>::collide(BroadPhaseCollisionManager<S>* other_manager_, void* cdata, CollisionCallBack<S> callback) const
 {
-  SaPCollisionManager* other_manager = static_cast<SaPCollisionManager*>(other_manager_);
+  SaPCollisionManager* other_manager = dynamic_cast<SaPCollisionManager*>(other_manager_);
+  if(!other_manager)
+  {
+    this->collideHierarchies(other_manager_, cdata, callback);
+    return;
+  }
 
   if((size() == 0) || (other_manager->size() == 0)) return;
 
@@ -1015,17 +877,17 @@ void SaPCollisionManager<S>::collide(BroadPhaseCollisionManager<S>* other_manage
 
   if(this->size() < other_manager->size())
   {
-    for(auto it = AABB_arr.cbegin(); it != AABB_arr.cend(); ++it)
+    for(size_t i = 0; i < AABB_arr.size(); ++i)
     {
-      if(other_manager->collide_((*it)->obj, cdata, callback))
+      if(other_manager->collide_(AABB_arr[i].obj, cdata, callback))
         return;
     }
   }
   else
   {
-    for(auto it = other_manager->AABB_arr.cbegin(), end = other_manager->AABB_arr.cend(); it != end; ++it)
+    for(size_t i = 0; i < other_manager->AABB_arr.size(); ++i)
     {
-      if(collide_((*it)->obj, cdata, callback))
+      if(collide_(other_manager->AABB_arr[i].obj, cdata, callback))
         return;
     }
   }
@@ -1049,17 +911,17 @@ void SaPCollisionManager<S>::distance(BroadPhaseCollisionManager<S>* other_manag
 
   if(this->size() < other_manager->size())
   {
-    for(auto it = AABB_arr.cbegin(), end = AABB_arr.cend(); it != end; ++it)
+    for(size_t i = 0; i < AABB_arr.size(); ++i)
     {
-      if(other_manager->distance_((*it)->obj, cdata, callback, min_dist))
+      if(other_manager->distance_(AABB_arr[i].obj, cdata, callback, min_dist))
         return;
     }
   }
   else
   {
-    for(auto it = other_manager->AABB_arr.cbegin(), end = other_manager->AABB_arr.cend(); it != end; ++it)
+    for(size_t i = 0; i < other_manager->AABB_arr.size(); ++i)
     {
-      if(distance_((*it)->obj, cdata, callback, min_dist))
+      if(distance_(other_manager->AABB_arr[i].obj, cdata, callback, min_dist))
         return;
     }
   }
@@ -1069,7 +931,7 @@ void SaPCollisionManager<S>::distance(BroadPhaseCollisionManager<S>* other_manag
 template <typename S>
 bool SaPCollisionManager<S>::empty() const
 {
-  return AABB_arr.size();
+  return AABB_arr.empty();
 }
 
 //==============================================================================
@@ -1081,38 +943,70 @@ size_t SaPCollisionManager<S>::size() const
 
 //==============================================================================
 template <typename S>
-const Vector3<S>&SaPCollisionManager<S>::EndPoint::getVal() const
+void SaPCollisionManager<S>::enablePersistentPairs(bool enable)
 {
-  if(minmax) return aabb->cached.max_;
-  else return aabb->cached.min_;
-}
+  if(enable == this->enable_persistent_pairs_)
+    return;
 
-//==============================================================================
-template <typename S>
-Vector3<S>&SaPCollisionManager<S>::EndPoint::getVal()
-{
-  if(minmax) return aabb->cached.max_;
-  else return aabb->cached.min_;
+  this->enable_persistent_pairs_ = enable;
+
+  changed_pairs.clear();
+  if(enable)
+  {
+    // Nothing has been reported yet, so every current pair counts as started
+    changed_pairs.reserve(overlap_pairs.size());
+    for(auto it = overlap_pairs.begin(), end = overlap_pairs.end(); it != end; ++it)
+      changed_pairs.insert(*it);
+  }
 }
 
 //==============================================================================
 template <typename S>
-S SaPCollisionManager<S>::EndPoint::getVal(size_t i) const
+void SaPCollisionManager<S>::collideIncremental(
+    void* cdata, OverlapEventCallBack<S> callback)
 {
-  if(minmax)
-    return aabb->cached.max_[i];
-  else
-    return aabb->cached.min_[i];
+  if(!this->enable_persistent_pairs_)
+    return;
+
+  // A changed pair started overlapping if it is in the overlap pairs now, and
+  // stopped otherwise. Stopped pairs are reported first, as in the base class.
+  for(auto it = changed_pairs.begin(), end = changed_pairs.end(); it != end; ++it)
+  {
+    if(!overlap_pairs.contains(*it))
+      callback(it->obj1, it->obj2, false, cdata);
+  }
+
+  for(auto it = changed_pairs.begin(), end = changed_pairs.end(); it != end; ++it)
+  {
+    if(overlap_pairs.contains(*it))
+      callback(it->obj1, it->obj2, true, cdata);
+  }
+
+  changed_pairs.clear();
 }
 
 //==============================================================================
 template <typename S>
-S& SaPCollisionManager<S>::EndPoint::getVal(size_t i)
+void SaPCollisionManager<S>::getPersistentPairs(
+    std::vector<std::pair<CollisionObject<S>*, CollisionObject<S>*>>& pairs) const
 {
-  if(minmax)
-    return aabb->cached.max_[i];
-  else
-    return aabb->cached.min_[i];
+  pairs.clear();
+  if(!this->enable_persistent_pairs_)
+    return;
+
+  // The reported pairs are the current ones with the unreported changes
+  // undone
+  for(auto it = overlap_pairs.begin(), end = overlap_pairs.end(); it != end; ++it)
+  {
+    if(!changed_pairs.contains(*it))
+      pairs.emplace_back(it->obj1, it->obj2);
+  }
+
+  for(auto it = changed_pairs.begin(), end = changed_pairs.end(); it != end; ++it)
+  {
+    if(!overlap_pairs.contains(*it))
+      pairs.emplace_back(it->obj1, it->obj2);
+  }
 }
 
 //==============================================================================
@@ -1140,29 +1034,24 @@ bool SaPCollisionManager<S>::SaPPair::operator ==(const typename SaPCollisionMan
 
 //==============================================================================
 template <typename S>
-SaPCollisionManager<S>::isUnregistered::isUnregistered(CollisionObject<S>* obj_) : obj(obj_)
-{}
-
-//==============================================================================
-template <typename S>
-bool SaPCollisionManager<S>::isUnregistered::operator()(const SaPPair& pair) const
+std::size_t SaPCollisionManager<S>::SaPPairHash::operator()(
+    const typename SaPCollisionManager<S>::SaPPair& pair) const
 {
-  return (pair.obj1 == obj) || (pair.obj2 == obj);
+  const std::size_t h1 = reinterpret_cast<std::size_t>(pair.obj1);
+  const std::size_t h2 = reinterpret_cast<std::size_t>(pair.obj2);
+  return h1 ^ (h2 + 0x9e3779b97f4a7c15ULL + (h1 << 6) + (h1 >> 2));
 }
 
 //==============================================================================
 template <typename S>
-SaPCollisionManager<S>::isNotValidPair::isNotValidPair(CollisionObject<S>* obj1_, CollisionObject<S>* obj2_) : obj1(obj1_),
-  obj2(obj2_)
-{
-  // Do nothing
-}
+SaPCollisionManager<S>::isUnregistered::isUnregistered(CollisionObject<S>* obj_) : obj(obj_)
+{}
 
 //==============================================================================
 template <typename S>
-bool SaPCollisionManager<S>::isNotValidPair::operator()(const SaPPair& pair)
+bool SaPCollisionManager<S>::isUnregistered::operator()(const SaPPair& pair) const
 {
-  return (pair.obj1 == obj1) && (pair.obj2 == obj2);
+  return (pair.obj1 == obj) || (pair.obj2 == obj);
 }
 
 } // namespace fcl
@@ -244,7 +244,12 @@ void NaiveCollisionManager<S>::distance(void* cdata, DistanceCallBack<S> callbac
 template <typename S>
 void NaiveCollisionManager<S>::collide(BroadPhaseCollisionManager<S>* other_manager_, void* cdata, CollisionCallBack<S> callback) const
 {
-  NaiveCollisionManager* other_manager = static_cast<NaiveCollisionManager*>(other_manager_);
+  NaiveCollisionManager* other_manager = dynamic_cast<NaiveCollisionManager*>(other_manager_);
+  if(!other_manager)
+  {
+    this->collideHierarchies(other_manager_, cdata, callback);
+    return;
+  }
 
   if((size() == 0) || (other_manager->size() == 0)) return;
 
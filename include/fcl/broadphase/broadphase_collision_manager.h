@@ -38,10 +38,16 @@
 #ifndef FCL_BROADPHASE_BROADPHASECOLLISIONMANAGER_H
 #define FCL_BROADPHASE_BROADPHASECOLLISIONMANAGER_H
 
+#include <algorithm>
+#include <limits>
+#include <memory>
 #include <set>
 #include <vector>
 
 #include "fcl/object/collision_object.h"
+#include "fcl/common/detail/parallel.h"
+#include "fcl/broadphase/detail/aabb_hierarchy.h"
+#include "fcl/math/detail/morton.h"
 
 namespace fcl
 {
@@ -59,9 +65,28 @@ using DistanceCallBack = bool (*)(
     CollisionObject<S>* o1,
     CollisionObject<S>* o2, void* cdata, S& dist);
 
+/// @brief Callback for a pair of objects whose AABBs started (begin is true)
+/// or stopped (begin is false) overlapping.
+template <typename S>
+using OverlapEventCallBack = void (*)(
+    CollisionObject<S>* o1, CollisionObject<S>* o2, bool begin, void* cdata);
+
+/// @brief Callback for the distance between two objects, for the nearest
+/// neighbor and radius queries. It is only called for the objects that the
+/// distance between the AABBs does not rule out, so the distance it returns
+/// must not be smaller than that one.
+template <typename S>
+using ObjectDistanceCallBack = S (*)(
+    CollisionObject<S>* o1, CollisionObject<S>* o2, void* cdata);
+
 /// @brief Base class for broad phase collision. It helps to accelerate the
 /// collision/distance between N objects. Also support self collision, self
 /// distance and collision/distance with another M objects.
+///
+/// The const queries keep their scratch state on the stack, so any number of
+/// threads may run them concurrently on one manager, as long as no thread
+/// modifies the manager or its objects meanwhile. See BroadPhaseSnapshots for
+/// updating a scene while it is being queried.
 template <typename S>
 class BroadPhaseCollisionManager
 {
@@ -121,15 +146,109 @@ public:
   /// @brief the number of objects managed by the manager
   virtual size_t size() const = 0;
 
+  /// @brief enable or disable the persistent overlap pairs. While enabled,
+  /// the manager keeps the set of pairs of objects whose AABBs overlap across
+  /// update() calls, so that collideIncremental() only reports the changes.
+  /// Only SaPCollisionManager tracks the pairs as its objects move. The other
+  /// managers find all the pairs again with a full self collide() on every
+  /// collideIncremental() and compare them with the previous set. That costs
+  /// more than a plain collide(), and only saves work for the callback.
+  virtual void enablePersistentPairs(bool enable);
+
+  /// @brief whether the persistent overlap pairs are enabled
+  bool isPersistentPairsEnabled() const;
+
+  /// @brief report the pairs of objects whose AABBs started or stopped
+  /// overlapping since the previous call, and make them the new persistent
+  /// pairs. Pairs involving an object that was unregistered in between are
+  /// reported as stopped. Does nothing unless the persistent pairs are
+  /// enabled; the first call after enabling reports all the overlapping pairs
+  /// as started.
+  ///
+  /// The pointer of an object unregistered since the previous call only
+  /// identifies it: the object may have been deleted, so the callback must
+  /// not dereference the pointers of stopped pairs unless the caller keeps
+  /// unregistered objects alive until this call. For the same reason, an
+  /// object deleted and replaced by a new one at the same address in between
+  /// is taken as the same object.
+  virtual void collideIncremental(void* cdata, OverlapEventCallBack<S> callback);
+
+  /// @brief return the persistent pairs as of the last collideIncremental(),
+  /// with the smaller pointer first in each pair
+  virtual void getPersistentPairs(
+      std::vector<std::pair<CollisionObject<S>*, CollisionObject<S>*>>& pairs) const;
+
+  /// @brief the AABB hierarchy the manager keeps over its objects, or nullptr
+  /// if it keeps none. Used to collide with managers of other types.
+  virtual const detail::AABBHierarchy<S>* getAABBHierarchy() const;
+
+  /// @brief an object found by a nearest neighbor or radius query, with its
+  /// distance to the query object
+  using Neighbor = std::pair<S, CollisionObject<S>*>;
+
+  /// @brief find the k objects of the manager nearest to obj, by increasing
+  /// distance. The distance is given by the callback, or is the distance
+  /// between the AABBs if there is no callback. obj itself is never reported.
+  void nearest(CollisionObject<S>* obj, std::size_t k, std::vector<Neighbor>& neighbors,
+               void* cdata = nullptr, ObjectDistanceCallBack<S> callback = nullptr) const;
+
+  /// @brief find the objects of the manager within the radius of obj, by
+  /// increasing distance. The distance is that of nearest().
+  void withinRadius(CollisionObject<S>* obj, S radius, std::vector<Neighbor>& neighbors,
+                    void* cdata = nullptr, ObjectDistanceCallBack<S> callback = nullptr) const;
+
+  /// @brief nearest() for each of the objs, using num_threads threads (the
+  /// callback must then be thread-safe). The queries run in the Morton order
+  /// of the objects, and each one is bounded by the distances to the
+  /// neighbors of the previous one.
+  void nearest(const std::vector<CollisionObject<S>*>& objs, std::size_t k,
+               std::vector<std::vector<Neighbor>>& neighbors,
+               void* cdata = nullptr, ObjectDistanceCallBack<S> callback = nullptr,
+               int num_threads = 1) const;
+
+  /// @brief withinRadius() for each of the objs, using num_threads threads
+  /// (the callback must then be thread-safe)
+  void withinRadius(const std::vector<CollisionObject<S>*>& objs, S radius,
+                    std::vector<std::vector<Neighbor>>& neighbors,
+                    void* cdata = nullptr, ObjectDistanceCallBack<S> callback = nullptr,
+                    int num_threads = 1) const;
+
 protected:
 
+  /// @brief add to neighbors, a max-heap on the distance, the objects nearest
+  /// to obj among those within max_dist of it, keeping at most k of them. The
+  /// default tests all the objects of the manager.
+  virtual void nearest_(CollisionObject<S>* obj, std::size_t k, S max_dist,
+                        std::vector<Neighbor>& neighbors,
+                        void* cdata, ObjectDistanceCallBack<S> callback) const;
+
+  /// @brief the distance beyond which an object cannot enter the neighbors
+  static S neighborBound(const std::vector<Neighbor>& neighbors, std::size_t k, S max_dist);
+
+  /// @brief add candidate to the neighbors of obj if it is near enough, see
+  /// nearest_()
+  static void testNeighbor(CollisionObject<S>* obj, CollisionObject<S>* candidate,
+                           std::size_t k, S max_dist, std::vector<Neighbor>& neighbors,
+                           void* cdata, ObjectDistanceCallBack<S> callback);
+
+  /// @brief perform collision test with the objects of a manager of any type,
+  /// by traversing the AABB hierarchies of the two managers together. A
+  /// manager without a hierarchy of its own gets a temporary one built over
+  /// its objects. The callback gets the objects of this manager first.
+  void collideHierarchies(BroadPhaseCollisionManager* other_manager, void* cdata, CollisionCallBack<S> callback) const;
+
   /// @brief tools help to avoid repeating collision or distance callback for the pairs of objects tested before. It can be useful for some of the broadphase algorithms.
-  mutable std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*> > tested_set;
-  mutable bool enable_tested_set_;
+  /// A query owns its tested set, so that concurrent queries do not share it.
+  using TestedSet = std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*> >;
 
-  bool inTestedSet(CollisionObject<S>* a, CollisionObject<S>* b) const;
+  static bool inTestedSet(const TestedSet& tested_set, CollisionObject<S>* a, CollisionObject<S>* b);
 
-  void insertTestedSet(CollisionObject<S>* a, CollisionObject<S>* b) const;
+  static void insertTestedSet(TestedSet& tested_set, CollisionObject<S>* a, CollisionObject<S>* b);
+
+  /// @brief the overlap pairs reported by the last collideIncremental(). Only
+  /// used by managers that do not track the overlap pairs themselves.
+  std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*> > persistent_pairs;
+  bool enable_persistent_pairs_;
 
 };
 
@@ -145,7 +264,7 @@ using BroadPhaseCollisionManagerd = BroadPhaseCollisionManager<double>;
 //==============================================================================
 template <typename S>
 BroadPhaseCollisionManager<S>::BroadPhaseCollisionManager()
-  : enable_tested_set_(false)
+  : enable_persistent_pairs_(false)
 {
   // Do nothing
 }
@@ -184,7 +303,7 @@ void BroadPhaseCollisionManager<S>::update(
 //==============================================================================
 template <typename S>
 bool BroadPhaseCollisionManager<S>::inTestedSet(
-    CollisionObject<S>* a, CollisionObject<S>* b) const
+    const TestedSet& tested_set, CollisionObject<S>* a, CollisionObject<S>* b)
 {
   if(a < b) return tested_set.find(std::make_pair(a, b)) != tested_set.end();
   else return tested_set.find(std::make_pair(b, a)) != tested_set.end();
@@ -193,12 +312,342 @@ bool BroadPhaseCollisionManager<S>::inTestedSet(
 //==============================================================================
 template <typename S>
 void BroadPhaseCollisionManager<S>::insertTestedSet(
-    CollisionObject<S>* a, CollisionObject<S>* b) const
+    TestedSet& tested_set, CollisionObject<S>* a, CollisionObject<S>* b)
 {
   if(a < b) tested_set.insert(std::make_pair(a, b));
   else tested_set.insert(std::make_pair(b, a));
 }
 
+//==============================================================================
+template <typename S>
+void BroadPhaseCollisionManager<S>::enablePersistentPairs(bool enable)
+{
+  enable_persistent_pairs_ = enable;
+  if(!enable)
+    persistent_pairs.clear();
+}
+
+//==============================================================================
+template <typename S>
+bool BroadPhaseCollisionManager<S>::isPersistentPairsEnabled() const
+{
+  return enable_persistent_pairs_;
+}
+
+namespace detail
+{
+
+//==============================================================================
+/// @brief call func(i, prev) for every index i of objs, where prev is the
+/// index of the object queried before by the same thread, or objs.size() for
+/// its first one. The objects are visited in the Morton order of their AABB
+/// centers, one contiguous run per thread, so that consecutive ones are close.
+template <typename S, typename Func>
+void forEachInMortonOrder(
+    const std::vector<CollisionObject<S>*>& objs, int num_threads, Func func)
+{
+  if(objs.empty()) return;
+
+  AABB<S> bound(objs[0]->getAABB().center());
+  for(auto obj : objs)
+    bound += obj->getAABB().center();
+
+  // a flat bound would quantize with an infinite scale
+  for(int i = 0; i < 3; ++i)
+  {
+    if(!(bound.max_[i] > bound.min_[i]))
+      bound.max_[i] = bound.min_[i] + 1;
+  }
+
+  morton_functor<S, uint32> coder(bound);
+  std::vector<std::pair<uint32, std::size_t>> order(objs.size());
+  for(std::size_t i = 0; i < objs.size(); ++i)
+    order[i] = std::make_pair(coder(objs[i]->getAABB().center()), i);
+  std::sort(order.begin(), order.end());
+
+  num_threads = resolveNumThreads(num_threads);
+  const std::size_t num_runs = std::min(static_cast<std::size_t>(num_threads), objs.size());
+  parallelFor(num_runs, num_threads, [&](std::size_t run, int)
+  {
+    const std::size_t begin = order.size() * run / num_runs;
+    const std::size_t end = order.size() * (run + 1) / num_runs;
+    for(std::size_t i = begin; i < end; ++i)
+      func(order[i].second, (i == begin) ? objs.size() : order[i - 1].second);
+  });
+}
+
+//==============================================================================
+template <typename S>
+bool hierarchyCollisionRecurse(
+    const AABBHierarchy<S>& h1, typename AABBHierarchy<S>::NodeId node1,
+    const AABBHierarchy<S>& h2, typename AABBHierarchy<S>::NodeId node2,
+    void* cdata, CollisionCallBack<S> callback)
+{
+  const AABB<S>& bv1 = h1.getAABB(node1);
+  const AABB<S>& bv2 = h2.getAABB(node2);
+  if(!bv1.overlap(bv2)) return false;
+
+  const bool leaf1 = h1.isLeaf(node1);
+  const bool leaf2 = h2.isLeaf(node2);
+  if(leaf1 && leaf2)
+  {
+    // leaves may hold enlarged AABBs, check the objects' own ones
+    CollisionObject<S>* obj1 = h1.getObject(node1);
+    CollisionObject<S>* obj2 = h2.getObject(node2);
+    if(!obj1->getAABB().overlap(obj2->getAABB())) return false;
+    return callback(obj1, obj2, cdata);
+  }
+
+  if(leaf2 || (!leaf1 && (bv1.size() > bv2.size())))
+  {
+    if(hierarchyCollisionRecurse(h1, h1.getChild(node1, 0), h2, node2, cdata, callback))
+      return true;
+    if(hierarchyCollisionRecurse(h1, h1.getChild(node1, 1), h2, node2, cdata, callback))
+      return true;
+  }
+  else
+  {
+    if(hierarchyCollisionRecurse(h1, node1, h2, h2.getChild(node2, 0), cdata, callback))
+      return true;
+    if(hierarchyCollisionRecurse(h1, node1, h2, h2.getChild(node2, 1), cdata, callback))
+      return true;
+  }
+
+  return false;
+}
+
+//==============================================================================
+template <typename S>
+bool collectOverlapPairs(
+    CollisionObject<S>* o1, CollisionObject<S>* o2, void* cdata)
+{
+  auto* pairs = static_cast<
+      std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*> >*>(cdata);
+
+  if(o1 < o2) pairs->insert(std::make_pair(o1, o2));
+  else pairs->insert(std::make_pair(o2, o1));
+
+  return false;
+}
+
+} // namespace detail
+
+//==============================================================================
+template <typename S>
+void BroadPhaseCollisionManager<S>::collideIncremental(
+    void* cdata, OverlapEventCallBack<S> callback)
+{
+  if(!enable_persistent_pairs_)
+    return;
+
+  // Without incremental tracking of the overlap pairs, find them all again and
+  // compare them with the previous ones
+  std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*> > pairs;
+  collide(&pairs, detail::collectOverlapPairs<S>);
+
+  for(auto it = persistent_pairs.cbegin(), end = persistent_pairs.cend(); it != end; ++it)
+  {
+    if(pairs.find(*it) == pairs.end())
+      callback(it->first, it->second, false, cdata);
+  }
+
+  for(auto it = pairs.cbegin(), end = pairs.cend(); it != end; ++it)
+  {
+    if(persistent_pairs.find(*it) == persistent_pairs.end())
+      callback(it->first, it->second, true, cdata);
+  }
+
+  persistent_pairs.swap(pairs);
+}
+
+//==============================================================================
+template <typename S>
+void BroadPhaseCollisionManager<S>::getPersistentPairs(
+    std::vector<std::pair<CollisionObject<S>*, CollisionObject<S>*>>& pairs) const
+{
+  pairs.assign(persistent_pairs.begin(), persistent_pairs.end());
+}
+
+//==============================================================================
+template <typename S>
+const detail::AABBHierarchy<S>*
+BroadPhaseCollisionManager<S>::getAABBHierarchy() const
+{
+  return nullptr;
+}
+
+//==============================================================================
+template <typename S>
+void BroadPhaseCollisionManager<S>::collideHierarchies(
+    BroadPhaseCollisionManager* other_manager, void* cdata, CollisionCallBack<S> callback) const
+{
+  if(empty() || other_manager->empty()) return;
+
+  std::unique_ptr<detail::ObjectAABBHierarchy<S>> built1;
+  const detail::AABBHierarchy<S>* h1 = getAABBHierarchy();
+  if(!h1)
+  {
+    std::vector<CollisionObject<S>*> objs;
+    getObjects(objs);
+    built1.reset(new detail::ObjectAABBHierarchy<S>(objs));
+    h1 = built1.get();
+  }
+
+  std::unique_ptr<detail::ObjectAABBHierarchy<S>> built2;
+  const detail::AABBHierarchy<S>* h2 = other_manager->getAABBHierarchy();
+  if(!h2)
+  {
+    std::vector<CollisionObject<S>*> objs;
+    other_manager->getObjects(objs);
+    built2.reset(new detail::ObjectAABBHierarchy<S>(objs));
+    h2 = built2.get();
+  }
+
+  if(h1->empty() || h2->empty()) return;
+
+  detail::hierarchyCollisionRecurse(*h1, h1->getRoot(), *h2, h2->getRoot(), cdata, callback);
+}
+
+//==============================================================================
+template <typename S>
+void BroadPhaseCollisionManager<S>::nearest(
+    CollisionObject<S>* obj, std::size_t k, std::vector<Neighbor>& neighbors,
+    void* cdata, ObjectDistanceCallBack<S> callback) const
+{
+  neighbors.clear();
+  if(k == 0 || empty()) return;
+
+  nearest_(obj, k, std::numeric_limits<S>::max(), neighbors, cdata, callback);
+  std::sort_heap(neighbors.begin(), neighbors.end());
+}
+
+//==============================================================================
+template <typename S>
+void BroadPhaseCollisionManager<S>::withinRadius(
+    CollisionObject<S>* obj, S radius, std::vector<Neighbor>& neighbors,
+    void* cdata, ObjectDistanceCallBack<S> callback) const
+{
+  neighbors.clear();
+  if(radius < 0 || empty()) return;
+
+  nearest_(obj, std::numeric_limits<std::size_t>::max(), radius, neighbors, cdata, callback);
+  std::sort_heap(neighbors.begin(), neighbors.end());
+}
+
+//==============================================================================
+template <typename S>
+void BroadPhaseCollisionManager<S>::nearest(
+    const std::vector<CollisionObject<S>*>& objs, std::size_t k,
+    std::vector<std::vector<Neighbor>>& neighbors,
+    void* cdata, ObjectDistanceCallBack<S> callback, int num_threads) const
+{
+  neighbors.resize(objs.size());
+  for(auto& obj_neighbors : neighbors)
+    obj_neighbors.clear();
+  if(k == 0 || empty()) return;
+
+  detail::forEachInMortonOrder(objs, num_threads, [&](std::size_t i, std::size_t prev)
+  {
+    CollisionObject<S>* obj = objs[i];
+
+    // the k neighbors of the previous object, other than obj, bound the
+    // distance to the k-th neighbor of obj
+    S max_dist = std::numeric_limits<S>::max();
+    if(prev < objs.size() && neighbors[prev].size() == k)
+    {
+      std::vector<S> dists;
+      dists.reserve(k);
+      for(const auto& neighbor : neighbors[prev])
+      {
+        if(neighbor.second == obj) break;
+        dists.push_back(callback ? callback(obj, neighbor.second, cdata)
+                                 : obj->getAABB().distance(neighbor.second->getAABB()));
+      }
+
+      if(dists.size() == k)
+        max_dist = *std::max_element(dists.begin(), dists.end());
+    }
+
+    nearest_(obj, k, max_dist, neighbors[i], cdata, callback);
+    std::sort_heap(neighbors[i].begin(), neighbors[i].end());
+  });
+}
+
+//==============================================================================
+template <typename S>
+void BroadPhaseCollisionManager<S>::withinRadius(
+    const std::vector<CollisionObject<S>*>& objs, S radius,
+    std::vector<std::vector<Neighbor>>& neighbors,
+    void* cdata, ObjectDistanceCallBack<S> callback, int num_threads) const
+{
+  neighbors.resize(objs.size());
+  for(auto& obj_neighbors : neighbors)
+    obj_neighbors.clear();
+  if(radius < 0 || empty()) return;
+
+  detail::forEachInMortonOrder(objs, num_threads, [&](std::size_t i, std::size_t)
+  {
+    nearest_(objs[i], std::numeric_limits<std::size_t>::max(), radius, neighbors[i], cdata, callback);
+    std::sort_heap(neighbors[i].begin(), neighbors[i].end());
+  });
+}
+
+//==============================================================================
+template <typename S>
+void BroadPhaseCollisionManager<S>::nearest_(
+    CollisionObject<S>* obj, std::size_t k, S max_dist,
+    std::vector<Neighbor>& neighbors,
+    void* cdata, ObjectDistanceCallBack<S> callback) const
+{
+  std::vector<CollisionObject<S>*> objs;
+  getObjects(objs);
+
+  for(auto candidate : objs)
+    testNeighbor(obj, candidate, k, max_dist, neighbors, cdata, callback);
+}
+
+//==============================================================================
+template <typename S>
+S BroadPhaseCollisionManager<S>::neighborBound(
+    const std::vector<Neighbor>& neighbors, std::size_t k, S max_dist)
+{
+  if(neighbors.size() < k)
+    return max_dist;
+  else
+    return neighbors.front().first;
+}
+
+//==============================================================================
+template <typename S>
+void BroadPhaseCollisionManager<S>::testNeighbor(
+    CollisionObject<S>* obj, CollisionObject<S>* candidate,
+    std::size_t k, S max_dist, std::vector<Neighbor>& neighbors,
+    void* cdata, ObjectDistanceCallBack<S> callback)
+{
+  if(candidate == obj) return;
+
+  const S bound = neighborBound(neighbors, k, max_dist);
+  S dist = obj->getAABB().distance(candidate->getAABB());
+  if(dist > bound) return;
+
+  if(callback)
+  {
+    dist = callback(obj, candidate, cdata);
+    if(dist > bound) return;
+  }
+
+  if(neighbors.size() == k)
+  {
+    if(!(dist < bound)) return;
+
+    std::pop_heap(neighbors.begin(), neighbors.end());
+    neighbors.pop_back();
+  }
+
+  neighbors.emplace_back(dist, candidate);
+  std::push_heap(neighbors.begin(), neighbors.end());
+}
+
 } // namespace fcl
 
 #endif
@@ -42,11 +42,13 @@
 #include <unordered_map>
 #include <functional>
 #include <limits>
+#include "fcl/common/detail/parallel.h"
 #include "fcl/math/bv/utility.h"
 #include "fcl/object/geometry/shape/box.h"
 #include "fcl/object/geometry/shape/construct_box.h"
 #include "fcl/broadphase/broadphase_collision_manager.h"
 #include "fcl/broadphase/detail/hierarchy_tree.h"
+#include "fcl/broadphase/detail/parallel_self_collision.h"
 #if FCL_HAVE_OCTOMAP
 #include "fcl/object/geometry/octree/octree.h"
 #endif
@@ -54,6 +56,45 @@
 namespace fcl
 {
 
+namespace detail
+{
+
+namespace dynamic_AABB_tree
+{
+
+/// @brief AABBHierarchy view of the tree of a DynamicAABBTreeCollisionManager
+template <typename S>
+class TreeAABBHierarchy : public AABBHierarchy<S>
+{
+public:
+
+  using NodeId = typename AABBHierarchy<S>::NodeId;
+
+  TreeAABBHierarchy(const HierarchyTree<AABB<S>>& tree);
+
+  bool empty() const override;
+
+  NodeId getRoot() const override;
+
+  bool isLeaf(NodeId node) const override;
+
+  NodeId getChild(NodeId node, int i) const override;
+
+  const AABB<S>& getAABB(NodeId node) const override;
+
+  CollisionObject<S>* getObject(NodeId node) const override;
+
+private:
+
+  static const NodeBase<AABB<S>>* toNode(NodeId node);
+
+  const HierarchyTree<AABB<S>>& tree;
+};
+
+} // namespace dynamic_AABB_tree
+
+} // namespace detail
+
 template <typename S>
 class DynamicAABBTreeCollisionManager : public BroadPhaseCollisionManager<S>
 {
@@ -71,6 +112,11 @@ public:
   bool octree_as_geometry_collide;
   bool octree_as_geometry_distance;
 
+  /// @brief the margin the leaf AABBs are enlarged by. A leaf is only moved
+  /// in the tree once the object's AABB escapes it, so objects that jitter
+  /// within the margin cost no restructuring.
+  S fat_aabb_margin;
+
   DynamicAABBTreeCollisionManager();
 
   /// @brief add objects to the manager
@@ -109,6 +155,19 @@ public:
   /// @brief perform collision test for the objects belonging to the manager (i.e., N^2 self collision)
   void collide(void* cdata, CollisionCallBack<S> callback) const;
 
+  /// @brief perform self collision test using cdata.size() threads, one
+  /// callback data per thread. The tree traversal is split into independent
+  /// subtree pairs that collect the candidate pairs in parallel, and the
+  /// callbacks then run as in detail::parallelSelfCollide(): thread t calls
+  /// callback only with cdata[t], and sees its pairs in the order of the serial
+  /// traversal. The callback must be safe to call concurrently with distinct
+  /// cdata. Each cdata has its own stop criterion, so that the merged results
+  /// only match the serial collide() when no callback returns true; with
+  /// CollisionRequest::num_max_contacts = 1, for instance, each cdata may get
+  /// a contact. All the candidate pairs are collected before the first
+  /// callback runs.
+  void collide(const std::vector<void*>& cdata, CollisionCallBack<S> callback) const;
+
   /// @brief perform distance test for the objects belonging to the manager (i.e., N^2 self distance)
   void distance(void* cdata, DistanceCallBack<S> callback) const;
 
@@ -126,13 +185,38 @@ public:
 
   const detail::HierarchyTree<AABB<S>>& getTree() const;
 
+  const detail::AABBHierarchy<S>* getAABBHierarchy() const override;
+
+  /// @brief set the expected displacement of an object until its next update.
+  /// The leaf AABB of the object is extended along it when the object's AABB
+  /// escapes the leaf; a zero displacement removes the hint.
+  void setVelocityHint(CollisionObject<S>* obj, const Vector3<S>& vel);
+
 private:
   detail::HierarchyTree<AABB<S>> dtree;
   std::unordered_map<CollisionObject<S>*, DynamicAABBNode*> table;
+  std::unordered_map<CollisionObject<S>*, Vector3<S>> velocity_hints;
+  detail::dynamic_AABB_tree::TreeAABBHierarchy<S> hierarchy;
 
   bool setup_;
 
   void update_(CollisionObject<S>* updated_obj);
+
+  /// @brief whether the leaf AABBs are enlarged
+  bool useFatAABB_() const;
+
+  /// @brief the velocity hint of an object, zero if it has none
+  Vector3<S> velocityHint_(CollisionObject<S>* obj) const;
+
+  /// @brief the leaf AABB of an object
+  AABB<S> fatAABB_(CollisionObject<S>* obj) const;
+
+  using Neighbor = typename BroadPhaseCollisionManager<S>::Neighbor;
+
+  /// @brief visits the nodes best first, nearest to obj first
+  void nearest_(CollisionObject<S>* obj, std::size_t k, S max_dist,
+                std::vector<Neighbor>& neighbors,
+                void* cdata, ObjectDistanceCallBack<S> callback) const override;
 };
 
 using DynamicAABBTreeCollisionManagerf = DynamicAABBTreeCollisionManager<float>;
@@ -587,7 +671,12 @@ bool collisionRecurse(
   if(root1->isLeaf() && root2->isLeaf())
   {
     if(!root1->bv.overlap(root2->bv)) return false;
-    return callback(static_cast<CollisionObject<S>*>(root1->data), static_cast<CollisionObject<S>*>(root2->data), cdata);
+
+    // leaves may hold enlarged AABBs, check the objects' own ones
+    CollisionObject<S>* obj1 = static_cast<CollisionObject<S>*>(root1->data);
+    CollisionObject<S>* obj2 = static_cast<CollisionObject<S>*>(root2->data);
+    if(!obj1->getAABB().overlap(obj2->getAABB())) return false;
+    return callback(obj1, obj2, cdata);
   }
 
   if(!root1->bv.overlap(root2->bv)) return false;
@@ -615,8 +704,9 @@ bool collisionRecurse(typename DynamicAABBTreeCollisionManager<S>::DynamicAABBNo
 {
   if(root->isLeaf())
   {
-    if(!root->bv.overlap(query->getAABB())) return false;
-    return callback(static_cast<CollisionObject<S>*>(root->data), query, cdata);
+    CollisionObject<S>* obj = static_cast<CollisionObject<S>*>(root->data);
+    if(!obj->getAABB().overlap(query->getAABB())) return false;
+    return callback(obj, query, cdata);
   }
 
   if(!root->bv.overlap(query->getAABB())) return false;
@@ -650,6 +740,81 @@ bool selfCollisionRecurse(typename DynamicAABBTreeCollisionManager<S>::DynamicAA
   return false;
 }
 
+//==============================================================================
+/// @brief Independent piece of the self collision traversal: self collision
+/// within node1 if node2 is nullptr, otherwise collision between the subtrees
+/// node1 and node2.
+template <typename S>
+struct SelfCollisionTask
+{
+  typename DynamicAABBTreeCollisionManager<S>::DynamicAABBNode* node1;
+  typename DynamicAABBTreeCollisionManager<S>::DynamicAABBNode* node2;
+};
+
+//==============================================================================
+/// @brief Unfold the top of the self collision traversal of root until there
+/// are at least min_num_tasks tasks (or nothing left to unfold). The tasks are
+/// kept in the order selfCollisionRecurse would visit them.
+template <typename S>
+void splitSelfCollisionTasks(
+    typename DynamicAABBTreeCollisionManager<S>::DynamicAABBNode* root,
+    std::size_t min_num_tasks,
+    std::vector<SelfCollisionTask<S>>& tasks)
+{
+  tasks.clear();
+  if(root->isLeaf()) return;
+  tasks.push_back({root, nullptr});
+
+  std::vector<SelfCollisionTask<S>> next_tasks;
+  bool unfolded = true;
+  while(unfolded && tasks.size() < min_num_tasks)
+  {
+    unfolded = false;
+    next_tasks.clear();
+    next_tasks.reserve(3 * tasks.size());
+
+    for(const auto& task : tasks)
+    {
+      auto* node1 = task.node1;
+      auto* node2 = task.node2;
+
+      if(!node2)
+      {
+        if(!node1->children[0]->isLeaf())
+          next_tasks.push_back({node1->children[0], nullptr});
+        if(!node1->children[1]->isLeaf())
+          next_tasks.push_back({node1->children[1], nullptr});
+        next_tasks.push_back({node1->children[0], node1->children[1]});
+        unfolded = true;
+      }
+      else if(!node1->bv.overlap(node2->bv))
+      {
+        unfolded = true;
+      }
+      else if(node1->isLeaf() && node2->isLeaf())
+      {
+        next_tasks.push_back(task);
+      }
+      else
+      {
+        if(node2->isLeaf() || (!node1->isLeaf() && (node1->bv.size() > node2->bv.size())))
+        {
+          next_tasks.push_back({node1->children[0], node2});
+          next_tasks.push_back({node1->children[1], node2});
+        }
+        else
+        {
+          next_tasks.push_back({node1, node2->children[0]});
+          next_tasks.push_back({node1, node2->children[1]});
+        }
+        unfolded = true;
+      }
+    }
+
+    tasks.swap(next_tasks);
+  }
+}
+
 //==============================================================================
 template <typename S>
 bool distanceRecurse(
@@ -801,6 +966,64 @@ bool selfDistanceRecurse(typename DynamicAABBTreeCollisionManager<S>::DynamicAAB
   return false;
 }
 
+//==============================================================================
+template <typename S>
+TreeAABBHierarchy<S>::TreeAABBHierarchy(const HierarchyTree<AABB<S>>& tree)
+  : tree(tree)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template <typename S>
+bool TreeAABBHierarchy<S>::empty() const
+{
+  return tree.empty();
+}
+
+//==============================================================================
+template <typename S>
+typename TreeAABBHierarchy<S>::NodeId TreeAABBHierarchy<S>::getRoot() const
+{
+  return reinterpret_cast<NodeId>(tree.getRoot());
+}
+
+//==============================================================================
+template <typename S>
+bool TreeAABBHierarchy<S>::isLeaf(NodeId node) const
+{
+  return toNode(node)->isLeaf();
+}
+
+//==============================================================================
+template <typename S>
+typename TreeAABBHierarchy<S>::NodeId TreeAABBHierarchy<S>::getChild(
+    NodeId node, int i) const
+{
+  return reinterpret_cast<NodeId>(toNode(node)->children[i]);
+}
+
+//==============================================================================
+template <typename S>
+const AABB<S>& TreeAABBHierarchy<S>::getAABB(NodeId node) const
+{
+  return toNode(node)->bv;
+}
+
+//==============================================================================
+template <typename S>
+CollisionObject<S>* TreeAABBHierarchy<S>::getObject(NodeId node) const
+{
+  return static_cast<CollisionObject<S>*>(toNode(node)->data);
+}
+
+//==============================================================================
+template <typename S>
+const NodeBase<AABB<S>>* TreeAABBHierarchy<S>::toNode(NodeId node)
+{
+  return reinterpret_cast<const NodeBase<AABB<S>>*>(node);
+}
+
 } // namespace dynamic_AABB_tree
 
 } // namespace detail
@@ -809,7 +1032,8 @@ bool selfDistanceRecurse(typename DynamicAABBTreeCollisionManager<S>::DynamicAAB
 template <typename S>
 DynamicAABBTreeCollisionManager<S>::DynamicAABBTreeCollisionManager()
   : tree_topdown_balance_threshold(dtree.bu_threshold),
-    tree_topdown_level(dtree.topdown_level)
+    tree_topdown_level(dtree.topdown_level),
+    hierarchy(dtree)
 {
   max_tree_nonbalanced_level = 10;
   tree_incremental_balance_pass = 10;
@@ -821,6 +1045,8 @@ DynamicAABBTreeCollisionManager<S>::DynamicAABBTreeCollisionManager()
   // from experiment, this is the optimal setting
   octree_as_geometry_collide = true;
   octree_as_geometry_distance = false;
+
+  fat_aabb_margin = 0;
 }
 
 //==============================================================================
@@ -841,7 +1067,7 @@ void DynamicAABBTreeCollisionManager<S>::registerObjects(
     for(size_t i = 0, size = other_objs.size(); i < size; ++i)
     {
       DynamicAABBNode* node = new DynamicAABBNode; // node will be managed by the dtree
-      node->bv = other_objs[i]->getAABB();
+      node->bv = fatAABB_(other_objs[i]);
       node->parent = nullptr;
       node->children[1] = nullptr;
       node->data = other_objs[i];
@@ -859,7 +1085,7 @@ void DynamicAABBTreeCollisionManager<S>::registerObjects(
 template <typename S>
 void DynamicAABBTreeCollisionManager<S>::registerObject(CollisionObject<S>* obj)
 {
-  DynamicAABBNode* node = dtree.insert(obj->getAABB(), obj);
+  DynamicAABBNode* node = dtree.insert(fatAABB_(obj), obj);
   table[obj] = node;
 }
 
@@ -869,6 +1095,7 @@ void DynamicAABBTreeCollisionManager<S>::unregisterObject(CollisionObject<S>* ob
 {
   DynamicAABBNode* node = table[obj];
   table.erase(obj);
+  velocity_hints.erase(obj);
   dtree.remove(node);
 }
 
@@ -901,11 +1128,32 @@ void DynamicAABBTreeCollisionManager<S>::setup()
 template <typename S>
 void DynamicAABBTreeCollisionManager<S>::update()
 {
-  for(auto it = table.cbegin(); it != table.cend(); ++it)
+  if(useFatAABB_())
   {
-    CollisionObject<S>* obj = it->first;
-    DynamicAABBNode* node = it->second;
-    node->bv = obj->getAABB();
+    // only the leaves the objects escaped are enlarged again
+    bool changed = false;
+    for(auto it = table.cbegin(); it != table.cend(); ++it)
+    {
+      CollisionObject<S>* obj = it->first;
+      DynamicAABBNode* node = it->second;
+      if(!node->bv.contain(obj->getAABB()))
+      {
+        node->bv = fatAABB_(obj);
+        changed = true;
+      }
+    }
+
+    if(!changed)
+      return;
+  }
+  else
+  {
+    for(auto it = table.cbegin(); it != table.cend(); ++it)
+    {
+      CollisionObject<S>* obj = it->first;
+      DynamicAABBNode* node = it->second;
+      node->bv = obj->getAABB();
+    }
   }
 
   dtree.refit();
@@ -922,10 +1170,76 @@ void DynamicAABBTreeCollisionManager<S>::update_(CollisionObject<S>* updated_obj
   if(it != table.end())
   {
     DynamicAABBNode* node = it->second;
-    if(!node->bv.equal(updated_obj->getAABB()))
-      dtree.update(node, updated_obj->getAABB());
+    const AABB<S>& aabb = updated_obj->getAABB();
+    if(node->bv.equal(aabb))
+      return;
+
+    if(useFatAABB_())
+    {
+      if(dtree.update(node, aabb, velocityHint_(updated_obj), fat_aabb_margin))
+        setup_ = false;
+    }
+    else
+    {
+      // without fat AABBs the leaf tracks the object's AABB exactly, so it is
+      // also reinserted when that shrinks
+      if(!dtree.update(node, aabb))
+      {
+        node->bv = aabb;
+        dtree.update(node);
+      }
+      setup_ = false;
+    }
+  }
+}
+
+//==============================================================================
+template <typename S>
+void DynamicAABBTreeCollisionManager<S>::nearest_(
+    CollisionObject<S>* obj, std::size_t k, S max_dist,
+    std::vector<Neighbor>& neighbors,
+    void* cdata, ObjectDistanceCallBack<S> callback) const
+{
+  if(dtree.empty()) return;
+
+  const AABB<S>& aabb = obj->getAABB();
+
+  // the nodes to visit, in a min-heap on their distance to obj
+  using NodeDistance = std::pair<S, const DynamicAABBNode*>;
+  auto farther = [](const NodeDistance& a, const NodeDistance& b)
+  {
+    return a.first > b.first;
+  };
+  std::vector<NodeDistance> queue;
+  queue.emplace_back(dtree.getRoot()->bv.distance(aabb), dtree.getRoot());
+
+  while(!queue.empty())
+  {
+    std::pop_heap(queue.begin(), queue.end(), farther);
+    const NodeDistance next = queue.back();
+    queue.pop_back();
+
+    const S bound = this->neighborBound(neighbors, k, max_dist);
+    if(next.first > bound) break;
+
+    const DynamicAABBNode* node = next.second;
+    if(node->isLeaf())
+    {
+      this->testNeighbor(obj, static_cast<CollisionObject<S>*>(node->data),
+                         k, max_dist, neighbors, cdata, callback);
+      continue;
+    }
+
+    for(int i = 0; i < 2; ++i)
+    {
+      const S dist = node->children[i]->bv.distance(aabb);
+      if(dist <= bound)
+      {
+        queue.emplace_back(dist, node->children[i]);
+        std::push_heap(queue.begin(), queue.end(), farther);
+      }
+    }
   }
-  setup_ = false;
 }
 
 //==============================================================================
@@ -951,6 +1265,7 @@ void DynamicAABBTreeCollisionManager<S>::clear()
 {
   dtree.clear();
   table.clear();
+  velocity_hints.clear();
 }
 
 //==============================================================================
@@ -1020,6 +1335,31 @@ void DynamicAABBTreeCollisionManager<S>::collide(void* cdata, CollisionCallBack<
   detail::dynamic_AABB_tree::selfCollisionRecurse(dtree.getRoot(), cdata, callback);
 }
 
+//==============================================================================
+template <typename S>
+void DynamicAABBTreeCollisionManager<S>::collide(
+    const std::vector<void*>& cdata, CollisionCallBack<S> callback) const
+{
+  if(size() == 0 || cdata.empty()) return;
+
+  // Collect the leaf pairs with overlapping AABBs, a few tasks per thread so
+  // that unbalanced subtrees are picked up by idle threads
+  std::vector<detail::dynamic_AABB_tree::SelfCollisionTask<S>> tasks;
+  detail::dynamic_AABB_tree::splitSelfCollisionTasks<S>(
+        dtree.getRoot(), 16 * cdata.size(), tasks);
+
+  detail::parallelSelfCollide<S>(tasks.size(), [&](std::size_t i, void* pairs)
+  {
+    const auto& task = tasks[i];
+    if(task.node2)
+      detail::dynamic_AABB_tree::collisionRecurse<S>(
+            task.node1, task.node2, pairs, detail::collectPairs<S>);
+    else
+      detail::dynamic_AABB_tree::selfCollisionRecurse<S>(
+            task.node1, pairs, detail::collectPairs<S>);
+  }, cdata, callback);
+}
+
 //==============================================================================
 template <typename S>
 void DynamicAABBTreeCollisionManager<S>::distance(void* cdata, DistanceCallBack<S> callback) const
@@ -1033,7 +1373,12 @@ void DynamicAABBTreeCollisionManager<S>::distance(void* cdata, DistanceCallBack<
 template <typename S>
 void DynamicAABBTreeCollisionManager<S>::collide(BroadPhaseCollisionManager<S>* other_manager_, void* cdata, CollisionCallBack<S> callback) const
 {
-  DynamicAABBTreeCollisionManager* other_manager = static_cast<DynamicAABBTreeCollisionManager*>(other_manager_);
+  DynamicAABBTreeCollisionManager* other_manager = dynamic_cast<DynamicAABBTreeCollisionManager*>(other_manager_);
+  if(!other_manager)
+  {
+    this->collideHierarchies(other_manager_, cdata, callback);
+    return;
+  }
   if((size() == 0) || (other_manager->size() == 0)) return;
   detail::dynamic_AABB_tree::collisionRecurse(dtree.getRoot(), other_manager->dtree.getRoot(), cdata, callback);
 }
@@ -1070,6 +1415,51 @@ DynamicAABBTreeCollisionManager<S>::getTree() const
   return dtree;
 }
 
+//==============================================================================
+template <typename S>
+const detail::AABBHierarchy<S>*
+DynamicAABBTreeCollisionManager<S>::getAABBHierarchy() const
+{
+  return &hierarchy;
+}
+
+//==============================================================================
+template <typename S>
+void DynamicAABBTreeCollisionManager<S>::setVelocityHint(
+    CollisionObject<S>* obj, const Vector3<S>& vel)
+{
+  if(vel.isZero())
+    velocity_hints.erase(obj);
+  else
+    velocity_hints[obj] = vel;
+}
+
+//==============================================================================
+template <typename S>
+bool DynamicAABBTreeCollisionManager<S>::useFatAABB_() const
+{
+  return (fat_aabb_margin > 0) || !velocity_hints.empty();
+}
+
+//==============================================================================
+template <typename S>
+Vector3<S> DynamicAABBTreeCollisionManager<S>::velocityHint_(
+    CollisionObject<S>* obj) const
+{
+  if(velocity_hints.empty())
+    return Vector3<S>::Zero();
+
+  const auto it = velocity_hints.find(obj);
+  return (it != velocity_hints.end()) ? it->second : Vector3<S>::Zero();
+}
+
+//==============================================================================
+template <typename S>
+AABB<S> DynamicAABBTreeCollisionManager<S>::fatAABB_(CollisionObject<S>* obj) const
+{
+  return detail::fatBV(obj->getAABB(), velocityHint_(obj), fat_aabb_margin);
+}
+
 } // namespace fcl
 
 #endif
@@ -46,6 +46,7 @@
 #include "fcl/object/geometry/shape/construct_box.h"
 #include "fcl/broadphase/broadphase_collision_manager.h"
 #include "fcl/broadphase/detail/hierarchy_tree_array.h"
+#include "fcl/common/detail/parallel.h"
 #if FCL_HAVE_OCTOMAP
 #include "fcl/object/geometry/octree/octree.h"
 #endif
@@ -53,6 +54,44 @@
 namespace fcl
 {
 
+namespace detail
+{
+
+namespace dynamic_AABB_tree_array
+{
+
+/// @brief AABBHierarchy view of the tree of a
+/// DynamicAABBTreeCollisionManager_Array
+template <typename S>
+class TreeAABBHierarchy : public AABBHierarchy<S>
+{
+public:
+
+  using NodeId = typename AABBHierarchy<S>::NodeId;
+
+  TreeAABBHierarchy(const implementation_array::HierarchyTree<AABB<S>>& tree);
+
+  bool empty() const override;
+
+  NodeId getRoot() const override;
+
+  bool isLeaf(NodeId node) const override;
+
+  NodeId getChild(NodeId node, int i) const override;
+
+  const AABB<S>& getAABB(NodeId node) const override;
+
+  CollisionObject<S>* getObject(NodeId node) const override;
+
+private:
+
+  const implementation_array::HierarchyTree<AABB<S>>& tree;
+};
+
+} // namespace dynamic_AABB_tree_array
+
+} // namespace detail
+
 template <typename S>
 class DynamicAABBTreeCollisionManager_Array : public BroadPhaseCollisionManager<S>
 {
@@ -69,6 +108,20 @@ public:
 
   bool octree_as_geometry_collide;
   bool octree_as_geometry_distance;
+
+  /// @brief whether update() refits the tree in parallel and improves it with
+  /// local rotations, instead of refitting it serially and rebalancing it.
+  /// Meant for frames where most of the objects move.
+  bool parallel_update;
+
+  /// @brief the number of threads of the parallel update, non-positive for
+  /// the hardware concurrency
+  int num_threads;
+
+  /// @brief the margin the leaf AABBs are enlarged by. A leaf is only moved
+  /// in the tree once the object's AABB escapes it, so objects that jitter
+  /// within the margin cost no restructuring.
+  S fat_aabb_margin;
   
   DynamicAABBTreeCollisionManager_Array();
 
@@ -125,13 +178,50 @@ public:
 
   const detail::implementation_array::HierarchyTree<AABB<S>>& getTree() const;
 
+  const detail::AABBHierarchy<S>* getAABBHierarchy() const override;
+
+  /// @brief the SAH cost of the tree refit by the last parallel update, before
+  /// the rotations
+  S getSAHCostBeforeUpdate() const;
+
+  /// @brief the SAH cost of the tree after the last parallel update
+  S getSAHCostAfterUpdate() const;
+
+  /// @brief set the expected displacement of an object until its next update.
+  /// The leaf AABB of the object is extended along it when the object's AABB
+  /// escapes the leaf; a zero displacement removes the hint.
+  void setVelocityHint(CollisionObject<S>* obj, const Vector3<S>& vel);
+
 private:
   detail::implementation_array::HierarchyTree<AABB<S>> dtree;
   std::unordered_map<CollisionObject<S>*, size_t> table;
+  std::unordered_map<CollisionObject<S>*, Vector3<S>> velocity_hints;
+  detail::dynamic_AABB_tree_array::TreeAABBHierarchy<S> hierarchy;
 
   bool setup_;
 
+  S sah_cost_before_update;
+  S sah_cost_after_update;
+
   void update_(CollisionObject<S>* updated_obj);
+
+  void parallelUpdate_();
+
+  /// @brief whether the leaf AABBs are enlarged
+  bool useFatAABB_() const;
+
+  /// @brief the velocity hint of an object, zero if it has none
+  Vector3<S> velocityHint_(CollisionObject<S>* obj) const;
+
+  /// @brief the leaf AABB of an object
+  AABB<S> fatAABB_(CollisionObject<S>* obj) const;
+
+  using Neighbor = typename BroadPhaseCollisionManager<S>::Neighbor;
+
+  /// @brief visits the nodes best first, nearest to obj first
+  void nearest_(CollisionObject<S>* obj, std::size_t k, S max_dist,
+                std::vector<Neighbor>& neighbors,
+                void* cdata, ObjectDistanceCallBack<S> callback) const override;
 };
 
 using DynamicAABBTreeCollisionManager_Arrayf = DynamicAABBTreeCollisionManager_Array<float>;
@@ -561,7 +651,12 @@ bool collisionRecurse(typename DynamicAABBTreeCollisionManager_Array<S>::Dynamic
   if(root1->isLeaf() && root2->isLeaf())
   {
     if(!root1->bv.overlap(root2->bv)) return false;
-    return callback(static_cast<CollisionObject<S>*>(root1->data), static_cast<CollisionObject<S>*>(root2->data), cdata);
+
+    // leaves may hold enlarged AABBs, check the objects' own ones
+    CollisionObject<S>* obj1 = static_cast<CollisionObject<S>*>(root1->data);
+    CollisionObject<S>* obj2 = static_cast<CollisionObject<S>*>(root2->data);
+    if(!obj1->getAABB().overlap(obj2->getAABB())) return false;
+    return callback(obj1, obj2, cdata);
   }
 
   if(!root1->bv.overlap(root2->bv)) return false;
@@ -590,8 +685,9 @@ bool collisionRecurse(typename DynamicAABBTreeCollisionManager_Array<S>::Dynamic
   typename DynamicAABBTreeCollisionManager_Array<S>::DynamicAABBNode* root = nodes + root_id;
   if(root->isLeaf())
   {
-    if(!root->bv.overlap(query->getAABB())) return false;
-    return callback(static_cast<CollisionObject<S>*>(root->data), query, cdata);
+    CollisionObject<S>* obj = static_cast<CollisionObject<S>*>(root->data);
+    if(!obj->getAABB().overlap(query->getAABB())) return false;
+    return callback(obj, query, cdata);
   }
 
   if(!root->bv.overlap(query->getAABB())) return false;
@@ -803,6 +899,58 @@ bool distanceRecurse(typename DynamicAABBTreeCollisionManager_Array<S>::DynamicA
 
 #endif
 
+//==============================================================================
+template <typename S>
+TreeAABBHierarchy<S>::TreeAABBHierarchy(
+    const implementation_array::HierarchyTree<AABB<S>>& tree)
+  : tree(tree)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template <typename S>
+bool TreeAABBHierarchy<S>::empty() const
+{
+  return tree.empty();
+}
+
+//==============================================================================
+template <typename S>
+typename TreeAABBHierarchy<S>::NodeId TreeAABBHierarchy<S>::getRoot() const
+{
+  return tree.getRoot();
+}
+
+//==============================================================================
+template <typename S>
+bool TreeAABBHierarchy<S>::isLeaf(NodeId node) const
+{
+  return tree.getNodes()[node].isLeaf();
+}
+
+//==============================================================================
+template <typename S>
+typename TreeAABBHierarchy<S>::NodeId TreeAABBHierarchy<S>::getChild(
+    NodeId node, int i) const
+{
+  return tree.getNodes()[node].children[i];
+}
+
+//==============================================================================
+template <typename S>
+const AABB<S>& TreeAABBHierarchy<S>::getAABB(NodeId node) const
+{
+  return tree.getNodes()[node].bv;
+}
+
+//==============================================================================
+template <typename S>
+CollisionObject<S>* TreeAABBHierarchy<S>::getObject(NodeId node) const
+{
+  return static_cast<CollisionObject<S>*>(tree.getNodes()[node].data);
+}
+
 } // namespace dynamic_AABB_tree_array
 
 } // namespace detail
@@ -811,7 +959,8 @@ bool distanceRecurse(typename DynamicAABBTreeCollisionManager_Array<S>::DynamicA
 template <typename S>
 DynamicAABBTreeCollisionManager_Array<S>::DynamicAABBTreeCollisionManager_Array()
   : tree_topdown_balance_threshold(dtree.bu_threshold),
-    tree_topdown_level(dtree.topdown_level)
+    tree_topdown_level(dtree.topdown_level),
+    hierarchy(dtree)
 {
   max_tree_nonbalanced_level = 10;
   tree_incremental_balance_pass = 10;
@@ -823,6 +972,12 @@ DynamicAABBTreeCollisionManager_Array<S>::DynamicAABBTreeCollisionManager_Array(
   // from experiment, this is the optimal setting
   octree_as_geometry_collide = true;
   octree_as_geometry_distance = false;
+
+  parallel_update = false;
+  num_threads = 1;
+  fat_aabb_margin = 0;
+  sah_cost_before_update = 0;
+  sah_cost_after_update = 0;
 }
 
 //==============================================================================
@@ -842,7 +997,7 @@ void DynamicAABBTreeCollisionManager_Array<S>::registerObjects(
     table.rehash(other_objs.size());
     for(size_t i = 0, size = other_objs.size(); i < size; ++i)
     {
-      leaves[i].bv = other_objs[i]->getAABB();
+      leaves[i].bv = fatAABB_(other_objs[i]);
       leaves[i].parent = dtree.NULL_NODE;
       leaves[i].children[1] = dtree.NULL_NODE;
       leaves[i].data = other_objs[i];
@@ -861,7 +1016,7 @@ void DynamicAABBTreeCollisionManager_Array<S>::registerObjects(
 template <typename S>
 void DynamicAABBTreeCollisionManager_Array<S>::registerObject(CollisionObject<S>* obj)
 {
-  size_t node = dtree.insert(obj->getAABB(), obj);
+  size_t node = dtree.insert(fatAABB_(obj), obj);
   table[obj] = node;
 }
 
@@ -871,6 +1026,7 @@ void DynamicAABBTreeCollisionManager_Array<S>::unregisterObject(CollisionObject<
 {
   size_t node = table[obj];
   table.erase(obj);
+  velocity_hints.erase(obj);
   dtree.remove(node);
 }
 
@@ -903,11 +1059,38 @@ void DynamicAABBTreeCollisionManager_Array<S>::setup()
 template <typename S>
 void DynamicAABBTreeCollisionManager_Array<S>::update()
 {
-  for(auto it = table.cbegin(), end = table.cend(); it != end; ++it)
+  if(parallel_update)
   {
-    const CollisionObject<S>* obj = it->first;
-    size_t node = it->second;
-    dtree.getNodes()[node].bv = obj->getAABB();
+    parallelUpdate_();
+    return;
+  }
+
+  if(useFatAABB_())
+  {
+    // only the leaves the objects escaped are enlarged again
+    bool changed = false;
+    for(auto it = table.cbegin(), end = table.cend(); it != end; ++it)
+    {
+      CollisionObject<S>* obj = it->first;
+      DynamicAABBNode& leaf = dtree.getNodes()[it->second];
+      if(!leaf.bv.contain(obj->getAABB()))
+      {
+        leaf.bv = fatAABB_(obj);
+        changed = true;
+      }
+    }
+
+    if(!changed)
+      return;
+  }
+  else
+  {
+    for(auto it = table.cbegin(), end = table.cend(); it != end; ++it)
+    {
+      const CollisionObject<S>* obj = it->first;
+      size_t node = it->second;
+      dtree.getNodes()[node].bv = obj->getAABB();
+    }
   }
 
   dtree.refit();
@@ -916,6 +1099,45 @@ void DynamicAABBTreeCollisionManager_Array<S>::update()
   setup();
 }
 
+//==============================================================================
+template <typename S>
+void DynamicAABBTreeCollisionManager_Array<S>::parallelUpdate_()
+{
+  std::vector<size_t> leaves;
+  dtree.getLeaves(leaves);
+
+  DynamicAABBNode* nodes = dtree.getNodes();
+  const bool fat = useFatAABB_();
+  std::atomic<bool> changed(!fat);
+  const size_t block_size = 256;
+  const size_t num_blocks = (leaves.size() + block_size - 1) / block_size;
+  detail::parallelFor(num_blocks, num_threads, [&](size_t block, int)
+  {
+    const size_t end = std::min(leaves.size(), (block + 1) * block_size);
+    for(size_t i = block * block_size; i < end; ++i)
+    {
+      DynamicAABBNode& leaf = nodes[leaves[i]];
+      CollisionObject<S>* obj = static_cast<CollisionObject<S>*>(leaf.data);
+      if(!fat)
+      {
+        leaf.bv = obj->getAABB();
+      }
+      else if(!leaf.bv.contain(obj->getAABB()))
+      {
+        leaf.bv = fatAABB_(obj);
+        changed.store(true, std::memory_order_relaxed);
+      }
+    }
+  });
+
+  // nothing to refit if every object stayed within its leaf
+  if(!changed.load())
+    return;
+
+  dtree.refitAndRotate(leaves, num_threads, sah_cost_before_update, sah_cost_after_update);
+  setup_ = true;
+}
+
 //==============================================================================
 template <typename S>
 void DynamicAABBTreeCollisionManager_Array<S>::update_(CollisionObject<S>* updated_obj)
@@ -924,10 +1146,77 @@ void DynamicAABBTreeCollisionManager_Array<S>::update_(CollisionObject<S>* updat
   if(it != table.end())
   {
     size_t node = it->second;
-    if(!dtree.getNodes()[node].bv.equal(updated_obj->getAABB()))
-      dtree.update(node, updated_obj->getAABB());
+    const AABB<S>& aabb = updated_obj->getAABB();
+    if(dtree.getNodes()[node].bv.equal(aabb))
+      return;
+
+    if(useFatAABB_())
+    {
+      if(dtree.update(node, aabb, velocityHint_(updated_obj), fat_aabb_margin))
+        setup_ = false;
+    }
+    else
+    {
+      // without fat AABBs the leaf tracks the object's AABB exactly, so it is
+      // also reinserted when that shrinks
+      if(!dtree.update(node, aabb))
+      {
+        dtree.getNodes()[node].bv = aabb;
+        dtree.update(node);
+      }
+      setup_ = false;
+    }
+  }
+}
+
+//==============================================================================
+template <typename S>
+void DynamicAABBTreeCollisionManager_Array<S>::nearest_(
+    CollisionObject<S>* obj, std::size_t k, S max_dist,
+    std::vector<Neighbor>& neighbors,
+    void* cdata, ObjectDistanceCallBack<S> callback) const
+{
+  if(dtree.empty()) return;
+
+  const AABB<S>& aabb = obj->getAABB();
+  const DynamicAABBNode* nodes = dtree.getNodes();
+
+  // the nodes to visit, in a min-heap on their distance to obj
+  using NodeDistance = std::pair<S, size_t>;
+  auto farther = [](const NodeDistance& a, const NodeDistance& b)
+  {
+    return a.first > b.first;
+  };
+  std::vector<NodeDistance> queue;
+  queue.emplace_back(nodes[dtree.getRoot()].bv.distance(aabb), dtree.getRoot());
+
+  while(!queue.empty())
+  {
+    std::pop_heap(queue.begin(), queue.end(), farther);
+    const NodeDistance next = queue.back();
+    queue.pop_back();
+
+    const S bound = this->neighborBound(neighbors, k, max_dist);
+    if(next.first > bound) break;
+
+    const DynamicAABBNode* node = nodes + next.second;
+    if(node->isLeaf())
+    {
+      this->testNeighbor(obj, static_cast<CollisionObject<S>*>(node->data),
+                         k, max_dist, neighbors, cdata, callback);
+      continue;
+    }
+
+    for(int i = 0; i < 2; ++i)
+    {
+      const S dist = nodes[node->children[i]].bv.distance(aabb);
+      if(dist <= bound)
+      {
+        queue.emplace_back(dist, node->children[i]);
+        std::push_heap(queue.begin(), queue.end(), farther);
+      }
+    }
   }
-  setup_ = false;
 }
 
 //==============================================================================
@@ -953,6 +1242,7 @@ void DynamicAABBTreeCollisionManager_Array<S>::clear()
 {
   dtree.clear();
   table.clear();
+  velocity_hints.clear();
 }
 
 //==============================================================================
@@ -1035,7 +1325,12 @@ void DynamicAABBTreeCollisionManager_Array<S>::distance(void* cdata, DistanceCal
 template <typename S>
 void DynamicAABBTreeCollisionManager_Array<S>::collide(BroadPhaseCollisionManager<S>* other_manager_, void* cdata, CollisionCallBack<S> callback) const
 {
-  DynamicAABBTreeCollisionManager_Array* other_manager = static_cast<DynamicAABBTreeCollisionManager_Array*>(other_manager_);
+  DynamicAABBTreeCollisionManager_Array* other_manager = dynamic_cast<DynamicAABBTreeCollisionManager_Array*>(other_manager_);
+  if(!other_manager)
+  {
+    this->collideHierarchies(other_manager_, cdata, callback);
+    return;
+  }
   if((size() == 0) || (other_manager->size() == 0)) return;
   detail::dynamic_AABB_tree_array::collisionRecurse(dtree.getNodes(), dtree.getRoot(), other_manager->dtree.getNodes(), other_manager->dtree.getRoot(), cdata, callback);
 }
@@ -1072,6 +1367,65 @@ DynamicAABBTreeCollisionManager_Array<S>::getTree() const
   return dtree;
 }
 
+//==============================================================================
+template <typename S>
+const detail::AABBHierarchy<S>*
+DynamicAABBTreeCollisionManager_Array<S>::getAABBHierarchy() const
+{
+  return &hierarchy;
+}
+
+//==============================================================================
+template <typename S>
+S DynamicAABBTreeCollisionManager_Array<S>::getSAHCostBeforeUpdate() const
+{
+  return sah_cost_before_update;
+}
+
+//==============================================================================
+template <typename S>
+S DynamicAABBTreeCollisionManager_Array<S>::getSAHCostAfterUpdate() const
+{
+  return sah_cost_after_update;
+}
+
+//==============================================================================
+template <typename S>
+void DynamicAABBTreeCollisionManager_Array<S>::setVelocityHint(
+    CollisionObject<S>* obj, const Vector3<S>& vel)
+{
+  if(vel.isZero())
+    velocity_hints.erase(obj);
+  else
+    velocity_hints[obj] = vel;
+}
+
+//==============================================================================
+template <typename S>
+bool DynamicAABBTreeCollisionManager_Array<S>::useFatAABB_() const
+{
+  return (fat_aabb_margin > 0) || !velocity_hints.empty();
+}
+
+//==============================================================================
+template <typename S>
+Vector3<S> DynamicAABBTreeCollisionManager_Array<S>::velocityHint_(
+    CollisionObject<S>* obj) const
+{
+  if(velocity_hints.empty())
+    return Vector3<S>::Zero();
+
+  const auto it = velocity_hints.find(obj);
+  return (it != velocity_hints.end()) ? it->second : Vector3<S>::Zero();
+}
+
+//==============================================================================
+template <typename S>
+AABB<S> DynamicAABBTreeCollisionManager_Array<S>::fatAABB_(CollisionObject<S>* obj) const
+{
+  return detail::fatBV(obj->getAABB(), velocityHint_(obj), fat_aabb_margin);
+}
+
 } // namespace fcl
 
 #endif
@@ -0,0 +1,900 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef FCL_BROADPHASE_HIERARCHICALSPATIALHASH_H
+#define FCL_BROADPHASE_HIERARCHICALSPATIALHASH_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include "fcl/math/bv/AABB.h"
+#include "fcl/broadphase/broadphase_collision_manager.h"
+#include "fcl/broadphase/detail/flat_hash_table.h"
+#include "fcl/broadphase/detail/grid_hash.h"
+
+namespace fcl
+{
+
+/// @brief Hierarchical spatial hashing collision manager. The objects are
+/// hashed into a stack of unbounded grids whose cell sizes grow geometrically,
+/// each object into the finest grid whose cells are at least as large as its
+/// AABB, so that it overlaps at most two cells along each axis. Objects of
+/// very different sizes can therefore share the manager without a scene limit.
+/// The cell sizes are either given, or picked in setup() from the sizes of the
+/// registered objects and picked again by update() when those sizes drift.
+template<typename S,
+         typename HashTable
+             = detail::FlatHashTable<AABB<S>, CollisionObject<S>*, detail::GridHash<S>> >
+class HierarchicalSpatialHashingCollisionManager : public BroadPhaseCollisionManager<S>
+{
+public:
+  /// @brief pick the cell sizes from the objects registered by setup(), using
+  /// at most max_num_levels grids
+  HierarchicalSpatialHashingCollisionManager(unsigned int max_num_levels = 16);
+
+  /// @brief use num_levels grids with the cell sizes
+  /// min_cell_size * cell_size_ratio^i
+  HierarchicalSpatialHashingCollisionManager(
+      S min_cell_size, unsigned int num_levels, S cell_size_ratio = 2);
+
+  /// @brief add one object to the manager
+  void registerObject(CollisionObject<S>* obj);
+
+  /// @brief remove one object from the manager
+  void unregisterObject(CollisionObject<S>* obj);
+
+  /// @brief initialize the manager, related with the specific type of manager
+  void setup();
+
+  /// @brief update the condition of manager
+  void update();
+
+  /// @brief update the manager by explicitly given the object updated
+  void update(CollisionObject<S>* updated_obj);
+
+  /// @brief update the manager by explicitly given the set of objects update
+  void update(const std::vector<CollisionObject<S>*>& updated_objs);
+
+  /// @brief clear the manager
+  void clear();
+
+  /// @brief return the objects managed by the manager
+  void getObjects(std::vector<CollisionObject<S>*>& objs) const;
+
+  /// @brief perform collision test between one object and all the objects belonging to the manager
+  void collide(CollisionObject<S>* obj, void* cdata, CollisionCallBack<S> callback) const;
+
+  /// @brief perform distance computation between one object and all the objects belonging ot the manager
+  void distance(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback) const;
+
+  /// @brief perform collision test for the objects belonging to the manager (i.e, N^2 self collision).
+  /// The order of the pairs is unspecified, as it depends on the object
+  /// addresses.
+  void collide(void* cdata, CollisionCallBack<S> callback) const;
+
+  /// @brief perform distance test for the objects belonging to the manager (i.e., N^2 self distance)
+  void distance(void* cdata, DistanceCallBack<S> callback) const;
+
+  /// @brief perform collision test with objects belonging to another manager
+  void collide(BroadPhaseCollisionManager<S>* other_manager, void* cdata, CollisionCallBack<S> callback) const;
+
+  /// @brief perform distance test with objects belonging to another manager
+  void distance(BroadPhaseCollisionManager<S>* other_manager, void* cdata, DistanceCallBack<S> callback) const;
+
+  /// @brief whether the manager is empty
+  bool empty() const;
+
+  /// @brief the number of objects managed by the manager
+  size_t size() const;
+
+  /// @brief pick the cell sizes again from the registered objects (if they
+  /// are picked automatically) and rehash all the objects
+  void rebuild();
+
+  /// @brief the number of grids
+  size_t numLevels() const;
+
+  /// @brief the cell size of a grid
+  S cellSize(size_t level) const;
+
+  /// @brief whether update() picks the cell sizes again when the object sizes
+  /// drift, only for automatic cell sizes
+  bool auto_rebuild;
+
+  /// @brief update() rebuilds once the finest cell size picked for the current
+  /// objects differs from the current one by more than this factor, or once
+  /// an object is this much larger than the coarsest cells
+  S rebuild_ratio;
+
+  /// @brief objects overlapping more cells than this in their grid are kept
+  /// out of the grids and tested against every object instead
+  unsigned int max_object_cells;
+
+protected:
+
+  /// @brief the grid of an object and the AABB it was hashed with
+  struct ObjectInfo
+  {
+    AABB<S> aabb;
+
+    /// @brief -1 for the objects kept out of the grids
+    int level;
+  };
+
+  /// @brief pick the finest cell size and the number of grids from the sizes
+  /// of the registered objects
+  void pickCellSizes(S& min_cell_size, size_t& num_levels) const;
+
+  /// @brief replace the grids
+  void createLevels(S min_cell_size, size_t num_levels);
+
+  /// @brief hash all the objects again into the current grids
+  void rehash();
+
+  /// @brief the largest side of the AABB
+  static S extent(const AABB<S>& aabb);
+
+  /// @brief the finest grid whose cells are at least as large as the AABB
+  int objectLevel(const AABB<S>& aabb) const;
+
+  void insert_(CollisionObject<S>* obj);
+
+  void remove_(CollisionObject<S>* obj);
+
+  /// @brief append the objects of one grid that may overlap the AABB; return
+  /// whether the whole grid was appended
+  bool queryLevel(size_t level, const AABB<S>& aabb, std::vector<CollisionObject<S>*>& candidates) const;
+
+  /// @brief perform collision test between one object and all the objects belonging to the manager
+  bool collide_(CollisionObject<S>* obj, void* cdata, CollisionCallBack<S> callback) const;
+
+  using TestedSet = typename BroadPhaseCollisionManager<S>::TestedSet;
+
+  /// @brief perform distance computation between one object and all the objects belonging ot the manager
+  bool distance_(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist, TestedSet* tested_set = nullptr) const;
+
+  bool distanceObjectToObjects(
+      CollisionObject<S>* obj,
+      const std::vector<CollisionObject<S>*>& objs,
+      void* cdata,
+      DistanceCallBack<S> callback,
+      S& min_dist,
+      TestedSet* tested_set) const;
+
+  /// @brief all objects in the scene
+  std::vector<CollisionObject<S>*> objs;
+
+  std::unordered_map<CollisionObject<S>*, ObjectInfo> obj_info_map;
+
+  /// @brief the cell size of each grid, from fine to coarse
+  std::vector<S> cell_sizes;
+
+  /// @brief the spatial hash table of each grid
+  std::vector<HashTable> hash_tables;
+
+  /// @brief the objects hashed into each grid
+  std::vector<std::vector<CollisionObject<S>*>> level_objs;
+
+  /// @brief the objects too large for any grid
+  std::vector<CollisionObject<S>*> large_objs;
+
+  S cell_size_ratio;
+
+  unsigned int max_num_levels;
+
+  /// @brief whether the cell sizes are picked from the objects
+  bool auto_cell_size;
+
+  /// @brief whether the objects are hashed into the grids
+  bool setup_;
+};
+
+template<typename HashTable = detail::FlatHashTable<AABB<float>, CollisionObject<float>*, detail::GridHash<float>>>
+using HierarchicalSpatialHashingCollisionManagerf = HierarchicalSpatialHashingCollisionManager<float, HashTable>;
+
+template<typename HashTable = detail::FlatHashTable<AABB<double>, CollisionObject<double>*, detail::GridHash<double>>>
+using HierarchicalSpatialHashingCollisionManagerd = HierarchicalSpatialHashingCollisionManager<double, HashTable>;
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template<typename S, typename HashTable>
+HierarchicalSpatialHashingCollisionManager<S, HashTable>::HierarchicalSpatialHashingCollisionManager(
+    unsigned int max_num_levels_)
+  : auto_rebuild(true),
+    rebuild_ratio(4),
+    max_object_cells(64),
+    cell_size_ratio(2),
+    max_num_levels(std::max(max_num_levels_, 1u)),
+    auto_cell_size(true),
+    setup_(false)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+HierarchicalSpatialHashingCollisionManager<S, HashTable>::HierarchicalSpatialHashingCollisionManager(
+    S min_cell_size, unsigned int num_levels, S cell_size_ratio_)
+  : auto_rebuild(false),
+    rebuild_ratio(4),
+    max_object_cells(64),
+    cell_size_ratio(cell_size_ratio_),
+    max_num_levels(std::max(num_levels, 1u)),
+    auto_cell_size(false),
+    setup_(true)
+{
+  createLevels(min_cell_size, max_num_levels);
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::registerObject(
+    CollisionObject<S>* obj)
+{
+  objs.push_back(obj);
+
+  // with automatic cell sizes, the first setup() hashes everything at once
+  if(setup_)
+    insert_(obj);
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::unregisterObject(
+    CollisionObject<S>* obj)
+{
+  auto it = std::find(objs.begin(), objs.end(), obj);
+  if(it == objs.end())
+    return;
+
+  objs.erase(it);
+
+  if(setup_)
+    remove_(obj);
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::setup()
+{
+  if(!setup_)
+    rebuild();
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::update()
+{
+  if(auto_cell_size && (!setup_ || auto_rebuild))
+  {
+    S min_cell_size;
+    size_t num_levels;
+    pickCellSizes(min_cell_size, num_levels);
+
+    bool drifted = !setup_ || cell_sizes.empty();
+    if(!drifted)
+    {
+      S max_size = 0;
+      for(const auto& obj : objs)
+        max_size = std::max(max_size, extent(obj->getAABB()));
+
+      const S ratio = min_cell_size / cell_sizes.front();
+      drifted = (ratio > rebuild_ratio) || (ratio * rebuild_ratio < 1)
+          || (max_size > cell_sizes.back() * rebuild_ratio);
+    }
+
+    if(drifted)
+    {
+      createLevels(min_cell_size, num_levels);
+      setup_ = true;
+    }
+  }
+
+  rehash();
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::update(
+    CollisionObject<S>* updated_obj)
+{
+  if(!setup_)
+  {
+    setup();
+    return;
+  }
+
+  remove_(updated_obj);
+  insert_(updated_obj);
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::update(
+    const std::vector<CollisionObject<S>*>& updated_objs)
+{
+  for(size_t i = 0; i < updated_objs.size(); ++i)
+    update(updated_objs[i]);
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::clear()
+{
+  objs.clear();
+  obj_info_map.clear();
+  for(size_t i = 0; i < hash_tables.size(); ++i)
+  {
+    hash_tables[i].clear();
+    level_objs[i].clear();
+  }
+  large_objs.clear();
+
+  if(auto_cell_size)
+    setup_ = false;
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::getObjects(
+    std::vector<CollisionObject<S>*>& objs_) const
+{
+  objs_ = objs;
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::collide(
+    CollisionObject<S>* obj, void* cdata, CollisionCallBack<S> callback) const
+{
+  if(size() == 0) return;
+  collide_(obj, cdata, callback);
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::distance(
+    CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback) const
+{
+  if(size() == 0) return;
+  S min_dist = std::numeric_limits<S>::max();
+  distance_(obj, cdata, callback, min_dist);
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::collide(
+    void* cdata, CollisionCallBack<S> callback) const
+{
+  if(size() == 0)
+    return;
+
+  // Every pair is reported once, by the object in the finer grid, which looks
+  // for it in its own grid and the coarser ones. Within one grid, only the
+  // smaller pointer reports.
+  std::vector<CollisionObject<S>*> candidates;
+  for(size_t level = 0; level < level_objs.size(); ++level)
+  {
+    for(const auto& obj1 : level_objs[level])
+    {
+      const AABB<S>& aabb1 = obj1->getAABB();
+
+      for(size_t level2 = level; level2 < level_objs.size(); ++level2)
+      {
+        candidates.clear();
+        queryLevel(level2, aabb1, candidates);
+        for(const auto& obj2 : candidates)
+        {
+          if(obj1 == obj2)
+            continue;
+
+          if((level2 == level) && (obj2 < obj1))
+            continue;
+
+          if(aabb1.overlap(obj2->getAABB()))
+          {
+            if(callback(obj1, obj2, cdata))
+              return;
+          }
+        }
+      }
+
+      for(const auto& obj2 : large_objs)
+      {
+        if(aabb1.overlap(obj2->getAABB()))
+        {
+          if(callback(obj1, obj2, cdata))
+            return;
+        }
+      }
+    }
+  }
+
+  for(size_t i = 0; i < large_objs.size(); ++i)
+  {
+    for(size_t j = i + 1; j < large_objs.size(); ++j)
+    {
+      if(large_objs[i]->getAABB().overlap(large_objs[j]->getAABB()))
+      {
+        if(callback(large_objs[i], large_objs[j], cdata))
+          return;
+      }
+    }
+  }
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::distance(
+    void* cdata, DistanceCallBack<S> callback) const
+{
+  if(size() == 0)
+    return;
+
+  TestedSet tested_set;
+
+  S min_dist = std::numeric_limits<S>::max();
+
+  for(const auto& obj : objs)
+  {
+    if(distance_(obj, cdata, callback, min_dist, &tested_set))
+      break;
+  }
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::collide(
+    BroadPhaseCollisionManager<S>* other_manager_, void* cdata, CollisionCallBack<S> callback) const
+{
+  auto* other_manager = dynamic_cast<HierarchicalSpatialHashingCollisionManager<S, HashTable>* >(other_manager_);
+  if(!other_manager)
+  {
+    this->collideHierarchies(other_manager_, cdata, callback);
+    return;
+  }
+
+  if((size() == 0) || (other_manager->size() == 0))
+    return;
+
+  if(this == other_manager)
+  {
+    collide(cdata, callback);
+    return;
+  }
+
+  if(this->size() < other_manager->size())
+  {
+    for(const auto& obj : objs)
+    {
+      if(other_manager->collide_(obj, cdata, callback))
+        return;
+    }
+  }
+  else
+  {
+    for(const auto& obj : other_manager->objs)
+    {
+      if(collide_(obj, cdata, callback))
+        return;
+    }
+  }
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::distance(
+    BroadPhaseCollisionManager<S>* other_manager_, void* cdata, DistanceCallBack<S> callback) const
+{
+  auto* other_manager = static_cast<HierarchicalSpatialHashingCollisionManager<S, HashTable>* >(other_manager_);
+
+  if((size() == 0) || (other_manager->size() == 0))
+    return;
+
+  if(this == other_manager)
+  {
+    distance(cdata, callback);
+    return;
+  }
+
+  S min_dist = std::numeric_limits<S>::max();
+
+  if(this->size() < other_manager->size())
+  {
+    for(const auto& obj : objs)
+      if(other_manager->distance_(obj, cdata, callback, min_dist)) return;
+  }
+  else
+  {
+    for(const auto& obj : other_manager->objs)
+      if(distance_(obj, cdata, callback, min_dist)) return;
+  }
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+bool HierarchicalSpatialHashingCollisionManager<S, HashTable>::empty() const
+{
+  return objs.empty();
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+size_t HierarchicalSpatialHashingCollisionManager<S, HashTable>::size() const
+{
+  return objs.size();
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::rebuild()
+{
+  if(auto_cell_size)
+  {
+    S min_cell_size;
+    size_t num_levels;
+    pickCellSizes(min_cell_size, num_levels);
+    createLevels(min_cell_size, num_levels);
+  }
+
+  setup_ = true;
+  rehash();
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+size_t HierarchicalSpatialHashingCollisionManager<S, HashTable>::numLevels() const
+{
+  return cell_sizes.size();
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+S HierarchicalSpatialHashingCollisionManager<S, HashTable>::cellSize(size_t level) const
+{
+  return cell_sizes[level];
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::pickCellSizes(
+    S& min_cell_size, size_t& num_levels) const
+{
+  S min_size = std::numeric_limits<S>::max();
+  S max_size = 0;
+  for(const auto& obj : objs)
+  {
+    const S size = extent(obj->getAABB());
+    min_size = std::min(min_size, size);
+    max_size = std::max(max_size, size);
+  }
+
+  if(max_size <= 0)
+  {
+    // no objects, or only points
+    min_cell_size = 1;
+    num_levels = 1;
+    return;
+  }
+
+  // the finest cells fit the smallest object, unless that needs more grids
+  // than allowed to reach the largest one
+  min_cell_size = std::max(
+        min_size, max_size / std::pow(cell_size_ratio, S(max_num_levels - 1)));
+
+  num_levels = 1;
+  S cell_size = min_cell_size;
+  while(cell_size < max_size && num_levels < max_num_levels)
+  {
+    cell_size *= cell_size_ratio;
+    ++num_levels;
+  }
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::createLevels(
+    S min_cell_size, size_t num_levels)
+{
+  cell_sizes.clear();
+  hash_tables.clear();
+  level_objs.clear();
+
+  S cell_size = min_cell_size;
+  for(size_t i = 0; i < num_levels; ++i)
+  {
+    cell_sizes.push_back(cell_size);
+    hash_tables.emplace_back(detail::GridHash<S>(cell_size));
+    hash_tables.back().init(1000);
+    cell_size *= cell_size_ratio;
+  }
+
+  level_objs.resize(num_levels);
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::rehash()
+{
+  for(size_t i = 0; i < hash_tables.size(); ++i)
+  {
+    hash_tables[i].clear();
+    level_objs[i].clear();
+  }
+  large_objs.clear();
+  obj_info_map.clear();
+
+  for(const auto& obj : objs)
+    insert_(obj);
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+S HierarchicalSpatialHashingCollisionManager<S, HashTable>::extent(
+    const AABB<S>& aabb)
+{
+  return (aabb.max_ - aabb.min_).maxCoeff();
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+int HierarchicalSpatialHashingCollisionManager<S, HashTable>::objectLevel(
+    const AABB<S>& aabb) const
+{
+  const S size = extent(aabb);
+  size_t level = 0;
+  while(level + 1 < cell_sizes.size() && cell_sizes[level] < size)
+    ++level;
+
+  return static_cast<int>(level);
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::insert_(
+    CollisionObject<S>* obj)
+{
+  ObjectInfo& info = obj_info_map[obj];
+  info.aabb = obj->getAABB();
+  info.level = objectLevel(info.aabb);
+
+  if(cell_sizes.empty()
+     || detail::GridHash<S>(cell_sizes[info.level]).numCells(info.aabb) > max_object_cells)
+  {
+    info.level = -1;
+    large_objs.push_back(obj);
+    return;
+  }
+
+  hash_tables[info.level].insert(info.aabb, obj);
+  level_objs[info.level].push_back(obj);
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+void HierarchicalSpatialHashingCollisionManager<S, HashTable>::remove_(
+    CollisionObject<S>* obj)
+{
+  auto it = obj_info_map.find(obj);
+  if(it == obj_info_map.end())
+    return;
+
+  const ObjectInfo& info = it->second;
+  std::vector<CollisionObject<S>*>& list
+      = (info.level < 0) ? large_objs : level_objs[info.level];
+  if(info.level >= 0)
+    hash_tables[info.level].remove(info.aabb, obj);
+
+  auto list_it = std::find(list.begin(), list.end(), obj);
+  if(list_it != list.end())
+  {
+    *list_it = list.back();
+    list.pop_back();
+  }
+
+  obj_info_map.erase(it);
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+bool HierarchicalSpatialHashingCollisionManager<S, HashTable>::queryLevel(
+    size_t level, const AABB<S>& aabb, std::vector<CollisionObject<S>*>& candidates) const
+{
+  const std::vector<CollisionObject<S>*>& list = level_objs[level];
+  if(list.empty())
+    return true;
+
+  // a query over more cells than there are objects in the grid is slower than
+  // looking at all of them
+  if(detail::GridHash<S>(cell_sizes[level]).numCells(aabb) > list.size())
+  {
+    candidates.insert(candidates.end(), list.begin(), list.end());
+    return true;
+  }
+
+  const std::vector<CollisionObject<S>*> result = hash_tables[level].query(aabb);
+  candidates.insert(candidates.end(), result.begin(), result.end());
+  return false;
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+bool HierarchicalSpatialHashingCollisionManager<S, HashTable>::collide_(
+    CollisionObject<S>* obj, void* cdata, CollisionCallBack<S> callback) const
+{
+  const AABB<S>& obj_aabb = obj->getAABB();
+
+  std::vector<CollisionObject<S>*> candidates;
+  for(size_t level = 0; level < level_objs.size(); ++level)
+    queryLevel(level, obj_aabb, candidates);
+  candidates.insert(candidates.end(), large_objs.begin(), large_objs.end());
+
+  for(const auto& obj2 : candidates)
+  {
+    if(obj == obj2)
+      continue;
+
+    if(obj_aabb.overlap(obj2->getAABB()))
+    {
+      if(callback(obj, obj2, cdata))
+        return true;
+    }
+  }
+
+  return false;
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+bool HierarchicalSpatialHashingCollisionManager<S, HashTable>::distance_(
+    CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist,
+    TestedSet* tested_set) const
+{
+  auto delta = (obj->getAABB().max_ - obj->getAABB().min_) * 0.5;
+  auto aabb = obj->getAABB();
+  if(min_dist < std::numeric_limits<S>::max())
+  {
+    Vector3<S> min_dist_delta(min_dist, min_dist, min_dist);
+    aabb.expand(min_dist_delta);
+  }
+
+  auto status = 1;
+  S old_min_distance;
+
+  std::vector<CollisionObject<S>*> candidates;
+  while(1)
+  {
+    old_min_distance = min_dist;
+
+    candidates.clear();
+    bool all_objects = true;
+    for(size_t level = 0; level < level_objs.size(); ++level)
+    {
+      if(!queryLevel(level, aabb, candidates))
+        all_objects = false;
+    }
+    candidates.insert(candidates.end(), large_objs.begin(), large_objs.end());
+
+    if(distanceObjectToObjects(obj, candidates, cdata, callback, min_dist, tested_set))
+      return true;
+
+    if(status == 1)
+    {
+      if(old_min_distance < std::numeric_limits<S>::max())
+      {
+        break;
+      }
+      else
+      {
+        if(min_dist < old_min_distance)
+        {
+          Vector3<S> min_dist_delta(min_dist, min_dist, min_dist);
+          aabb = AABB<S>(obj->getAABB(), min_dist_delta);
+          status = 0;
+        }
+        else
+        {
+          // nothing else to find
+          if(all_objects)
+            break;
+
+          if(aabb.equal(obj->getAABB()))
+            aabb.expand(delta);
+          else
+            aabb.expand(obj->getAABB(), 2.0);
+        }
+      }
+    }
+    else if(status == 0)
+    {
+      break;
+    }
+  }
+
+  return false;
+}
+
+//==============================================================================
+template<typename S, typename HashTable>
+bool HierarchicalSpatialHashingCollisionManager<S, HashTable>::distanceObjectToObjects(
+    CollisionObject<S>* obj,
+    const std::vector<CollisionObject<S>*>& objs,
+    void* cdata,
+    DistanceCallBack<S> callback,
+    S& min_dist,
+    TestedSet* tested_set) const
+{
+  for(auto& obj2 : objs)
+  {
+    if(obj == obj2)
+      continue;
+
+    if(!tested_set)
+    {
+      if(obj->getAABB().distance(obj2->getAABB()) < min_dist)
+      {
+        if(callback(obj, obj2, cdata, min_dist))
+          return true;
+      }
+    }
+    else
+    {
+      if(!this->inTestedSet(*tested_set, obj, obj2))
+      {
+        if(obj->getAABB().distance(obj2->getAABB()) < min_dist)
+        {
+          if(callback(obj, obj2, cdata, min_dist))
+            return true;
+        }
+
+        this->insertTestedSet(*tested_set, obj, obj2);
+      }
+    }
+  }
+
+  return false;
+}
+
+} // namespace fcl
+
+#endif
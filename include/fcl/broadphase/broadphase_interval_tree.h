@@ -111,6 +111,8 @@ protected:
   /// @brief Extention interval tree's interval to SAP interval, adding more information
   struct SAPInterval;
 
+  using TestedSet = typename BroadPhaseCollisionManager<S>::TestedSet;
+
   bool checkColl(
       typename std::deque<detail::SimpleInterval<S>*>::const_iterator pos_start,
       typename std::deque<detail::SimpleInterval<S>*>::const_iterator pos_end,
@@ -124,11 +126,20 @@ protected:
       CollisionObject<S>* obj,
       void* cdata,
       DistanceCallBack<S> callback,
-      S& min_dist) const;
+      S& min_dist,
+      TestedSet* tested_set) const;
 
   bool collide_(CollisionObject<S>* obj, void* cdata, CollisionCallBack<S> callback) const;
 
-  bool distance_(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist) const;
+  bool distance_(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist, TestedSet* tested_set = nullptr) const;
+
+  using Neighbor = typename BroadPhaseCollisionManager<S>::Neighbor;
+
+  /// @brief looks for the objects in a window around obj along the longest
+  /// axis of the scene, widened until it holds the k nearest objects
+  void nearest_(CollisionObject<S>* obj, std::size_t k, S max_dist,
+                std::vector<Neighbor>& neighbors,
+                void* cdata, ObjectDistanceCallBack<S> callback) const override;
 
   /// @brief vector stores all the end points
   std::vector<EndPoint> endpoints[3];
@@ -436,7 +447,7 @@ void IntervalTreeCollisionManager<S>::update(CollisionObject<S>* updated_obj)
     it = std::lower_bound(endpoints[i].begin(), endpoints[i].end(), dummy);
     for(; it != endpoints[i].end(); ++it)
     {
-      if(it->obj == updated_obj && it->minmax == 0)
+      if(it->obj == updated_obj && it->minmax == 1)
       {
         it->value = new_aabb.max_[i];
         break;
@@ -554,7 +565,7 @@ void IntervalTreeCollisionManager<S>::distance(CollisionObject<S>* obj, void* cd
 
 //==============================================================================
 template <typename S>
-bool IntervalTreeCollisionManager<S>::distance_(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist) const
+bool IntervalTreeCollisionManager<S>::distance_(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist, TestedSet* tested_set) const
 {
   static const unsigned int CUTOFF = 100;
 
@@ -591,20 +602,20 @@ bool IntervalTreeCollisionManager<S>::distance_(CollisionObject<S>* obj, void* c
           int d3 = results2.size();
 
           if(d1 >= d2 && d1 >= d3)
-            dist_res = checkDist(results0.begin(), results0.end(), obj, cdata, callback, min_dist);
+            dist_res = checkDist(results0.begin(), results0.end(), obj, cdata, callback, min_dist, tested_set);
           else if(d2 >= d1 && d2 >= d3)
-            dist_res = checkDist(results1.begin(), results1.end(), obj, cdata, callback, min_dist);
+            dist_res = checkDist(results1.begin(), results1.end(), obj, cdata, callback, min_dist, tested_set);
           else
-            dist_res = checkDist(results2.begin(), results2.end(), obj, cdata, callback, min_dist);
+            dist_res = checkDist(results2.begin(), results2.end(), obj, cdata, callback, min_dist, tested_set);
         }
         else
-          dist_res = checkDist(results2.begin(), results2.end(), obj, cdata, callback, min_dist);
+          dist_res = checkDist(results2.begin(), results2.end(), obj, cdata, callback, min_dist, tested_set);
       }
       else
-        dist_res = checkDist(results1.begin(), results1.end(), obj, cdata, callback, min_dist);
+        dist_res = checkDist(results1.begin(), results1.end(), obj, cdata, callback, min_dist, tested_set);
     }
     else
-      dist_res = checkDist(results0.begin(), results0.end(), obj, cdata, callback, min_dist);
+      dist_res = checkDist(results0.begin(), results0.end(), obj, cdata, callback, min_dist, tested_set);
 
     if(dist_res) return true;
 
@@ -705,22 +716,23 @@ void IntervalTreeCollisionManager<S>::distance(void* cdata, DistanceCallBack<S>
 {
   if(size() == 0) return;
 
-  this->enable_tested_set_ = true;
-  this->tested_set.clear();
+  TestedSet tested_set;
   S min_dist = std::numeric_limits<S>::max();
 
   for(size_t i = 0; i < endpoints[0].size(); ++i)
-    if(distance_(endpoints[0][i].obj, cdata, callback, min_dist)) break;
-
-  this->enable_tested_set_ = false;
-  this->tested_set.clear();
+    if(distance_(endpoints[0][i].obj, cdata, callback, min_dist, &tested_set)) break;
 }
 
 //==============================================================================
 template <typename S>
 void IntervalTreeCollisionManager<S>::collide(BroadPhaseCollisionManager<S>* other_manager_, void* cdata, CollisionCallBack<S> callback) const
 {
-  IntervalTreeCollisionManager* other_manager = static_cast<IntervalTreeCollisionManager*>(other_manager_);
+  IntervalTreeCollisionManager* other_manager = dynamic_cast<IntervalTreeCollisionManager*>(other_manager_);
+  if(!other_manager)
+  {
+    this->collideHierarchies(other_manager_, cdata, callback);
+    return;
+  }
 
   if((size() == 0) || (other_manager->size() == 0)) return;
 
@@ -811,6 +823,79 @@ bool IntervalTreeCollisionManager<S>::checkColl(
   return false;
 }
 
+//==============================================================================
+template <typename S>
+void IntervalTreeCollisionManager<S>::nearest_(
+    CollisionObject<S>* obj, std::size_t k, S max_dist,
+    std::vector<Neighbor>& neighbors,
+    void* cdata, ObjectDistanceCallBack<S> callback) const
+{
+  if(endpoints[0].empty()) return;
+
+  const AABB<S>& aabb = obj->getAABB();
+
+  // the end points are sorted, so they give the bound of the scene, and the
+  // objects are looked for along its longest axis
+  AABB<S> scene;
+  for(int i = 0; i < 3; ++i)
+  {
+    scene.min_[i] = endpoints[i].front().value;
+    scene.max_[i] = endpoints[i].back().value;
+  }
+  const Vector3<S> side = scene.max_ - scene.min_;
+  int axis;
+  side.maxCoeff(&axis);
+
+  // the objects within r of obj all overlap the window [min - r, max + r]
+  // along the axis. Without a bound, start from the half side of the cube
+  // that would hold k objects if they were spread evenly over the scene.
+  S r = max_dist;
+  if(r == std::numeric_limits<S>::max())
+  {
+    const S ratio = static_cast<S>(k) / size();
+    r = std::cbrt(side[0] * side[1] * side[2] * ratio) / 2;
+    if(!(r > 0))
+      r = side[axis] * ratio / 2;
+    r = std::max(r, aabb.distance(scene));
+  }
+
+  while(1)
+  {
+    neighbors.clear();
+
+    const S low = aabb.min_[axis] - r;
+    const S high = aabb.max_[axis] + r;
+
+    // the objects starting in the window, from the sorted end points
+    EndPoint probe;
+    probe.value = low;
+    const auto first = std::lower_bound(endpoints[axis].begin(), endpoints[axis].end(), probe);
+    probe.value = high;
+    const auto last = std::upper_bound(first, endpoints[axis].end(), probe);
+    for(auto it = first; it != last; ++it)
+    {
+      if(it->minmax == 0)
+        this->testNeighbor(obj, it->obj, k, max_dist, neighbors, cdata, callback);
+    }
+
+    // and the objects starting before it that reach into it
+    const std::deque<detail::SimpleInterval<S>*> results = interval_trees[axis]->query(low, low);
+    for(auto ivl : results)
+    {
+      if(ivl->low < low)
+        this->testNeighbor(obj, static_cast<SAPInterval*>(ivl)->obj, k, max_dist, neighbors, cdata, callback);
+    }
+
+    // done once no object outside the window can be nearer than the
+    // neighbors found
+    const S bound = this->neighborBound(neighbors, k, max_dist);
+    if(bound <= r || (low <= scene.min_[axis] && high >= scene.max_[axis]))
+      break;
+
+    r = (neighbors.size() == k) ? bound : 2 * r;
+  }
+}
+
 //==============================================================================
 template <typename S>
 bool IntervalTreeCollisionManager<S>::checkDist(
@@ -819,14 +904,15 @@ bool IntervalTreeCollisionManager<S>::checkDist(
     CollisionObject<S>* obj,
     void* cdata,
     DistanceCallBack<S> callback,
-    S& min_dist) const
+    S& min_dist,
+    TestedSet* tested_set) const
 {
   while(pos_start < pos_end)
   {
     SAPInterval* ivl = static_cast<SAPInterval*>(*pos_start);
     if(ivl->obj != obj)
     {
-      if(!this->enable_tested_set_)
+      if(!tested_set)
       {
         if(ivl->obj->getAABB().distance(obj->getAABB()) < min_dist)
         {
@@ -836,7 +922,7 @@ bool IntervalTreeCollisionManager<S>::checkDist(
       }
       else
       {
-        if(!this->inTestedSet(ivl->obj, obj))
+        if(!this->inTestedSet(*tested_set, ivl->obj, obj))
         {
           if(ivl->obj->getAABB().distance(obj->getAABB()) < min_dist)
           {
@@ -844,7 +930,7 @@ bool IntervalTreeCollisionManager<S>::checkDist(
               return true;
           }
 
-          this->insertTestedSet(ivl->obj, obj);
+          this->insertTestedSet(*tested_set, ivl->obj, obj);
         }
       }
     }
@@ -0,0 +1,166 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef FCL_BROADPHASE_BROADPHASESNAPSHOTS_H
+#define FCL_BROADPHASE_BROADPHASESNAPSHOTS_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "fcl/broadphase/broadphase_collision_manager.h"
+
+namespace fcl
+{
+
+/// @brief Publishes successive versions of a scene to concurrent readers in
+/// the manner of read-copy-update. Readers acquire() the current version and
+/// query it for as long as they hold it, without locking against the writer.
+/// The writer publish()es the next version, built in a manager of its own
+/// over copies of the objects, so it may go on moving the original objects
+/// while readers query the previous version. A version is freed once it is
+/// replaced and no reader holds it anymore.
+///
+/// The callbacks of a query get the copies of the objects; the copies keep the
+/// transform, the AABB and the user data of the originals.
+template <typename S>
+class BroadPhaseSnapshots
+{
+public:
+
+  using ConstManagerPtr = std::shared_ptr<const BroadPhaseCollisionManager<S>>;
+
+  /// @brief creates an empty manager for each version
+  using ManagerFactory = std::function<BroadPhaseCollisionManager<S>*()>;
+
+  BroadPhaseSnapshots(ManagerFactory factory);
+
+  /// @brief the current version, nullptr before the first publish. Safe to
+  /// call from any thread.
+  ConstManagerPtr acquire() const;
+
+  /// @brief replace the current version by one over copies of the objects.
+  /// Calls from several writers are serialized.
+  void publish(const std::vector<CollisionObject<S>*>& objs);
+
+  /// @brief the number of versions published so far
+  std::size_t getEpoch() const;
+
+private:
+
+  /// @brief a manager together with the copies of the objects it manages
+  struct Version
+  {
+    std::unique_ptr<BroadPhaseCollisionManager<S>> manager;
+    std::vector<std::unique_ptr<CollisionObject<S>>> objs;
+  };
+
+  ManagerFactory factory;
+
+  /// @brief only accessed through the atomic shared_ptr functions
+  ConstManagerPtr current;
+
+  /// @brief serializes the writers
+  std::mutex publish_mutex;
+
+  std::atomic<std::size_t> epoch;
+};
+
+using BroadPhaseSnapshotsf = BroadPhaseSnapshots<float>;
+using BroadPhaseSnapshotsd = BroadPhaseSnapshots<double>;
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template <typename S>
+BroadPhaseSnapshots<S>::BroadPhaseSnapshots(ManagerFactory factory_)
+  : factory(factory_), epoch(0)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template <typename S>
+typename BroadPhaseSnapshots<S>::ConstManagerPtr
+BroadPhaseSnapshots<S>::acquire() const
+{
+  return std::atomic_load(&current);
+}
+
+//==============================================================================
+template <typename S>
+void BroadPhaseSnapshots<S>::publish(
+    const std::vector<CollisionObject<S>*>& objs)
+{
+  std::lock_guard<std::mutex> lock(publish_mutex);
+
+  std::shared_ptr<Version> version = std::make_shared<Version>();
+  version->manager.reset(factory());
+  version->objs.reserve(objs.size());
+
+  std::vector<CollisionObject<S>*> copies;
+  copies.reserve(objs.size());
+  for(auto obj : objs)
+  {
+    version->objs.emplace_back(new CollisionObject<S>(*obj));
+    copies.push_back(version->objs.back().get());
+  }
+
+  version->manager->registerObjects(copies);
+  version->manager->setup();
+
+  // the manager shares the ownership of its version, so the copies live as
+  // long as any reader holds the manager
+  ConstManagerPtr manager(version, version->manager.get());
+  std::atomic_store(&current, manager);
+  ++epoch;
+}
+
+//==============================================================================
+template <typename S>
+std::size_t BroadPhaseSnapshots<S>::getEpoch() const
+{
+  return epoch;
+}
+
+} // namespace fcl
+
+#endif
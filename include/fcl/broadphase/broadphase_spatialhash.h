@@ -94,7 +94,9 @@ public:
   /// @brief perform distance computation between one object and all the objects belonging ot the manager
   void distance(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback) const;
 
-  /// @brief perform collision test for the objects belonging to the manager (i.e, N^2 self collision)
+  /// @brief perform collision test for the objects belonging to the manager (i.e, N^2 self collision).
+  /// The order of the pairs is unspecified, as it depends on the object
+  /// addresses.
   void collide(void* cdata, CollisionCallBack<S> callback) const;
 
   /// @brief perform distance test for the objects belonging to the manager (i.e., N^2 self distance)
@@ -120,8 +122,10 @@ protected:
   /// @brief perform collision test between one object and all the objects belonging to the manager
   bool collide_(CollisionObject<S>* obj, void* cdata, CollisionCallBack<S> callback) const;
 
+  using TestedSet = typename BroadPhaseCollisionManager<S>::TestedSet;
+
   /// @brief perform distance computation between one object and all the objects belonging ot the manager
-  bool distance_(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist) const;
+  bool distance_(CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist, TestedSet* tested_set = nullptr) const;
 
   /// @brief all objects in the scene
   std::list<CollisionObject<S>*> objs;
@@ -157,7 +161,8 @@ private:
       const Container& objs,
       void* cdata,
       DistanceCallBack<S> callback,
-      S& min_dist) const;
+      S& min_dist,
+      TestedSet* tested_set) const;
 
 };
 
@@ -495,7 +500,8 @@ bool SpatialHashingCollisionManager<S, HashTable>::collide_(
 //==============================================================================
 template<typename S, typename HashTable>
 bool SpatialHashingCollisionManager<S, HashTable>::distance_(
-    CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist) const
+    CollisionObject<S>* obj, void* cdata, DistanceCallBack<S> callback, S& min_dist,
+    TestedSet* tested_set) const
 {
   auto delta = (obj->getAABB().max_ - obj->getAABB().min_) * 0.5;
   auto aabb = obj->getAABB();
@@ -517,7 +523,7 @@ bool SpatialHashingCollisionManager<S, HashTable>::distance_(
     if(scene_limit.overlap(aabb, overlap_aabb))
     {
       if (distanceObjectToObjects(
-            obj, hash_table->query(overlap_aabb), cdata, callback, min_dist))
+            obj, hash_table->query(overlap_aabb), cdata, callback, min_dist, tested_set))
       {
         return true;
       }
@@ -525,7 +531,7 @@ bool SpatialHashingCollisionManager<S, HashTable>::distance_(
       if(!scene_limit.contain(aabb))
       {
         if (distanceObjectToObjects(
-              obj, objs_outside_scene_limit, cdata, callback, min_dist))
+              obj, objs_outside_scene_limit, cdata, callback, min_dist, tested_set))
         {
           return true;
         }
@@ -534,13 +540,13 @@ bool SpatialHashingCollisionManager<S, HashTable>::distance_(
     else
     {
       if (distanceObjectToObjects(
-            obj, objs_partially_penetrating_scene_limit, cdata, callback, min_dist))
+            obj, objs_partially_penetrating_scene_limit, cdata, callback, min_dist, tested_set))
       {
         return true;
       }
 
       if (distanceObjectToObjects(
-            obj, objs_outside_scene_limit, cdata, callback, min_dist))
+            obj, objs_outside_scene_limit, cdata, callback, min_dist, tested_set))
       {
         return true;
       }
@@ -646,26 +652,27 @@ void SpatialHashingCollisionManager<S, HashTable>::distance(
   if(size() == 0)
     return;
 
-  this->enable_tested_set_ = true;
-  this->tested_set.clear();
+  TestedSet tested_set;
 
   S min_dist = std::numeric_limits<S>::max();
 
   for(const auto& obj : objs)
   {
-    if(distance_(obj, cdata, callback, min_dist))
+    if(distance_(obj, cdata, callback, min_dist, &tested_set))
       break;
   }
-
-  this->enable_tested_set_ = false;
-  this->tested_set.clear();
 }
 
 //==============================================================================
 template<typename S, typename HashTable>
 void SpatialHashingCollisionManager<S, HashTable>::collide(BroadPhaseCollisionManager<S>* other_manager_, void* cdata, CollisionCallBack<S> callback) const
 {
-  auto* other_manager = static_cast<SpatialHashingCollisionManager<S, HashTable>* >(other_manager_);
+  auto* other_manager = dynamic_cast<SpatialHashingCollisionManager<S, HashTable>* >(other_manager_);
+  if(!other_manager)
+  {
+    this->collideHierarchies(other_manager_, cdata, callback);
+    return;
+  }
 
   if((size() == 0) || (other_manager->size() == 0))
     return;
@@ -758,14 +765,15 @@ bool SpatialHashingCollisionManager<S, HashTable>::distanceObjectToObjects(
     const Container& objs,
     void* cdata,
     DistanceCallBack<S> callback,
-    S& min_dist) const
+    S& min_dist,
+    TestedSet* tested_set) const
 {
   for(auto& obj2 : objs)
   {
     if(obj == obj2)
       continue;
 
-    if(!this->enable_tested_set_)
+    if(!tested_set)
     {
       if(obj->getAABB().distance(obj2->getAABB()) < min_dist)
       {
@@ -775,7 +783,7 @@ bool SpatialHashingCollisionManager<S, HashTable>::distanceObjectToObjects(
     }
     else
     {
-      if(!this->inTestedSet(obj, obj2))
+      if(!this->inTestedSet(*tested_set, obj, obj2))
       {
         if(obj->getAABB().distance(obj2->getAABB()) < min_dist)
         {
@@ -783,7 +791,7 @@ bool SpatialHashingCollisionManager<S, HashTable>::distanceObjectToObjects(
             return true;
         }
 
-        this->insertTestedSet(obj, obj2);
+        this->insertTestedSet(*tested_set, obj, obj2);
       }
     }
   }
@@ -0,0 +1,231 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef FCL_BROADPHASE_DETAIL_AABBHIERARCHY_H
+#define FCL_BROADPHASE_DETAIL_AABBHIERARCHY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "fcl/math/bv/AABB.h"
+#include "fcl/object/collision_object.h"
+
+namespace fcl
+{
+
+namespace detail
+{
+
+/// @brief Read-only view of a binary AABB hierarchy over collision objects.
+/// Broad phase managers of different types collide with each other by
+/// traversing their hierarchies together through this interface.
+template <typename S>
+class AABBHierarchy
+{
+public:
+
+  /// @brief opaque handle of a node
+  using NodeId = std::uintptr_t;
+
+  virtual ~AABBHierarchy() = default;
+
+  /// @brief whether the hierarchy has no node
+  virtual bool empty() const = 0;
+
+  /// @brief the root node
+  virtual NodeId getRoot() const = 0;
+
+  /// @brief whether a node is a leaf
+  virtual bool isLeaf(NodeId node) const = 0;
+
+  /// @brief the i-th (0 or 1) child of an internal node
+  virtual NodeId getChild(NodeId node, int i) const = 0;
+
+  /// @brief the AABB of a node
+  virtual const AABB<S>& getAABB(NodeId node) const = 0;
+
+  /// @brief the object of a leaf
+  virtual CollisionObject<S>* getObject(NodeId node) const = 0;
+};
+
+/// @brief AABB hierarchy built top-down over a set of objects, splitting at
+/// the median along the longest axis of the object centers, for the managers
+/// that keep no hierarchy of their own
+template <typename S>
+class ObjectAABBHierarchy : public AABBHierarchy<S>
+{
+public:
+
+  using NodeId = typename AABBHierarchy<S>::NodeId;
+
+  ObjectAABBHierarchy(const std::vector<CollisionObject<S>*>& objs);
+
+  bool empty() const override;
+
+  NodeId getRoot() const override;
+
+  bool isLeaf(NodeId node) const override;
+
+  NodeId getChild(NodeId node, int i) const override;
+
+  const AABB<S>& getAABB(NodeId node) const override;
+
+  CollisionObject<S>* getObject(NodeId node) const override;
+
+private:
+
+  struct Node
+  {
+    AABB<S> bv;
+    NodeId children[2];
+
+    /// @brief nullptr for internal nodes
+    CollisionObject<S>* obj;
+  };
+
+  /// @brief build the subtree over the objects in [begin, end) and return its
+  /// root
+  NodeId build(std::size_t begin, std::size_t end);
+
+  std::vector<CollisionObject<S>*> objs;
+  std::vector<Node> nodes;
+  NodeId root;
+};
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template <typename S>
+ObjectAABBHierarchy<S>::ObjectAABBHierarchy(
+    const std::vector<CollisionObject<S>*>& objs_)
+  : objs(objs_), root(0)
+{
+  if(!objs.empty())
+  {
+    nodes.reserve(2 * objs.size() - 1);
+    root = build(0, objs.size());
+  }
+}
+
+//==============================================================================
+template <typename S>
+bool ObjectAABBHierarchy<S>::empty() const
+{
+  return nodes.empty();
+}
+
+//==============================================================================
+template <typename S>
+typename ObjectAABBHierarchy<S>::NodeId ObjectAABBHierarchy<S>::getRoot() const
+{
+  return root;
+}
+
+//==============================================================================
+template <typename S>
+bool ObjectAABBHierarchy<S>::isLeaf(NodeId node) const
+{
+  return nodes[node].obj != nullptr;
+}
+
+//==============================================================================
+template <typename S>
+typename ObjectAABBHierarchy<S>::NodeId ObjectAABBHierarchy<S>::getChild(
+    NodeId node, int i) const
+{
+  return nodes[node].children[i];
+}
+
+//==============================================================================
+template <typename S>
+const AABB<S>& ObjectAABBHierarchy<S>::getAABB(NodeId node) const
+{
+  return nodes[node].bv;
+}
+
+//==============================================================================
+template <typename S>
+CollisionObject<S>* ObjectAABBHierarchy<S>::getObject(NodeId node) const
+{
+  return nodes[node].obj;
+}
+
+//==============================================================================
+template <typename S>
+typename ObjectAABBHierarchy<S>::NodeId ObjectAABBHierarchy<S>::build(
+    std::size_t begin, std::size_t end)
+{
+  const NodeId node = nodes.size();
+  nodes.emplace_back();
+
+  if(end - begin == 1)
+  {
+    nodes[node].bv = objs[begin]->getAABB();
+    nodes[node].obj = objs[begin];
+    return node;
+  }
+
+  AABB<S> centers(objs[begin]->getAABB().center());
+  for(std::size_t i = begin + 1; i < end; ++i)
+    centers += objs[i]->getAABB().center();
+
+  int axis;
+  (centers.max_ - centers.min_).maxCoeff(&axis);
+
+  const std::size_t mid = begin + (end - begin) / 2;
+  std::nth_element(objs.begin() + begin, objs.begin() + mid, objs.begin() + end,
+                   [axis](CollisionObject<S>* a, CollisionObject<S>* b)
+  {
+    return a->getAABB().center()[axis] < b->getAABB().center()[axis];
+  });
+
+  const NodeId child0 = build(begin, mid);
+  const NodeId child1 = build(mid, end);
+  nodes[node].children[0] = child0;
+  nodes[node].children[1] = child1;
+  nodes[node].bv = nodes[child0].bv + nodes[child1].bv;
+  nodes[node].obj = nullptr;
+  return node;
+}
+
+} // namespace detail
+} // namespace fcl
+
+#endif
@@ -0,0 +1,423 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef FCL_BROADPHASE_DETAIL_FLATHASHSET_H
+#define FCL_BROADPHASE_DETAIL_FLATHASHSET_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+namespace fcl
+{
+
+namespace detail
+{
+
+/// @brief Hash set with open addressing (linear probing) over a contiguous
+/// slot array. Erasure uses backward shifting, so the table never accumulates
+/// tombstones and lookups stay short however often keys come and go. The
+/// output of Hash is remixed, so identity hashes of pointers are fine.
+template <typename Key,
+          typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+class FlatHashSet
+{
+public:
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Key*;
+    using reference = const Key&;
+
+    const_iterator(const FlatHashSet* set, std::size_t slot);
+
+    reference operator*() const;
+    pointer operator->() const;
+    const_iterator& operator++();
+    const_iterator operator++(int);
+    bool operator==(const const_iterator& other) const;
+    bool operator!=(const const_iterator& other) const;
+
+  private:
+    const FlatHashSet* set_;
+    std::size_t slot_;
+  };
+
+  FlatHashSet(const Hash& hash = Hash(), const Equal& equal = Equal());
+
+  /// @brief Insert a key; return false if it was already present
+  bool insert(const Key& key);
+
+  /// @brief Erase a key; return false if it was not present
+  bool erase(const Key& key);
+
+  /// @brief Whether the key is present
+  bool contains(const Key& key) const;
+
+  /// @brief Erase all keys for which pred(key) is true; return the number of
+  /// erased keys
+  template <typename Predicate>
+  std::size_t eraseIf(Predicate pred);
+
+  /// @brief Make room for n keys without rehashing
+  void reserve(std::size_t n);
+
+  /// @brief Remove all keys, keeping the allocated slots
+  void clear();
+
+  std::size_t size() const;
+
+  bool empty() const;
+
+  const_iterator begin() const;
+
+  const_iterator end() const;
+
+private:
+
+  std::vector<Key> keys_;
+
+  std::vector<unsigned char> used_;
+
+  std::size_t size_;
+
+  Hash hash_;
+
+  Equal equal_;
+
+  /// @brief Home slot of a key
+  std::size_t home(const Key& key) const;
+
+  /// @brief Slot holding the key, or keys_.size() if absent
+  std::size_t find(const Key& key) const;
+
+  /// @brief Empty a slot and shift the rest of its probe run back
+  void eraseSlot(std::size_t slot);
+
+  void rehash(std::size_t capacity);
+};
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+FlatHashSet<Key, Hash, Equal>::const_iterator::const_iterator(
+    const FlatHashSet* set, std::size_t slot)
+  : set_(set), slot_(slot)
+{
+  while(slot_ < set_->used_.size() && !set_->used_[slot_])
+    ++slot_;
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+const Key& FlatHashSet<Key, Hash, Equal>::const_iterator::operator*() const
+{
+  return set_->keys_[slot_];
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+const Key* FlatHashSet<Key, Hash, Equal>::const_iterator::operator->() const
+{
+  return &set_->keys_[slot_];
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+typename FlatHashSet<Key, Hash, Equal>::const_iterator&
+FlatHashSet<Key, Hash, Equal>::const_iterator::operator++()
+{
+  ++slot_;
+  while(slot_ < set_->used_.size() && !set_->used_[slot_])
+    ++slot_;
+  return *this;
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+typename FlatHashSet<Key, Hash, Equal>::const_iterator
+FlatHashSet<Key, Hash, Equal>::const_iterator::operator++(int)
+{
+  const_iterator it = *this;
+  ++(*this);
+  return it;
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+bool FlatHashSet<Key, Hash, Equal>::const_iterator::operator==(
+    const const_iterator& other) const
+{
+  return slot_ == other.slot_;
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+bool FlatHashSet<Key, Hash, Equal>::const_iterator::operator!=(
+    const const_iterator& other) const
+{
+  return slot_ != other.slot_;
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+FlatHashSet<Key, Hash, Equal>::FlatHashSet(const Hash& hash,
+                                           const Equal& equal)
+  : size_(0), hash_(hash), equal_(equal)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+bool FlatHashSet<Key, Hash, Equal>::insert(const Key& key)
+{
+  // Keep the load factor at or below one half
+  if(2 * (size_ + 1) > keys_.size())
+    rehash(keys_.size() ? 2 * keys_.size() : 16);
+
+  const std::size_t mask = keys_.size() - 1;
+  std::size_t slot = home(key);
+  while(used_[slot])
+  {
+    if(equal_(keys_[slot], key))
+      return false;
+    slot = (slot + 1) & mask;
+  }
+
+  keys_[slot] = key;
+  used_[slot] = 1;
+  ++size_;
+  return true;
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+bool FlatHashSet<Key, Hash, Equal>::erase(const Key& key)
+{
+  const std::size_t slot = find(key);
+  if(slot == keys_.size())
+    return false;
+
+  eraseSlot(slot);
+  return true;
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+bool FlatHashSet<Key, Hash, Equal>::contains(const Key& key) const
+{
+  return find(key) != keys_.size();
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+template <typename Predicate>
+std::size_t FlatHashSet<Key, Hash, Equal>::eraseIf(Predicate pred)
+{
+  std::size_t num_erased = 0;
+  std::size_t slot = 0;
+  while(slot < keys_.size())
+  {
+    // Backward shifting may move a later key into this slot, so look at the
+    // slot again after erasing. Keys that wrap around from the front are
+    // visited twice, which is harmless for a pure predicate.
+    if(used_[slot] && pred(keys_[slot]))
+    {
+      eraseSlot(slot);
+      ++num_erased;
+    }
+    else
+    {
+      ++slot;
+    }
+  }
+
+  return num_erased;
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+void FlatHashSet<Key, Hash, Equal>::reserve(std::size_t n)
+{
+  std::size_t capacity = keys_.size() ? keys_.size() : 16;
+  while(capacity < 2 * n)
+    capacity *= 2;
+
+  if(capacity > keys_.size())
+    rehash(capacity);
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+void FlatHashSet<Key, Hash, Equal>::clear()
+{
+  std::fill(used_.begin(), used_.end(), 0);
+  size_ = 0;
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+std::size_t FlatHashSet<Key, Hash, Equal>::size() const
+{
+  return size_;
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+bool FlatHashSet<Key, Hash, Equal>::empty() const
+{
+  return size_ == 0;
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+typename FlatHashSet<Key, Hash, Equal>::const_iterator
+FlatHashSet<Key, Hash, Equal>::begin() const
+{
+  return const_iterator(this, 0);
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+typename FlatHashSet<Key, Hash, Equal>::const_iterator
+FlatHashSet<Key, Hash, Equal>::end() const
+{
+  return const_iterator(this, keys_.size());
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+std::size_t FlatHashSet<Key, Hash, Equal>::home(const Key& key) const
+{
+  // 64-bit finalizer from MurmurHash3, so that aligned pointers and other
+  // regular hashes spread over the low bits used for the slot index
+  std::uint64_t h = static_cast<std::uint64_t>(hash_(key));
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return static_cast<std::size_t>(h) & (keys_.size() - 1);
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+std::size_t FlatHashSet<Key, Hash, Equal>::find(const Key& key) const
+{
+  if(size_ == 0)
+    return keys_.size();
+
+  const std::size_t mask = keys_.size() - 1;
+  std::size_t slot = home(key);
+  while(used_[slot])
+  {
+    if(equal_(keys_[slot], key))
+      return slot;
+    slot = (slot + 1) & mask;
+  }
+
+  return keys_.size();
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+void FlatHashSet<Key, Hash, Equal>::eraseSlot(std::size_t slot)
+{
+  const std::size_t mask = keys_.size() - 1;
+  std::size_t hole = slot;
+  std::size_t next = (hole + 1) & mask;
+  while(used_[next])
+  {
+    // A key may fill the hole only if the hole lies cyclically between its
+    // home slot and its current slot
+    const std::size_t h = home(keys_[next]);
+    if(((next - h) & mask) >= ((next - hole) & mask))
+    {
+      keys_[hole] = keys_[next];
+      hole = next;
+    }
+    next = (next + 1) & mask;
+  }
+
+  used_[hole] = 0;
+  --size_;
+}
+
+//==============================================================================
+template <typename Key, typename Hash, typename Equal>
+void FlatHashSet<Key, Hash, Equal>::rehash(std::size_t capacity)
+{
+  std::vector<Key> keys;
+  std::vector<unsigned char> used;
+  keys.swap(keys_);
+  used.swap(used_);
+
+  keys_.resize(capacity);
+  used_.assign(capacity, 0);
+  size_ = 0;
+
+  const std::size_t mask = capacity - 1;
+  for(std::size_t i = 0; i < keys.size(); ++i)
+  {
+    if(!used[i])
+      continue;
+
+    std::size_t slot = home(keys[i]);
+    while(used_[slot])
+      slot = (slot + 1) & mask;
+    keys_[slot] = keys[i];
+    used_[slot] = 1;
+    ++size_;
+  }
+}
+
+} // namespace detail
+} // namespace fcl
+
+#endif
@@ -0,0 +1,283 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FCL_BROADPHASE_FLATHASHTABLE_H
+#define FCL_BROADPHASE_FLATHASHTABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace fcl
+{
+
+namespace detail
+{
+
+/// @brief A hash table from cell index to the data in that cell, implemented
+/// with open addressing (linear probing) over contiguous arrays. HashFnc is any
+/// extended hash function: HashFnc(key) = {index1, index2, ..., }. The bins
+/// keep their memory across clear(), so that a table refilled every frame
+/// stops allocating once it has grown. A bin emptied by remove() keeps its
+/// cell until the next clear().
+template<typename Key, typename Data, typename HashFnc>
+class FlatHashTable
+{
+protected:
+  typedef std::vector<Data> Bin;
+
+  /// @brief cell index of each slot
+  std::vector<unsigned int> keys_;
+
+  /// @brief whether each slot holds a cell
+  std::vector<unsigned char> used_;
+
+  /// @brief data of each slot
+  std::vector<Bin> bins_;
+
+  /// @brief number of slots holding a cell
+  size_t num_cells_;
+
+  HashFnc h_;
+
+public:
+  FlatHashTable(const HashFnc& h);
+
+  /// @brief Init the hash table with room for size cells; the table grows
+  /// beyond that as needed
+  void init(size_t size);
+
+  //// @brief Insert a key-value pair into the table
+  void insert(Key key, Data value);
+
+  /// @brief Find the elements in the hash table whose key is the same as query
+  /// key.
+  std::vector<Data> query(Key key) const;
+
+  /// @brief remove the key-value pair from the table
+  void remove(Key key, Data value);
+
+  /// @brief clear the hash table
+  void clear();
+
+protected:
+  /// @brief Home slot of a cell index
+  size_t home(unsigned int index) const;
+
+  /// @brief Slot holding the cell index, or keys_.size() if absent
+  size_t find(unsigned int index) const;
+
+  /// @brief Bin of the cell index, which is added if absent
+  Bin& bin(unsigned int index);
+
+  void rehash(size_t capacity);
+};
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template<typename Key, typename Data, typename HashFnc>
+FlatHashTable<Key, Data, HashFnc>::FlatHashTable(const HashFnc& h)
+  : num_cells_(0), h_(h)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template<typename Key, typename Data, typename HashFnc>
+void FlatHashTable<Key, Data, HashFnc>::init(size_t size)
+{
+  clear();
+
+  size_t capacity = 16;
+  while(capacity < 2 * size)
+    capacity *= 2;
+
+  if(capacity > keys_.size())
+    rehash(capacity);
+}
+
+//==============================================================================
+template<typename Key, typename Data, typename HashFnc>
+void FlatHashTable<Key, Data, HashFnc>::insert(Key key, Data value)
+{
+  std::vector<unsigned int> indices = h_(key);
+  for(size_t i = 0; i < indices.size(); ++i)
+    bin(indices[i]).push_back(value);
+}
+
+//==============================================================================
+template<typename Key, typename Data, typename HashFnc>
+std::vector<Data> FlatHashTable<Key, Data, HashFnc>::query(Key key) const
+{
+  std::vector<unsigned int> indices = h_(key);
+  std::vector<Data> result;
+  for(size_t i = 0; i < indices.size(); ++i)
+  {
+    const size_t slot = find(indices[i]);
+    if(slot != keys_.size())
+      result.insert(result.end(), bins_[slot].begin(), bins_[slot].end());
+  }
+
+  // an object spanning several of the cells is found once per cell
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+
+  return result;
+}
+
+//==============================================================================
+template<typename Key, typename Data, typename HashFnc>
+void FlatHashTable<Key, Data, HashFnc>::remove(Key key, Data value)
+{
+  std::vector<unsigned int> indices = h_(key);
+  for(size_t i = 0; i < indices.size(); ++i)
+  {
+    const size_t slot = find(indices[i]);
+    if(slot == keys_.size())
+      continue;
+
+    Bin& b = bins_[slot];
+    b.erase(std::remove(b.begin(), b.end(), value), b.end());
+  }
+}
+
+//==============================================================================
+template<typename Key, typename Data, typename HashFnc>
+void FlatHashTable<Key, Data, HashFnc>::clear()
+{
+  for(size_t i = 0; i < keys_.size(); ++i)
+  {
+    if(used_[i])
+    {
+      bins_[i].clear();
+      used_[i] = 0;
+    }
+  }
+
+  num_cells_ = 0;
+}
+
+//==============================================================================
+template<typename Key, typename Data, typename HashFnc>
+size_t FlatHashTable<Key, Data, HashFnc>::home(unsigned int index) const
+{
+  // Fibonacci hashing, so that the neighbouring cell indices of a grid spread
+  // over the table
+  const std::uint64_t h = static_cast<std::uint64_t>(index) * 0x9e3779b97f4a7c15ULL;
+  return static_cast<size_t>(h >> 32) & (keys_.size() - 1);
+}
+
+//==============================================================================
+template<typename Key, typename Data, typename HashFnc>
+size_t FlatHashTable<Key, Data, HashFnc>::find(unsigned int index) const
+{
+  if(num_cells_ == 0)
+    return keys_.size();
+
+  const size_t mask = keys_.size() - 1;
+  size_t slot = home(index);
+  while(used_[slot])
+  {
+    if(keys_[slot] == index)
+      return slot;
+    slot = (slot + 1) & mask;
+  }
+
+  return keys_.size();
+}
+
+//==============================================================================
+template<typename Key, typename Data, typename HashFnc>
+typename FlatHashTable<Key, Data, HashFnc>::Bin&
+FlatHashTable<Key, Data, HashFnc>::bin(unsigned int index)
+{
+  // Keep the load factor at or below one half
+  if(2 * (num_cells_ + 1) > keys_.size())
+    rehash(keys_.size() ? 2 * keys_.size() : 16);
+
+  const size_t mask = keys_.size() - 1;
+  size_t slot = home(index);
+  while(used_[slot])
+  {
+    if(keys_[slot] == index)
+      return bins_[slot];
+    slot = (slot + 1) & mask;
+  }
+
+  keys_[slot] = index;
+  used_[slot] = 1;
+  ++num_cells_;
+  return bins_[slot];
+}
+
+//==============================================================================
+template<typename Key, typename Data, typename HashFnc>
+void FlatHashTable<Key, Data, HashFnc>::rehash(size_t capacity)
+{
+  std::vector<unsigned int> keys;
+  std::vector<unsigned char> used;
+  std::vector<Bin> bins;
+  keys.swap(keys_);
+  used.swap(used_);
+  bins.swap(bins_);
+
+  keys_.resize(capacity);
+  used_.assign(capacity, 0);
+  bins_.resize(capacity);
+
+  const size_t mask = capacity - 1;
+  for(size_t i = 0; i < keys.size(); ++i)
+  {
+    if(!used[i])
+      continue;
+
+    size_t slot = home(keys[i]);
+    while(used_[slot])
+      slot = (slot + 1) & mask;
+    keys_[slot] = keys[i];
+    used_[slot] = 1;
+    bins_[slot].swap(bins[i]);
+  }
+}
+
+} // namespace detail
+} // namespace fcl
+
+#endif
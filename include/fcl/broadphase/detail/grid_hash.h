@@ -0,0 +1,154 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef FCL_BROADPHASE_GRIDHASH_H
+#define FCL_BROADPHASE_GRIDHASH_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "fcl/math/bv/AABB.h"
+
+namespace fcl
+{
+
+namespace detail
+{
+
+/// @brief Spatial hash function over an unbounded grid of cubic cells: hash an
+/// AABB to the keys of all the cells it overlaps. Unlike SpatialHash, there is
+/// no scene limit, so distinct cells may share a key; users of the keys must
+/// check the AABBs of what they find.
+template <typename S_>
+struct GridHash
+{
+  using S = S_;
+
+  GridHash(S cell_size_);
+
+  std::vector<unsigned int> operator() (const AABB<S>& aabb) const;
+
+  /// @brief the number of cells the AABB overlaps
+  double numCells(const AABB<S>& aabb) const;
+
+  S cellSize() const;
+
+private:
+
+  /// @brief the cell coordinate of a value along one axis
+  std::int64_t coord(S value) const;
+
+  S cell_size;
+};
+
+using GridHashf = GridHash<float>;
+using GridHashd = GridHash<double>;
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template <typename S>
+GridHash<S>::GridHash(S cell_size_)
+  : cell_size(cell_size_)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template <typename S>
+std::vector<unsigned int> GridHash<S>::operator()(const AABB<S>& aabb) const
+{
+  const std::int64_t min_x = coord(aabb.min_[0]);
+  const std::int64_t max_x = coord(aabb.max_[0]);
+  const std::int64_t min_y = coord(aabb.min_[1]);
+  const std::int64_t max_y = coord(aabb.max_[1]);
+  const std::int64_t min_z = coord(aabb.min_[2]);
+  const std::int64_t max_z = coord(aabb.max_[2]);
+
+  std::vector<unsigned int> keys;
+  keys.reserve((max_x - min_x + 1) * (max_y - min_y + 1) * (max_z - min_z + 1));
+  for(std::int64_t x = min_x; x <= max_x; ++x)
+  {
+    for(std::int64_t y = min_y; y <= max_y; ++y)
+    {
+      for(std::int64_t z = min_z; z <= max_z; ++z)
+      {
+        // the primes of Teschner et al., "Optimized Spatial Hashing for
+        // Collision Detection of Deformable Objects"
+        const std::uint64_t h = (static_cast<std::uint64_t>(x) * 73856093ULL)
+            ^ (static_cast<std::uint64_t>(y) * 19349663ULL)
+            ^ (static_cast<std::uint64_t>(z) * 83492791ULL);
+        keys.push_back(static_cast<unsigned int>(h ^ (h >> 32)));
+      }
+    }
+  }
+
+  return keys;
+}
+
+//==============================================================================
+template <typename S>
+double GridHash<S>::numCells(const AABB<S>& aabb) const
+{
+  // computed in floating point, so that huge AABBs do not overflow
+  double n = 1;
+  for(int i = 0; i < 3; ++i)
+    n *= std::floor(aabb.max_[i] / cell_size) - std::floor(aabb.min_[i] / cell_size) + 1;
+  return n;
+}
+
+//==============================================================================
+template <typename S>
+S GridHash<S>::cellSize() const
+{
+  return cell_size;
+}
+
+//==============================================================================
+template <typename S>
+std::int64_t GridHash<S>::coord(S value) const
+{
+  return static_cast<std::int64_t>(std::floor(value / cell_size));
+}
+
+} // namespace detail
+} // namespace fcl
+
+#endif
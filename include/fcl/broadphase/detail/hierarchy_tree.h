@@ -44,7 +44,7 @@
 #include <iostream>
 #include "fcl/common/warning.h"
 #include "fcl/math/bv/AABB.h"
-#include "fcl/broadphase/detail/morton.h"
+#include "fcl/math/detail/morton.h"
 #include "fcl/broadphase/detail/node_base.h"
 
 namespace fcl
@@ -92,7 +92,10 @@ public:
   /// @brief update the tree when the bounding volume of a given leaf has changed
   bool update(NodeType* leaf, const BV& bv);
 
-  /// @brief update one leaf's bounding volume, with prediction 
+  /// @brief update one leaf's bounding volume, with prediction: if bv
+  /// escapes the leaf's bounding volume, the leaf is reinserted with bv
+  /// enlarged by margin and extended along the expected displacement vel, so
+  /// that it does not need to move again until bv escapes that larger volume
   bool update(NodeType* leaf, const BV& bv, const Vector3<S>& vel, S margin);
 
   /// @brief update one leaf's bounding volume, with prediction 
@@ -247,6 +250,12 @@ public:
   int bu_threshold;
 };
 
+/// @brief Enlarge a bounding volume by margin and extend it along the expected
+/// displacement vel. Only AABBs are enlarged; other bounding volumes are
+/// returned as they are.
+template<typename BV>
+BV fatBV(const BV& bv, const Vector3<typename BV::S>& vel, typename BV::S margin);
+
 /// @brief Compare two nodes accoording to the d-th dimension of node center
 template<typename BV>
 bool nodeBaseLess(NodeBase<BV>* a, NodeBase<BV>* b, int d);
@@ -380,46 +389,22 @@ bool HierarchyTree<BV>::update(NodeType* leaf, const BV& bv)
   return true;
 }
 
-//==============================================================================
-template <typename S, typename BV>
-struct UpdateImpl
-{
-  static bool run(
-      const HierarchyTree<BV>& tree,
-      typename HierarchyTree<BV>::NodeType* leaf,
-      const BV& bv,
-      const Vector3<S>& /*vel*/,
-      S /*margin*/)
-  {
-    if(leaf->bv.contain(bv)) return false;
-    tree.update_(leaf, bv);
-    return true;
-  }
-
-  static bool run(
-      const HierarchyTree<BV>& tree,
-      typename HierarchyTree<BV>::NodeType* leaf,
-      const BV& bv,
-      const Vector3<S>& /*vel*/)
-  {
-    if(leaf->bv.contain(bv)) return false;
-    tree.update_(leaf, bv);
-    return true;
-  }
-};
-
 //==============================================================================
 template<typename BV>
 bool HierarchyTree<BV>::update(NodeType* leaf, const BV& bv, const Vector3<S>& vel, S margin)
 {
-  return UpdateImpl<typename BV::S, BV>::run(*this, leaf, bv, vel, margin);
+  if(leaf->bv.contain(bv)) return false;
+  update_(leaf, fatBV(bv, vel, margin));
+  return true;
 }
 
 //==============================================================================
 template<typename BV>
 bool HierarchyTree<BV>::update(NodeType* leaf, const BV& bv, const Vector3<S>& vel)
 {
-  return UpdateImpl<typename BV::S, BV>::run(*this, leaf, bv, vel);
+  if(leaf->bv.contain(bv)) return false;
+  update_(leaf, fatBV(bv, vel, (S)0));
+  return true;
 }
 
 //==============================================================================
@@ -1226,6 +1211,43 @@ bool nodeBaseLess(NodeBase<BV>* a, NodeBase<BV>* b, int d)
   return false;
 }
 
+//==============================================================================
+template <typename S, typename BV>
+struct FatBVImpl
+{
+  static BV run(const BV& bv, const Vector3<S>& /*vel*/, S /*margin*/)
+  {
+    return bv;
+  }
+};
+
+//==============================================================================
+template <typename S>
+struct FatBVImpl<S, AABB<S>>
+{
+  static AABB<S> run(const AABB<S>& bv, const Vector3<S>& vel, S margin)
+  {
+    AABB<S> res(bv);
+    for(int i = 0; i < 3; ++i)
+    {
+      res.min_[i] -= margin;
+      res.max_[i] += margin;
+      if(vel[i] < 0)
+        res.min_[i] += vel[i];
+      else
+        res.max_[i] += vel[i];
+    }
+    return res;
+  }
+};
+
+//==============================================================================
+template<typename BV>
+BV fatBV(const BV& bv, const Vector3<typename BV::S>& vel, typename BV::S margin)
+{
+  return FatBVImpl<typename BV::S, BV>::run(bv, vel, margin);
+}
+
 //==============================================================================
 template <typename S, typename BV>
 struct SelectImpl
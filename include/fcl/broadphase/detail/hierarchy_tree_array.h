@@ -43,9 +43,11 @@
 #include <functional>
 #include <iostream>
 #include "fcl/common/warning.h"
+#include "fcl/common/detail/parallel.h"
 #include "fcl/math/bv/AABB.h"
-#include "fcl/broadphase/detail/morton.h"
+#include "fcl/math/detail/morton.h"
 #include "fcl/broadphase/detail/node_base_array.h"
+#include "fcl/broadphase/detail/hierarchy_tree.h"
 
 namespace fcl
 {
@@ -111,7 +113,9 @@ public:
   /// @brief update the tree when the bounding volume of a given leaf has changed
   bool update(size_t leaf, const BV& bv);
 
-  /// @brief update one leaf's bounding volume, with prediction 
+  /// @brief update one leaf's bounding volume, with prediction: if bv
+  /// escapes the leaf's bounding volume, the leaf is reinserted with bv
+  /// enlarged by margin and extended along the expected displacement vel
   bool update(size_t leaf, const BV& bv, const Vector3<S>& vel, S margin);
 
   /// @brief update one leaf's bounding volume, with prediction 
@@ -135,6 +139,26 @@ public:
   /// @brief refit the tree, i.e., when the leaf nodes' bounding volumes change, update the entire tree in a bottom-up manner
   void refit();
 
+  /// @brief refit the tree from the given leaves, which must be all the leaves
+  /// of the tree, using num_threads threads. Each thread walks up from its
+  /// leaves; an atomic counter per node lets only the second child to arrive
+  /// go on, so every internal node is refit once, after both its children.
+  void refit(const std::vector<size_t>& leaves, int num_threads);
+
+  /// @brief same as refit(leaves, num_threads), but also rotate each internal
+  /// node's children with its grandchildren when that lowers the SAH cost
+  /// (Kensler, "Tree Rotations for Improving Bounding Volume Hierarchies").
+  /// Returns the SAH cost of the refit tree before and after the rotations.
+  void refitAndRotate(const std::vector<size_t>& leaves, int num_threads,
+                      S& sah_cost_before, S& sah_cost_after);
+
+  /// @brief the SAH cost of the tree: the summed surface areas of the
+  /// internal nodes, relative to the surface area of the root
+  S getSAHCost() const;
+
+  /// @brief get the ids of all the leaves of the tree
+  void getLeaves(std::vector<size_t>& leaves) const;
+
   /// @brief extract all the leaves of the tree 
   void extractLeaves(size_t root, NodeType*& leaves) const;
 
@@ -229,6 +253,21 @@ private:
 
   void recurseRefit(size_t node);
 
+  /// @brief refit the tree in parallel from all its leaves, optionally
+  /// rotating the nodes; accumulate the summed surface areas of the internal
+  /// nodes before and after the rotations
+  void refitBottomup(const std::vector<size_t>& leaves, int num_threads, bool rotate,
+                     S& area_before, S& area_after);
+
+  /// @brief apply the rotation among the children and grandchildren of an
+  /// internal node that lowers the summed surface area most, if any; return
+  /// the change of the summed surface area
+  S rotate(size_t node);
+
+  S getSAHArea(size_t node) const;
+
+  void getLeaves(size_t node, std::vector<size_t>& leaves) const;
+
 protected:
   size_t root_node;
   NodeType* nodes;
@@ -273,6 +312,10 @@ private:
   size_t d;
 };
 
+/// @brief the surface area of a bounding volume, used by the SAH cost
+template<typename BV>
+typename BV::S surfaceArea(const BV& bv);
+
 /// @brief select the node from node1 and node2 which is close to the query-th
 /// node in the nodes. 0 for node1 and 1 for node2.
 template<typename BV>
@@ -583,7 +626,7 @@ template<typename BV>
 bool HierarchyTree<BV>::update(size_t leaf, const BV& bv, const Vector3<S>& vel, S margin)
 {
   if(nodes[leaf].bv.contain(bv)) return false;
-  update_(leaf, bv);
+  update_(leaf, fatBV(bv, vel, margin));
   return true;
 }
 
@@ -592,7 +635,7 @@ template<typename BV>
 bool HierarchyTree<BV>::update(size_t leaf, const BV& bv, const Vector3<S>& vel)
 {
   if(nodes[leaf].bv.contain(bv)) return false;
-  update_(leaf, bv);
+  update_(leaf, fatBV(bv, vel, (S)0));
   return true;
 }
 
@@ -701,6 +744,47 @@ void HierarchyTree<BV>::refit()
     recurseRefit(root_node);
 }
 
+//==============================================================================
+template<typename BV>
+void HierarchyTree<BV>::refit(const std::vector<size_t>& leaves, int num_threads)
+{
+  S area_before, area_after;
+  refitBottomup(leaves, num_threads, false, area_before, area_after);
+}
+
+//==============================================================================
+template<typename BV>
+void HierarchyTree<BV>::refitAndRotate(const std::vector<size_t>& leaves, int num_threads,
+                                       S& sah_cost_before, S& sah_cost_after)
+{
+  S area_before, area_after;
+  refitBottomup(leaves, num_threads, true, area_before, area_after);
+
+  const S root_area = (root_node != NULL_NODE) ? surfaceArea(nodes[root_node].bv) : 0;
+  sah_cost_before = (root_area > 0) ? area_before / root_area : 0;
+  sah_cost_after = (root_area > 0) ? area_after / root_area : 0;
+}
+
+//==============================================================================
+template<typename BV>
+typename HierarchyTree<BV>::S HierarchyTree<BV>::getSAHCost() const
+{
+  if(root_node == NULL_NODE) return 0;
+
+  const S root_area = surfaceArea(nodes[root_node].bv);
+  return (root_area > 0) ? getSAHArea(root_node) / root_area : 0;
+}
+
+//==============================================================================
+template<typename BV>
+void HierarchyTree<BV>::getLeaves(std::vector<size_t>& leaves) const
+{
+  leaves.clear();
+  leaves.reserve(n_leaves);
+  if(root_node != NULL_NODE)
+    getLeaves(root_node, leaves);
+}
+
 //==============================================================================
 template<typename BV>
 void HierarchyTree<BV>::extractLeaves(size_t root, NodeType*& leaves) const
@@ -1169,10 +1253,11 @@ void HierarchyTree<BV>::update_(size_t leaf, const BV& bv)
       for(int i = 0; (i < max_lookahead_level) && (nodes[root].parent != NULL_NODE); ++i)
         root = nodes[root].parent;
     }
-
-    nodes[leaf].bv = bv;
-    insertLeaf(root, leaf);
   }
+
+  // a leaf that was the whole tree is put back as the new root
+  nodes[leaf].bv = bv;
+  insertLeaf(root, leaf);
 }
 
 //==============================================================================
@@ -1270,6 +1355,137 @@ void HierarchyTree<BV>::recurseRefit(size_t node)
     return;
 }
 
+//==============================================================================
+template<typename BV>
+void HierarchyTree<BV>::refitBottomup(const std::vector<size_t>& leaves, int num_threads, bool rotate_nodes,
+                                      S& area_before, S& area_after)
+{
+  area_before = 0;
+  area_after = 0;
+  if(root_node == NULL_NODE)
+    return;
+
+  // the number of children that reached each node so far
+  std::vector<std::atomic<unsigned int>> visits(n_nodes_alloc);
+  for(size_t i = 0; i < n_nodes_alloc; ++i)
+    visits[i].store(0, std::memory_order_relaxed);
+
+  // leaves are handed out in blocks to keep the shared task counter cold
+  const size_t block_size = 256;
+  const size_t num_blocks = (leaves.size() + block_size - 1) / block_size;
+  num_threads = resolveNumThreads(num_threads);
+  std::vector<S> thread_area_before(num_threads, 0);
+  std::vector<S> thread_area_after(num_threads, 0);
+
+  parallelFor(num_blocks, num_threads, [&](size_t block, int thread_id)
+  {
+    const size_t end = std::min(leaves.size(), (block + 1) * block_size);
+    for(size_t i = block * block_size; i < end; ++i)
+    {
+      size_t node = nodes[leaves[i]].parent;
+      while(node != NULL_NODE)
+      {
+        // the first child to arrive stops here, the second one finishes the
+        // node: both subtrees are complete and no other thread touches them
+        if(visits[node].fetch_add(1, std::memory_order_acq_rel) == 0)
+          break;
+
+        nodes[node].bv = nodes[nodes[node].children[0]].bv + nodes[nodes[node].children[1]].bv;
+
+        // rotations below a node keep its leaves, so its area is the same in
+        // the tree before and after the rotations
+        const S area = surfaceArea(nodes[node].bv);
+        thread_area_before[thread_id] += area;
+        thread_area_after[thread_id] += area;
+        if(rotate_nodes)
+          thread_area_after[thread_id] += rotate(node);
+
+        node = nodes[node].parent;
+      }
+    }
+  });
+
+  for(int i = 0; i < num_threads; ++i)
+  {
+    area_before += thread_area_before[i];
+    area_after += thread_area_after[i];
+  }
+}
+
+//==============================================================================
+template<typename BV>
+typename HierarchyTree<BV>::S HierarchyTree<BV>::rotate(size_t node)
+{
+  // Swapping a child with a grandchild below the other child changes only the
+  // bounding volume of that other child
+  S best_gain = 0;
+  size_t best_child = NULL_NODE;
+  size_t best_grandchild = NULL_NODE;
+
+  for(size_t i = 0; i < 2; ++i)
+  {
+    const size_t child = nodes[node].children[i];
+    const size_t other = nodes[node].children[1 - i];
+    if(nodes[other].isLeaf())
+      continue;
+
+    const S other_area = surfaceArea(nodes[other].bv);
+    for(size_t j = 0; j < 2; ++j)
+    {
+      const size_t kept = nodes[other].children[1 - j];
+      const S gain = other_area - surfaceArea(nodes[child].bv + nodes[kept].bv);
+      if(gain > best_gain)
+      {
+        best_gain = gain;
+        best_child = i;
+        best_grandchild = j;
+      }
+    }
+  }
+
+  if(best_child == NULL_NODE)
+    return 0;
+
+  const size_t child = nodes[node].children[best_child];
+  const size_t other = nodes[node].children[1 - best_child];
+  const size_t grandchild = nodes[other].children[best_grandchild];
+
+  nodes[node].children[best_child] = grandchild;
+  nodes[grandchild].parent = node;
+  nodes[other].children[best_grandchild] = child;
+  nodes[child].parent = other;
+  nodes[other].bv = nodes[nodes[other].children[0]].bv + nodes[nodes[other].children[1]].bv;
+
+  return -best_gain;
+}
+
+//==============================================================================
+template<typename BV>
+typename HierarchyTree<BV>::S HierarchyTree<BV>::getSAHArea(size_t node) const
+{
+  if(nodes[node].isLeaf())
+    return 0;
+
+  return surfaceArea(nodes[node].bv)
+      + getSAHArea(nodes[node].children[0])
+      + getSAHArea(nodes[node].children[1]);
+}
+
+//==============================================================================
+template<typename BV>
+void HierarchyTree<BV>::getLeaves(size_t node, std::vector<size_t>& leaves) const
+{
+  if(nodes[node].isLeaf())
+  {
+    leaves.push_back(node);
+  }
+  else
+  {
+    getLeaves(nodes[node].children[0], leaves);
+    getLeaves(nodes[node].children[1], leaves);
+  }
+}
+
 //==============================================================================
 template<typename BV>
 void HierarchyTree<BV>::fetchLeaves(size_t root, NodeType*& leaves, int depth)
@@ -1305,6 +1521,36 @@ bool nodeBaseLess<BV>::operator()(size_t i, size_t j) const
   return false;
 }
 
+//==============================================================================
+template <typename S, typename BV>
+struct SurfaceAreaImpl
+{
+  static S run(const BV& bv)
+  {
+    return bv.size();
+  }
+};
+
+//==============================================================================
+template <typename S>
+struct SurfaceAreaImpl<S, AABB<S>>
+{
+  static S run(const AABB<S>& bv)
+  {
+    const S w = bv.width();
+    const S h = bv.height();
+    const S d = bv.depth();
+    return 2 * (w * h + h * d + d * w);
+  }
+};
+
+//==============================================================================
+template<typename BV>
+typename BV::S surfaceArea(const BV& bv)
+{
+  return SurfaceAreaImpl<typename BV::S, BV>::run(bv);
+}
+
 //==============================================================================
 template <typename S, typename BV>
 struct SelectImpl
@@ -42,6 +42,7 @@
 #include <limits>
 #include <cstdlib>
 #include <iostream>
+#include <vector>
 #include "fcl/broadphase/detail/interval_tree_node.h"
 
 namespace fcl
@@ -92,8 +93,9 @@ public:
   /// @brief Get the successor of a given node
   IntervalTreeNode<S>* getSuccessor(IntervalTreeNode<S>* node) const;
 
-  /// @brief Return result for a given query
-  std::deque<SimpleInterval<S>*> query(double low, double high);
+  /// @brief Return result for a given query. Safe to call from several
+  /// threads at once.
+  std::deque<SimpleInterval<S>*> query(double low, double high) const;
 
 protected:
 
@@ -120,12 +122,6 @@ protected:
   void fixupMaxHigh(IntervalTreeNode<S>* node);
 
   void deleteFixup(IntervalTreeNode<S>* node);
-
-private:
-  unsigned int recursion_node_stack_size;
-  it_recursion_node<S>* recursion_node_stack;
-  unsigned int current_parent;
-  unsigned int recursion_node_stack_top;
 };
 
 //============================================================================//
@@ -149,12 +145,6 @@ IntervalTree<S>::IntervalTree()
   root->key = root->high = root->max_high = std::numeric_limits<double>::max();
   root->red = false;
   root->stored_interval = nullptr;
-
-  /// the following are used for the query function
-  recursion_node_stack_size = 128;
-  recursion_node_stack = (it_recursion_node<S>*)malloc(recursion_node_stack_size*sizeof(it_recursion_node<S>));
-  recursion_node_stack_top = 1;
-  recursion_node_stack[0].start_node = nullptr;
 }
 
 //==============================================================================
@@ -193,7 +183,6 @@ IntervalTree<S>::~IntervalTree()
   }
   delete nil;
   delete root;
-  free(recursion_node_stack);
 }
 
 //==============================================================================
@@ -302,8 +291,8 @@ IntervalTreeNode<S>* IntervalTree<S>::insert(SimpleInterval<S>* new_interval)
       y = x->parent->parent->right;
       if(y->red)
       {
-        x->parent->red = true;
-        y->red = true;
+        x->parent->red = false;
+        y->red = false;
         x->parent->parent->red = true;
         x = x->parent->parent;
       }
@@ -609,13 +598,17 @@ bool overlap(S a1, S a2, S b1, S b2)
 
 //==============================================================================
 template <typename S>
-std::deque<SimpleInterval<S>*> IntervalTree<S>::query(double low, double high)
+std::deque<SimpleInterval<S>*> IntervalTree<S>::query(double low, double high) const
 {
   std::deque<SimpleInterval<S>*> result_stack;
   IntervalTreeNode<S>* x = root->left;
   bool run = (x != nil);
 
-  current_parent = 0;
+  // the recursion stack is per query, so that queries may run concurrently
+  std::vector<it_recursion_node<S>> recursion_node_stack(128);
+  unsigned int recursion_node_stack_top = 1;
+  recursion_node_stack[0].start_node = nullptr;
+  unsigned int current_parent = 0;
 
   while(run)
   {
@@ -626,13 +619,8 @@ std::deque<SimpleInterval<S>*> IntervalTree<S>::query(double low, double high)
     }
     if(x->left->max_high >= low)
     {
-      if(recursion_node_stack_top == recursion_node_stack_size)
-      {
-        recursion_node_stack_size *= 2;
-        recursion_node_stack = (it_recursion_node<S> *)realloc(recursion_node_stack, recursion_node_stack_size * sizeof(it_recursion_node<S>));
-        if(recursion_node_stack == nullptr)
-          exit(1);
-      }
+      if(recursion_node_stack_top == recursion_node_stack.size())
+        recursion_node_stack.resize(2 * recursion_node_stack.size());
       recursion_node_stack[recursion_node_stack_top].start_node = x;
       recursion_node_stack[recursion_node_stack_top].try_right_branch = false;
       recursion_node_stack[recursion_node_stack_top].parent_index = current_parent;
@@ -0,0 +1,147 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FCL_BROADPHASE_DETAIL_PARALLELSELFCOLLISION_H
+#define FCL_BROADPHASE_DETAIL_PARALLELSELFCOLLISION_H
+
+#include <atomic>
+#include <utility>
+#include <vector>
+#include "fcl/common/detail/parallel.h"
+#include "fcl/broadphase/broadphase_collision_manager.h"
+
+namespace fcl
+{
+
+namespace detail
+{
+
+/// @brief Collision callback that only records the pair into the
+/// std::vector<std::pair<CollisionObject<S>*, CollisionObject<S>*>> pointed by
+/// pairs.
+template <typename S>
+bool collectPairs(CollisionObject<S>* o1, CollisionObject<S>* o2, void* pairs);
+
+/// @brief Multi-threaded self collision shared by the broad phase managers,
+/// using cdata.size() threads. It runs in two phases:
+/// - collect(i, pairs) is called concurrently for each task i in
+///   [0, num_tasks), and appends the candidate pairs of task i to pairs (e.g.
+///   through collectPairs). The tasks in order must enumerate the pairs in the
+///   order of the serial collide().
+/// - the callbacks then run over all the pairs, handed out in small chunks in
+///   that order so that threads that drew cheap pairs pick up more. A thread
+///   calls callback only with its own cdata[t], so the pairs reported to one
+///   cdata come in the serial order.
+///
+/// Every candidate pair is collected before the first callback runs, so a
+/// callback that stops early still pays for the whole broad phase traversal.
+/// Each cdata has its own stop criterion: a thread stops at the first of its
+/// callbacks that returns true, and the other threads stop before their next
+/// pair. Pairs already in flight on other threads are still reported, so the
+/// merged results are in general a superset of those of the serial collide():
+/// with a callback that stops after k contacts, up to k contacts may be
+/// reported to each cdata.
+template <typename S, typename Collect>
+void parallelSelfCollide(
+    std::size_t num_tasks, Collect collect,
+    const std::vector<void*>& cdata, CollisionCallBack<S> callback);
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template <typename S>
+bool collectPairs(CollisionObject<S>* o1, CollisionObject<S>* o2, void* pairs)
+{
+  using ObjectPairs
+      = std::vector<std::pair<CollisionObject<S>*, CollisionObject<S>*>>;
+  static_cast<ObjectPairs*>(pairs)->emplace_back(o1, o2);
+  return false;
+}
+
+//==============================================================================
+template <typename S, typename Collect>
+void parallelSelfCollide(
+    std::size_t num_tasks, Collect collect,
+    const std::vector<void*>& cdata, CollisionCallBack<S> callback)
+{
+  if(num_tasks == 0 || cdata.empty()) return;
+
+  using ObjectPair = std::pair<CollisionObject<S>*, CollisionObject<S>*>;
+  const int num_threads = static_cast<int>(cdata.size());
+
+  std::vector<std::vector<ObjectPair>> task_pairs(num_tasks);
+  parallelFor(num_tasks, num_threads, [&](std::size_t i, int)
+  {
+    collect(i, &task_pairs[i]);
+  });
+
+  std::size_t num_pairs = 0;
+  for(const auto& pairs : task_pairs)
+    num_pairs += pairs.size();
+
+  std::vector<ObjectPair> pairs;
+  pairs.reserve(num_pairs);
+  for(const auto& p : task_pairs)
+    pairs.insert(pairs.end(), p.begin(), p.end());
+
+  // Small enough that uneven narrow phase costs even out between the threads,
+  // large enough that the shared chunk counter is not contended. parallelFor
+  // hands the chunks out in increasing order, so each thread sees its pairs in
+  // the serial order.
+  const std::size_t chunk_size = 32;
+  const std::size_t num_chunks = (num_pairs + chunk_size - 1) / chunk_size;
+  std::atomic<bool> done(false);
+  parallelFor(num_chunks, num_threads, [&](std::size_t chunk, int thread)
+  {
+    const std::size_t end = std::min((chunk + 1) * chunk_size, num_pairs);
+    for(std::size_t j = chunk * chunk_size; j < end; ++j)
+    {
+      if(done.load(std::memory_order_relaxed))
+        return;
+
+      if(callback(pairs[j].first, pairs[j].second, cdata[thread]))
+        done.store(true, std::memory_order_relaxed);
+    }
+  });
+}
+
+} // namespace detail
+} // namespace fcl
+
+#endif
@@ -0,0 +1,166 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FCL_COMMON_DETAIL_PARALLEL_H
+#define FCL_COMMON_DETAIL_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace fcl
+{
+
+namespace detail
+{
+
+/// @brief Return the number of threads to use when the caller asks for a
+/// non-positive thread count, i.e., the hardware concurrency (at least one).
+int resolveNumThreads(int num_threads);
+
+/// @brief Call func(task_id, thread_id) for every task_id in [0, num_tasks)
+/// using num_threads threads. Tasks are handed out one at a time through a
+/// shared atomic counter, so a thread that finishes early keeps pulling work
+/// from the remaining tasks. The calling thread takes part as thread 0, and
+/// no thread is spawned when num_threads or num_tasks is one.
+template <typename Func>
+void parallelFor(std::size_t num_tasks, int num_threads, Func func);
+
+/// @brief Sort [first, last) with comp using num_threads threads. The range is
+/// cut into one chunk per thread, the chunks are sorted concurrently, and
+/// neighbouring runs are then merged pairwise, again concurrently. Like
+/// std::sort, the order of equivalent elements is unspecified.
+template <typename RandomIt, typename Compare>
+void parallelSort(RandomIt first, RandomIt last, Compare comp, int num_threads);
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+inline int resolveNumThreads(int num_threads)
+{
+  if(num_threads > 0)
+    return num_threads;
+
+  const unsigned int hardware_threads = std::thread::hardware_concurrency();
+  return hardware_threads > 0 ? static_cast<int>(hardware_threads) : 1;
+}
+
+//==============================================================================
+template <typename Func>
+void parallelFor(std::size_t num_tasks, int num_threads, Func func)
+{
+  if(num_tasks == 0) return;
+
+  num_threads = resolveNumThreads(num_threads);
+  if(static_cast<std::size_t>(num_threads) > num_tasks)
+    num_threads = static_cast<int>(num_tasks);
+
+  if(num_threads == 1)
+  {
+    for(std::size_t i = 0; i < num_tasks; ++i)
+      func(i, 0);
+    return;
+  }
+
+  std::atomic<std::size_t> next_task(0);
+
+  auto worker = [&](int thread_id)
+  {
+    for(std::size_t i = next_task++; i < num_tasks; i = next_task++)
+      func(i, thread_id);
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for(int i = 1; i < num_threads; ++i)
+    threads.emplace_back(worker, i);
+
+  worker(0);
+
+  for(auto& thread : threads)
+    thread.join();
+}
+
+//==============================================================================
+template <typename RandomIt, typename Compare>
+void parallelSort(RandomIt first, RandomIt last, Compare comp, int num_threads)
+{
+  // Below this many elements per chunk the threads cost more than they save
+  const std::size_t min_chunk_size = 4096;
+
+  const std::size_t n = static_cast<std::size_t>(last - first);
+  num_threads = resolveNumThreads(num_threads);
+  const std::size_t num_chunks
+      = std::min(static_cast<std::size_t>(num_threads), n / min_chunk_size);
+
+  if(num_chunks <= 1)
+  {
+    std::sort(first, last, comp);
+    return;
+  }
+
+  std::vector<RandomIt> bounds(num_chunks + 1);
+  for(std::size_t i = 0; i <= num_chunks; ++i)
+    bounds[i] = first + n * i / num_chunks;
+
+  parallelFor(num_chunks, num_threads, [&](std::size_t i, int)
+  {
+    std::sort(bounds[i], bounds[i + 1], comp);
+  });
+
+  for(std::size_t width = 1; width < num_chunks; width *= 2)
+  {
+    const std::size_t num_merges = (num_chunks + 2 * width - 1) / (2 * width);
+    parallelFor(num_merges, num_threads, [&](std::size_t i, int)
+    {
+      const std::size_t begin = 2 * width * i;
+      const std::size_t middle = begin + width;
+      const std::size_t end = std::min(begin + 2 * width, num_chunks);
+      if(middle < end)
+        std::inplace_merge(bounds[begin], bounds[middle], bounds[end], comp);
+    });
+  }
+}
+
+} // namespace detail
+} // namespace fcl
+
+#endif
@@ -37,6 +37,8 @@
 #ifndef FCL_MATH_CONSTANTS_
 #define FCL_MATH_CONSTANTS_
 
+#include <limits>
+
 #include "fcl/common/types.h"
 
 namespace fcl
@@ -50,6 +52,13 @@ static constexpr S pi() { return S(3.1415926535897932384626433832795028841971693
 
 /// The golden ratio
 static constexpr S phi() { return S(1.618033988749894848204586834365638117720309179805762862135448623L); }
+
+/// The machine epsilon of S
+static constexpr S eps() { return std::numeric_limits<S>::epsilon(); }
+
+/// The default tolerance of the GJK and EPA algorithms: 1e-6, which in single
+/// precision is only a few ulps, so no less than 64 eps
+static constexpr S gjk_default_tolerance() { return (S(64) * eps() > S(1e-6)) ? S(64) * eps() : S(1e-6); }
 };
 
 using constantsf = constants<float>;
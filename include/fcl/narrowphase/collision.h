@@ -39,7 +39,11 @@
 #ifndef FCL_COLLISION_H
 #define FCL_COLLISION_H
 
+#include "fcl/common/detail/parallel.h"
 #include "fcl/object/collision_object.h"
+#include "fcl/narrowphase/collision_query.h"
+#include "fcl/narrowphase/collision_request.h"
+#include "fcl/narrowphase/collision_result.h"
 #include "fcl/narrowphase/detail/collision_func_matrix.h"
 #include "fcl/narrowphase/detail/gjk_solver_indep.h"
 #include "fcl/narrowphase/detail/gjk_solver_libccd.h"
@@ -65,6 +69,20 @@ std::size_t collide(const CollisionGeometry<S>* o1, const Transform3<S>& tf1,
                     const CollisionRequest<S>& request,
                     CollisionResult<S>& result);
 
+/// @brief Batched collision interface: performs the collision for each of the
+/// num_queries queries with the same request and writes the result of
+/// queries[i] into results[i], which is cleared first. The queries are grouped
+/// by the node types of their geometries so that each collision function and
+/// narrow phase solver is set up once per group rather than once per query.
+/// With num_threads other than one the groups are split into chunks that are
+/// processed concurrently (a non-positive value uses all hardware threads).
+/// Return value is the number of queries in collision.
+template <typename S>
+std::size_t collide(const CollisionQuery<S>* queries, std::size_t num_queries,
+                    const CollisionRequest<S>& request,
+                    CollisionResult<S>* results,
+                    int num_threads = 1);
+
 //============================================================================//
 //                                                                            //
 //                              Implementations                               //
@@ -148,6 +166,112 @@ std::size_t collide(
   return res;
 }
 
+namespace detail
+{
+
+//==============================================================================
+template <typename NarrowPhaseSolver>
+std::size_t collideBatch(
+    const CollisionQuery<typename NarrowPhaseSolver::S>* queries,
+    std::size_t num_queries,
+    const CollisionRequest<typename NarrowPhaseSolver::S>& request,
+    CollisionResult<typename NarrowPhaseSolver::S>* results,
+    int num_threads)
+{
+  for(std::size_t i = 0; i < num_queries; ++i)
+    results[i].clear();
+
+  if(request.num_max_contacts == 0)
+  {
+    std::cerr << "Warning: should stop early as num_max_contact is " << request.num_max_contacts << " !" << std::endl;
+    return 0;
+  }
+
+  // Sort the queries by the collision function they dispatch to. The counting
+  // sort keeps the original order within each group.
+  const std::size_t num_keys = NODE_COUNT * NODE_COUNT;
+  std::vector<std::size_t> keys(num_queries);
+  std::vector<bool> swapped(num_queries);
+  std::vector<std::size_t> offsets(num_keys + 1, 0);
+  for(std::size_t i = 0; i < num_queries; ++i)
+  {
+    const auto& query = queries[i];
+    const NODE_TYPE node_type1 = query.o1->getNodeType();
+    const NODE_TYPE node_type2 = query.o2->getNodeType();
+    swapped[i] = (query.o1->getObjectType() == OT_GEOM)
+        && (query.o2->getObjectType() == OT_BVH);
+    keys[i] = swapped[i] ? node_type2 * NODE_COUNT + node_type1
+                         : node_type1 * NODE_COUNT + node_type2;
+    offsets[keys[i] + 1]++;
+  }
+
+  for(std::size_t i = 0; i < num_keys; ++i)
+    offsets[i + 1] += offsets[i];
+
+  std::vector<std::size_t> order(num_queries);
+  {
+    std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+    for(std::size_t i = 0; i < num_queries; ++i)
+      order[cursor[keys[i]]++] = i;
+  }
+
+  // Split the groups into chunks, a few per thread to balance the load
+  num_threads = resolveNumThreads(num_threads);
+  const std::size_t max_chunk_size = std::max<std::size_t>(
+        1, num_queries / (8 * static_cast<std::size_t>(num_threads)));
+
+  struct Chunk
+  {
+    std::size_t key;
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  std::vector<Chunk> chunks;
+  for(std::size_t key = 0; key < num_keys; ++key)
+  {
+    for(std::size_t begin = offsets[key]; begin < offsets[key + 1]; begin += max_chunk_size)
+      chunks.push_back({key, begin, std::min(begin + max_chunk_size, offsets[key + 1])});
+  }
+
+  const auto& looktable = getCollisionFunctionLookTable<NarrowPhaseSolver>();
+
+  parallelFor(chunks.size(), num_threads, [&](std::size_t i, int)
+  {
+    const Chunk& chunk = chunks[i];
+    const auto func = looktable.collision_matrix[chunk.key / NODE_COUNT][chunk.key % NODE_COUNT];
+    if(!func)
+    {
+      std::cerr << "Warning: collision function between node type " << chunk.key / NODE_COUNT << " and node type " << chunk.key % NODE_COUNT << " is not supported"<< std::endl;
+      return;
+    }
+
+    // The queries share the solver without depending on one another, as the
+    // cached guess is only used when the request sets it for every query
+    NarrowPhaseSolver nsolver;
+    for(std::size_t j = chunk.begin; j < chunk.end; ++j)
+    {
+      const std::size_t id = order[j];
+      const auto& query = queries[id];
+      if(swapped[id])
+        func(query.o2, query.tf2, query.o1, query.tf1, &nsolver, request, results[id]);
+      else
+        func(query.o1, query.tf1, query.o2, query.tf2, &nsolver, request, results[id]);
+    }
+  });
+
+  std::size_t num_collisions = 0;
+  for(std::size_t i = 0; i < num_queries; ++i)
+  {
+    if(results[i].isCollision())
+      ++num_collisions;
+  }
+
+  return num_collisions;
+}
+
+} // namespace detail
+
 //==============================================================================
 template <typename S>
 std::size_t collide(const CollisionObject<S>* o1, const CollisionObject<S>* o2,
@@ -198,6 +322,27 @@ std::size_t collide(
   }
 }
 
+//==============================================================================
+template <typename S>
+std::size_t collide(const CollisionQuery<S>* queries, std::size_t num_queries,
+                    const CollisionRequest<S>& request,
+                    CollisionResult<S>* results,
+                    int num_threads)
+{
+  switch(request.gjk_solver_type)
+  {
+  case GST_LIBCCD:
+    return detail::collideBatch<detail::GJKSolver_libccd<S>>(
+          queries, num_queries, request, results, num_threads);
+  case GST_INDEP:
+    return detail::collideBatch<detail::GJKSolver_indep<S>>(
+          queries, num_queries, request, results, num_threads);
+  default:
+    std::cerr << "Warning! Invalid GJK solver" << std::endl;
+    return -1; // error
+  }
+}
+
 } // namespace fcl
 
 #endif
@@ -0,0 +1,121 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FCL_COLLISIONQUERY_H
+#define FCL_COLLISIONQUERY_H
+
+#include "fcl/common/types.h"
+#include "fcl/object/collision_object.h"
+
+namespace fcl
+{
+
+/// @brief one query of a batched collision: a pair of geometries and the
+/// configurations they are tested at. Store queries in Eigen::aligned_vector.
+template <typename S>
+struct CollisionQuery
+{
+  /// @brief geometry of the first object
+  const CollisionGeometry<S>* o1;
+
+  /// @brief configuration of the first object in world coordinate
+  Transform3<S> tf1;
+
+  /// @brief geometry of the second object
+  const CollisionGeometry<S>* o2;
+
+  /// @brief configuration of the second object in world coordinate
+  Transform3<S> tf2;
+
+  CollisionQuery();
+
+  CollisionQuery(const CollisionGeometry<S>* o1_,
+                 const Transform3<S>& tf1_,
+                 const CollisionGeometry<S>* o2_,
+                 const Transform3<S>& tf2_);
+
+  /// @brief query between two collision objects at their current configuration
+  CollisionQuery(const CollisionObject<S>* o1_, const CollisionObject<S>* o2_);
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+using CollisionQueryf = CollisionQuery<float>;
+using CollisionQueryd = CollisionQuery<double>;
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template <typename S>
+CollisionQuery<S>::CollisionQuery()
+  : o1(nullptr),
+    tf1(Transform3<S>::Identity()),
+    o2(nullptr),
+    tf2(Transform3<S>::Identity())
+{
+  // Do nothing
+}
+
+//==============================================================================
+template <typename S>
+CollisionQuery<S>::CollisionQuery(
+    const CollisionGeometry<S>* o1_,
+    const Transform3<S>& tf1_,
+    const CollisionGeometry<S>* o2_,
+    const Transform3<S>& tf2_)
+  : o1(o1_), tf1(tf1_), o2(o2_), tf2(tf2_)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template <typename S>
+CollisionQuery<S>::CollisionQuery(
+    const CollisionObject<S>* o1_, const CollisionObject<S>* o2_)
+  : o1(o1_->collisionGeometry().get()),
+    tf1(o1_->getTransform()),
+    o2(o2_->collisionGeometry().get()),
+    tf2(o2_->getTransform())
+{
+  // Do nothing
+}
+
+} // namespace fcl
+
+#endif
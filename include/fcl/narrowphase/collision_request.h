@@ -40,6 +40,7 @@
 
 #include "fcl/common/types.h"
 #include "fcl/narrowphase/gjk_solver.h"
+#include "fcl/narrowphase/gjk_simplex_cache.h"
 
 namespace fcl
 {
@@ -75,6 +76,11 @@ struct CollisionRequest
   /// @brief the gjk intial guess set by user
   Vector3<S> cached_gjk_guess;
 
+  /// @brief the gjk initial simplex set by user, usually the
+  /// cached_gjk_simplex of the last result between the same pair of shapes.
+  /// Used in place of cached_gjk_guess unless empty, by GST_INDEP only.
+  GJKSimplexCache<S> cached_gjk_simplex;
+
   CollisionRequest(size_t num_max_contacts_ = 1,
                    bool enable_contact_ = false,
                    size_t num_max_cost_sources_ = 1,
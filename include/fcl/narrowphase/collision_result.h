@@ -43,6 +43,7 @@
 #include "fcl/common/types.h"
 #include "fcl/narrowphase/contact.h"
 #include "fcl/narrowphase/cost_source.h"
+#include "fcl/narrowphase/gjk_simplex_cache.h"
 
 namespace fcl
 {
@@ -61,6 +62,10 @@ private:
 public:
   Vector3<S> cached_gjk_guess;
 
+  /// @brief the terminal simplex of the GJK query, to start the next query
+  /// between the same pair of shapes from
+  GJKSimplexCache<S> cached_gjk_simplex;
+
 public:
   CollisionResult();
 
@@ -325,17 +325,23 @@ std::size_t ShapeShapeCollide(
   {
     nsolver->enableCachedGuess(true);
     nsolver->setCachedGuess(request.cached_gjk_guess);
+    nsolver->setCachedSimplex(request.cached_gjk_simplex);
   }
   else
   {
-    nsolver->enableCachedGuess(true);
+    // Start from the default guess rather than whatever the last query on
+    // this solver left behind, so that the result does not depend on it
+    nsolver->enableCachedGuess(false);
   }
 
   initialize(node, *obj1, tf1, *obj2, tf2, nsolver, request, result);
   collide(&node);
 
   if(request.enable_cached_gjk_guess)
+  {
     result.cached_gjk_guess = nsolver->getCachedGuess();
+    result.cached_gjk_simplex = nsolver->getCachedSimplex();
+  }
 
   return result.numContacts();
 }
@@ -614,7 +620,10 @@ std::size_t orientedMeshCollide(
   const BVHModel<BV>* obj2 = static_cast<const BVHModel<BV>* >(o2);
 
   initialize(node, *obj1, tf1, *obj2, tf2, request, result);
-  collide(&node);
+  if(obj2->getWideBVH())
+    collide(&node, *obj2->getWideBVH());
+  else
+    collide(&node);
 
   return result.numContacts();
 }
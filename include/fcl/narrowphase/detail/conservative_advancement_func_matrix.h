@@ -131,7 +131,7 @@ bool conservativeAdvancement(const BVHModel<BV>& o1,
     node.delta_t = 1;
     node.min_distance = std::numeric_limits<S>::max();
 
-    distanceRecurse<S>(&node, 0, 0, nullptr);
+    distanceRecurse<S>(&node, 0, 0, static_cast<BVHFrontList*>(nullptr));
 
     if(node.delta_t <= node.t_err)
     {
@@ -208,7 +208,7 @@ bool conservativeAdvancementMeshOriented(const BVHModel<BV>& o1,
     node.delta_t = 1;
     node.min_distance = std::numeric_limits<S>::max();
 
-    distanceRecurse(&node, 0, 0, nullptr);
+    distanceRecurse(&node, 0, 0, static_cast<BVHFrontList*>(nullptr));
 
     if(node.delta_t <= node.t_err)
     {
@@ -276,7 +276,7 @@ bool conservativeAdvancement(const Shape1& o1,
     node.delta_t = 1;
     node.min_distance = std::numeric_limits<S>::max();
 
-    distanceRecurse(&node, 0, 0, nullptr);
+    distanceRecurse(&node, 0, 0, static_cast<BVHFrontList*>(nullptr));
 
     if(node.delta_t <= node.t_err)
     {
@@ -341,7 +341,7 @@ bool conservativeAdvancement(const BVHModel<BV>& o1,
     node.delta_t = 1;
     node.min_distance = std::numeric_limits<S>::max();
 
-    distanceRecurse<S>(&node, 0, 0, nullptr);
+    distanceRecurse<S>(&node, 0, 0, static_cast<BVHFrontList*>(nullptr));
 
     if(node.delta_t <= node.t_err)
     {
@@ -413,7 +413,7 @@ bool conservativeAdvancementMeshShapeOriented(const BVHModel<BV>& o1,
     node.delta_t = 1;
     node.min_distance = std::numeric_limits<S>::max();
 
-    distanceRecurse(&node, 0, 0, nullptr);
+    distanceRecurse(&node, 0, 0, static_cast<BVHFrontList*>(nullptr));
 
     if(node.delta_t <= node.t_err)
     {
@@ -507,7 +507,7 @@ bool conservativeAdvancement(const Shape& o1,
     node.delta_t = 1;
     node.min_distance = std::numeric_limits<S>::max();
 
-    distanceRecurse(&node, 0, 0, nullptr);
+    distanceRecurse(&node, 0, 0, static_cast<BVHFrontList*>(nullptr));
 
     if(node.delta_t <= node.t_err)
     {
@@ -578,7 +578,7 @@ bool conservativeAdvancementShapeMeshOriented(const Shape& o1,
     node.delta_t = 1;
     node.min_distance = std::numeric_limits<S>::max();
 
-    distanceRecurse(&node, 0, 0, nullptr);
+    distanceRecurse(&node, 0, 0, static_cast<BVHFrontList*>(nullptr));
 
     if(node.delta_t <= node.t_err)
     {
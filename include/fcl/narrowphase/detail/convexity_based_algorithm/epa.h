@@ -38,6 +38,8 @@
 #ifndef FCL_NARROWPHASE_DETAIL_EPA_H
 #define FCL_NARROWPHASE_DETAIL_EPA_H
 
+#include <vector>
+
 #include "fcl/narrowphase/detail/convexity_based_algorithm/gjk.h"
 
 namespace fcl
@@ -52,23 +54,38 @@ namespace detail
 //static const size_t EPA_MAX_ITERATIONS = 255;
 // TODO(JS): remove?
 
-/// @brief class for EPA algorithm
+/// @brief face of the EPA polytope
+template <typename S>
+struct EPASimplexF
+{
+  Vector3<S> n;
+  S d;
+  GJKSimplexV<S>* c[3]; // a face has three vertices
+  EPASimplexF* f[3]; // a face has three adjacent faces
+  EPASimplexF* l[2]; // the pre and post faces in the list
+  size_t e[3];
+  size_t pass;
+};
+
+/// @brief storage for the vertices and faces of the EPA polytope. The EPA runs
+/// given a workspace keep its storage, which only grows, so that the runs
+/// sharing one allocate nothing once it is large enough. A workspace must not
+/// be shared by concurrent runs.
 template <typename S>
+struct EPAWorkspace
+{
+  std::vector<GJKSimplexV<S>> sv_store;
+  std::vector<EPASimplexF<S>> fc_store;
+};
+
+/// @brief class for EPA algorithm, on the shapes of GJK<S, Shape1, Shape2>
+template <typename S, typename Shape1 = ShapeBase<S>, typename Shape2 = ShapeBase<S>>
 struct EPA
 {
 private:
-  using SimplexV = typename GJK<S>::SimplexV;
+  using SimplexV = GJKSimplexV<S>;
 
-  struct SimplexF
-  {
-    Vector3<S> n;
-    S d;
-    SimplexV* c[3]; // a face has three vertices
-    SimplexF* f[3]; // a face has three adjacent faces
-    SimplexF* l[2]; // the pre and post faces in the list
-    size_t e[3];
-    size_t pass;
-  };
+  using SimplexF = EPASimplexF<S>;
 
   struct SimplexList
   {
@@ -113,12 +130,15 @@ private:
   unsigned int max_iterations;
   S tolerance;
 
+  /// @brief the storage used when no workspace is given
+  EPAWorkspace<S> own_workspace;
+
 public:
 
   enum Status {Valid, Touching, Degenerated, NonConvex, InvalidHull, OutOfFaces, OutOfVertices, AccuracyReached, FallBack, Failed};
   
   Status status;
-  typename GJK<S>::Simplex result;
+  typename GJK<S, Shape1, Shape2>::Simplex result;
   Vector3<S> normal;
   S depth;
   SimplexV* sv_store;
@@ -131,16 +151,23 @@ public:
                                                                                                                      max_iterations(max_iterations_),
                                                                                                                      tolerance(tolerance_)
   {
-    initialize();
+    initialize(own_workspace);
   }
 
-  ~EPA()
+  /// @brief EPA on the storage of workspace, which must outlive it
+  EPA(unsigned int max_face_num_, unsigned int max_vertex_num_, unsigned int max_iterations_, S tolerance_,
+      EPAWorkspace<S>& workspace) : max_face_num(max_face_num_),
+                                    max_vertex_num(max_vertex_num_),
+                                    max_iterations(max_iterations_),
+                                    tolerance(tolerance_)
   {
-    delete [] sv_store;
-    delete [] fc_store;
+    initialize(workspace);
   }
 
-  void initialize();
+  EPA(const EPA&) = delete;
+  EPA& operator=(const EPA&) = delete;
+
+  void initialize(EPAWorkspace<S>& workspace);
 
   bool getEdgeDist(SimplexF* face, SimplexV* a, SimplexV* b, S& dist);
 
@@ -149,7 +176,7 @@ public:
   /// @brief Find the best polytope face to split
   SimplexF* findBest();
 
-  Status evaluate(GJK<S>& gjk, const Vector3<S>& guess);
+  Status evaluate(GJK<S, Shape1, Shape2>& gjk, const Vector3<S>& guess);
 
   /// @brief the goal is to add a face connecting vertex w and face edge f[e] 
   bool expand(size_t pass, SimplexV* w, SimplexF* f, size_t e, SimplexHorizon& horizon);  
@@ -165,11 +192,15 @@ using EPAd = EPA<double>;
 //============================================================================//
 
 //==============================================================================
-template <typename S>
-void EPA<S>::initialize()
+template <typename S, typename Shape1, typename Shape2>
+void EPA<S, Shape1, Shape2>::initialize(EPAWorkspace<S>& workspace)
 {
-  sv_store = new SimplexV[max_vertex_num];
-  fc_store = new SimplexF[max_face_num];
+  if(workspace.sv_store.size() < max_vertex_num)
+    workspace.sv_store.resize(max_vertex_num);
+  if(workspace.fc_store.size() < max_face_num)
+    workspace.fc_store.resize(max_face_num);
+  sv_store = workspace.sv_store.data();
+  fc_store = workspace.fc_store.data();
   status = Failed;
   normal = Vector3<S>(0, 0, 0);
   depth = 0;
@@ -179,8 +210,8 @@ void EPA<S>::initialize()
 }
 
 //==============================================================================
-template <typename S>
-bool EPA<S>::getEdgeDist(SimplexF* face, SimplexV* a, SimplexV* b, S& dist)
+template <typename S, typename Shape1, typename Shape2>
+bool EPA<S, Shape1, Shape2>::getEdgeDist(SimplexF* face, SimplexV* a, SimplexV* b, S& dist)
 {
   Vector3<S> ba = b->w - a->w;
   Vector3<S> n_ab = ba.cross(face->n);
@@ -210,11 +241,11 @@ bool EPA<S>::getEdgeDist(SimplexF* face, SimplexV* a, SimplexV* b, S& dist)
 }
 
 //==============================================================================
-template <typename S>
-typename EPA<S>::SimplexF* EPA<S>::newFace(
-      typename GJK<S>::SimplexV* a,
-      typename GJK<S>::SimplexV* b,
-      typename GJK<S>::SimplexV* c,
+template <typename S, typename Shape1, typename Shape2>
+typename EPA<S, Shape1, Shape2>::SimplexF* EPA<S, Shape1, Shape2>::newFace(
+      SimplexV* a,
+      SimplexV* b,
+      SimplexV* c,
       bool forced)
 {
   if(stock.root)
@@ -258,8 +289,8 @@ typename EPA<S>::SimplexF* EPA<S>::newFace(
 
 //==============================================================================
 /** @brief Find the best polytope face to split */
-template <typename S>
-typename EPA<S>::SimplexF* EPA<S>::findBest()
+template <typename S, typename Shape1, typename Shape2>
+typename EPA<S, Shape1, Shape2>::SimplexF* EPA<S, Shape1, Shape2>::findBest()
 {
   SimplexF* minf = hull.root;
   S mind = minf->d * minf->d;
@@ -276,10 +307,10 @@ typename EPA<S>::SimplexF* EPA<S>::findBest()
 }
 
 //==============================================================================
-template <typename S>
-typename EPA<S>::Status EPA<S>::evaluate(GJK<S>& gjk, const Vector3<S>& guess)
+template <typename S, typename Shape1, typename Shape2>
+typename EPA<S, Shape1, Shape2>::Status EPA<S, Shape1, Shape2>::evaluate(GJK<S, Shape1, Shape2>& gjk, const Vector3<S>& guess)
 {
-  typename GJK<S>::Simplex& simplex = *gjk.getSimplex();
+  typename GJK<S, Shape1, Shape2>::Simplex& simplex = *gjk.getSimplex();
   if((simplex.rank > 1) && gjk.encloseOrigin())
   {
     while(hull.root)
@@ -400,8 +431,8 @@ typename EPA<S>::Status EPA<S>::evaluate(GJK<S>& gjk, const Vector3<S>& guess)
 
 //==============================================================================
 /** @brief the goal is to add a face connecting vertex w and face edge f[e] */
-template <typename S>
-bool EPA<S>::expand(size_t pass, SimplexV* w, SimplexF* f, size_t e, SimplexHorizon& horizon)
+template <typename S, typename Shape1, typename Shape2>
+bool EPA<S, Shape1, Shape2>::expand(size_t pass, SimplexV* w, SimplexF* f, size_t e, SimplexHorizon& horizon)
 {
   static const size_t nexti[] = {1, 2, 0};
   static const size_t previ[] = {2, 0, 1};
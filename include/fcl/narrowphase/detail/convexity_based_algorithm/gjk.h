@@ -38,7 +38,10 @@
 #ifndef FCL_NARROWPHASE_DETAIL_GJK_H
 #define FCL_NARROWPHASE_DETAIL_GJK_H
 
+#include <algorithm>
+
 #include "fcl/common/types.h"
+#include "fcl/narrowphase/gjk_simplex_cache.h"
 #include "fcl/narrowphase/detail/convexity_based_algorithm/minkowski_diff.h"
 
 namespace fcl
@@ -47,33 +50,44 @@ namespace fcl
 namespace detail
 {
 
-/// @brief class for GJK algorithm
+/// @brief vertex of a GJK simplex, which does not depend on the shapes so
+/// that EPA may store them for any pair of shapes
 template <typename S>
-struct GJK
+struct GJKSimplexV
 {
-  struct SimplexV
-  {
-    /// @brief support direction
-    Vector3<S> d;
-    /// @brieg support vector (i.e., the furthest point on the shape along the support direction)
-    Vector3<S> w;
-  };
+  /// @brief support direction
+  Vector3<S> d;
+  /// @brieg support vector (i.e., the furthest point on the shape along the support direction)
+  Vector3<S> w;
+};
 
-  struct Simplex
-  {
-    /// @brief simplex vertex
-    SimplexV* c[4];
-    /// @brief weight 
-    S p[4];
-    /// @brief size of simplex (number of vertices)
-    size_t rank;
+/// @brief GJK simplex
+template <typename S>
+struct GJKSimplex
+{
+  /// @brief simplex vertex
+  GJKSimplexV<S>* c[4];
+  /// @brief weight 
+  S p[4];
+  /// @brief size of simplex (number of vertices)
+  size_t rank;
+
+  GJKSimplex();
+};
 
-    Simplex();
-  };
+/// @brief class for GJK algorithm. When Shape1 and Shape2 are the static
+/// types of the two shapes, the support functions are resolved at compile
+/// time; by default they dispatch on the node types at run time.
+template <typename S, typename Shape1 = ShapeBase<S>, typename Shape2 = ShapeBase<S>>
+struct GJK
+{
+  using SimplexV = GJKSimplexV<S>;
+
+  using Simplex = GJKSimplex<S>;
 
   enum Status {Valid, Inside, Failed};
 
-  MinkowskiDiff<S> shape;
+  MinkowskiDiff<S, Shape1, Shape2> shape;
   Vector3<S> ray;
   S distance;
   Simplex simplices[2];
@@ -82,8 +96,9 @@ struct GJK
   
   void initialize();
 
-  /// @brief GJK algorithm, given the initial value guess
-  Status evaluate(const MinkowskiDiff<S>& shape_, const Vector3<S>& guess);
+  /// @brief GJK algorithm, given the initial value guess, or starting from
+  /// the simplex of cache if it is given and not empty
+  Status evaluate(const MinkowskiDiff<S, Shape1, Shape2>& shape_, const Vector3<S>& guess, const GJKSimplexCache<S>* cache = nullptr);
 
   /// @brief apply the support function along a direction, the result is return in sv
   void getSupport(const Vector3<S>& d, SimplexV& sv) const;
@@ -106,7 +121,20 @@ struct GJK
   /// @brief get the guess from current simplex
   Vector3<S> getGuessFromSimplex() const;
 
+  /// @brief get the number of iterations of the last evaluation
+  unsigned int getNumIterations() const;
+
+  /// @brief store the simplex of the last evaluation in cache, for the next
+  /// evaluation between the same shapes to start from. Call it before EPA,
+  /// which grows the simplex.
+  void getSimplexCache(GJKSimplexCache<S>& cache) const;
+
 private:
+  /// @brief project the origin onto the current simplex, keep the vertices of
+  /// the nearest sub-simplex as the current simplex and set ray to the nearest
+  /// point. Return false, leaving the simplex as it is, if it is degenerated.
+  bool projectOrigin();
+
   SimplexV store_v[4];
   SimplexV* free_v[4];
   size_t nfree;
@@ -115,6 +143,7 @@ private:
   Status status;
 
   unsigned int max_iterations;
+  unsigned int num_iterations;
   S tolerance;
 
 };
@@ -129,16 +158,16 @@ using GJKd = GJK<double>;
 //============================================================================//
 
 //==============================================================================
-template <typename S>
-GJK<S>::GJK(unsigned int max_iterations_, S tolerance_)
+template <typename S, typename Shape1, typename Shape2>
+GJK<S, Shape1, Shape2>::GJK(unsigned int max_iterations_, S tolerance_)
   : max_iterations(max_iterations_), tolerance(tolerance_)
 {
   initialize();
 }
 
 //==============================================================================
-template <typename S>
-void GJK<S>::initialize()
+template <typename S, typename Shape1, typename Shape2>
+void GJK<S, Shape1, Shape2>::initialize()
 {
   ray.setZero();
   nfree = 0;
@@ -146,18 +175,26 @@ void GJK<S>::initialize()
   current = 0;
   distance = 0.0;
   simplex = nullptr;
+  num_iterations = 0;
 }
 
 //==============================================================================
-template <typename S>
-Vector3<S> GJK<S>::getGuessFromSimplex() const
+template <typename S, typename Shape1, typename Shape2>
+Vector3<S> GJK<S, Shape1, Shape2>::getGuessFromSimplex() const
 {
   return ray;
 }
 
 //==============================================================================
-template <typename S>
-typename GJK<S>::Status GJK<S>::evaluate(const MinkowskiDiff<S>& shape_, const Vector3<S>& guess)
+template <typename S, typename Shape1, typename Shape2>
+unsigned int GJK<S, Shape1, Shape2>::getNumIterations() const
+{
+  return num_iterations;
+}
+
+//==============================================================================
+template <typename S, typename Shape1, typename Shape2>
+typename GJK<S, Shape1, Shape2>::Status GJK<S, Shape1, Shape2>::evaluate(const MinkowskiDiff<S, Shape1, Shape2>& shape_, const Vector3<S>& guess, const GJKSimplexCache<S>* cache)
 {
   size_t iterations = 0;
   S alpha = 0;
@@ -177,16 +214,36 @@ typename GJK<S>::Status GJK<S>::evaluate(const MinkowskiDiff<S>& shape_, const V
   simplices[0].rank = 0;
   ray = guess;
 
-  appendVertex(simplices[0], (ray.squaredNorm() > 0) ? (-ray).eval() : Vector3<S>::UnitX());
-  simplices[0].p[0] = 1;
-  ray = simplices[0].c[0]->w;
-  lastw[0] = lastw[1] = lastw[2] = lastw[3] = ray; // cache previous support points, the new support point will compare with it to avoid too close support points
+  if(cache)
+  {
+    shape.support_hints[0] = cache->support_hints[0];
+    shape.support_hints[1] = cache->support_hints[1];
+
+    // warm start: the cached simplex, at the current poses of the shapes
+    for(size_t i = 0; i < cache->rank; ++i)
+      appendVertex(simplices[0], cache->d[i]);
 
-  do
+    if(cache->rank > 0 && !projectOrigin()) // degenerated since, start over
+    {
+      while(simplices[0].rank > 0)
+        removeVertex(simplices[0]);
+    }
+  }
+
+  if(simplices[current].rank == 0)
+  {
+    appendVertex(simplices[0], (ray.squaredNorm() > 0) ? (-ray).eval() : Vector3<S>::UnitX());
+    simplices[0].p[0] = 1;
+    ray = simplices[0].c[0]->w;
+  }
+
+  // cache previous support points, the new support point will compare with it to avoid too close support points
+  for(size_t i = 0; i < 4; ++i)
+    lastw[i] = simplices[current].c[std::min(i, simplices[current].rank - 1)]->w;
+
+  while(status == Valid)
   {
-    size_t next = 1 - current;
     Simplex& curr_simplex = simplices[current];
-    Simplex& next_simplex = simplices[next];
 
     // check A: when origin is near the existing simplex, stop
     S rl = ray.norm();
@@ -228,36 +285,7 @@ typename GJK<S>::Status GJK<S>::evaluate(const MinkowskiDiff<S>& shape_, const V
       break;
     }
 
-    typename Project<S>::ProjectResult project_res;
-    switch(curr_simplex.rank)
-    {
-    case 2:
-      project_res = Project<S>::projectLineOrigin(curr_simplex.c[0]->w, curr_simplex.c[1]->w); break;
-    case 3:
-      project_res = Project<S>::projectTriangleOrigin(curr_simplex.c[0]->w, curr_simplex.c[1]->w, curr_simplex.c[2]->w); break;
-    case 4:
-      project_res = Project<S>::projectTetrahedraOrigin(curr_simplex.c[0]->w, curr_simplex.c[1]->w, curr_simplex.c[2]->w, curr_simplex.c[3]->w); break;
-    }
-
-    if(project_res.sqr_distance >= 0)
-    {
-      next_simplex.rank = 0;
-      ray.setZero();
-      current = next;
-      for(size_t i = 0; i < curr_simplex.rank; ++i)
-      {
-        if(project_res.encode & (1 << i))
-        {
-          next_simplex.c[next_simplex.rank] = curr_simplex.c[i];
-          next_simplex.p[next_simplex.rank++] = project_res.parameterization[i]; // weights[i];
-          ray += curr_simplex.c[i]->w * project_res.parameterization[i]; // weights[i];
-        }
-        else
-          free_v[nfree++] = curr_simplex.c[i];
-      }
-      if(project_res.encode == 15) status = Inside; // the origin is within the 4-simplex, collision
-    }
-    else
+    if(!projectOrigin())
     {
       removeVertex(simplices[current]);
       break;
@@ -265,9 +293,10 @@ typename GJK<S>::Status GJK<S>::evaluate(const MinkowskiDiff<S>& shape_, const V
 
     status = ((++iterations) < max_iterations) ? status : Failed;
 
-  } while(status == Valid);
+  }
 
   simplex = &simplices[current];
+  num_iterations = iterations;
   switch(status)
   {
   case Valid: distance = ray.norm(); break;
@@ -278,31 +307,91 @@ typename GJK<S>::Status GJK<S>::evaluate(const MinkowskiDiff<S>& shape_, const V
 }
 
 //==============================================================================
-template <typename S>
-void GJK<S>::getSupport(const Vector3<S>& d, SimplexV& sv) const
+template <typename S, typename Shape1, typename Shape2>
+void GJK<S, Shape1, Shape2>::getSimplexCache(GJKSimplexCache<S>& cache) const
+{
+  cache.rank = simplex ? simplex->rank : 0;
+  for(size_t i = 0; i < cache.rank; ++i)
+  {
+    cache.d[i] = simplex->c[i]->d;
+    cache.p[i] = simplex->p[i];
+  }
+  cache.support_hints[0] = shape.support_hints[0];
+  cache.support_hints[1] = shape.support_hints[1];
+}
+
+//==============================================================================
+template <typename S, typename Shape1, typename Shape2>
+bool GJK<S, Shape1, Shape2>::projectOrigin()
+{
+  const size_t next = 1 - current;
+  Simplex& curr_simplex = simplices[current];
+  Simplex& next_simplex = simplices[next];
+
+  typename Project<S>::ProjectResult project_res;
+  switch(curr_simplex.rank)
+  {
+  case 1:
+    project_res.parameterization[0] = 1;
+    project_res.sqr_distance = curr_simplex.c[0]->w.squaredNorm();
+    project_res.encode = 1;
+    break;
+  case 2:
+    project_res = Project<S>::projectLineOrigin(curr_simplex.c[0]->w, curr_simplex.c[1]->w); break;
+  case 3:
+    project_res = Project<S>::projectTriangleOrigin(curr_simplex.c[0]->w, curr_simplex.c[1]->w, curr_simplex.c[2]->w); break;
+  case 4:
+    project_res = Project<S>::projectTetrahedraOrigin(curr_simplex.c[0]->w, curr_simplex.c[1]->w, curr_simplex.c[2]->w, curr_simplex.c[3]->w); break;
+  }
+
+  if(project_res.sqr_distance < 0)
+    return false;
+
+  next_simplex.rank = 0;
+  ray.setZero();
+  current = next;
+  for(size_t i = 0; i < curr_simplex.rank; ++i)
+  {
+    if(project_res.encode & (1 << i))
+    {
+      next_simplex.c[next_simplex.rank] = curr_simplex.c[i];
+      next_simplex.p[next_simplex.rank++] = project_res.parameterization[i]; // weights[i];
+      ray += curr_simplex.c[i]->w * project_res.parameterization[i]; // weights[i];
+    }
+    else
+      free_v[nfree++] = curr_simplex.c[i];
+  }
+  if(project_res.encode == 15) status = Inside; // the origin is within the 4-simplex, collision
+
+  return true;
+}
+
+//==============================================================================
+template <typename S, typename Shape1, typename Shape2>
+void GJK<S, Shape1, Shape2>::getSupport(const Vector3<S>& d, SimplexV& sv) const
 {
   sv.d = d.normalized();
   sv.w = shape.support(sv.d);
 }
 
 //==============================================================================
-template <typename S>
-void GJK<S>::getSupport(const Vector3<S>& d, const Vector3<S>& v, SimplexV& sv) const
+template <typename S, typename Shape1, typename Shape2>
+void GJK<S, Shape1, Shape2>::getSupport(const Vector3<S>& d, const Vector3<S>& v, SimplexV& sv) const
 {
   sv.d = d.normalized();
   sv.w = shape.support(sv.d, v);
 }
 
 //==============================================================================
-template <typename S>
-void GJK<S>::removeVertex(Simplex& simplex)
+template <typename S, typename Shape1, typename Shape2>
+void GJK<S, Shape1, Shape2>::removeVertex(Simplex& simplex)
 {
   free_v[nfree++] = simplex.c[--simplex.rank];
 }
 
 //==============================================================================
-template <typename S>
-void GJK<S>::appendVertex(Simplex& simplex, const Vector3<S>& v)
+template <typename S, typename Shape1, typename Shape2>
+void GJK<S, Shape1, Shape2>::appendVertex(Simplex& simplex, const Vector3<S>& v)
 {
   simplex.p[simplex.rank] = 0; // initial weight 0
   simplex.c[simplex.rank] = free_v[--nfree]; // set the memory
@@ -310,8 +399,8 @@ void GJK<S>::appendVertex(Simplex& simplex, const Vector3<S>& v)
 }
 
 //==============================================================================
-template <typename S>
-bool GJK<S>::encloseOrigin()
+template <typename S, typename Shape1, typename Shape2>
+bool GJK<S, Shape1, Shape2>::encloseOrigin()
 {
   switch(simplex->rank)
   {
@@ -376,15 +465,15 @@ bool GJK<S>::encloseOrigin()
 }
 
 //==============================================================================
-template <typename S>
-typename GJK<S>::Simplex* GJK<S>::getSimplex() const
+template <typename S, typename Shape1, typename Shape2>
+typename GJK<S, Shape1, Shape2>::Simplex* GJK<S, Shape1, Shape2>::getSimplex() const
 {
   return simplex;
 }
 
 //==============================================================================
 template <typename S>
-GJK<S>::Simplex::Simplex()
+GJKSimplex<S>::GJKSimplex()
   : rank(0)
 {
   // Do nothing
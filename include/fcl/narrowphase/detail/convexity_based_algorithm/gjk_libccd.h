@@ -234,6 +234,9 @@ template <typename S>
 struct ccd_convex_t : public ccd_obj_t
 {
   const Convex<S>* convex;
+
+  /// @brief the vertex found by the last support call, to start the next
+  mutable int support_hint;
 };
 
 struct ccd_triangle_t : public ccd_obj_t
@@ -719,6 +722,7 @@ static void convexToGJK(const Convex<S>& s, const Transform3<S>& tf, ccd_convex_
 {
   shapeToGJK(s, tf, conv);
   conv->convex = &s;
+  conv->support_hint = -1;
 }
 
 /** Support functions */
@@ -865,28 +869,14 @@ template <typename S>
 static void supportConvex(const void* obj, const ccd_vec3_t* dir_, ccd_vec3_t* v)
 {
   const auto* c = (const ccd_convex_t<S>*)obj;
-  ccd_vec3_t dir, p;
-  ccd_real_t maxdot, dot;
-  int i;
-  Vector3<S>* curp;
-  const auto& center = c->convex->center;
+  ccd_vec3_t dir;
 
   ccdVec3Copy(&dir, dir_);
   ccdQuatRotVec(&dir, &c->rot_inv);
 
-  maxdot = -CCD_REAL_MAX;
-  curp = c->convex->points;
-
-  for(i = 0; i < c->convex->num_points; ++i, curp += 1)
-  {
-    ccdVec3Set(&p, (*curp)[0] - center[0], (*curp)[1] - center[1], (*curp)[2] - center[2]);
-    dot = ccdVec3Dot(&dir, &p);
-    if(dot > maxdot)
-    {
-      ccdVec3Set(v, (*curp)[0], (*curp)[1], (*curp)[2]);
-      maxdot = dot;
-    }
-  }
+  const Vector3<S> d(ccdVec3X(&dir), ccdVec3Y(&dir), ccdVec3Z(&dir));
+  const Vector3<S>& p = c->convex->points[c->convex->findExtremeVertex(d, &c->support_hint)];
+  ccdVec3Set(v, p[0], p[1], p[2]);
 
   // transform support vertex
   ccdQuatRotVec(v, &c->rot);
@@ -47,17 +47,28 @@ namespace fcl
 namespace detail
 {
 
-/// @brief the support function for shape
+/// @brief the support function for shape. For the shapes that search their
+/// vertices, hint is the vertex to start from and receives the vertex found.
 template <typename S, typename Derived>
 Vector3<S> getSupport(
     const ShapeBase<S>* shape,
-    const Eigen::MatrixBase<Derived>& dir);
-
-/// @brief Minkowski difference class of two shapes
-template <typename S>
+    const Eigen::MatrixBase<Derived>& dir,
+    int* hint = nullptr);
+
+/// @brief the support function run(shape, dir, hint) for a shape of static
+/// type Shape, with hint as for getSupport(). The default dispatches on the
+/// node type at run time; the specializations for the convex shapes are
+/// inlined into the support functions of MinkowskiDiff.
+template <typename S, typename Shape>
+struct ShapeSupportImpl;
+
+/// @brief Minkowski difference class of two shapes. Shape1 and Shape2 are the
+/// static types of the two shapes, or ShapeBase<S> if they are only known at
+/// run time.
+template <typename S, typename Shape1 = ShapeBase<S>, typename Shape2 = ShapeBase<S>>
 struct MinkowskiDiff
 {
-  /// @brief points to two shapes
+  /// @brief points to two shapes, of types Shape1 and Shape2
   const ShapeBase<S>* shapes[2];
 
   /// @brief rotation from shape0 to shape1
@@ -66,6 +77,10 @@ struct MinkowskiDiff
   /// @brief transform from shape1 to shape0 
   Transform3<S> toshape0;
 
+  /// @brief the vertices found by the last support calls of the two shapes,
+  /// which start the next searches of the shapes that search their vertices
+  mutable int support_hints[2];
+
   MinkowskiDiff();
 
   /// @brief support function for shape0
@@ -101,11 +116,189 @@ using MinkowskiDiffd = MinkowskiDiff<double>;
 //                                                                            //
 //============================================================================//
 
+//==============================================================================
+template <typename S, typename Shape>
+struct ShapeSupportImpl
+{
+  template <typename Derived>
+  static Vector3<S> run(
+      const Shape& shape, const Eigen::MatrixBase<Derived>& dir,
+      int* hint = nullptr)
+  {
+    return getSupport<S>(&shape, dir, hint);
+  }
+};
+
+//==============================================================================
+template <typename S>
+struct ShapeSupportImpl<S, TriangleP<S>>
+{
+  template <typename Derived>
+  static Vector3<S> run(
+      const TriangleP<S>& triangle, const Eigen::MatrixBase<Derived>& dir,
+      int* = nullptr)
+  {
+    S dota = dir.dot(triangle.a);
+    S dotb = dir.dot(triangle.b);
+    S dotc = dir.dot(triangle.c);
+    if(dota > dotb)
+    {
+      if(dotc > dota)
+        return triangle.c;
+      else
+        return triangle.a;
+    }
+    else
+    {
+      if(dotc > dotb)
+        return triangle.c;
+      else
+        return triangle.b;
+    }
+  }
+};
+
+//==============================================================================
+template <typename S>
+struct ShapeSupportImpl<S, Box<S>>
+{
+  template <typename Derived>
+  static Vector3<S> run(
+      const Box<S>& box, const Eigen::MatrixBase<Derived>& dir,
+      int* = nullptr)
+  {
+    return Vector3<S>((dir[0]>0)?(box.side[0]/2):(-box.side[0]/2),
+                      (dir[1]>0)?(box.side[1]/2):(-box.side[1]/2),
+                      (dir[2]>0)?(box.side[2]/2):(-box.side[2]/2));
+  }
+};
+
+//==============================================================================
+template <typename S>
+struct ShapeSupportImpl<S, Sphere<S>>
+{
+  template <typename Derived>
+  static Vector3<S> run(
+      const Sphere<S>& sphere, const Eigen::MatrixBase<Derived>& dir,
+      int* = nullptr)
+  {
+    return dir * sphere.radius;
+  }
+};
+
+//==============================================================================
+template <typename S>
+struct ShapeSupportImpl<S, Ellipsoid<S>>
+{
+  template <typename Derived>
+  static Vector3<S> run(
+      const Ellipsoid<S>& ellipsoid, const Eigen::MatrixBase<Derived>& dir,
+      int* = nullptr)
+  {
+    const S a2 = ellipsoid.radii[0] * ellipsoid.radii[0];
+    const S b2 = ellipsoid.radii[1] * ellipsoid.radii[1];
+    const S c2 = ellipsoid.radii[2] * ellipsoid.radii[2];
+
+    const Vector3<S> v(a2 * dir[0], b2 * dir[1], c2 * dir[2]);
+    const S d = std::sqrt(v.dot(dir));
+
+    return v / d;
+  }
+};
+
+//==============================================================================
+template <typename S>
+struct ShapeSupportImpl<S, Capsule<S>>
+{
+  template <typename Derived>
+  static Vector3<S> run(
+      const Capsule<S>& capsule, const Eigen::MatrixBase<Derived>& dir,
+      int* = nullptr)
+  {
+    S half_h = capsule.lz * 0.5;
+    Vector3<S> pos1(0, 0, half_h);
+    Vector3<S> pos2(0, 0, -half_h);
+    Vector3<S> v = dir * capsule.radius;
+    pos1 += v;
+    pos2 += v;
+    if(dir.dot(pos1) > dir.dot(pos2))
+      return pos1;
+    else return pos2;
+  }
+};
+
+//==============================================================================
+template <typename S>
+struct ShapeSupportImpl<S, Cone<S>>
+{
+  template <typename Derived>
+  static Vector3<S> run(
+      const Cone<S>& cone, const Eigen::MatrixBase<Derived>& dir,
+      int* = nullptr)
+  {
+    S zdist = dir[0] * dir[0] + dir[1] * dir[1];
+    S len = zdist + dir[2] * dir[2];
+    zdist = std::sqrt(zdist);
+    len = std::sqrt(len);
+    S half_h = cone.lz * 0.5;
+    S radius = cone.radius;
+
+    S sin_a = radius / std::sqrt(radius * radius + 4 * half_h * half_h);
+
+    if(dir[2] > len * sin_a)
+      return Vector3<S>(0, 0, half_h);
+    else if(zdist > 0)
+    {
+      S rad = radius / zdist;
+      return Vector3<S>(rad * dir[0], rad * dir[1], -half_h);
+    }
+    else
+      return Vector3<S>(0, 0, -half_h);
+  }
+};
+
+//==============================================================================
+template <typename S>
+struct ShapeSupportImpl<S, Cylinder<S>>
+{
+  template <typename Derived>
+  static Vector3<S> run(
+      const Cylinder<S>& cylinder, const Eigen::MatrixBase<Derived>& dir,
+      int* = nullptr)
+  {
+    S zdist = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1]);
+    S half_h = cylinder.lz * 0.5;
+    if(zdist == 0.0)
+    {
+      return Vector3<S>(0, 0, (dir[2]>0)? half_h:-half_h);
+    }
+    else
+    {
+      S d = cylinder.radius / zdist;
+      return Vector3<S>(d * dir[0], d * dir[1], (dir[2]>0)?half_h:-half_h);
+    }
+  }
+};
+
+//==============================================================================
+template <typename S>
+struct ShapeSupportImpl<S, Convex<S>>
+{
+  template <typename Derived>
+  static Vector3<S> run(
+      const Convex<S>& convex, const Eigen::MatrixBase<Derived>& dir,
+      int* hint = nullptr)
+  {
+    return convex.points[convex.findExtremeVertex(dir, hint)];
+  }
+};
+
 //==============================================================================
 template <typename S, typename Derived>
 Vector3<S> getSupport(
     const ShapeBase<S>* shape,
-    const Eigen::MatrixBase<Derived>& dir)
+    const Eigen::MatrixBase<Derived>& dir,
+    int* hint)
 {
   // Check the number of rows is 6 at compile time
   EIGEN_STATIC_ASSERT(
@@ -116,126 +309,29 @@ Vector3<S> getSupport(
   switch(shape->getNodeType())
   {
   case GEOM_TRIANGLE:
-    {
-      const auto* triangle = static_cast<const TriangleP<S>*>(shape);
-      S dota = dir.dot(triangle->a);
-      S dotb = dir.dot(triangle->b);
-      S dotc = dir.dot(triangle->c);
-      if(dota > dotb)
-      {
-        if(dotc > dota)
-          return triangle->c;
-        else
-          return triangle->a;
-      }
-      else
-      {
-        if(dotc > dotb)
-          return triangle->c;
-        else
-          return triangle->b;
-      }
-    }
-    break;
+    return ShapeSupportImpl<S, TriangleP<S>>::run(
+          *static_cast<const TriangleP<S>*>(shape), dir);
   case GEOM_BOX:
-    {
-      const Box<S>* box = static_cast<const Box<S>*>(shape);
-      return Vector3<S>((dir[0]>0)?(box->side[0]/2):(-box->side[0]/2),
-                   (dir[1]>0)?(box->side[1]/2):(-box->side[1]/2),
-                   (dir[2]>0)?(box->side[2]/2):(-box->side[2]/2));
-    }
-    break;
+    return ShapeSupportImpl<S, Box<S>>::run(
+          *static_cast<const Box<S>*>(shape), dir);
   case GEOM_SPHERE:
-    {
-      const Sphere<S>* sphere = static_cast<const Sphere<S>*>(shape);
-      return dir * sphere->radius;
-    }
-    break;
+    return ShapeSupportImpl<S, Sphere<S>>::run(
+          *static_cast<const Sphere<S>*>(shape), dir);
   case GEOM_ELLIPSOID:
-    {
-      const Ellipsoid<S>* ellipsoid = static_cast<const Ellipsoid<S>*>(shape);
-
-      const S a2 = ellipsoid->radii[0] * ellipsoid->radii[0];
-      const S b2 = ellipsoid->radii[1] * ellipsoid->radii[1];
-      const S c2 = ellipsoid->radii[2] * ellipsoid->radii[2];
-
-      const Vector3<S> v(a2 * dir[0], b2 * dir[1], c2 * dir[2]);
-      const S d = std::sqrt(v.dot(dir));
-
-      return v / d;
-    }
-    break;
+    return ShapeSupportImpl<S, Ellipsoid<S>>::run(
+          *static_cast<const Ellipsoid<S>*>(shape), dir);
   case GEOM_CAPSULE:
-    {
-      const Capsule<S>* capsule = static_cast<const Capsule<S>*>(shape);
-      S half_h = capsule->lz * 0.5;
-      Vector3<S> pos1(0, 0, half_h);
-      Vector3<S> pos2(0, 0, -half_h);
-      Vector3<S> v = dir * capsule->radius;
-      pos1 += v;
-      pos2 += v;
-      if(dir.dot(pos1) > dir.dot(pos2))
-        return pos1;
-      else return pos2;
-    }
-    break;
+    return ShapeSupportImpl<S, Capsule<S>>::run(
+          *static_cast<const Capsule<S>*>(shape), dir);
   case GEOM_CONE:
-    {
-      const Cone<S>* cone = static_cast<const Cone<S>*>(shape);
-      S zdist = dir[0] * dir[0] + dir[1] * dir[1];
-      S len = zdist + dir[2] * dir[2];
-      zdist = std::sqrt(zdist);
-      len = std::sqrt(len);
-      S half_h = cone->lz * 0.5;
-      S radius = cone->radius;
-
-      S sin_a = radius / std::sqrt(radius * radius + 4 * half_h * half_h);
-
-      if(dir[2] > len * sin_a)
-        return Vector3<S>(0, 0, half_h);
-      else if(zdist > 0)
-      {
-        S rad = radius / zdist;
-        return Vector3<S>(rad * dir[0], rad * dir[1], -half_h);
-      }
-      else
-        return Vector3<S>(0, 0, -half_h);
-    }
-    break;
+    return ShapeSupportImpl<S, Cone<S>>::run(
+          *static_cast<const Cone<S>*>(shape), dir);
   case GEOM_CYLINDER:
-    {
-      const Cylinder<S>* cylinder = static_cast<const Cylinder<S>*>(shape);
-      S zdist = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1]);
-      S half_h = cylinder->lz * 0.5;
-      if(zdist == 0.0)
-      {
-        return Vector3<S>(0, 0, (dir[2]>0)? half_h:-half_h);
-      }
-      else
-      {
-        S d = cylinder->radius / zdist;
-        return Vector3<S>(d * dir[0], d * dir[1], (dir[2]>0)?half_h:-half_h);
-      }
-    }
-    break;
+    return ShapeSupportImpl<S, Cylinder<S>>::run(
+          *static_cast<const Cylinder<S>*>(shape), dir);
   case GEOM_CONVEX:
-    {
-      const Convex<S>* convex = static_cast<const Convex<S>*>(shape);
-      S maxdot = - std::numeric_limits<S>::max();
-      Vector3<S>* curp = convex->points;
-      Vector3<S> bestv = Vector3<S>::Zero();
-      for(int i = 0; i < convex->num_points; ++i, curp+=1)
-      {
-        S dot = dir.dot(*curp);
-        if(dot > maxdot)
-        {
-          bestv = *curp;
-          maxdot = dot;
-        }
-      }
-      return bestv;
-    }
-    break;
+    return ShapeSupportImpl<S, Convex<S>>::run(
+          *static_cast<const Convex<S>*>(shape), dir, hint);
   case GEOM_PLANE:
   break;
   default:
@@ -246,36 +342,43 @@ Vector3<S> getSupport(
 }
 
 //==============================================================================
-template <typename S>
-MinkowskiDiff<S>::MinkowskiDiff()
+template <typename S, typename Shape1, typename Shape2>
+MinkowskiDiff<S, Shape1, Shape2>::MinkowskiDiff()
 {
-  // Do nothing
+  support_hints[0] = support_hints[1] = -1;
 }
 
 //==============================================================================
-template <typename S>
-Vector3<S> MinkowskiDiff<S>::support0(const Vector3<S>& d) const
+template <typename S, typename Shape1, typename Shape2>
+Vector3<S> MinkowskiDiff<S, Shape1, Shape2>::support0(const Vector3<S>& d) const
 {
-  return getSupport(shapes[0], d);
+  return ShapeSupportImpl<S, Shape1>::run(
+        *static_cast<const Shape1*>(shapes[0]), d, &support_hints[0]);
 }
 
 //==============================================================================
-template <typename S>
-Vector3<S> MinkowskiDiff<S>::support1(const Vector3<S>& d) const
+template <typename S, typename Shape1, typename Shape2>
+Vector3<S> MinkowskiDiff<S, Shape1, Shape2>::support1(const Vector3<S>& d) const
 {
-  return toshape0 * getSupport(shapes[1], toshape1 * d);
+  // evaluate the direction in the frame of shape1 once, rather than the
+  // product on each access of its coefficients, and transform the support
+  // point back without the homogeneous product of the affine transform
+  const Vector3<S> d1 = toshape1 * d;
+  return toshape0.linear() * ShapeSupportImpl<S, Shape2>::run(
+        *static_cast<const Shape2*>(shapes[1]), d1, &support_hints[1])
+      + toshape0.translation();
 }
 
 //==============================================================================
-template <typename S>
-Vector3<S> MinkowskiDiff<S>::support(const Vector3<S>& d) const
+template <typename S, typename Shape1, typename Shape2>
+Vector3<S> MinkowskiDiff<S, Shape1, Shape2>::support(const Vector3<S>& d) const
 {
   return support0(d) - support1(-d);
 }
 
 //==============================================================================
-template <typename S>
-Vector3<S> MinkowskiDiff<S>::support(const Vector3<S>& d, size_t index) const
+template <typename S, typename Shape1, typename Shape2>
+Vector3<S> MinkowskiDiff<S, Shape1, Shape2>::support(const Vector3<S>& d, size_t index) const
 {
   if(index)
     return support1(d);
@@ -284,25 +387,25 @@ Vector3<S> MinkowskiDiff<S>::support(const Vector3<S>& d, size_t index) const
 }
 
 //==============================================================================
-template <typename S>
-Vector3<S> MinkowskiDiff<S>::support0(const Vector3<S>& d, const Vector3<S>& v) const
+template <typename S, typename Shape1, typename Shape2>
+Vector3<S> MinkowskiDiff<S, Shape1, Shape2>::support0(const Vector3<S>& d, const Vector3<S>& v) const
 {
   if(d.dot(v) <= 0)
-    return getSupport(shapes[0], d);
+    return support0(d);
   else
-    return getSupport(shapes[0], d) + v;
+    return support0(d) + v;
 }
 
 //==============================================================================
-template <typename S>
-Vector3<S> MinkowskiDiff<S>::support(const Vector3<S>& d, const Vector3<S>& v) const
+template <typename S, typename Shape1, typename Shape2>
+Vector3<S> MinkowskiDiff<S, Shape1, Shape2>::support(const Vector3<S>& d, const Vector3<S>& v) const
 {
   return support0(d, v) - support1(-d);
 }
 
 //==============================================================================
-template <typename S>
-Vector3<S> MinkowskiDiff<S>::support(const Vector3<S>& d, const Vector3<S>& v, size_t index) const
+template <typename S, typename Shape1, typename Shape2>
+Vector3<S> MinkowskiDiff<S, Shape1, Shape2>::support(const Vector3<S>& d, const Vector3<S>& v, size_t index) const
 {
   if(index)
     return support1(d);
@@ -39,6 +39,7 @@
 #define FCL_NARROWPHASE_DETAIL_PROJECT_H
 
 #include "fcl/common/types.h"
+#include "fcl/math/constants.h"
 #include "fcl/math/geometry.h"
 
 namespace fcl
@@ -83,6 +84,10 @@ public:
 
   /// @brief Project origin (0) onto tetrahedran a-b-c-d
   static ProjectResult projectTetrahedraOrigin(const Vector3<S>& a, const Vector3<S>& b, const Vector3<S>& c, const Vector3<S>& d);
+
+  /// @brief Project origin (0) onto the hull of the coplanar points a-b-c-d,
+  /// i.e. onto the nearest of the four triangles they form
+  static ProjectResult projectFlatTetrahedraOrigin(const Vector3<S>& a, const Vector3<S>& b, const Vector3<S>& c, const Vector3<S>& d);
 };
 
 using Projectf = Project<float>;
@@ -306,6 +311,14 @@ typename Project<S>::ProjectResult Project<S>::projectTetrahedraOrigin(const Vec
   const Vector3<S>* vt[] = {&a, &b, &c, &d};
   const Vector3<S> dl[3] = {a-d, b-d, c-d};
   S vl = triple(dl[0], dl[1], dl[2]);
+
+  // the rounding error of vl is a few eps of the product of the edge lengths;
+  // below that vl and the side tests that follow are noise, which in single
+  // precision happens well before the tetrahedron is exactly flat
+  const S vl_tolerance = 4 * constants<S>::eps();
+  if(vl * vl <= vl_tolerance * vl_tolerance * dl[0].squaredNorm() * dl[1].squaredNorm() * dl[2].squaredNorm())
+    return projectFlatTetrahedraOrigin(a, b, c, d);
+
   bool ng = (vl * a.dot((b-c).cross(a-b))) <= 0;
   if(ng && std::abs(vl) > 0) // abs(vl) == 0, the tetrahedron is degenerated; if ng is false, then the last vertex in the tetrahedron does not grow toward the origin (in fact origin is on the other side of the abc face)
   {
@@ -350,6 +363,39 @@ typename Project<S>::ProjectResult Project<S>::projectTetrahedraOrigin(const Vec
   return res;
 }
 
+//==============================================================================
+template <typename S>
+typename Project<S>::ProjectResult Project<S>::projectFlatTetrahedraOrigin(const Vector3<S>& a, const Vector3<S>& b, const Vector3<S>& c, const Vector3<S>& d)
+{
+  ProjectResult res;
+
+  static const size_t faces[4][3] = {{0, 1, 2}, {0, 1, 3}, {0, 2, 3}, {1, 2, 3}};
+  const Vector3<S>* vt[] = {&a, &b, &c, &d};
+
+  for(size_t i = 0; i < 4; ++i)
+  {
+    const size_t* face = faces[i];
+    ProjectResult res_triangle = projectTriangleOrigin(*vt[face[0]], *vt[face[1]], *vt[face[2]]);
+    if(res_triangle.sqr_distance < 0) // the triangle is degenerated too
+      continue;
+
+    if(res.sqr_distance < 0 || res_triangle.sqr_distance < res.sqr_distance)
+    {
+      res.sqr_distance = res_triangle.sqr_distance;
+      res.encode = 0;
+      res.parameterization[0] = res.parameterization[1] = res.parameterization[2] = res.parameterization[3] = 0;
+      for(size_t j = 0; j < 3; ++j)
+      {
+        if(res_triangle.encode & (1 << j))
+          res.encode |= 1 << face[j];
+        res.parameterization[face[j]] = res_triangle.parameterization[j];
+      }
+    }
+  }
+
+  return res;
+}
+
 //==============================================================================
 template <typename S>
 Project<S>::ProjectResult::ProjectResult()
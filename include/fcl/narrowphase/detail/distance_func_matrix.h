@@ -426,7 +426,10 @@ typename BV::S orientedMeshDistance(
   const BVHModel<BV>* obj2 = static_cast<const BVHModel<BV>* >(o2);
 
   initialize(node, *obj1, tf1, *obj2, tf2, request, result);
-  distance(&node);
+  if(obj2->getWideBVH())
+    distance(&node, *obj2->getWideBVH());
+  else
+    distance(&node);
 
   return result.min_distance;
 }
@@ -40,6 +40,7 @@
 
 #include <algorithm>
 
+#include "fcl/math/constants.h"
 #include "fcl/narrowphase/detail/convexity_based_algorithm/gjk.h"
 #include "fcl/narrowphase/detail/convexity_based_algorithm/epa.h"
 #include "fcl/narrowphase/detail/primitive_shape_algorithm/capsule_capsule.h"
@@ -154,6 +155,14 @@ struct GJKSolver_indep
 
   Vector3<S> getCachedGuess() const;
 
+  void setCachedSimplex(const GJKSimplexCache<S>& cache) const;
+
+  GJKSimplexCache<S> getCachedSimplex() const;
+
+  /// @brief Get the storage for EPA in the penetration queries: epa_workspace
+  /// if set, or else that of the calling thread
+  EPAWorkspace<S>& getEPAWorkspace() const;
+
   /// @brief maximum number of simplex face used in EPA algorithm
   unsigned int epa_max_face_num;
 
@@ -163,10 +172,12 @@ struct GJKSolver_indep
   /// @brief maximum number of iterations used for EPA iterations
   unsigned int epa_max_iterations;
 
-  /// @brief the threshold used in EPA to stop iteration
+  /// @brief the threshold used in EPA to stop iteration, by default
+  /// constants<S>::gjk_default_tolerance()
   S epa_tolerance;
 
-  /// @brief the threshold used in GJK to stop iteration
+  /// @brief the threshold used in GJK to stop iteration, by default
+  /// constants<S>::gjk_default_tolerance()
   S gjk_tolerance;
 
   /// @brief maximum number of iterations used for GJK iterations
@@ -177,6 +188,17 @@ struct GJKSolver_indep
 
   /// @brief smart guess
   mutable Vector3<S> cached_guess;
+
+  /// @brief the simplex the GJK queries between two shapes start from when
+  /// enable_cached_guess is set, in place of cached_guess unless it is empty.
+  /// Each such query stores its terminal simplex in it.
+  mutable GJKSimplexCache<S> cached_simplex;
+
+  /// @brief storage for EPA in the penetration queries, which must not be
+  /// shared by concurrent queries. If null, which is the default, each thread
+  /// uses a storage of its own, so that once it has grown the queries
+  /// allocate nothing.
+  EPAWorkspace<S>* epa_workspace;
 };
 
 using GJKSolver_indepf = GJKSolver_indep<float>;
@@ -241,23 +263,27 @@ struct ShapeIntersectIndepImpl
     Vector3<S> guess(1, 0, 0);
     if(gjkSolver.enable_cached_guess) guess = gjkSolver.cached_guess;
 
-    detail::MinkowskiDiff<S> shape;
+    detail::MinkowskiDiff<S, Shape1, Shape2> shape;
     shape.shapes[0] = &s1;
     shape.shapes[1] = &s2;
     shape.toshape1.noalias() = tf2.linear().transpose() * tf1.linear();
     shape.toshape0 = tf1.inverse(Eigen::Isometry) * tf2;
 
-    detail::GJK<S> gjk(gjkSolver.gjk_max_iterations, gjkSolver.gjk_tolerance);
-    typename detail::GJK<S>::Status gjk_status = gjk.evaluate(shape, -guess);
-    if(gjkSolver.enable_cached_guess) gjkSolver.cached_guess = gjk.getGuessFromSimplex();
+    detail::GJK<S, Shape1, Shape2> gjk(gjkSolver.gjk_max_iterations, gjkSolver.gjk_tolerance);
+    typename detail::GJK<S, Shape1, Shape2>::Status gjk_status = gjk.evaluate(shape, -guess, gjkSolver.enable_cached_guess ? &gjkSolver.cached_simplex : nullptr);
+    if(gjkSolver.enable_cached_guess)
+    {
+      gjkSolver.cached_guess = gjk.getGuessFromSimplex();
+      gjk.getSimplexCache(gjkSolver.cached_simplex);
+    }
 
     switch(gjk_status)
     {
-    case detail::GJK<S>::Inside:
+    case detail::GJK<S, Shape1, Shape2>::Inside:
       {
-        detail::EPA<S> epa(gjkSolver.epa_max_face_num, gjkSolver.epa_max_vertex_num, gjkSolver.epa_max_iterations, gjkSolver.epa_tolerance);
-        typename detail::EPA<S>::Status epa_status = epa.evaluate(gjk, -guess);
-        if(epa_status != detail::EPA<S>::Failed)
+        detail::EPA<S, Shape1, Shape2> epa(gjkSolver.epa_max_face_num, gjkSolver.epa_max_vertex_num, gjkSolver.epa_max_iterations, gjkSolver.epa_tolerance, gjkSolver.getEPAWorkspace());
+        typename detail::EPA<S, Shape1, Shape2>::Status epa_status = epa.evaluate(gjk, -guess);
+        if(epa_status != detail::EPA<S, Shape1, Shape2>::Failed)
         {
           Vector3<S> w0 = Vector3<S>::Zero();
           for(size_t i = 0; i < epa.result.rank; ++i)
@@ -474,23 +500,23 @@ struct ShapeTriangleIntersectIndepImpl
     Vector3<S> guess(1, 0, 0);
     if(gjkSolver.enable_cached_guess) guess = gjkSolver.cached_guess;
 
-    detail::MinkowskiDiff<S> shape;
+    detail::MinkowskiDiff<S, Shape, TriangleP<S>> shape;
     shape.shapes[0] = &s;
     shape.shapes[1] = &tri;
     shape.toshape1 = tf.linear();
     shape.toshape0 = tf.inverse(Eigen::Isometry);
 
-    detail::GJK<S> gjk(gjkSolver.gjk_max_iterations, gjkSolver.gjk_tolerance);
-    typename detail::GJK<S>::Status gjk_status = gjk.evaluate(shape, -guess);
+    detail::GJK<S, Shape, TriangleP<S>> gjk(gjkSolver.gjk_max_iterations, gjkSolver.gjk_tolerance);
+    typename detail::GJK<S, Shape, TriangleP<S>>::Status gjk_status = gjk.evaluate(shape, -guess);
     if(gjkSolver.enable_cached_guess) gjkSolver.cached_guess = gjk.getGuessFromSimplex();
 
     switch(gjk_status)
     {
-    case detail::GJK<S>::Inside:
+    case detail::GJK<S, Shape, TriangleP<S>>::Inside:
       {
-        detail::EPA<S> epa(gjkSolver.epa_max_face_num, gjkSolver.epa_max_vertex_num, gjkSolver.epa_max_iterations, gjkSolver.epa_tolerance);
-        typename detail::EPA<S>::Status epa_status = epa.evaluate(gjk, -guess);
-        if(epa_status != detail::EPA<S>::Failed)
+        detail::EPA<S, Shape, TriangleP<S>> epa(gjkSolver.epa_max_face_num, gjkSolver.epa_max_vertex_num, gjkSolver.epa_max_iterations, gjkSolver.epa_tolerance, gjkSolver.getEPAWorkspace());
+        typename detail::EPA<S, Shape, TriangleP<S>>::Status epa_status = epa.evaluate(gjk, -guess);
+        if(epa_status != detail::EPA<S, Shape, TriangleP<S>>::Failed)
         {
           Vector3<S> w0 = Vector3<S>::Zero();
           for(size_t i = 0; i < epa.result.rank; ++i)
@@ -571,23 +597,23 @@ struct ShapeTransformedTriangleIntersectIndepImpl
     Vector3<S> guess(1, 0, 0);
     if(gjkSolver.enable_cached_guess) guess = gjkSolver.cached_guess;
 
-    detail::MinkowskiDiff<S> shape;
+    detail::MinkowskiDiff<S, Shape, TriangleP<S>> shape;
     shape.shapes[0] = &s;
     shape.shapes[1] = &tri;
     shape.toshape1.noalias() = tf2.linear().transpose() * tf1.linear();
     shape.toshape0 = tf1.inverse(Eigen::Isometry) * tf2;
 
-    detail::GJK<S> gjk(gjkSolver.gjk_max_iterations, gjkSolver.gjk_tolerance);
-    typename detail::GJK<S>::Status gjk_status = gjk.evaluate(shape, -guess);
+    detail::GJK<S, Shape, TriangleP<S>> gjk(gjkSolver.gjk_max_iterations, gjkSolver.gjk_tolerance);
+    typename detail::GJK<S, Shape, TriangleP<S>>::Status gjk_status = gjk.evaluate(shape, -guess);
     if(gjkSolver.enable_cached_guess) gjkSolver.cached_guess = gjk.getGuessFromSimplex();
 
     switch(gjk_status)
     {
-    case detail::GJK<S>::Inside:
+    case detail::GJK<S, Shape, TriangleP<S>>::Inside:
       {
-        detail::EPA<S> epa(gjkSolver.epa_max_face_num, gjkSolver.epa_max_vertex_num, gjkSolver.epa_max_iterations, gjkSolver.epa_tolerance);
-        typename detail::EPA<S>::Status epa_status = epa.evaluate(gjk, -guess);
-        if(epa_status != detail::EPA<S>::Failed)
+        detail::EPA<S, Shape, TriangleP<S>> epa(gjkSolver.epa_max_face_num, gjkSolver.epa_max_vertex_num, gjkSolver.epa_max_iterations, gjkSolver.epa_tolerance, gjkSolver.getEPAWorkspace());
+        typename detail::EPA<S, Shape, TriangleP<S>>::Status epa_status = epa.evaluate(gjk, -guess);
+        if(epa_status != detail::EPA<S, Shape, TriangleP<S>>::Failed)
         {
           Vector3<S> w0 = Vector3<S>::Zero();
           for(size_t i = 0; i < epa.result.rank; ++i)
@@ -711,17 +737,21 @@ struct ShapeDistanceIndepImpl
     Vector3<S> guess(1, 0, 0);
     if(gjkSolver.enable_cached_guess) guess = gjkSolver.cached_guess;
 
-    detail::MinkowskiDiff<S> shape;
+    detail::MinkowskiDiff<S, Shape1, Shape2> shape;
     shape.shapes[0] = &s1;
     shape.shapes[1] = &s2;
     shape.toshape1.noalias() = tf2.linear().transpose() * tf1.linear();
     shape.toshape0 = tf1.inverse(Eigen::Isometry) * tf2;
 
-    detail::GJK<S> gjk(gjkSolver.gjk_max_iterations, gjkSolver.gjk_tolerance);
-    typename detail::GJK<S>::Status gjk_status = gjk.evaluate(shape, -guess);
-    if(gjkSolver.enable_cached_guess) gjkSolver.cached_guess = gjk.getGuessFromSimplex();
+    detail::GJK<S, Shape1, Shape2> gjk(gjkSolver.gjk_max_iterations, gjkSolver.gjk_tolerance);
+    typename detail::GJK<S, Shape1, Shape2>::Status gjk_status = gjk.evaluate(shape, -guess, gjkSolver.enable_cached_guess ? &gjkSolver.cached_simplex : nullptr);
+    if(gjkSolver.enable_cached_guess)
+    {
+      gjkSolver.cached_guess = gjk.getGuessFromSimplex();
+      gjk.getSimplexCache(gjkSolver.cached_simplex);
+    }
 
-    if(gjk_status == detail::GJK<S>::Valid)
+    if(gjk_status == detail::GJK<S, Shape1, Shape2>::Valid)
     {
       Vector3<S> w0 = Vector3<S>::Zero();
       Vector3<S> w1 = Vector3<S>::Zero();
@@ -877,17 +907,17 @@ struct ShapeTriangleDistanceIndepImpl
     Vector3<S> guess(1, 0, 0);
     if(gjkSolver.enable_cached_guess) guess = gjkSolver.cached_guess;
 
-    detail::MinkowskiDiff<S> shape;
+    detail::MinkowskiDiff<S, Shape, TriangleP<S>> shape;
     shape.shapes[0] = &s;
     shape.shapes[1] = &tri;
     shape.toshape1 = tf.linear();
     shape.toshape0 = tf.inverse(Eigen::Isometry);
 
-    detail::GJK<S> gjk(gjkSolver.gjk_max_iterations, gjkSolver.gjk_tolerance);
-    typename detail::GJK<S>::Status gjk_status = gjk.evaluate(shape, -guess);
+    detail::GJK<S, Shape, TriangleP<S>> gjk(gjkSolver.gjk_max_iterations, gjkSolver.gjk_tolerance);
+    typename detail::GJK<S, Shape, TriangleP<S>>::Status gjk_status = gjk.evaluate(shape, -guess);
     if(gjkSolver.enable_cached_guess) gjkSolver.cached_guess = gjk.getGuessFromSimplex();
 
-    if(gjk_status == detail::GJK<S>::Valid)
+    if(gjk_status == detail::GJK<S, Shape, TriangleP<S>>::Valid)
     {
       Vector3<S> w0 = Vector3<S>::Zero();
       Vector3<S> w1 = Vector3<S>::Zero();
@@ -967,17 +997,17 @@ struct ShapeTransformedTriangleDistanceIndepImpl
     Vector3<S> guess(1, 0, 0);
     if(gjkSolver.enable_cached_guess) guess = gjkSolver.cached_guess;
 
-    detail::MinkowskiDiff<S> shape;
+    detail::MinkowskiDiff<S, Shape, TriangleP<S>> shape;
     shape.shapes[0] = &s;
     shape.shapes[1] = &tri;
     shape.toshape1.noalias() = tf2.linear().transpose() * tf1.linear();
     shape.toshape0 = tf1.inverse(Eigen::Isometry) * tf2;
 
-    detail::GJK<S> gjk(gjkSolver.gjk_max_iterations, gjkSolver.gjk_tolerance);
-    typename detail::GJK<S>::Status gjk_status = gjk.evaluate(shape, -guess);
+    detail::GJK<S, Shape, TriangleP<S>> gjk(gjkSolver.gjk_max_iterations, gjkSolver.gjk_tolerance);
+    typename detail::GJK<S, Shape, TriangleP<S>>::Status gjk_status = gjk.evaluate(shape, -guess);
     if(gjkSolver.enable_cached_guess) gjkSolver.cached_guess = gjk.getGuessFromSimplex();
 
-    if(gjk_status == detail::GJK<S>::Valid)
+    if(gjk_status == detail::GJK<S, Shape, TriangleP<S>>::Valid)
     {
       Vector3<S> w0 = Vector3<S>::Zero();
       Vector3<S> w1 = Vector3<S>::Zero();
@@ -1045,13 +1075,14 @@ template <typename S>
 GJKSolver_indep<S>::GJKSolver_indep()
 {
   gjk_max_iterations = 128;
-  gjk_tolerance = 1e-6;
+  gjk_tolerance = constants<S>::gjk_default_tolerance();
   epa_max_face_num = 128;
   epa_max_vertex_num = 64;
   epa_max_iterations = 255;
-  epa_tolerance = 1e-6;
+  epa_tolerance = constants<S>::gjk_default_tolerance();
   enable_cached_guess = false;
   cached_guess = Vector3<S>(1, 0, 0);
+  epa_workspace = nullptr;
 }
 
 //==============================================================================
@@ -1075,6 +1106,31 @@ Vector3<S> GJKSolver_indep<S>::getCachedGuess() const
   return cached_guess;
 }
 
+//==============================================================================
+template <typename S>
+void GJKSolver_indep<S>::setCachedSimplex(const GJKSimplexCache<S>& cache) const
+{
+  cached_simplex = cache;
+}
+
+//==============================================================================
+template <typename S>
+GJKSimplexCache<S> GJKSolver_indep<S>::getCachedSimplex() const
+{
+  return cached_simplex;
+}
+
+//==============================================================================
+template <typename S>
+EPAWorkspace<S>& GJKSolver_indep<S>::getEPAWorkspace() const
+{
+  if(epa_workspace)
+    return *epa_workspace;
+
+  static thread_local EPAWorkspace<S> thread_workspace;
+  return thread_workspace;
+}
+
 } // namespace detail
 } // namespace fcl
 
@@ -40,6 +40,7 @@
 
 #include <algorithm>
 
+#include "fcl/narrowphase/gjk_simplex_cache.h"
 #include "fcl/narrowphase/detail/convexity_based_algorithm/gjk_libccd.h"
 #include "fcl/narrowphase/detail/primitive_shape_algorithm/capsule_capsule.h"
 #include "fcl/narrowphase/detail/primitive_shape_algorithm/sphere_capsule.h"
@@ -153,6 +154,12 @@ struct GJKSolver_libccd
 
   Vector3<S> getCachedGuess() const;
 
+  /// @brief Deliberately a no-op: libccd always starts GJK from scratch
+  void setCachedSimplex(const GJKSimplexCache<S>& cache) const;
+
+  /// @brief Always returns an empty cache
+  GJKSimplexCache<S> getCachedSimplex() const;
+
   /// @brief maximum number of iterations used in GJK algorithm for collision
   unsigned int max_collision_iterations;
 
@@ -976,6 +983,21 @@ Vector3<S> GJKSolver_libccd<S>::getCachedGuess() const
   return Vector3<S>(-1, 0, 0);
 }
 
+//==============================================================================
+template<typename S>
+void GJKSolver_libccd<S>::setCachedSimplex(
+    const GJKSimplexCache<S>& /*cache*/) const
+{
+  // libccd cannot start from a given simplex, so there is nothing to store
+}
+
+//==============================================================================
+template<typename S>
+GJKSimplexCache<S> GJKSolver_libccd<S>::getCachedSimplex() const
+{
+  return GJKSimplexCache<S>();
+}
+
 } // namespace detail
 } // namespace fcl
 
@@ -44,6 +44,7 @@
 #include "fcl/math/bv/kIOS.h"
 #include "fcl/narrowphase/contact.h"
 #include "fcl/narrowphase/cost_source.h"
+#include "fcl/object/geometry/bvh/detail/BVH_wide.h"
 #include "fcl/narrowphase/detail/primitive_shape_algorithm/intersect.h"
 #include "fcl/narrowphase/detail/traversal/collision/bvh_collision_traversal_node.h"
 
@@ -112,6 +113,12 @@ public:
 
   void leafTesting(int b1, int b2, const Transform3<S>& tf) const;
 
+  /// @brief BV culling test between the node b1 of the first model and all the
+  /// children of the wide node node2 of the second model at once. Bit i of the
+  /// return value is set if the i-th child of node2 is not culled.
+  template <int N>
+  unsigned int BVTesting(int b1, const WideBVNode<OBB<S>, N>& node2) const;
+
   Matrix3<S> R;
   Vector3<S> T;
 
@@ -517,6 +524,19 @@ bool MeshCollisionTraversalNodeOBB<S>::BVTesting(
         this->model2->getBV(b2).bv.extent);
 }
 
+//==============================================================================
+template <typename S>
+template <int N>
+unsigned int MeshCollisionTraversalNodeOBB<S>::BVTesting(
+    int b1, const WideBVNode<OBB<S>, N>& node2) const
+{
+  if(this->enable_statistics) this->num_bv_tests += node2.num_children;
+
+  const unsigned int valid = (1u << node2.num_children) - 1;
+
+  return overlapPacket(R, T, this->model1->getBV(b1).bv, node2.bounds) & valid;
+}
+
 //==============================================================================
 template <typename S>
 void MeshCollisionTraversalNodeOBB<S>::leafTesting(
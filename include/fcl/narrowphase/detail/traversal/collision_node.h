@@ -53,24 +53,41 @@ namespace detail
 {
 
 /// @brief collision on collision traversal node; can use front list to accelerate
-template <typename S>
-void collide(CollisionTraversalNodeBase<S>* node, BVHFrontList* front_list = nullptr);
+template <typename S, typename FrontList = BVHFrontList>
+void collide(CollisionTraversalNodeBase<S>* node, FrontList* front_list = nullptr);
 
 /// @brief self collision on collision traversal node; can use front list to accelerate
-template <typename S>
-void selfCollide(CollisionTraversalNodeBase<S>* node, BVHFrontList* front_list = nullptr);
+template <typename S, typename FrontList = BVHFrontList>
+void selfCollide(CollisionTraversalNodeBase<S>* node, FrontList* front_list = nullptr);
 
 /// @brief distance computation on distance traversal node; can use front list to accelerate
-template <typename S>
-void distance(DistanceTraversalNodeBase<S>* node, BVHFrontList* front_list = nullptr, int qsize = 2);
+template <typename S, typename FrontList = BVHFrontList>
+void distance(DistanceTraversalNodeBase<S>* node, FrontList* front_list = nullptr, int qsize = 2);
 
 /// @brief special collision on OBB traversal node
-template <typename S>
-void collide2(MeshCollisionTraversalNodeOBB<S>* node, BVHFrontList* front_list = nullptr);
+template <typename S, typename FrontList = BVHFrontList>
+void collide2(MeshCollisionTraversalNodeOBB<S>* node, FrontList* front_list = nullptr);
 
 /// @brief special collision on RSS traversal node
-template <typename S>
-void collide2(MeshCollisionTraversalNodeRSS<S>* node, BVHFrontList* front_list = nullptr);
+template <typename S, typename FrontList = BVHFrontList>
+void collide2(MeshCollisionTraversalNodeRSS<S>* node, FrontList* front_list = nullptr);
+
+/// @brief collision on collision traversal node, where the second model is
+/// traversed through its wide hierarchy wide_model2. wide_model2 must be built
+/// from the second model of node.
+template <typename S, typename BV, int N>
+void collide(CollisionTraversalNodeBase<S>* node, const WideBVH<BV, N>& wide_model2);
+
+/// @brief collision on OBB traversal node in packet mode: the children of the
+/// wide nodes of wide_model2 are culled N at a time
+template <typename S, int N>
+void collide(MeshCollisionTraversalNodeOBB<S>* node, const WideBVH<OBB<S>, N>& wide_model2);
+
+/// @brief distance computation on distance traversal node, where the second
+/// model is traversed through its wide hierarchy wide_model2. wide_model2 must
+/// be built from the second model of node.
+template <typename S, typename BV, int N>
+void distance(DistanceTraversalNodeBase<S>* node, const WideBVH<BV, N>& wide_model2);
 
 //============================================================================//
 //                                                                            //
@@ -79,8 +96,8 @@ void collide2(MeshCollisionTraversalNodeRSS<S>* node, BVHFrontList* front_list =
 //============================================================================//
 
 //==============================================================================
-template <typename S>
-void collide(CollisionTraversalNodeBase<S>* node, BVHFrontList* front_list)
+template <typename S, typename FrontList>
+void collide(CollisionTraversalNodeBase<S>* node, FrontList* front_list)
 {
   if(front_list && front_list->size() > 0)
   {
@@ -93,8 +110,8 @@ void collide(CollisionTraversalNodeBase<S>* node, BVHFrontList* front_list)
 }
 
 //==============================================================================
-template <typename S>
-void collide2(MeshCollisionTraversalNodeOBB<S>* node, BVHFrontList* front_list)
+template <typename S, typename FrontList>
+void collide2(MeshCollisionTraversalNodeOBB<S>* node, FrontList* front_list)
 {
   if(front_list && front_list->size() > 0)
   {
@@ -115,8 +132,8 @@ void collide2(MeshCollisionTraversalNodeOBB<S>* node, BVHFrontList* front_list)
 }
 
 //==============================================================================
-template <typename S>
-void collide2(MeshCollisionTraversalNodeRSS<S>* node, BVHFrontList* front_list)
+template <typename S, typename FrontList>
+void collide2(MeshCollisionTraversalNodeRSS<S>* node, FrontList* front_list)
 {
   if(front_list && front_list->size() > 0)
   {
@@ -129,8 +146,38 @@ void collide2(MeshCollisionTraversalNodeRSS<S>* node, BVHFrontList* front_list)
 }
 
 //==============================================================================
-template <typename S>
-void selfCollide(CollisionTraversalNodeBase<S>* node, BVHFrontList* front_list)
+template <typename S, typename BV, int N>
+void collide(CollisionTraversalNodeBase<S>* node, const WideBVH<BV, N>& wide_model2)
+{
+  if(wide_model2.empty())
+  {
+    collisionRecurse(node, 0, 0, static_cast<BVHFrontList*>(nullptr));
+    return;
+  }
+
+  if(node->BVTesting(0, 0)) return;
+
+  collisionRecurse(node, 0, wide_model2, 0, 0);
+}
+
+//==============================================================================
+template <typename S, int N>
+void collide(MeshCollisionTraversalNodeOBB<S>* node, const WideBVH<OBB<S>, N>& wide_model2)
+{
+  if(wide_model2.empty())
+  {
+    collisionRecurse(node, 0, 0, static_cast<BVHFrontList*>(nullptr));
+    return;
+  }
+
+  if(node->BVTesting(0, 0)) return;
+
+  collisionRecurse(node, 0, wide_model2, 0, 0);
+}
+
+//==============================================================================
+template <typename S, typename FrontList>
+void selfCollide(CollisionTraversalNodeBase<S>* node, FrontList* front_list)
 {
 
   if(front_list && front_list->size() > 0)
@@ -144,8 +191,8 @@ void selfCollide(CollisionTraversalNodeBase<S>* node, BVHFrontList* front_list)
 }
 
 //==============================================================================
-template <typename S>
-void distance(DistanceTraversalNodeBase<S>* node, BVHFrontList* front_list, int qsize)
+template <typename S, typename FrontList>
+void distance(DistanceTraversalNodeBase<S>* node, FrontList* front_list, int qsize)
 {
   node->preprocess();
 
@@ -157,6 +204,20 @@ void distance(DistanceTraversalNodeBase<S>* node, BVHFrontList* front_list, int
   node->postprocess();
 }
 
+//==============================================================================
+template <typename S, typename BV, int N>
+void distance(DistanceTraversalNodeBase<S>* node, const WideBVH<BV, N>& wide_model2)
+{
+  node->preprocess();
+
+  if(wide_model2.empty())
+    distanceRecurse(node, 0, 0, static_cast<BVHFrontList*>(nullptr));
+  else
+    distanceRecurse(node, 0, wide_model2, 0, 0);
+
+  node->postprocess();
+}
+
 } // namespace detail
 } // namespace fcl
 
@@ -39,7 +39,8 @@
 #ifndef FCL_TRAVERSAL_RECURSE_H
 #define FCL_TRAVERSAL_RECURSE_H
 
-#include <queue>
+#include <algorithm>
+#include <vector>
 #include "fcl/object/geometry/bvh/detail/BVH_front.h"
 #include "fcl/narrowphase/detail/traversal/traversal_node_base.h"
 #include "fcl/narrowphase/detail/traversal/collision/collision_traversal_node_base.h"
@@ -53,33 +54,73 @@ namespace detail
 {
 
 /// @brief Recurse function for collision
-template <typename S>
-void collisionRecurse(CollisionTraversalNodeBase<S>* node, int b1, int b2, BVHFrontList* front_list);
+template <typename S, typename FrontList>
+void collisionRecurse(CollisionTraversalNodeBase<S>* node, int b1, int b2, FrontList* front_list);
 
 /// @brief Recurse function for collision, specialized for OBB type
-template <typename S>
-void collisionRecurse(MeshCollisionTraversalNodeOBB<S>* node, int b1, int b2, const Matrix3<S>& R, const Vector3<S>& T, BVHFrontList* front_list);
+template <typename S, typename FrontList>
+void collisionRecurse(MeshCollisionTraversalNodeOBB<S>* node, int b1, int b2, const Matrix3<S>& R, const Vector3<S>& T, FrontList* front_list);
+
+/// @brief BV culling test between the node b1 of the first model and all the
+/// children of the wide node node2 of the second model. Bit i of the return
+/// value is set if the i-th child of node2 is not culled.
+template <typename S, typename BV, int N>
+unsigned int wideBVTesting(CollisionTraversalNodeBase<S>* node, int b1, const WideBVNode<BV, N>& node2);
+
+/// @brief BV culling test for wide nodes, specialized for OBB type: the
+/// children of node2 are culled together with a packet test
+template <typename S, int N>
+unsigned int wideBVTesting(MeshCollisionTraversalNodeOBB<S>* node, int b1, const WideBVNode<OBB<S>, N>& node2);
+
+/// @brief Recurse function for collision between the node b1 of the first
+/// model and the node b2 of the second model, whose children are those of the
+/// wide node w2 (-1 if b2 is a leaf). b1 and b2 must overlap.
+template <typename TraversalNode, typename BV, int N>
+void collisionRecurse(TraversalNode* node, int b1, const WideBVH<BV, N>& wide_model2, int b2, int w2);
 
 /// @brief Recurse function for collision, specialized for RSS type
-template <typename S>
-void collisionRecurse(MeshCollisionTraversalNodeRSS<S>* node, int b1, int b2, const Matrix3<S>& R, const Vector3<S>& T, BVHFrontList* front_list);
+template <typename S, typename FrontList>
+void collisionRecurse(MeshCollisionTraversalNodeRSS<S>* node, int b1, int b2, const Matrix3<S>& R, const Vector3<S>& T, FrontList* front_list);
 
 /// @brief Recurse function for self collision. Make sure node is set correctly so that the first and second tree are the same
-template <typename S>
-void selfCollisionRecurse(CollisionTraversalNodeBase<S>* node, int b, BVHFrontList* front_list);
+template <typename S, typename FrontList>
+void selfCollisionRecurse(CollisionTraversalNodeBase<S>* node, int b, FrontList* front_list);
 
 /// @brief Recurse function for distance
-template <typename S>
-void distanceRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, BVHFrontList* front_list);
+template <typename S, typename FrontList>
+void distanceRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, FrontList* front_list);
+
+/// @brief Recurse function for distance between the node b1 of the first
+/// model and the node b2 of the second model, whose children are those of the
+/// wide node w2 (-1 if b2 is a leaf)
+template <typename S, typename BV, int N>
+void distanceRecurse(DistanceTraversalNodeBase<S>* node, int b1, const WideBVH<BV, N>& wide_model2, int b2, int w2);
 
 /// @brief Recurse function for distance, using queue acceleration
+template <typename S, typename FrontList>
+void distanceQueueRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, FrontList* front_list, int qsize);
+
 template <typename S>
-void distanceQueueRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, BVHFrontList* front_list, int qsize);
+struct BVT;
+
+/// @brief Recurse function for distance, using queue acceleration. The queues
+/// of all the recursion levels are stacked in storage.
+template <typename S, typename FrontList>
+void distanceQueueRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, FrontList* front_list, int qsize, std::vector<BVT<S>>& storage);
 
 /// @brief Recurse function for front list propagation
 template <typename S>
 void propagateBVHFrontListCollisionRecurse(CollisionTraversalNodeBase<S>* node, BVHFrontList* front_list);
 
+/// @brief Recurse function for front list propagation, on a flat front list
+template <typename S>
+void propagateBVHFrontListCollisionRecurse(CollisionTraversalNodeBase<S>* node, BVHFlatFrontList* front_list);
+
+/// @brief Propagate the front node (b1, b2), appending the new front nodes
+/// to front_list. Return whether the front node stays in the front.
+template <typename S, typename FrontList>
+bool propagateBVHFrontNode(CollisionTraversalNodeBase<S>* node, int b1, int b2, FrontList* front_list);
+
 //============================================================================//
 //                                                                            //
 //                              Implementations                               //
@@ -87,8 +128,8 @@ void propagateBVHFrontListCollisionRecurse(CollisionTraversalNodeBase<S>* node,
 //============================================================================//
 
 //==============================================================================
-template <typename S>
-void collisionRecurse(CollisionTraversalNodeBase<S>* node, int b1, int b2, BVHFrontList* front_list)
+template <typename S, typename FrontList>
+void collisionRecurse(CollisionTraversalNodeBase<S>* node, int b1, int b2, FrontList* front_list)
 {
   bool l1 = node->isFirstNodeLeaf(b1);
   bool l2 = node->isSecondNodeLeaf(b2);
@@ -136,8 +177,8 @@ void collisionRecurse(CollisionTraversalNodeBase<S>* node, int b1, int b2, BVHFr
 }
 
 //==============================================================================
-template <typename S>
-void collisionRecurse(MeshCollisionTraversalNodeOBB<S>* node, int b1, int b2, const Matrix3<S>& R, const Vector3<S>& T, BVHFrontList* front_list)
+template <typename S, typename FrontList>
+void collisionRecurse(MeshCollisionTraversalNodeOBB<S>* node, int b1, int b2, const Matrix3<S>& R, const Vector3<S>& T, FrontList* front_list)
 {
   bool l1 = node->isFirstNodeLeaf(b1);
   bool l2 = node->isSecondNodeLeaf(b2);
@@ -221,8 +262,79 @@ void collisionRecurse(MeshCollisionTraversalNodeOBB<S>* node, int b1, int b2, co
 }
 
 //==============================================================================
-template <typename S>
-void collisionRecurse(MeshCollisionTraversalNodeRSS<S>* node, int b1, int b2, const Matrix3<S>& R, const Vector3<S>& T, BVHFrontList* front_list)
+template <typename S, typename BV, int N>
+unsigned int wideBVTesting(CollisionTraversalNodeBase<S>* node, int b1, const WideBVNode<BV, N>& node2)
+{
+  unsigned int mask = 0;
+  for(int i = 0; i < node2.num_children; ++i)
+  {
+    if(!node->BVTesting(b1, node2.child_bv[i]))
+      mask |= (1u << i);
+  }
+
+  return mask;
+}
+
+//==============================================================================
+template <typename S, int N>
+unsigned int wideBVTesting(MeshCollisionTraversalNodeOBB<S>* node, int b1, const WideBVNode<OBB<S>, N>& node2)
+{
+  return node->BVTesting(b1, node2);
+}
+
+//==============================================================================
+template <typename TraversalNode, typename BV, int N>
+void collisionRecurse(TraversalNode* node, int b1, const WideBVH<BV, N>& wide_model2, int b2, int w2)
+{
+  const bool l1 = node->isFirstNodeLeaf(b1);
+
+  if(w2 < 0)
+  {
+    if(l1)
+    {
+      node->leafTesting(b1, b2);
+    }
+    else
+    {
+      collisionRecurse(node, node->getFirstLeftChild(b1), b2, static_cast<BVHFrontList*>(nullptr));
+      if(node->canStop()) return;
+      collisionRecurse(node, node->getFirstRightChild(b1), b2, static_cast<BVHFrontList*>(nullptr));
+    }
+    return;
+  }
+
+  if(!l1 && node->firstOverSecond(b1, b2))
+  {
+    const int c1 = node->getFirstLeftChild(b1);
+    const int c2 = node->getFirstRightChild(b1);
+
+    if(!node->BVTesting(c1, b2))
+      collisionRecurse(node, c1, wide_model2, b2, w2);
+
+    if(node->canStop()) return;
+
+    if(!node->BVTesting(c2, b2))
+      collisionRecurse(node, c2, wide_model2, b2, w2);
+
+    return;
+  }
+
+  const WideBVNode<BV, N>& node2 = wide_model2.getNode(w2);
+  const unsigned int mask = wideBVTesting(node, b1, node2);
+
+  for(int i = 0; i < node2.num_children; ++i)
+  {
+    if(!(mask & (1u << i))) continue;
+
+    collisionRecurse(node, b1, wide_model2, node2.child_bv[i], node2.child_node[i]);
+
+    if(node->canStop()) return;
+  }
+}
+
+//==============================================================================
+template <typename S, typename FrontList>
+void collisionRecurse(MeshCollisionTraversalNodeRSS<S>* node, int b1, int b2, const Matrix3<S>& R, const Vector3<S>& T, FrontList* front_list)
 {
   // Do nothing
 }
@@ -231,8 +343,8 @@ void collisionRecurse(MeshCollisionTraversalNodeRSS<S>* node, int b1, int b2, co
 /** Recurse function for self collision
  * Make sure node is set correctly so that the first and second tree are the same
  */
-template <typename S>
-void selfCollisionRecurse(CollisionTraversalNodeBase<S>* node, int b, BVHFrontList* front_list)
+template <typename S, typename FrontList>
+void selfCollisionRecurse(CollisionTraversalNodeBase<S>* node, int b, FrontList* front_list)
 {
   bool l = node->isFirstNodeLeaf(b);
 
@@ -251,8 +363,8 @@ void selfCollisionRecurse(CollisionTraversalNodeBase<S>* node, int b, BVHFrontLi
 }
 
 //==============================================================================
-template <typename S>
-void distanceRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, BVHFrontList* front_list)
+template <typename S, typename FrontList>
+void distanceRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, FrontList* front_list)
 {
   bool l1 = node->isFirstNodeLeaf(b1);
   bool l2 = node->isSecondNodeLeaf(b2);
@@ -311,6 +423,68 @@ void distanceRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, BVHFron
   }
 }
 
+//==============================================================================
+template <typename S, typename BV, int N>
+void distanceRecurse(DistanceTraversalNodeBase<S>* node, int b1, const WideBVH<BV, N>& wide_model2, int b2, int w2)
+{
+  const bool l1 = node->isFirstNodeLeaf(b1);
+
+  if(w2 < 0)
+  {
+    if(l1)
+      node->leafTesting(b1, b2);
+    else
+      distanceRecurse(node, b1, b2, static_cast<BVHFrontList*>(nullptr));
+    return;
+  }
+
+  if(!l1 && node->firstOverSecond(b1, b2))
+  {
+    int a1 = node->getFirstLeftChild(b1);
+    int c1 = node->getFirstRightChild(b1);
+
+    S d1 = node->BVTesting(a1, b2);
+    S d2 = node->BVTesting(c1, b2);
+
+    if(d2 < d1)
+    {
+      std::swap(a1, c1);
+      std::swap(d1, d2);
+    }
+
+    if(!node->canStop(d1))
+      distanceRecurse(node, a1, wide_model2, b2, w2);
+
+    if(!node->canStop(d2))
+      distanceRecurse(node, c1, wide_model2, b2, w2);
+
+    return;
+  }
+
+  const WideBVNode<BV, N>& node2 = wide_model2.getNode(w2);
+
+  // visit the children of w2 from the closest to the farthest
+  S d[N];
+  int order[N];
+  for(int i = 0; i < node2.num_children; ++i)
+  {
+    d[i] = node->BVTesting(b1, node2.child_bv[i]);
+
+    int j = i;
+    for(; j > 0 && d[order[j - 1]] > d[i]; --j)
+      order[j] = order[j - 1];
+    order[j] = i;
+  }
+
+  for(int k = 0; k < node2.num_children; ++k)
+  {
+    const int i = order[k];
+    if(node->canStop(d[i])) return;
+
+    distanceRecurse(node, b1, wide_model2, node2.child_bv[i], node2.child_node[i]);
+  }
+}
+
 //==============================================================================
 /** @brief Bounding volume test structure */
 template <typename S>
@@ -335,53 +509,76 @@ struct BVT_Comparer
 };
 
 //==============================================================================
+/** @brief Bounded priority queue of BVT, closest first. Its elements are
+ * stored at the end of a vector shared with the queues of the enclosing
+ * recursion levels, which must not be modified while this one is alive. */
 template <typename S>
 struct BVTQ
 {
-  BVTQ() : qsize(2) {}
+  BVTQ(std::vector<BVT<S>>& storage_, unsigned int qsize_)
+    : storage(storage_), base(storage_.size()), qsize(qsize_) {}
+
+  ~BVTQ()
+  {
+    storage.resize(base);
+  }
 
   bool empty() const
   {
-    return pq.empty();
+    return storage.size() == base;
   }
 
   size_t size() const
   {
-    return pq.size();
+    return storage.size() - base;
   }
 
   const BVT<S>& top() const
   {
-    return pq.top();
+    return storage[base];
   }
 
   void push(const BVT<S>& x)
   {
-    pq.push(x);
+    storage.push_back(x);
+    std::push_heap(storage.begin() + base, storage.end(), BVT_Comparer<S>());
   }
 
   void pop()
   {
-    pq.pop();
+    std::pop_heap(storage.begin() + base, storage.end(), BVT_Comparer<S>());
+    storage.pop_back();
   }
 
   bool full() const
   {
-    return (pq.size() + 1 >= qsize);
+    return (size() + 1 >= qsize);
   }
 
-  std::priority_queue<BVT<S>, std::vector<BVT<S>>, BVT_Comparer<S>> pq;
+  std::vector<BVT<S>>& storage;
+
+  /** @brief Index of the first element of the queue in storage */
+  std::size_t base;
 
   /** @brief Queue size */
   unsigned int qsize;
 };
 
 //==============================================================================
-template <typename S>
-void distanceQueueRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, BVHFrontList* front_list, int qsize)
+template <typename S, typename FrontList>
+void distanceQueueRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, FrontList* front_list, int qsize)
 {
-  BVTQ<S> bvtq;
-  bvtq.qsize = qsize;
+  std::vector<BVT<S>> storage;
+  storage.reserve(4 * qsize);
+
+  distanceQueueRecurse(node, b1, b2, front_list, qsize, storage);
+}
+
+//==============================================================================
+template <typename S, typename FrontList>
+void distanceQueueRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, FrontList* front_list, int qsize, std::vector<BVT<S>>& storage)
+{
+  BVTQ<S> bvtq(storage, qsize);
 
   BVT<S> min_test;
   min_test.b1 = b1;
@@ -402,7 +599,7 @@ void distanceQueueRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, BV
     {
       // queue should not get two more tests, recur
 
-      distanceQueueRecurse(node, min_test.b1, min_test.b2, front_list, qsize);
+      distanceQueueRecurse(node, min_test.b1, min_test.b2, front_list, qsize, storage);
     }
     else
     {
@@ -455,63 +652,73 @@ void distanceQueueRecurse(DistanceTraversalNodeBase<S>* node, int b1, int b2, BV
 }
 
 //==============================================================================
-template <typename S>
-void propagateBVHFrontListCollisionRecurse(CollisionTraversalNodeBase<S>* node, BVHFrontList* front_list)
+template <typename S, typename FrontList>
+bool propagateBVHFrontNode(CollisionTraversalNodeBase<S>* node, int b1, int b2, FrontList* front_list)
 {
-  BVHFrontList::iterator front_iter;
-  BVHFrontList append;
-  for(front_iter = front_list->begin(); front_iter != front_list->end(); ++front_iter)
-  {
-    int b1 = front_iter->left;
-    int b2 = front_iter->right;
-    bool l1 = node->isFirstNodeLeaf(b1);
-    bool l2 = node->isSecondNodeLeaf(b2);
+  bool l1 = node->isFirstNodeLeaf(b1);
+  bool l2 = node->isSecondNodeLeaf(b2);
 
-    if(l1 & l2)
-    {
-      front_iter->valid = false; // the front node is no longer valid, in collideRecurse will add again.
-      collisionRecurse(node, b1, b2, &append);
-    }
-    else
-    {
-      if(!node->BVTesting(b1, b2))
-      {
-        front_iter->valid = false;
-
-        if(node->firstOverSecond(b1, b2))
-        {
-          int c1 = node->getFirstLeftChild(b1);
-          int c2 = node->getFirstRightChild(b1);
-
-          collisionRecurse(node, c1, b2, front_list);
-          collisionRecurse(node, c2, b2, front_list);
-        }
-        else
-        {
-          int c1 = node->getSecondLeftChild(b2);
-          int c2 = node->getSecondRightChild(b2);
-
-          collisionRecurse(node, b1, c1, front_list);
-          collisionRecurse(node, b1, c2, front_list);
-        }
-      }
-    }
+  if(l1 & l2)
+  {
+    // the front node is no longer valid, in collideRecurse will add again.
+    collisionRecurse(node, b1, b2, front_list);
+    return false;
   }
 
+  if(node->BVTesting(b1, b2))
+    return true;
 
-  // clean the old front list (remove invalid node)
-  for(front_iter = front_list->begin(); front_iter != front_list->end();)
+  if(node->firstOverSecond(b1, b2))
   {
-    if(!front_iter->valid)
-      front_iter = front_list->erase(front_iter);
-    else
-      ++front_iter;
+    int c1 = node->getFirstLeftChild(b1);
+    int c2 = node->getFirstRightChild(b1);
+
+    collisionRecurse(node, c1, b2, front_list);
+    collisionRecurse(node, c2, b2, front_list);
+  }
+  else
+  {
+    int c1 = node->getSecondLeftChild(b2);
+    int c2 = node->getSecondRightChild(b2);
+
+    collisionRecurse(node, b1, c1, front_list);
+    collisionRecurse(node, b1, c2, front_list);
   }
 
-  for(front_iter = append.begin(); front_iter != append.end(); ++front_iter)
+  return false;
+}
+
+//==============================================================================
+template <typename S>
+void propagateBVHFrontListCollisionRecurse(CollisionTraversalNodeBase<S>* node, BVHFrontList* front_list)
+{
+  // the traversal appends the new front nodes at the end of the list, where
+  // this loop does not visit them again
+  const std::size_t num_front_nodes = front_list->size();
+  BVHFrontList::iterator front_iter = front_list->begin();
+  for(std::size_t i = 0; i < num_front_nodes; ++i, ++front_iter)
+    front_iter->valid = propagateBVHFrontNode(node, front_iter->left, front_iter->right, front_list);
+
+  // clean the old front list (remove invalid node)
+  front_list->remove_if([](const BVHFrontNode& front_node) { return !front_node.valid; });
+}
+
+//==============================================================================
+template <typename S>
+void propagateBVHFrontListCollisionRecurse(CollisionTraversalNodeBase<S>* node, BVHFlatFrontList* front_list)
+{
+  const std::size_t num_front_nodes = front_list->size();
+  for(std::size_t i = 0; i < num_front_nodes; ++i)
   {
-    front_list->push_back(*front_iter);
+    // the list may grow, so the node is accessed by index
+    const BVHFrontNode front_node = (*front_list)[i];
+    const bool valid = propagateBVHFrontNode(node, front_node.left, front_node.right, front_list);
+    (*front_list)[i].valid = valid;
   }
+
+  front_list->erase(std::remove_if(front_list->begin(), front_list->end(),
+                                   [](const BVHFrontNode& front_node) { return !front_node.valid; }),
+                    front_list->end());
 }
 
 } // namespace detail
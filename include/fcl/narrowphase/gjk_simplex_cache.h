@@ -0,0 +1,107 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FCL_NARROWPHASE_GJKSIMPLEXCACHE_H
+#define FCL_NARROWPHASE_GJKSIMPLEXCACHE_H
+
+#include <cstddef>
+
+#include "fcl/common/types.h"
+
+namespace fcl
+{
+
+/// @brief The terminal simplex of a GJK query between two shapes, from which
+/// the next query between the same shapes starts. The vertices are kept as
+/// their support directions, in the frame of the first shape, so that they
+/// give the support points of the shapes in their new poses; between shapes
+/// that moved a little since, GJK then converges in one or two iterations.
+/// Any cache is a valid start for any pair of shapes, only a slower one.
+template <typename S>
+struct GJKSimplexCache
+{
+  /// @brief support directions of the vertices
+  Vector3<S> d[4];
+
+  /// @brief barycentric coordinates of the point of the simplex nearest to
+  /// the origin
+  S p[4];
+
+  /// @brief number of vertices, 0 for an empty cache
+  std::size_t rank;
+
+  /// @brief the support vertices found last on the two shapes, used as the
+  /// start of the search of the support functions that climb a vertex graph
+  int support_hints[2];
+
+  GJKSimplexCache();
+
+  /// @brief empty the cache, so that the next query starts from scratch
+  void clear();
+};
+
+using GJKSimplexCachef = GJKSimplexCache<float>;
+using GJKSimplexCached = GJKSimplexCache<double>;
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template <typename S>
+GJKSimplexCache<S>::GJKSimplexCache()
+{
+  clear();
+}
+
+//==============================================================================
+template <typename S>
+void GJKSimplexCache<S>::clear()
+{
+  for(std::size_t i = 0; i < 4; ++i)
+  {
+    d[i].setZero();
+    p[i] = 0;
+  }
+  rank = 0;
+  support_hints[0] = -1;
+  support_hints[1] = -1;
+}
+
+} // namespace fcl
+
+#endif
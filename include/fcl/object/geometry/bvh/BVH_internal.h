@@ -57,6 +57,13 @@ enum BVHBuildState
     BVH_BUILD_STATE_REPLACE_BEGUN,    /// after beginReplaceModel(), state for replacing geometry primitives
   };
 
+/// @brief Methods to build the bounding volume hierarchy
+enum BVHBuildMethod
+  {
+    BVH_BUILD_METHOD_TOP_DOWN,        /// recursive splitting with bv_splitter, every node fitted with bv_fitter
+    BVH_BUILD_METHOD_LINEAR           /// LBVH: primitives sorted along a Morton curve, AABB and KDOP merged bottom-up in O(n), oriented BVs refitted per node in O(n log n)
+  };
+
 /// @brief Error code for BVH 
 enum BVHReturnCode
   {
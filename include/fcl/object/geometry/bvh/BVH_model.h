@@ -38,21 +38,45 @@
 #ifndef FCL_BVH_MODEL_H
 #define FCL_BVH_MODEL_H
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <vector>
 #include <memory>
 
 #include "fcl/math/bv/OBB.h"
 #include "fcl/math/bv/kDOP.h"
+#include "fcl/math/detail/morton.h"
 #include "fcl/object/geometry/collision_geometry.h"
 #include "fcl/object/geometry/bvh/BVH_internal.h"
 #include "fcl/object/geometry/bvh/BV_node.h"
 #include "fcl/object/geometry/bvh/detail/BV_splitter.h"
 #include "fcl/object/geometry/bvh/detail/BV_fitter.h"
+#include "fcl/object/geometry/bvh/detail/BVH_wide.h"
+#include "fcl/object/geometry/bvh/detail/BVH_linear.h"
+#include "fcl/object/geometry/bvh/detail/BVH_shared_data.h"
+#include "fcl/common/detail/parallel.h"
 
 namespace fcl
 {
 
+namespace detail
+{
+
+template <typename BV>
+struct BVHSerializer;
+
+} // namespace detail
+
 /// @brief A class describing the bounding hierarchy of a mesh model or a point cloud model (which is viewed as a degraded version of mesh)
+///
+/// Once the model is built by endModel(), its vertices, triangles and
+/// hierarchy are shared, read only, with the copies made of it, and after
+/// loadBVHModel() from a storage they may live in a read-only mapped region.
+/// The public vertices and tri_indices pointers then alias that shared data:
+/// writing through them changes every copy, or faults on mapped storage. Go
+/// through beginReplaceModel() or beginUpdateModel() instead, which first
+/// give the model arrays of its own.
 template <typename BV>
 class BVHModel : public CollisionGeometry<typename BV::S>
 {
@@ -66,7 +90,11 @@ public:
   /// @brief Constructing an empty BVH
   BVHModel();
 
-  /// @brief copy from another BVH
+  /// @brief copy from another BVH. The vertices, triangles and hierarchy of
+  /// a built model are not copied but shared, read only, until either model
+  /// is modified through its member functions. The vertices and tri_indices
+  /// pointers of both models then point to the same arrays, which must not
+  /// be written to directly.
   BVHModel(const BVHModel& other);
 
   /// @brief deconstruction, delete mesh data related.
@@ -78,7 +106,9 @@ public:
   /// @brief Access the bv giving the its index
   const BVNode<BV>& getBV(int id) const;
 
-  /// @brief Access the bv giving the its index
+  /// @brief Access the bv giving the its index. Writing to a hierarchy that is
+  /// shared with other models or read from a loaded storage is an error, call
+  /// makeUnique() first.
   BVNode<BV>& getBV(int id);
 
   /// @brief Get the number of bv in the BVH
@@ -147,6 +177,20 @@ public:
   /// @brief Check the number of memory used
   int memUsage(int msg) const;
 
+  /// @brief Build the wide (4-ary) hierarchy from the current binary
+  /// hierarchy. The model must be processed or updated.
+  int buildWideBVH();
+
+  /// @brief Access the wide hierarchy, nullptr if it was not built. It is
+  /// used transparently by the oriented mesh collision and distance queries.
+  const detail::WideBVH<BV>* getWideBVH() const;
+
+  /// @brief Give the model vertices, triangles and hierarchy of its own,
+  /// copying them if they are shared with other models or read from a loaded
+  /// storage. Call it before writing to them through getBV() or the vertices
+  /// and tri_indices pointers.
+  void makeUnique();
+
   /// @brief This is a special acceleration: BVH_model default stores the BV's transform in world coordinate. However, we can also store each BV's transform related to its parent 
   /// BV node. When traversing the BVH, this can save one matrix transformation.
   void makeParentRelative();
@@ -158,10 +202,12 @@ public:
   Matrix3<S> computeMomentofInertia() const override;
 
 public:
-  /// @brief Geometry point data
+  /// @brief Geometry point data. It may be shared with other models once the
+  /// model is built and must then not be written to directly.
   Vector3<S>* vertices;
 
-  /// @brief Geometry triangle index data, will be nullptr for point clouds
+  /// @brief Geometry triangle index data, will be nullptr for point clouds.
+  /// It is shared like vertices.
   Triangle* tri_indices;
 
   /// @brief Geometry point data in previous frame
@@ -182,6 +228,23 @@ public:
   /// @brief Fitting rule to fit a BV node to a set of geometry primitives
   std::shared_ptr<detail::BVFitterBase<BV>> bv_fitter;
 
+  /// @brief Whether endModel(), endReplaceModel() and endUpdateModel() also
+  /// build the wide hierarchy. Otherwise these calls drop it.
+  bool build_wide_bvh;
+
+  /// @brief Number of threads used to build the bounding volume hierarchy,
+  /// the hardware concurrency if non-positive. The hierarchy is the same for
+  /// any number of threads. More than one thread needs bv_fitter and
+  /// bv_splitter to support clone().
+  int num_build_threads;
+
+  /// @brief How endModel(), endReplaceModel() and endUpdateModel() build the
+  /// bounding volume hierarchy. The linear build ignores bv_splitter and,
+  /// for AABB and KDOP, runs in time linear in the number of primitives, which
+  /// makes rebuilding deforming meshes every frame affordable, at the price
+  /// of a lower quality hierarchy.
+  BVHBuildMethod build_method;
+
 
 private:
 
@@ -198,9 +261,46 @@ private:
   /// @brief Number of BV nodes in bounding volume hierarchy
   int num_bvs;
 
+  /// @brief Wide hierarchy collapsed from bvs. It is never modified once
+  /// built, so copies of the model share it.
+  std::shared_ptr<detail::WideBVH<BV>> wide_bvh;
+
+  /// @brief Owner of vertices, tri_indices, primitive_indices and bvs once
+  /// the model is built, nullptr while they are owned by the model itself. It
+  /// is shared by the copies of the model, which makes the arrays read only.
+  std::shared_ptr<detail::BVHSharedData<BV>> shared_data;
+
+  /// @brief Hand vertices, tri_indices, primitive_indices and bvs over to
+  /// shared_data once the model is built
+  void shareData();
+
+  /// @brief Take vertices, tri_indices, primitive_indices and bvs back from
+  /// shared_data before they are modified, copying them if other models
+  /// still use them
+  void detachData();
+
+  /// @brief Free vertices, tri_indices, primitive_indices, bvs and
+  /// prev_vertices
+  void deleteData();
+
+  /// @brief Rebuild or drop the wide hierarchy after bvs changed
+  void updateWideBVH();
+
   /// @brief Build the bounding volume hierarchy
   int buildTree();
 
+  /// @brief Build the bounding volume hierarchy of an LBVH: the primitives
+  /// are sorted by the Morton code of their centroids, 30 bits or 60 bits
+  /// long for Code = uint32 or uint64, and each node is split where the
+  /// highest differing bit of its codes flips. AABB and KDOP BVs are merged
+  /// bottom-up, so the build is O(n) after the O(n) radix sort. Merging
+  /// oriented BVs would loosen them at every level, so OBB, RSS, OBBRSS and
+  /// kIOS nodes are instead each fitted with bv_fitter to all of their
+  /// primitives, which makes the refit O(n log n) for a balanced tree and up
+  /// to O(n^2) for a degenerate one, like the top-down build.
+  template <typename Code>
+  int buildTreeLinear(int num_primitives);
+
   /// @brief Refit the bounding volume hierarchy
   int refitTree(bool bottomup);
 
@@ -210,8 +310,16 @@ private:
   /// @brief Refit the bounding volume hierarchy in a bottom-up way (fast but less compact)
   int refitTree_bottomup();
 
-  /// @brief Recursive kernel for hierarchy construction
-  int recursiveBuildTree(int bv_id, int first_primitive, int num_primitives);
+  /// @brief Fit the BV node bv_id to its primitives and split them between
+  /// its two children, which are given the indices first_free and
+  /// first_free + 1. num_first_half is the number of primitives of the first
+  /// child.
+  int buildNode(detail::BVFitterBase<BV>* fitter, detail::BVSplitterBase<BV>* splitter, int bv_id, int first_primitive, int num_primitives, int first_free, int& num_first_half);
+
+  /// @brief Recursive kernel for hierarchy construction. The nodes of the
+  /// subtree below bv_id are given the indices starting from first_free, in
+  /// depth-first order, so that disjoint subtrees can be built concurrently.
+  int recursiveBuildTree(detail::BVFitterBase<BV>* fitter, detail::BVSplitterBase<BV>* splitter, int bv_id, int first_primitive, int num_primitives, int first_free);
 
   /// @brief Recursive kernel for bottomup refitting 
   int recursiveRefitTree_bottomup(int bv_id);
@@ -226,6 +334,8 @@ private:
 
   template <typename, typename>
   friend struct MakeParentRelativeRecurseImpl;
+
+  friend struct detail::BVHSerializer<BV>;
 };
 
 //============================================================================//
@@ -256,6 +366,9 @@ BVHModel<BV>::BVHModel() : vertices(nullptr),
   build_state(BVH_BUILD_STATE_EMPTY),
   bv_splitter(new detail::BVSplitter<BV>(detail::SPLIT_METHOD_MEAN)),
   bv_fitter(new detail::BVFitter<BV>()),
+  build_wide_bvh(false),
+  num_build_threads(1),
+  build_method(BVH_BUILD_METHOD_TOP_DOWN),
   num_tris_allocated(0),
   num_vertices_allocated(0),
   num_bvs_allocated(0),
@@ -276,9 +389,33 @@ BVHModel<BV>::BVHModel(const BVHModel<BV>& other)
     build_state(other.build_state),
     bv_splitter(other.bv_splitter),
     bv_fitter(other.bv_fitter),
+    build_wide_bvh(other.build_wide_bvh),
+    num_build_threads(other.num_build_threads),
+    build_method(other.build_method),
     num_tris_allocated(other.num_tris),
-    num_vertices_allocated(other.num_vertices)
+    num_vertices_allocated(other.num_vertices),
+    wide_bvh(other.wide_bvh)
 {
+  if(other.prev_vertices)
+  {
+    prev_vertices = new Vector3<S>[num_vertices];
+    memcpy(prev_vertices, other.prev_vertices, sizeof(Vector3<S>) * num_vertices);
+  }
+  else
+    prev_vertices = nullptr;
+
+  num_bvs = num_bvs_allocated = other.num_bvs;
+
+  if(other.shared_data)
+  {
+    shared_data = other.shared_data;
+    vertices = other.vertices;
+    tri_indices = other.tri_indices;
+    primitive_indices = other.primitive_indices;
+    bvs = other.bvs;
+    return;
+  }
+
   if(other.vertices)
   {
     vertices = new Vector3<S>[num_vertices];
@@ -295,14 +432,6 @@ BVHModel<BV>::BVHModel(const BVHModel<BV>& other)
   else
     tri_indices = nullptr;
 
-  if(other.prev_vertices)
-  {
-    prev_vertices = new Vector3<S>[num_vertices];
-    memcpy(prev_vertices, other.prev_vertices, sizeof(Vector3<S>) * num_vertices);
-  }
-  else
-    prev_vertices = nullptr;
-
   if(other.primitive_indices)
   {
     int num_primitives = 0;
@@ -324,7 +453,6 @@ BVHModel<BV>::BVHModel(const BVHModel<BV>& other)
   else
     primitive_indices = nullptr;
 
-  num_bvs = num_bvs_allocated = other.num_bvs;
   if(other.bvs)
   {
     bvs = new BVNode<BV>[num_bvs];
@@ -338,12 +466,7 @@ BVHModel<BV>::BVHModel(const BVHModel<BV>& other)
 template <typename BV>
 BVHModel<BV>::~BVHModel()
 {
-  delete [] vertices;
-  delete [] tri_indices;
-  delete [] bvs;
-
-  delete [] prev_vertices;
-  delete [] primitive_indices;
+  deleteData();
 }
 
 //==============================================================================
@@ -357,6 +480,7 @@ const BVNode<BV>& BVHModel<BV>::getBV(int id) const
 template <typename BV>
 BVNode<BV>& BVHModel<BV>::getBV(int id)
 {
+  assert(!shared_data || (shared_data.use_count() == 1 && !shared_data->storage));
   return bvs[id];
 }
 
@@ -397,11 +521,8 @@ int BVHModel<BV>::beginModel(int num_tris_, int num_vertices_)
 {
   if(build_state != BVH_BUILD_STATE_EMPTY)
   {
-    delete [] vertices; vertices = nullptr;
-    delete [] tri_indices; tri_indices = nullptr;
-    delete [] bvs; bvs = nullptr;
-    delete [] prev_vertices; prev_vertices = nullptr;
-    delete [] primitive_indices; primitive_indices = nullptr;
+    deleteData();
+    wide_bvh.reset();
 
     num_vertices_allocated = num_vertices = num_tris_allocated = num_tris = num_bvs_allocated = num_bvs = 0;
   }
@@ -691,6 +812,9 @@ int BVHModel<BV>::endModel()
   // finish constructing
   build_state = BVH_BUILD_STATE_PROCESSED;
 
+  shareData();
+  updateWideBVH();
+
   return BVH_OK;
 }
 
@@ -706,6 +830,8 @@ int BVHModel<BV>::beginReplaceModel()
 
   if(prev_vertices) delete [] prev_vertices; prev_vertices = nullptr;
 
+  detachData();
+
   num_vertex_updated = 0;
 
   build_state = BVH_BUILD_STATE_REPLACE_BEGUN;
@@ -790,6 +916,9 @@ int BVHModel<BV>::endReplaceModel(bool refit, bool bottomup)
 
   build_state = BVH_BUILD_STATE_PROCESSED;
 
+  shareData();
+  updateWideBVH();
+
   return BVH_OK;
 }
 
@@ -803,6 +932,8 @@ int BVHModel<BV>::beginUpdateModel()
     return BVH_ERR_BUILD_EMPTY_PREVIOUS_FRAME;
   }
 
+  detachData();
+
   if(prev_vertices)
   {
     Vector3<S>* temp = prev_vertices;
@@ -904,6 +1035,9 @@ int BVHModel<BV>::endUpdateModel(bool refit, bool bottomup)
 
   build_state = BVH_BUILD_STATE_UPDATED;
 
+  shareData();
+  updateWideBVH();
+
   return BVH_OK;
 }
 
@@ -915,22 +1049,156 @@ int BVHModel<BV>::memUsage(int msg) const
   int mem_tri_list = sizeof(Triangle) * num_tris;
   int mem_vertex_list = sizeof(Vector3<S>) * num_vertices;
 
-  int total_mem = mem_bv_list + mem_tri_list + mem_vertex_list + sizeof(BVHModel<BV>);
+  int mem_wide_bv_list = wide_bvh ? wide_bvh->memUsage() : 0;
+
+  int total_mem = mem_bv_list + mem_tri_list + mem_vertex_list + mem_wide_bv_list + sizeof(BVHModel<BV>);
   if(msg)
   {
     std::cerr << "Total for model " << total_mem << " bytes." << std::endl;
     std::cerr << "BVs: " << num_bvs << " allocated." << std::endl;
     std::cerr << "Tris: " << num_tris << " allocated." << std::endl;
     std::cerr << "Vertices: " << num_vertices << " allocated." << std::endl;
+    if(wide_bvh)
+      std::cerr << "Wide BVs: " << wide_bvh->getNumNodes() << " allocated, " << mem_wide_bv_list << " bytes (binary BVs: " << sizeof(BVNode<BV>) * num_bvs << " bytes)." << std::endl;
+  }
+
+  return BVH_OK;
+}
+
+//==============================================================================
+template <typename BV>
+int BVHModel<BV>::buildWideBVH()
+{
+  if(build_state != BVH_BUILD_STATE_PROCESSED && build_state != BVH_BUILD_STATE_UPDATED)
+  {
+    std::cerr << "BVH Warning! Call buildWideBVH() on a model that is not processed. buildWideBVH() was ignored." << std::endl;
+    return BVH_ERR_BUILD_OUT_OF_SEQUENCE;
   }
 
+  std::shared_ptr<detail::WideBVH<BV>> wide(new detail::WideBVH<BV>());
+  wide->build(*this);
+  wide_bvh = wide;
+
   return BVH_OK;
 }
 
+//==============================================================================
+template <typename BV>
+const detail::WideBVH<BV>* BVHModel<BV>::getWideBVH() const
+{
+  return wide_bvh.get();
+}
+
+//==============================================================================
+template <typename BV>
+void BVHModel<BV>::shareData()
+{
+  if(!shared_data)
+    shared_data = std::make_shared<detail::BVHSharedData<BV>>();
+
+  shared_data->vertices = vertices;
+  shared_data->tri_indices = tri_indices;
+  shared_data->primitive_indices = primitive_indices;
+  shared_data->bvs = bvs;
+}
+
+//==============================================================================
+template <typename BV>
+void BVHModel<BV>::detachData()
+{
+  if(!shared_data)
+    return;
+
+  if(shared_data.use_count() == 1 && !shared_data->storage)
+  {
+    // nobody else uses the arrays, take them back as they are. use_count()
+    // is a relaxed load, so order our writes after the last reads of the
+    // copies, which released their references
+    std::atomic_thread_fence(std::memory_order_acquire);
+    shared_data->vertices = nullptr;
+    shared_data->tri_indices = nullptr;
+    shared_data->primitive_indices = nullptr;
+    shared_data->bvs = nullptr;
+    shared_data.reset();
+    return;
+  }
+
+  const int num_primitives = (getModelType() == BVH_MODEL_POINTCLOUD) ? num_vertices : num_tris;
+
+  Vector3<S>* new_vertices = new Vector3<S>[num_vertices];
+  memcpy(new_vertices, vertices, sizeof(Vector3<S>) * num_vertices);
+  vertices = new_vertices;
+
+  if(tri_indices)
+  {
+    Triangle* new_tris = new Triangle[num_tris];
+    memcpy(new_tris, tri_indices, sizeof(Triangle) * num_tris);
+    tri_indices = new_tris;
+  }
+
+  unsigned int* new_primitive_indices = new unsigned int[num_primitives];
+  memcpy(new_primitive_indices, primitive_indices, sizeof(unsigned int) * num_primitives);
+  primitive_indices = new_primitive_indices;
+
+  BVNode<BV>* new_bvs = new BVNode<BV>[num_bvs];
+  memcpy(new_bvs, bvs, sizeof(BVNode<BV>) * num_bvs);
+  bvs = new_bvs;
+
+  num_vertices_allocated = num_vertices;
+  num_tris_allocated = num_tris;
+  num_bvs_allocated = num_bvs;
+
+  shared_data.reset();
+}
+
+//==============================================================================
+template <typename BV>
+void BVHModel<BV>::deleteData()
+{
+  if(shared_data)
+    shared_data.reset();
+  else
+  {
+    delete [] vertices;
+    delete [] tri_indices;
+    delete [] primitive_indices;
+    delete [] bvs;
+  }
+
+  vertices = nullptr;
+  tri_indices = nullptr;
+  primitive_indices = nullptr;
+  bvs = nullptr;
+
+  delete [] prev_vertices; prev_vertices = nullptr;
+}
+
+//==============================================================================
+template <typename BV>
+void BVHModel<BV>::updateWideBVH()
+{
+  if(build_wide_bvh)
+    buildWideBVH();
+  else
+    wide_bvh.reset();
+}
+
+//==============================================================================
+template <typename BV>
+void BVHModel<BV>::makeUnique()
+{
+  detachData();
+}
+
 //==============================================================================
 template <typename BV>
 void BVHModel<BV>::makeParentRelative()
 {
+  detachData();
+
+  // the wide bounds are absolute, so they cannot follow
+  wide_bvh.reset();
+
   makeParentRelativeRecurse(
         0, Matrix3<S>::Identity(), Vector3<S>::Zero());
 }
@@ -1006,13 +1274,6 @@ Matrix3<typename BV::S> BVHModel<BV>::computeMomentofInertia() const
 template <typename BV>
 int BVHModel<BV>::buildTree()
 {
-  // set BVFitter
-  bv_fitter->set(vertices, tri_indices, getModelType());
-  // set SplitRule
-  bv_splitter->set(vertices, tri_indices, getModelType());
-
-  num_bvs = 1;
-
   int num_primitives = 0;
   switch(getModelType())
   {
@@ -1027,27 +1288,129 @@ int BVHModel<BV>::buildTree()
     return BVH_ERR_UNSUPPORTED_FUNCTION;
   }
 
+  // every internal node has two children and every leaf one primitive
+  num_bvs = 2 * num_primitives - 1;
+
+  if(build_method == BVH_BUILD_METHOD_LINEAR)
+  {
+    // 30 bit codes have 1024 cells per axis, too coarse for large meshes
+    if(num_primitives < (1 << 16))
+      return buildTreeLinear<uint32>(num_primitives);
+    else
+      return buildTreeLinear<uint64>(num_primitives);
+  }
+
   for(int i = 0; i < num_primitives; ++i)
     primitive_indices[i] = i;
-  recursiveBuildTree(0, 0, num_primitives);
 
-  bv_fitter->clear();
-  bv_splitter->clear();
+  // set BVFitter
+  bv_fitter->set(vertices, tri_indices, getModelType());
+  // set SplitRule
+  bv_splitter->set(vertices, tri_indices, getModelType());
 
-  return BVH_OK;
+  // one fitter and one splitter per thread
+  const int num_threads = detail::resolveNumThreads(num_build_threads);
+  std::vector<std::shared_ptr<detail::BVFitterBase<BV>>> fitters(1, bv_fitter);
+  std::vector<std::shared_ptr<detail::BVSplitterBase<BV>>> splitters(1, bv_splitter);
+  for(int i = 1; i < num_threads; ++i)
+  {
+    std::shared_ptr<detail::BVFitterBase<BV>> fitter = bv_fitter->clone();
+    std::shared_ptr<detail::BVSplitterBase<BV>> splitter = bv_splitter->clone();
+    if(!fitter || !splitter)
+      break;
+
+    fitters.push_back(fitter);
+    splitters.push_back(splitter);
+  }
+
+  int result = BVH_OK;
+
+  if(fitters.size() == 1)
+  {
+    result = recursiveBuildTree(bv_fitter.get(), bv_splitter.get(), 0, 0, num_primitives, 1);
+  }
+  else
+  {
+    // split the largest subtree until there are enough of them to keep all
+    // the threads busy; the subtrees are then built independently
+    struct BuildTask
+    {
+      int bv_id;
+      int first_primitive;
+      int num_primitives;
+      int first_free;
+
+      bool operator < (const BuildTask& other) const
+      {
+        return num_primitives < other.num_primitives;
+      }
+    };
+
+    std::vector<BuildTask> tasks(1, BuildTask{0, 0, num_primitives, 1});
+    const std::size_t min_num_tasks = 8 * fitters.size();
+    const int min_task_primitives = 256;
+
+    while(tasks.size() < min_num_tasks && tasks.front().num_primitives >= min_task_primitives)
+    {
+      std::pop_heap(tasks.begin(), tasks.end());
+      const BuildTask task = tasks.back();
+      tasks.pop_back();
+
+      int num_first_half = 0;
+      result = buildNode(bv_fitter.get(), bv_splitter.get(), task.bv_id, task.first_primitive, task.num_primitives, task.first_free, num_first_half);
+      if(result != BVH_OK)
+        break;
+
+      tasks.push_back(BuildTask{task.first_free, task.first_primitive, num_first_half, task.first_free + 2});
+      std::push_heap(tasks.begin(), tasks.end());
+      tasks.push_back(BuildTask{task.first_free + 1, task.first_primitive + num_first_half, task.num_primitives - num_first_half, task.first_free + 2 * num_first_half});
+      std::push_heap(tasks.begin(), tasks.end());
+    }
+
+    if(result == BVH_OK)
+    {
+      // largest first
+      std::sort_heap(tasks.begin(), tasks.end());
+      std::reverse(tasks.begin(), tasks.end());
+
+      std::vector<int> results(tasks.size(), BVH_OK);
+      detail::parallelFor(tasks.size(), static_cast<int>(fitters.size()), [&](std::size_t i, int thread_id)
+      {
+        const BuildTask& task = tasks[i];
+        results[i] = recursiveBuildTree(fitters[thread_id].get(), splitters[thread_id].get(), task.bv_id, task.first_primitive, task.num_primitives, task.first_free);
+      });
+
+      for(const int task_result : results)
+      {
+        if(task_result != BVH_OK)
+        {
+          result = task_result;
+          break;
+        }
+      }
+    }
+  }
+
+  for(std::size_t i = 0; i < fitters.size(); ++i)
+  {
+    fitters[i]->clear();
+    splitters[i]->clear();
+  }
+
+  return result;
 }
 
 //==============================================================================
 template <typename BV>
-int BVHModel<BV>::recursiveBuildTree(int bv_id, int first_primitive, int num_primitives)
+int BVHModel<BV>::buildNode(detail::BVFitterBase<BV>* fitter, detail::BVSplitterBase<BV>* splitter, int bv_id, int first_primitive, int num_primitives, int first_free, int& num_first_half)
 {
   BVHModelType type = getModelType();
   BVNode<BV>* bvnode = bvs + bv_id;
   unsigned int* cur_primitive_indices = primitive_indices + first_primitive;
 
   // constructing BV
-  BV bv = bv_fitter->fit(cur_primitive_indices, num_primitives);
-  bv_splitter->computeRule(bv, cur_primitive_indices, num_primitives);
+  BV bv = fitter->fit(cur_primitive_indices, num_primitives);
+  splitter->computeRule(bv, cur_primitive_indices, num_primitives);
 
   bvnode->bv = bv;
   bvnode->first_primitive = first_primitive;
@@ -1056,11 +1419,11 @@ int BVHModel<BV>::recursiveBuildTree(int bv_id, int first_primitive, int num_pri
   if(num_primitives == 1)
   {
     bvnode->first_child = -((*cur_primitive_indices) + 1);
+    num_first_half = 0;
   }
   else
   {
-    bvnode->first_child = num_bvs;
-    num_bvs += 2;
+    bvnode->first_child = first_free;
 
     int c1 = 0;
     for(int i = 0; i < num_primitives; ++i)
@@ -1088,7 +1451,7 @@ int BVHModel<BV>::recursiveBuildTree(int bv_id, int first_primitive, int num_pri
       //  [1] [1] [1] [1] [2] [2] [2] [x] [x] ... [x]
       //                   c1          i
       //
-      if(bv_splitter->apply(p)) // in the right side
+      if(splitter->apply(p)) // in the right side
       {
         // do nothing
       }
@@ -1102,10 +1465,138 @@ int BVHModel<BV>::recursiveBuildTree(int bv_id, int first_primitive, int num_pri
 
     if((c1 == 0) || (c1 == num_primitives)) c1 = num_primitives / 2;
 
-    int num_first_half = c1;
+    num_first_half = c1;
+  }
 
-    recursiveBuildTree(bvnode->leftChild(), first_primitive, num_first_half);
-    recursiveBuildTree(bvnode->rightChild(), first_primitive + num_first_half, num_primitives - num_first_half);
+  return BVH_OK;
+}
+
+//==============================================================================
+template <typename BV>
+int BVHModel<BV>::recursiveBuildTree(detail::BVFitterBase<BV>* fitter, detail::BVSplitterBase<BV>* splitter, int bv_id, int first_primitive, int num_primitives, int first_free)
+{
+  int num_first_half = 0;
+  int result = buildNode(fitter, splitter, bv_id, first_primitive, num_primitives, first_free, num_first_half);
+  if(result != BVH_OK || num_primitives == 1)
+    return result;
+
+  // the subtree of the first child takes 2 * num_first_half - 2 indices
+  // after those of the two children
+  result = recursiveBuildTree(fitter, splitter, first_free, first_primitive, num_first_half, first_free + 2);
+  if(result != BVH_OK)
+    return result;
+
+  return recursiveBuildTree(fitter, splitter, first_free + 1, first_primitive + num_first_half, num_primitives - num_first_half, first_free + 2 * num_first_half);
+}
+
+//==============================================================================
+template <typename BV>
+template <typename Code>
+int BVHModel<BV>::buildTreeLinear(int num_primitives)
+{
+  const bool is_pointcloud = (getModelType() == BVH_MODEL_POINTCLOUD);
+
+  std::vector<Vector3<S>> centroids(num_primitives);
+  AABB<S> bound;
+  for(int i = 0; i < num_primitives; ++i)
+  {
+    if(is_pointcloud)
+      centroids[i] = vertices[i];
+    else
+    {
+      const Triangle& t = tri_indices[i];
+      centroids[i].noalias() = (vertices[t[0]] + vertices[t[1]] + vertices[t[2]]) / 3.0;
+    }
+
+    bound += centroids[i];
+  }
+
+  // a flat bound would quantize with an infinite scale
+  for(int i = 0; i < 3; ++i)
+  {
+    if(!(bound.max_[i] > bound.min_[i]))
+      bound.max_[i] = bound.min_[i] + 1;
+  }
+
+  detail::morton_functor<S, Code> coder(bound);
+  std::vector<Code> codes(num_primitives);
+  std::vector<unsigned int> indices(num_primitives);
+  for(int i = 0; i < num_primitives; ++i)
+  {
+    codes[i] = coder(centroids[i]);
+    indices[i] = i;
+  }
+
+  detail::radixSort(codes, indices);
+  std::copy(indices.begin(), indices.end(), primitive_indices);
+
+  // emit the nodes with the same numbering as recursiveBuildTree()
+  struct EmitTask
+  {
+    int bv_id;
+    int first_primitive;
+    int num_primitives;
+    int first_free;
+  };
+
+  std::vector<EmitTask> stack(1, EmitTask{0, 0, num_primitives, 1});
+  while(!stack.empty())
+  {
+    const EmitTask task = stack.back();
+    stack.pop_back();
+
+    BVNode<BV>* bvnode = bvs + task.bv_id;
+    bvnode->first_primitive = task.first_primitive;
+    bvnode->num_primitives = task.num_primitives;
+
+    if(task.num_primitives == 1)
+    {
+      bvnode->first_child = -(primitive_indices[task.first_primitive] + 1);
+      continue;
+    }
+
+    bvnode->first_child = task.first_free;
+
+    const int split = detail::findMortonSplit(codes.data(), task.first_primitive, task.first_primitive + task.num_primitives);
+    const int num_first_half = split - task.first_primitive;
+
+    stack.push_back(EmitTask{task.first_free + 1, split, task.num_primitives - num_first_half, task.first_free + 2 * num_first_half});
+    stack.push_back(EmitTask{task.first_free, task.first_primitive, num_first_half, task.first_free + 2});
+  }
+
+  if(!detail::IsMergeExact<BV>::value)
+  {
+    // merging oriented BVs bottom-up loosens them level after level
+    bv_fitter->set(vertices, tri_indices, getModelType());
+    for(int i = 0; i < num_bvs; ++i)
+      bvs[i].bv = bv_fitter->fit(primitive_indices + bvs[i].first_primitive, bvs[i].num_primitives);
+    bv_fitter->clear();
+
+    return BVH_OK;
+  }
+
+  // children always come after their parent, so a backward sweep fits every
+  // node after its children
+  for(int i = num_bvs - 1; i >= 0; --i)
+  {
+    BVNode<BV>* bvnode = bvs + i;
+    if(bvnode->isLeaf())
+    {
+      const int primitive_id = -(bvnode->first_child + 1);
+      BV bv;
+      if(is_pointcloud)
+        fit(vertices + primitive_id, 1, bv);
+      else
+      {
+        const Triangle& t = tri_indices[primitive_id];
+        Vector3<S> v[3] = {vertices[t[0]], vertices[t[1]], vertices[t[2]]};
+        fit(v, 3, bv);
+      }
+
+      bvnode->bv = bv;
+    }
+    else
+      bvnode->bv = bvs[bvnode->leftChild()].bv + bvs[bvnode->rightChild()].bv;
   }
 
   return BVH_OK;
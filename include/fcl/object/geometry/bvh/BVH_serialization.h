@@ -0,0 +1,515 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FCL_BVH_SERIALIZATION_H
+#define FCL_BVH_SERIALIZATION_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "fcl/object/geometry/bvh/BVH_model.h"
+
+namespace fcl
+{
+
+/// @brief Write a built BVH model in the binary BVH format: a fixed size
+/// header followed by the raw vertices, tri_indices, primitive_indices and bvs
+/// arrays, each starting on a 64 byte boundary. The bvs are stored as they
+/// are, so a model made parent relative stays so. The format is only meant to
+/// be read back on a machine with the same scalar and integer layout.
+template <typename BV>
+int saveBVHModel(const BVHModel<BV>& model, std::ostream& out);
+
+/// @brief Write a built BVH model to the file filename
+template <typename BV>
+int saveBVHModel(const BVHModel<BV>& model, const std::string& filename);
+
+/// @brief Replace model by the BVH model stored in the size bytes at data,
+/// for instance a memory mapped file. Nothing is parsed or rebuilt: the arrays
+/// are copied as they are once the header is validated. The model is left
+/// processed on success and empty on failure.
+///
+/// Unless trusted is set, every node, primitive and vertex index is also
+/// checked to be in range, and children to come after their parent, in one
+/// pass over the arrays. Only skip this for data this library wrote: the
+/// queries use the indices unchecked.
+template <typename BV>
+int loadBVHModel(BVHModel<BV>& model, const void* data, std::size_t size, bool trusted = false);
+
+/// @brief Replace model by the BVH model stored in the size bytes at
+/// storage, without copying: the model reads its arrays from storage, which
+/// it keeps alive, and only copies them before it is modified. This lets
+/// processes that map the same file share its pages. The arrays are copied
+/// anyway if storage is not aligned to 64 bytes. The indices are checked as
+/// above unless trusted is set, which leaves storage untouched past the
+/// header.
+template <typename BV>
+int loadBVHModel(BVHModel<BV>& model, std::shared_ptr<const void> storage, std::size_t size, bool trusted = false);
+
+/// @brief Replace model by the BVH model stored in the file filename. The
+/// file is memory mapped where the platform allows it and loaded as from
+/// storage above, so the model reads its arrays from the mapped pages;
+/// elsewhere it is read once into a buffer that the model keeps.
+template <typename BV>
+int loadBVHModel(BVHModel<BV>& model, const std::string& filename, bool trusted = false);
+
+namespace detail
+{
+
+/// @brief Header of the binary BVH format
+struct BVHFileHeader
+{
+  char magic[8];
+  uint32 version;
+  uint32 byte_order;
+  uint32 node_type;
+  uint32 scalar_size;
+  uint32 triangle_size;
+  uint32 node_size;
+  uint64 num_vertices;
+  uint64 num_tris;
+  uint64 num_primitives;
+  uint64 num_bvs;
+  uint64 vertices_offset;
+  uint64 tri_indices_offset;
+  uint64 primitive_indices_offset;
+  uint64 bvs_offset;
+  uint64 file_size;
+};
+
+/// @brief Access to the internals of BVHModel for the binary BVH format
+template <typename BV>
+struct BVHSerializer
+{
+  using S = typename BV::S;
+
+  static constexpr uint32 version = 1;
+  static constexpr uint32 byte_order = 0x01020304;
+  static constexpr uint64 alignment = 64;
+
+  /// @brief Fill the header of model, with the sections laid out one after
+  /// the other
+  static int makeHeader(const BVHModel<BV>& model, BVHFileHeader& header);
+
+  static int save(const BVHModel<BV>& model, std::ostream& out);
+
+  /// @brief Load the model from data, referencing the arrays in place if
+  /// storage holds data and copying them otherwise
+  static int load(BVHModel<BV>& model, const char* data, std::size_t size, std::shared_ptr<const void> storage, bool trusted);
+
+  /// @brief Whether every index stored in the arrays of model is in range
+  static bool checkIndices(const BVHModel<BV>& model, uint64 num_primitives);
+
+  /// @brief Leave model empty, as beginModel() would
+  static void clear(BVHModel<BV>& model);
+
+  /// @brief Round offset up to the next section boundary
+  static uint64 align(uint64 offset);
+
+  /// @brief Map the file filename read only, or read it into a buffer aligned
+  /// to a section boundary where it cannot be mapped. Return nullptr on
+  /// failure.
+  static std::shared_ptr<const void> readFile(const std::string& filename, std::size_t& size);
+};
+
+} // namespace detail
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template <typename BV>
+int saveBVHModel(const BVHModel<BV>& model, std::ostream& out)
+{
+  return detail::BVHSerializer<BV>::save(model, out);
+}
+
+//==============================================================================
+template <typename BV>
+int saveBVHModel(const BVHModel<BV>& model, const std::string& filename)
+{
+  std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+  if(!out)
+  {
+    std::cerr << "BVH Error! Cannot open file " << filename << " for writing." << std::endl;
+    return BVH_ERR_UNKNOWN;
+  }
+
+  return saveBVHModel(model, out);
+}
+
+//==============================================================================
+template <typename BV>
+int loadBVHModel(BVHModel<BV>& model, const void* data, std::size_t size, bool trusted)
+{
+  return detail::BVHSerializer<BV>::load(model, static_cast<const char*>(data), size, nullptr, trusted);
+}
+
+//==============================================================================
+template <typename BV>
+int loadBVHModel(BVHModel<BV>& model, std::shared_ptr<const void> storage, std::size_t size, bool trusted)
+{
+  const char* data = static_cast<const char*>(storage.get());
+  return detail::BVHSerializer<BV>::load(model, data, size, std::move(storage), trusted);
+}
+
+//==============================================================================
+template <typename BV>
+int loadBVHModel(BVHModel<BV>& model, const std::string& filename, bool trusted)
+{
+  std::size_t size = 0;
+  std::shared_ptr<const void> storage = detail::BVHSerializer<BV>::readFile(filename, size);
+  if(!storage)
+    return BVH_ERR_UNKNOWN;
+
+  return loadBVHModel(model, std::move(storage), size, trusted);
+}
+
+namespace detail
+{
+
+//==============================================================================
+template <typename BV>
+constexpr uint32 BVHSerializer<BV>::version;
+
+//==============================================================================
+template <typename BV>
+constexpr uint32 BVHSerializer<BV>::byte_order;
+
+//==============================================================================
+template <typename BV>
+constexpr uint64 BVHSerializer<BV>::alignment;
+
+//==============================================================================
+template <typename BV>
+uint64 BVHSerializer<BV>::align(uint64 offset)
+{
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+//==============================================================================
+template <typename BV>
+int BVHSerializer<BV>::makeHeader(const BVHModel<BV>& model, BVHFileHeader& header)
+{
+  if(model.build_state != BVH_BUILD_STATE_PROCESSED && model.build_state != BVH_BUILD_STATE_UPDATED)
+  {
+    std::cerr << "BVH Error! Only a processed or updated model can be saved." << std::endl;
+    return BVH_ERR_BUILD_OUT_OF_SEQUENCE;
+  }
+
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, "FCLBVH", 6);
+  header.version = version;
+  header.byte_order = byte_order;
+  header.node_type = model.getNodeType();
+  header.scalar_size = sizeof(S);
+  header.triangle_size = sizeof(Triangle);
+  header.node_size = sizeof(BVNode<BV>);
+  header.num_vertices = model.num_vertices;
+  header.num_tris = model.num_tris;
+  header.num_primitives = (model.getModelType() == BVH_MODEL_POINTCLOUD) ? model.num_vertices : model.num_tris;
+  header.num_bvs = model.num_bvs;
+
+  header.vertices_offset = align(sizeof(BVHFileHeader));
+  header.tri_indices_offset = align(header.vertices_offset + header.num_vertices * sizeof(Vector3<S>));
+  header.primitive_indices_offset = align(header.tri_indices_offset + header.num_tris * sizeof(Triangle));
+  header.bvs_offset = align(header.primitive_indices_offset + header.num_primitives * sizeof(unsigned int));
+  header.file_size = header.bvs_offset + header.num_bvs * sizeof(BVNode<BV>);
+
+  return BVH_OK;
+}
+
+//==============================================================================
+template <typename BV>
+int BVHSerializer<BV>::save(const BVHModel<BV>& model, std::ostream& out)
+{
+  BVHFileHeader header;
+  int result = makeHeader(model, header);
+  if(result != BVH_OK)
+    return result;
+
+  const struct
+  {
+    const void* data;
+    uint64 offset;
+    uint64 size;
+  } sections[] = {
+    {&header, 0, sizeof(header)},
+    {model.vertices, header.vertices_offset, header.num_vertices * sizeof(Vector3<S>)},
+    {model.tri_indices, header.tri_indices_offset, header.num_tris * sizeof(Triangle)},
+    {model.primitive_indices, header.primitive_indices_offset, header.num_primitives * sizeof(unsigned int)},
+    {model.bvs, header.bvs_offset, header.num_bvs * sizeof(BVNode<BV>)}
+  };
+
+  const char padding[alignment] = {0};
+  uint64 position = 0;
+  for(const auto& section : sections)
+  {
+    out.write(padding, section.offset - position);
+    out.write(static_cast<const char*>(section.data), section.size);
+    position = section.offset + section.size;
+  }
+
+  if(!out)
+  {
+    std::cerr << "BVH Error! Failed to write the BVH model." << std::endl;
+    return BVH_ERR_UNKNOWN;
+  }
+
+  return BVH_OK;
+}
+
+//==============================================================================
+template <typename BV>
+int BVHSerializer<BV>::load(BVHModel<BV>& model, const char* data, std::size_t size, std::shared_ptr<const void> storage, bool trusted)
+{
+  clear(model);
+
+  BVHFileHeader header;
+  if(size < sizeof(header))
+  {
+    std::cerr << "BVH Error! The data is too short for a BVH model." << std::endl;
+    return BVH_ERR_INCORRECT_DATA;
+  }
+  std::memcpy(&header, data, sizeof(header));
+
+  if(std::memcmp(header.magic, "FCLBVH", 6) != 0 || header.version != version)
+  {
+    std::cerr << "BVH Error! The data is not a BVH model of version " << version << "." << std::endl;
+    return BVH_ERR_INCORRECT_DATA;
+  }
+
+  if(header.byte_order != byte_order || header.node_type != static_cast<uint32>(model.getNodeType())
+     || header.scalar_size != sizeof(S) || header.triangle_size != sizeof(Triangle)
+     || header.node_size != sizeof(BVNode<BV>))
+  {
+    std::cerr << "BVH Error! The BVH model was saved with another BV type or on another platform." << std::endl;
+    return BVH_ERR_INCORRECT_DATA;
+  }
+
+  const uint64 num_primitives = header.num_tris ? header.num_tris : header.num_vertices;
+  if(header.num_vertices == 0 || header.num_primitives != num_primitives
+     || header.num_bvs != 2 * num_primitives - 1 || header.num_bvs > static_cast<uint64>(std::numeric_limits<int>::max()))
+  {
+    std::cerr << "BVH Error! The BVH model has inconsistent sizes." << std::endl;
+    return BVH_ERR_INCORRECT_DATA;
+  }
+
+  // the sections must be where this version puts them
+  BVHFileHeader expected = header;
+  expected.vertices_offset = align(sizeof(BVHFileHeader));
+  expected.tri_indices_offset = align(expected.vertices_offset + header.num_vertices * sizeof(Vector3<S>));
+  expected.primitive_indices_offset = align(expected.tri_indices_offset + header.num_tris * sizeof(Triangle));
+  expected.bvs_offset = align(expected.primitive_indices_offset + header.num_primitives * sizeof(unsigned int));
+  expected.file_size = expected.bvs_offset + header.num_bvs * sizeof(BVNode<BV>);
+  if(std::memcmp(&expected, &header, sizeof(header)) != 0 || header.file_size > size)
+  {
+    std::cerr << "BVH Error! The BVH model is truncated or corrupted." << std::endl;
+    return BVH_ERR_INCORRECT_DATA;
+  }
+
+  model.num_vertices = model.num_vertices_allocated = static_cast<int>(header.num_vertices);
+  model.num_tris = model.num_tris_allocated = static_cast<int>(header.num_tris);
+  model.num_bvs = model.num_bvs_allocated = static_cast<int>(header.num_bvs);
+
+  if(storage && reinterpret_cast<std::uintptr_t>(data) % alignment == 0)
+  {
+    // the arrays are only read until the model detaches them
+    std::shared_ptr<BVHSharedData<BV>> shared_data = std::make_shared<BVHSharedData<BV>>();
+    shared_data->vertices = reinterpret_cast<Vector3<S>*>(const_cast<char*>(data + header.vertices_offset));
+    if(model.num_tris)
+      shared_data->tri_indices = reinterpret_cast<Triangle*>(const_cast<char*>(data + header.tri_indices_offset));
+    shared_data->primitive_indices = reinterpret_cast<unsigned int*>(const_cast<char*>(data + header.primitive_indices_offset));
+    shared_data->bvs = reinterpret_cast<BVNode<BV>*>(const_cast<char*>(data + header.bvs_offset));
+    shared_data->storage = std::move(storage);
+
+    model.vertices = shared_data->vertices;
+    model.tri_indices = shared_data->tri_indices;
+    model.primitive_indices = shared_data->primitive_indices;
+    model.bvs = shared_data->bvs;
+    model.shared_data = std::move(shared_data);
+  }
+  else
+  {
+    model.vertices = new Vector3<S>[model.num_vertices];
+    std::memcpy(model.vertices, data + header.vertices_offset, header.num_vertices * sizeof(Vector3<S>));
+
+    if(model.num_tris)
+    {
+      model.tri_indices = new Triangle[model.num_tris];
+      std::memcpy(model.tri_indices, data + header.tri_indices_offset, header.num_tris * sizeof(Triangle));
+    }
+
+    // sized as in endModel()
+    model.primitive_indices = new unsigned int[model.num_bvs];
+    std::memcpy(model.primitive_indices, data + header.primitive_indices_offset, header.num_primitives * sizeof(unsigned int));
+
+    model.bvs = new BVNode<BV>[model.num_bvs];
+    std::memcpy(model.bvs, data + header.bvs_offset, header.num_bvs * sizeof(BVNode<BV>));
+
+    model.shareData();
+  }
+
+  if(!trusted && !checkIndices(model, header.num_primitives))
+  {
+    std::cerr << "BVH Error! The BVH model has indices out of range." << std::endl;
+    clear(model);
+    return BVH_ERR_INCORRECT_DATA;
+  }
+
+  model.build_state = BVH_BUILD_STATE_PROCESSED;
+  model.updateWideBVH();
+
+  return BVH_OK;
+}
+
+//==============================================================================
+template <typename BV>
+bool BVHSerializer<BV>::checkIndices(const BVHModel<BV>& model, uint64 num_primitives)
+{
+  for(int i = 0; i < model.num_tris; ++i)
+  {
+    for(int j = 0; j < 3; ++j)
+    {
+      if(model.tri_indices[i][j] >= static_cast<std::size_t>(model.num_vertices))
+        return false;
+    }
+  }
+
+  for(uint64 i = 0; i < num_primitives; ++i)
+  {
+    if(model.primitive_indices[i] >= num_primitives)
+      return false;
+  }
+
+  for(int i = 0; i < model.num_bvs; ++i)
+  {
+    const BVNode<BV>& node = model.bvs[i];
+    if(node.first_primitive < 0 || node.num_primitives <= 0
+       || static_cast<uint64>(node.first_primitive) + node.num_primitives > num_primitives)
+      return false;
+
+    if(node.isLeaf())
+    {
+      if(static_cast<uint64>(node.primitiveId()) >= num_primitives)
+        return false;
+    }
+    // children after their parent also rule out cycles
+    else if(node.first_child <= i || node.first_child >= model.num_bvs - 1)
+      return false;
+  }
+
+  return true;
+}
+
+//==============================================================================
+template <typename BV>
+void BVHSerializer<BV>::clear(BVHModel<BV>& model)
+{
+  model.deleteData();
+  model.wide_bvh.reset();
+  model.num_vertices_allocated = model.num_vertices = model.num_tris_allocated = model.num_tris = model.num_bvs_allocated = model.num_bvs = 0;
+  model.build_state = BVH_BUILD_STATE_EMPTY;
+}
+
+//==============================================================================
+template <typename BV>
+std::shared_ptr<const void> BVHSerializer<BV>::readFile(const std::string& filename, std::size_t& size)
+{
+#if defined(__unix__) || defined(__APPLE__)
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if(fd >= 0)
+  {
+    struct stat st;
+    void* data = MAP_FAILED;
+    if(fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+      size = static_cast<std::size_t>(st.st_size);
+      data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    // the mapping outlives the descriptor
+    if(data != MAP_FAILED)
+    {
+      const std::size_t mapped_size = size;
+      return std::shared_ptr<const void>(data, [mapped_size](const void* p) { munmap(const_cast<void*>(p), mapped_size); });
+    }
+  }
+#endif
+
+  std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+  if(!in)
+  {
+    std::cerr << "BVH Error! Cannot open file " << filename << " for reading." << std::endl;
+    return nullptr;
+  }
+
+  in.seekg(0, std::ios::end);
+  size = static_cast<std::size_t>(in.tellg());
+  in.seekg(0, std::ios::beg);
+
+  // new[] does not align to a section boundary, so the data starts at the
+  // first one in a slightly larger buffer
+  std::shared_ptr<char> buffer(new char[size + alignment], std::default_delete<char[]>());
+  char* data = buffer.get() + (alignment - reinterpret_cast<std::uintptr_t>(buffer.get()) % alignment) % alignment;
+  if(!in.read(data, size))
+  {
+    std::cerr << "BVH Error! Cannot read file " << filename << "." << std::endl;
+    return nullptr;
+  }
+
+  return std::shared_ptr<const void>(buffer, data);
+}
+
+} // namespace detail
+} // namespace fcl
+
+#endif
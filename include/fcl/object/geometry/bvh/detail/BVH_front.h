@@ -39,6 +39,7 @@
 #define FCL_BVH_FRONT_H
 
 #include <list>
+#include <vector>
 
 namespace fcl
 {
@@ -67,9 +68,17 @@ struct BVHFrontNode
 /// @brief BVH front list is a list of front nodes.
 using BVHFrontList = std::list<BVHFrontNode>;
 
+/// @brief BVH front list stored contiguously, so that a front list reused from
+/// one query to the next stops allocating once it has grown to the size of
+/// the front. It is accepted wherever a BVHFrontList is.
+using BVHFlatFrontList = std::vector<BVHFrontNode>;
+
 /// @brief Add new front node into the front list
 void updateFrontList(BVHFrontList* front_list, int b1, int b2);
 
+/// @brief Add new front node into the flat front list
+void updateFrontList(BVHFlatFrontList* front_list, int b1, int b2);
+
 //============================================================================//
 //                                                                            //
 //                              Implementations                               //
@@ -89,6 +98,12 @@ inline void updateFrontList(BVHFrontList* front_list, int b1, int b2)
   if(front_list) front_list->emplace_back(b1, b2);
 }
 
+//==============================================================================
+inline void updateFrontList(BVHFlatFrontList* front_list, int b1, int b2)
+{
+  if(front_list) front_list->emplace_back(b1, b2);
+}
+
 } // namespace detail
 } // namespace fcl
 
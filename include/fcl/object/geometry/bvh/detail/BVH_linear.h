@@ -0,0 +1,146 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef FCL_BVH_LINEAR_H
+#define FCL_BVH_LINEAR_H
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include "fcl/common/types.h"
+#include "fcl/math/bv/AABB.h"
+#include "fcl/math/bv/kDOP.h"
+
+namespace fcl
+{
+
+namespace detail
+{
+
+/// @brief Whether the sum of two BVs is the smallest BV of its type containing
+/// both, so that merging the BVs of two children is as tight as fitting their
+/// primitives again. The sum of oriented BVs is only an approximation.
+template <typename BV>
+struct IsMergeExact : std::false_type {};
+
+template <typename S>
+struct IsMergeExact<AABB<S>> : std::true_type {};
+
+template <typename S, std::size_t N>
+struct IsMergeExact<KDOP<S, N>> : std::true_type {};
+
+/// @brief Sort codes in increasing order and permute indices along with them.
+/// This is a least significant digit radix sort on bytes, so it is stable and
+/// runs in linear time.
+template <typename Code>
+void radixSort(std::vector<Code>& codes, std::vector<unsigned int>& indices);
+
+/// @brief Split the sorted codes[first, last) where the highest bit differing
+/// between codes[first] and codes[last - 1] flips, i.e. between the two halves
+/// of the smallest Morton cell containing the range. Returns the first index
+/// of the second half, or the middle of the range if all the codes are equal.
+template <typename Code>
+int findMortonSplit(const Code* codes, int first, int last);
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template <typename Code>
+void radixSort(std::vector<Code>& codes, std::vector<unsigned int>& indices)
+{
+  const std::size_t n = codes.size();
+  if(n == 0)
+    return;
+
+  std::vector<Code> codes_tmp(n);
+  std::vector<unsigned int> indices_tmp(n);
+
+  for(std::size_t shift = 0; shift < 8 * sizeof(Code); shift += 8)
+  {
+    std::size_t offsets[256] = {0};
+    for(std::size_t i = 0; i < n; ++i)
+      offsets[(codes[i] >> shift) & 0xff]++;
+
+    // all the codes share this digit
+    if(offsets[(codes[0] >> shift) & 0xff] == n)
+      continue;
+
+    std::size_t sum = 0;
+    for(std::size_t d = 0; d < 256; ++d)
+    {
+      const std::size_t count = offsets[d];
+      offsets[d] = sum;
+      sum += count;
+    }
+
+    for(std::size_t i = 0; i < n; ++i)
+    {
+      const std::size_t j = offsets[(codes[i] >> shift) & 0xff]++;
+      codes_tmp[j] = codes[i];
+      indices_tmp[j] = indices[i];
+    }
+
+    codes.swap(codes_tmp);
+    indices.swap(indices_tmp);
+  }
+}
+
+//==============================================================================
+template <typename Code>
+int findMortonSplit(const Code* codes, int first, int last)
+{
+  Code diff = codes[first] ^ codes[last - 1];
+  if(diff == 0)
+    return first + (last - first) / 2;
+
+  // keep the highest set bit only
+  for(std::size_t shift = 1; shift < 8 * sizeof(Code); shift <<= 1)
+    diff |= diff >> shift;
+  const Code bit = diff ^ (diff >> 1);
+
+  // the codes share all the bits above bit, so those with bit cleared come first
+  return static_cast<int>(std::partition_point(codes + first, codes + last,
+      [bit](Code code) { return (code & bit) == 0; }) - codes);
+}
+
+} // namespace detail
+} // namespace fcl
+
+#endif
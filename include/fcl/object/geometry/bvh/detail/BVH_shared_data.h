@@ -0,0 +1,106 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FCL_BVH_SHARED_DATA_H
+#define FCL_BVH_SHARED_DATA_H
+
+#include <memory>
+#include "fcl/math/triangle.h"
+#include "fcl/object/geometry/bvh/BV_node.h"
+
+namespace fcl
+{
+
+namespace detail
+{
+
+/// @brief Vertices, triangles and hierarchy of a built BVHModel, shared read
+/// only by the copies of the model. The arrays are either allocated with new[]
+/// and owned, or point into storage, e.g. a memory mapped file.
+template <typename BV>
+struct BVHSharedData
+{
+  using S = typename BV::S;
+
+  BVHSharedData();
+
+  BVHSharedData(const BVHSharedData&) = delete;
+  BVHSharedData& operator=(const BVHSharedData&) = delete;
+
+  ~BVHSharedData();
+
+  Vector3<S>* vertices;
+  Triangle* tri_indices;
+  unsigned int* primitive_indices;
+  BVNode<BV>* bvs;
+
+  /// @brief Memory the arrays point into, nullptr if they are owned
+  std::shared_ptr<const void> storage;
+};
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template <typename BV>
+BVHSharedData<BV>::BVHSharedData()
+  : vertices(nullptr),
+    tri_indices(nullptr),
+    primitive_indices(nullptr),
+    bvs(nullptr)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template <typename BV>
+BVHSharedData<BV>::~BVHSharedData()
+{
+  if(storage)
+    return;
+
+  delete [] vertices;
+  delete [] tri_indices;
+  delete [] primitive_indices;
+  delete [] bvs;
+}
+
+} // namespace detail
+} // namespace fcl
+
+#endif
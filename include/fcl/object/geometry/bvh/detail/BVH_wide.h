@@ -0,0 +1,281 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008-2014, Willow Garage, Inc.
+ *  Copyright (c) 2014-2016, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Open Source Robotics Foundation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FCL_BVH_WIDE_H
+#define FCL_BVH_WIDE_H
+
+#include <vector>
+#include "fcl/math/bv/OBB.h"
+#include "fcl/math/bv/detail/OBB_packet.h"
+#include "fcl/math/bv/utility.h"
+#include "fcl/object/geometry/bvh/BV_node.h"
+
+namespace fcl
+{
+
+template <typename BV>
+class BVHModel;
+
+namespace detail
+{
+
+/// @brief Bounds of the children of a wide BVH node. By default the N BVs are
+/// simply stored next to each other.
+template <typename BV, int N>
+struct WideBVBounds
+{
+  BV bv[N];
+
+  /// @brief Each child starts as the bound of the origin, so that the bounds
+  /// of the unused children are initialized
+  WideBVBounds();
+
+  /// @brief Store bv_ as the bound of child i
+  void set(int i, const BV& bv_);
+};
+
+/// @brief For OBB the bounds are stored in SoA form so that they can be tested
+/// as a packet, see overlapPacket()
+template <typename S, int N>
+struct WideBVBounds<OBB<S>, N> : public OBBPacket<S, N>
+{
+};
+
+/// @brief A node of a wide BVH: up to N children, obtained by collapsing the
+/// top levels of the corresponding subtree of the binary BVH
+template <typename BV, int N>
+struct WideBVNode
+{
+  /// @brief Number of valid children
+  int num_children;
+
+  /// @brief Index of each child in the bvs array of the binary BVHModel, so
+  /// that the leaves can be handed to the usual leaf tests
+  int child_bv[N];
+
+  /// @brief Index of the wide node of each child, -1 if the child is a leaf
+  int child_node[N];
+
+  /// @brief Bounds of the children
+  WideBVBounds<BV, N> bounds;
+
+  WideBVNode();
+};
+
+/// @brief Wide (N-ary) version of the bounding volume hierarchy of a BVHModel.
+/// It refers to the binary hierarchy by BV index and is invalidated whenever
+/// the binary hierarchy changes (rebuild, refit).
+template <typename BV, int N = 4>
+class WideBVH
+{
+public:
+
+  static_assert(N >= 2 && N <= 16, "The width of a wide BVH must be in [2, 16]");
+
+  using S = typename BV::S;
+
+  /// @brief Build the wide hierarchy from the binary hierarchy of model. Each
+  /// wide node replaces a binary node and takes as children the binary nodes
+  /// obtained by repeatedly opening its largest internal descendant.
+  void build(const BVHModel<BV>& model);
+
+  /// @brief Clear the wide hierarchy
+  void clear();
+
+  /// @brief Whether the hierarchy is empty, which happens when the binary
+  /// hierarchy is a single leaf
+  bool empty() const;
+
+  /// @brief Access the wide node giving its index. The root is node 0 and it
+  /// corresponds to the root of the binary hierarchy.
+  const WideBVNode<BV, N>& getNode(int id) const;
+
+  /// @brief Get the number of wide nodes
+  int getNumNodes() const;
+
+  /// @brief Get the number of bytes used by the wide nodes
+  int memUsage() const;
+
+private:
+
+  std::vector<WideBVNode<BV, N>> nodes;
+
+  /// @brief Recursive kernel for the construction, return the index of the
+  /// wide node replacing the binary node bv_id
+  int recursiveBuild(const BVHModel<BV>& model, int bv_id);
+};
+
+//============================================================================//
+//                                                                            //
+//                              Implementations                               //
+//                                                                            //
+//============================================================================//
+
+//==============================================================================
+template <typename BV, int N>
+WideBVBounds<BV, N>::WideBVBounds()
+{
+  Vector3<typename BV::S> origin = Vector3<typename BV::S>::Zero();
+  for(int i = 0; i < N; ++i)
+    fit(&origin, 1, bv[i]);
+}
+
+//==============================================================================
+template <typename BV, int N>
+void WideBVBounds<BV, N>::set(int i, const BV& bv_)
+{
+  bv[i] = bv_;
+}
+
+//==============================================================================
+template <typename BV, int N>
+WideBVNode<BV, N>::WideBVNode()
+  : num_children(0)
+{
+  for(int i = 0; i < N; ++i)
+  {
+    child_bv[i] = -1;
+    child_node[i] = -1;
+  }
+}
+
+//==============================================================================
+template <typename BV, int N>
+void WideBVH<BV, N>::build(const BVHModel<BV>& model)
+{
+  nodes.clear();
+
+  if(model.getNumBVs() == 0 || model.getBV(0).isLeaf())
+    return;
+
+  nodes.reserve(model.getNumBVs() / (N - 1) + 1);
+  recursiveBuild(model, 0);
+}
+
+//==============================================================================
+template <typename BV, int N>
+void WideBVH<BV, N>::clear()
+{
+  nodes.clear();
+}
+
+//==============================================================================
+template <typename BV, int N>
+bool WideBVH<BV, N>::empty() const
+{
+  return nodes.empty();
+}
+
+//==============================================================================
+template <typename BV, int N>
+const WideBVNode<BV, N>& WideBVH<BV, N>::getNode(int id) const
+{
+  return nodes[id];
+}
+
+//==============================================================================
+template <typename BV, int N>
+int WideBVH<BV, N>::getNumNodes() const
+{
+  return static_cast<int>(nodes.size());
+}
+
+//==============================================================================
+template <typename BV, int N>
+int WideBVH<BV, N>::memUsage() const
+{
+  return static_cast<int>(sizeof(WideBVNode<BV, N>) * nodes.size());
+}
+
+//==============================================================================
+template <typename BV, int N>
+int WideBVH<BV, N>::recursiveBuild(const BVHModel<BV>& model, int bv_id)
+{
+  int children[N];
+  int num_children = 2;
+  children[0] = model.getBV(bv_id).leftChild();
+  children[1] = model.getBV(bv_id).rightChild();
+
+  while(num_children < N)
+  {
+    int largest = -1;
+    S largest_size = 0;
+    for(int i = 0; i < num_children; ++i)
+    {
+      const BVNode<BV>& child = model.getBV(children[i]);
+      if(!child.isLeaf() && (largest < 0 || child.bv.size() > largest_size))
+      {
+        largest = i;
+        largest_size = child.bv.size();
+      }
+    }
+
+    if(largest < 0)
+      break;
+
+    // open the largest child in place to keep the order of the binary tree
+    const BVNode<BV>& opened = model.getBV(children[largest]);
+    for(int i = num_children; i > largest + 1; --i)
+      children[i] = children[i - 1];
+    children[largest] = opened.leftChild();
+    children[largest + 1] = opened.rightChild();
+    ++num_children;
+  }
+
+  const int id = static_cast<int>(nodes.size());
+  nodes.emplace_back();
+  nodes[id].num_children = num_children;
+  for(int i = 0; i < num_children; ++i)
+  {
+    nodes[id].child_bv[i] = children[i];
+    nodes[id].bounds.set(i, model.getBV(children[i]).bv);
+  }
+
+  for(int i = 0; i < num_children; ++i)
+  {
+    if(!model.getBV(children[i]).isLeaf())
+    {
+      const int child_id = recursiveBuild(model, children[i]);
+      nodes[id].child_node[i] = child_id;
+    }
+  }
+
+  return id;
+}
+
+} // namespace detail
+} // namespace fcl
+
+#endif
@@ -43,6 +43,7 @@
 #include "fcl/math/bv/kIOS.h"
 #include "fcl/math/bv/OBBRSS.h"
 #include <iostream>
+#include <memory>
 
 namespace fcl
 {
@@ -69,6 +70,11 @@ public:
 
   /// @brief clear the temporary data generated.
   virtual void clear() = 0;
+
+  /// @brief Create a copy of this fitter, including the primitives set
+  /// before, that can be used concurrently with it. The default returns
+  /// nullptr, in which case the hierarchy is built by a single thread.
+  virtual std::shared_ptr<BVFitterBase<BV>> clone() const;
 };
 
 /// @brief The class for the default algorithm fitting a bounding volume to a set of points
@@ -100,6 +106,9 @@ public:
   /// @brief Clear the geometry primitive data
   void clear();
 
+  /// @brief Create a copy of this fitter
+  std::shared_ptr<BVFitterBase<BV>> clone() const;
+
 private:
 
   Vector3<S>* vertices;
@@ -120,6 +129,13 @@ private:
 //                                                                            //
 //============================================================================//
 
+//==============================================================================
+template <typename BV>
+std::shared_ptr<BVFitterBase<BV>> BVFitterBase<BV>::clone() const
+{
+  return nullptr;
+}
+
 //==============================================================================
 template <typename BV>
 BVFitter<BV>::~BVFitter()
@@ -175,6 +191,13 @@ void BVFitter<BV>::clear()
   type = BVH_MODEL_UNKNOWN;
 }
 
+//==============================================================================
+template <typename BV>
+std::shared_ptr<BVFitterBase<BV>> BVFitter<BV>::clone() const
+{
+  return std::make_shared<BVFitter<BV>>(*this);
+}
+
 //==============================================================================
 template <typename S, typename BV>
 struct SetImpl
@@ -42,6 +42,9 @@
 #include "fcl/object/geometry/bvh/BVH_internal.h"
 #include "fcl/math/bv/kIOS.h"
 #include "fcl/math/bv/OBBRSS.h"
+#include <algorithm>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <iostream>
 
@@ -75,14 +78,20 @@ public:
 
   /// @brief Clear the geometry data set before
   virtual void clear() = 0;
+
+  /// @brief Create a copy of this splitter, including the geometry data set
+  /// before, that can be used concurrently with it. The default returns
+  /// nullptr, in which case the hierarchy is built by a single thread.
+  virtual std::shared_ptr<BVSplitterBase<BV>> clone() const;
 };
 
-/// @brief Three types of split algorithms are provided in FCL as default
+/// @brief Four types of split algorithms are provided in FCL as default
 enum SplitMethodType
 {
   SPLIT_METHOD_MEAN,
   SPLIT_METHOD_MEDIAN,
-  SPLIT_METHOD_BV_CENTER
+  SPLIT_METHOD_BV_CENTER,
+  SPLIT_METHOD_SAH
 };
 
 /// @brief A class describing the split rule that splits each BV node
@@ -113,6 +122,9 @@ public:
   /// @brief Clear the geometry data set before
   void clear();
 
+  /// @brief Create a copy of this splitter
+  std::shared_ptr<BVSplitterBase<BV>> clone() const;
+
 private:
 
   /// @brief The axis based on which the split decision is made. For most BV,
@@ -153,6 +165,11 @@ private:
   void computeRule_median(
       const BV& bv, unsigned int* primitive_indices, int num_primitives);
 
+  /// @brief Split algorithm 4: Split the node where the binned surface area
+  /// heuristic (volume heuristic for oriented BVs) is minimal
+  void computeRule_sah(
+      const BV& bv, unsigned int* primitive_indices, int num_primitives);
+
   template <typename, typename>
   friend struct ApplyImpl;
 
@@ -164,6 +181,9 @@ private:
 
   template <typename, typename>
   friend struct ComputeRuleMedianImpl;
+
+  template <typename, typename>
+  friend struct ComputeRuleSAHImpl;
 };
 
 template <typename S, typename BV>
@@ -194,12 +214,37 @@ void computeSplitValue_median(
     const Vector3<S>& split_vector,
     S& split_value);
 
+/// @brief Choose among the three axes (columns of axes) and the boundaries of
+/// num_bins bins of the primitive centroids the split with the lowest cost.
+/// The cost of a split is the sum over both sides of the number of primitives
+/// times the volume (if use_volume is true) or the surface area of their
+/// bounding box in the axes frame. Volume ties are broken by surface area.
+template <typename S>
+void computeSplitRule_sah(
+    const Matrix3<S>& axes,
+    bool use_volume,
+    int num_bins,
+    Vector3<S>* vertices,
+    Triangle* triangles,
+    unsigned int* primitive_indices,
+    int num_primitives,
+    BVHModelType type,
+    int& split_axis,
+    S& split_value);
+
 //============================================================================//
 //                                                                            //
 //                              Implementations                               //
 //                                                                            //
 //============================================================================//
 
+//==============================================================================
+template <typename BV>
+std::shared_ptr<BVSplitterBase<BV>> BVSplitterBase<BV>::clone() const
+{
+  return nullptr;
+}
+
 //==============================================================================
 template <typename BV>
 BVSplitter<BV>::BVSplitter(SplitMethodType method)
@@ -241,6 +286,9 @@ void BVSplitter<BV>::computeRule(
   case SPLIT_METHOD_BV_CENTER:
     computeRule_bvcenter(bv, primitive_indices, num_primitives);
     break;
+  case SPLIT_METHOD_SAH:
+    computeRule_sah(bv, primitive_indices, num_primitives);
+    break;
   default:
     std::cerr << "Split method not supported" << std::endl;
   }
@@ -407,6 +455,32 @@ void BVSplitter<BV>::computeRule_median(
         *this, bv, primitive_indices, num_primitives);
 }
 
+//==============================================================================
+template <typename S, typename BV>
+struct ComputeRuleSAHImpl
+{
+  static void run(
+      BVSplitter<BV>& splitter,
+      const BV& /*bv*/,
+      unsigned int* primitive_indices,
+      int num_primitives)
+  {
+    computeSplitRule_sah<S>(
+          Matrix3<S>::Identity(), false, 16, splitter.vertices,
+          splitter.tri_indices, primitive_indices, num_primitives,
+          splitter.type, splitter.split_axis, splitter.split_value);
+  }
+};
+
+//==============================================================================
+template <typename BV>
+void BVSplitter<BV>::computeRule_sah(
+    const BV& bv, unsigned int* primitive_indices, int num_primitives)
+{
+  ComputeRuleSAHImpl<S, BV>::run(
+        *this, bv, primitive_indices, num_primitives);
+}
+
 //==============================================================================
 template <typename S>
 struct ComputeRuleCenterImpl<S, OBB<S>>
@@ -456,6 +530,24 @@ struct ComputeRuleMedianImpl<S, OBB<S>>
   }
 };
 
+//==============================================================================
+template <typename S>
+struct ComputeRuleSAHImpl<S, OBB<S>>
+{
+  static void run(
+      BVSplitter<OBB<S>>& splitter,
+      const OBB<S>& bv,
+      unsigned int* primitive_indices,
+      int num_primitives)
+  {
+    computeSplitRule_sah<S>(
+          bv.axis, true, 16, splitter.vertices, splitter.tri_indices,
+          primitive_indices, num_primitives, splitter.type,
+          splitter.split_axis, splitter.split_value);
+    splitter.split_vector = bv.axis.col(splitter.split_axis);
+  }
+};
+
 //==============================================================================
 template <typename S>
 struct ComputeRuleCenterImpl<S, RSS<S>>
@@ -505,6 +597,24 @@ struct ComputeRuleMedianImpl<S, RSS<S>>
   }
 };
 
+//==============================================================================
+template <typename S>
+struct ComputeRuleSAHImpl<S, RSS<S>>
+{
+  static void run(
+      BVSplitter<RSS<S>>& splitter,
+      const RSS<S>& bv,
+      unsigned int* primitive_indices,
+      int num_primitives)
+  {
+    computeSplitRule_sah<S>(
+          bv.axis, true, 16, splitter.vertices, splitter.tri_indices,
+          primitive_indices, num_primitives, splitter.type,
+          splitter.split_axis, splitter.split_value);
+    splitter.split_vector = bv.axis.col(splitter.split_axis);
+  }
+};
+
 //==============================================================================
 template <typename S>
 struct ComputeRuleCenterImpl<S, kIOS<S>>
@@ -554,6 +664,24 @@ struct ComputeRuleMedianImpl<S, kIOS<S>>
   }
 };
 
+//==============================================================================
+template <typename S>
+struct ComputeRuleSAHImpl<S, kIOS<S>>
+{
+  static void run(
+      BVSplitter<kIOS<S>>& splitter,
+      const kIOS<S>& bv,
+      unsigned int* primitive_indices,
+      int num_primitives)
+  {
+    computeSplitRule_sah<S>(
+          bv.obb.axis, true, 16, splitter.vertices, splitter.tri_indices,
+          primitive_indices, num_primitives, splitter.type,
+          splitter.split_axis, splitter.split_value);
+    splitter.split_vector = bv.obb.axis.col(splitter.split_axis);
+  }
+};
+
 //==============================================================================
 template <typename S>
 struct ComputeRuleCenterImpl<S, OBBRSS<S>>
@@ -603,6 +731,24 @@ struct ComputeRuleMedianImpl<S, OBBRSS<S>>
   }
 };
 
+//==============================================================================
+template <typename S>
+struct ComputeRuleSAHImpl<S, OBBRSS<S>>
+{
+  static void run(
+      BVSplitter<OBBRSS<S>>& splitter,
+      const OBBRSS<S>& bv,
+      unsigned int* primitive_indices,
+      int num_primitives)
+  {
+    computeSplitRule_sah<S>(
+          bv.obb.axis, true, 16, splitter.vertices, splitter.tri_indices,
+          primitive_indices, num_primitives, splitter.type,
+          splitter.split_axis, splitter.split_value);
+    splitter.split_vector = bv.obb.axis.col(splitter.split_axis);
+  }
+};
+
 //==============================================================================
 template <typename S>
 struct ApplyImpl<S, OBB<S>>
@@ -660,6 +806,13 @@ void BVSplitter<BV>::clear()
   type = BVH_MODEL_UNKNOWN;
 }
 
+//==============================================================================
+template <typename BV>
+std::shared_ptr<BVSplitterBase<BV>> BVSplitter<BV>::clone() const
+{
+  return std::make_shared<BVSplitter<BV>>(*this);
+}
+
 //==============================================================================
 template <typename S, typename BV>
 struct ComputeSplitVectorImpl
@@ -827,6 +980,168 @@ void computeSplitValue_median(
   }
 }
 
+//==============================================================================
+template <typename S>
+void computeSplitRule_sah(
+    const Matrix3<S>& axes,
+    bool use_volume,
+    int num_bins,
+    Vector3<S>* vertices,
+    Triangle* triangles,
+    unsigned int* primitive_indices,
+    int num_primitives,
+    BVHModelType type,
+    int& split_axis,
+    S& split_value)
+{
+  // centroids and bounds of the primitives in the axes frame. The centroid is
+  // computed as in BVHModel::recursiveBuildTree() so that the split value is
+  // compared against the very same projections.
+  std::vector<Vector3<S>> proj(num_primitives);
+  std::vector<Vector3<S>> lower(num_primitives);
+  std::vector<Vector3<S>> upper(num_primitives);
+
+  for(int i = 0; i < num_primitives; ++i)
+  {
+    if(type == BVH_MODEL_TRIANGLES)
+    {
+      const Triangle& t = triangles[primitive_indices[i]];
+      const Vector3<S>& p1 = vertices[t[0]];
+      const Vector3<S>& p2 = vertices[t[1]];
+      const Vector3<S>& p3 = vertices[t[2]];
+      Vector3<S> p;
+      p.noalias() = (p1 + p2 + p3) / 3.0;
+
+      for(int a = 0; a < 3; ++a)
+      {
+        const Vector3<S> axis = axes.col(a);
+        const S d1 = axis.dot(p1);
+        const S d2 = axis.dot(p2);
+        const S d3 = axis.dot(p3);
+        proj[i][a] = axis.dot(p);
+        lower[i][a] = std::min(d1, std::min(d2, d3));
+        upper[i][a] = std::max(d1, std::max(d2, d3));
+      }
+    }
+    else if(type == BVH_MODEL_POINTCLOUD)
+    {
+      const Vector3<S>& p = vertices[primitive_indices[i]];
+
+      for(int a = 0; a < 3; ++a)
+      {
+        const Vector3<S> axis = axes.col(a);
+        proj[i][a] = lower[i][a] = upper[i][a] = axis.dot(p);
+      }
+    }
+  }
+
+  std::vector<int> bin_count(num_bins);
+  std::vector<S> bin_max(num_bins);
+  std::vector<Vector3<S>> bin_lower(num_bins);
+  std::vector<Vector3<S>> bin_upper(num_bins);
+  std::vector<S> right_volume(num_bins);
+  std::vector<S> right_area(num_bins);
+
+  const S inf = std::numeric_limits<S>::max();
+  S best_volume_cost = inf;
+  S best_area_cost = inf;
+
+  split_axis = 0;
+  split_value = proj.empty() ? 0 : proj[0][0];
+
+  auto volume = [](const Vector3<S>& l, const Vector3<S>& u)
+  {
+    const Vector3<S> e = u - l;
+    return e[0] * e[1] * e[2];
+  };
+
+  auto area = [](const Vector3<S>& l, const Vector3<S>& u)
+  {
+    const Vector3<S> e = u - l;
+    return 2 * (e[0] * e[1] + e[1] * e[2] + e[2] * e[0]);
+  };
+
+  for(int a = 0; a < 3; ++a)
+  {
+    S cmin = inf;
+    S cmax = -inf;
+    for(int i = 0; i < num_primitives; ++i)
+    {
+      cmin = std::min(cmin, proj[i][a]);
+      cmax = std::max(cmax, proj[i][a]);
+    }
+
+    if(!(cmax > cmin)) continue;
+
+    const S scale = num_bins / (cmax - cmin);
+
+    for(int k = 0; k < num_bins; ++k)
+    {
+      bin_count[k] = 0;
+      bin_max[k] = -inf;
+      bin_lower[k].setConstant(inf);
+      bin_upper[k].setConstant(-inf);
+    }
+
+    for(int i = 0; i < num_primitives; ++i)
+    {
+      int k = static_cast<int>((proj[i][a] - cmin) * scale);
+      if(k >= num_bins) k = num_bins - 1;
+
+      bin_count[k]++;
+      bin_max[k] = std::max(bin_max[k], proj[i][a]);
+      bin_lower[k] = bin_lower[k].cwiseMin(lower[i]);
+      bin_upper[k] = bin_upper[k].cwiseMax(upper[i]);
+    }
+
+    // sweep from the right to get the bounds of the bins k, ..., num_bins - 1
+    Vector3<S> l = Vector3<S>::Constant(inf);
+    Vector3<S> u = Vector3<S>::Constant(-inf);
+    int n = 0;
+    for(int k = num_bins - 1; k > 0; --k)
+    {
+      if(bin_count[k])
+      {
+        l = l.cwiseMin(bin_lower[k]);
+        u = u.cwiseMax(bin_upper[k]);
+        n += bin_count[k];
+      }
+      right_volume[k] = n ? n * volume(l, u) : 0;
+      right_area[k] = n ? n * area(l, u) : 0;
+    }
+
+    // sweep from the left and evaluate the split after bin k - 1
+    l.setConstant(inf);
+    u.setConstant(-inf);
+    n = 0;
+    S left_max = -inf;
+    for(int k = 1; k < num_bins; ++k)
+    {
+      if(bin_count[k - 1])
+      {
+        l = l.cwiseMin(bin_lower[k - 1]);
+        u = u.cwiseMax(bin_upper[k - 1]);
+        n += bin_count[k - 1];
+        left_max = bin_max[k - 1];
+      }
+
+      if(n == 0 || n == num_primitives) continue;
+
+      const S area_cost = n * area(l, u) + right_area[k];
+      const S volume_cost = use_volume ? n * volume(l, u) + right_volume[k] : 0;
+
+      if(volume_cost < best_volume_cost
+         || (volume_cost == best_volume_cost && area_cost < best_area_cost))
+      {
+        best_volume_cost = volume_cost;
+        best_area_cost = area_cost;
+        split_axis = a;
+        split_value = left_max;
+      }
+    }
+  }
+}
+
 } // namespace detail
 } // namespace fcl
 
@@ -39,6 +39,8 @@
 #ifndef FCL_SHAPE_CONVEX_H
 #define FCL_SHAPE_CONVEX_H
 
+#include <vector>
+
 #include "fcl/object/geometry/shape/shape_base.h"
 #include "fcl/object/geometry/shape/compute_bv.h"
 #include "fcl/math/bv/OBB.h"
@@ -110,10 +112,29 @@ public:
   std::vector<Vector3<S>> getBoundVertices(
       const Transform3<S>& tf) const;
 
+  /// @brief Get the index of the vertex farthest along dir. The search climbs
+  /// from a vertex to the adjacent vertices while they are farther, which
+  /// ends at the farthest vertex of a convex polytope. It starts from *hint if
+  /// that is a vertex on an edge, or else from a fixed vertex, and stores the
+  /// vertex found to *hint. Without edges, all the vertices are scanned.
+  int findExtremeVertex(const Vector3<S>& dir, int* hint = nullptr) const;
+
 protected:
 
   /// @brief Get edge information 
   void fillEdges();
+
+  /// @brief Get the vertex adjacency from the edges
+  void fillNeighbors();
+
+  /// @brief The vertices adjacent to vertex i are neighbors[j] for j from
+  /// neighbor_offsets[i] to neighbor_offsets[i + 1] - 1
+  std::vector<int> neighbor_offsets;
+  std::vector<int> neighbors;
+
+  /// @brief The vertex on an edge that findExtremeVertex() starts from when
+  /// the caller has no hint of its own
+  int start_vertex;
 };
 
 using Convexf = Convex<float>;
@@ -130,12 +151,12 @@ template <typename S>
 Convex<S>::Convex(
     Vector3<S>* plane_normals, S* plane_dis, int num_planes_,
     Vector3<S>* points, int num_points_, int* polygons_)
-  : ShapeBase<S>()
+  : ShapeBase<S>(), start_vertex(0)
 {
-  plane_normals = plane_normals;
-  plane_dis = plane_dis;
+  this->plane_normals = plane_normals;
+  this->plane_dis = plane_dis;
   num_planes = num_planes_;
-  points = points;
+  this->points = points;
   num_points = num_points_;
   polygons = polygons_;
   edges = nullptr;
@@ -149,18 +170,25 @@ Convex<S>::Convex(
   center = sum * (S)(1.0 / num_points);
 
   fillEdges();
+  fillNeighbors();
 }
 
 //==============================================================================
 template <typename S>
 Convex<S>::Convex(const Convex& other)
-  : ShapeBase<S>(other)
+  : ShapeBase<S>(other),
+    neighbor_offsets(other.neighbor_offsets),
+    neighbors(other.neighbors),
+    start_vertex(other.start_vertex)
 {
   plane_normals = other.plane_normals;
   plane_dis = other.plane_dis;
   num_planes = other.num_planes;
   points = other.points;
+  num_points = other.num_points;
   polygons = other.polygons;
+  num_edges = other.num_edges;
+  center = other.center;
   edges = new Edge[other.num_edges];
   memcpy(edges, other.edges, sizeof(Edge) * num_edges);
 }
@@ -370,6 +398,90 @@ void Convex<S>::fillEdges()
   }
 }
 
+//==============================================================================
+template <typename S>
+void Convex<S>::fillNeighbors()
+{
+  neighbor_offsets.assign(num_points + 1, 0);
+  for(int i = 0; i < num_edges; ++i)
+  {
+    ++neighbor_offsets[edges[i].first + 1];
+    ++neighbor_offsets[edges[i].second + 1];
+  }
+  for(int i = 0; i < num_points; ++i)
+    neighbor_offsets[i + 1] += neighbor_offsets[i];
+
+  neighbors.resize(2 * num_edges);
+  std::vector<int> next(neighbor_offsets.begin(), neighbor_offsets.end() - 1);
+  for(int i = 0; i < num_edges; ++i)
+  {
+    neighbors[next[edges[i].first]++] = edges[i].second;
+    neighbors[next[edges[i].second]++] = edges[i].first;
+  }
+
+  // start the first search from a vertex on an edge
+  for(int i = 0; i < num_points; ++i)
+  {
+    if(neighbor_offsets[i] < neighbor_offsets[i + 1])
+    {
+      start_vertex = i;
+      break;
+    }
+  }
+}
+
+//==============================================================================
+template <typename S>
+int Convex<S>::findExtremeVertex(const Vector3<S>& dir, int* hint) const
+{
+  int best = 0;
+
+  if(neighbors.empty())
+  {
+    S maxdot = - std::numeric_limits<S>::max();
+    for(int i = 0; i < num_points; ++i)
+    {
+      S dot = dir.dot(points[i]);
+      if(dot > maxdot)
+      {
+        best = i;
+        maxdot = dot;
+      }
+    }
+  }
+  else
+  {
+    if(hint && *hint >= 0 && *hint < num_points
+       && neighbor_offsets[*hint] < neighbor_offsets[*hint + 1])
+      best = *hint;
+    else
+      best = start_vertex;
+
+    // a linear function has no local maximum over the vertices of a convex
+    // polytope other than the global one
+    S maxdot = dir.dot(points[best]);
+    int current = -1;
+    while(best != current)
+    {
+      current = best;
+      for(int j = neighbor_offsets[current]; j < neighbor_offsets[current + 1]; ++j)
+      {
+        S dot = dir.dot(points[neighbors[j]]);
+        if(dot > maxdot)
+        {
+          best = neighbors[j];
+          maxdot = dot;
+        }
+      }
+    }
+  }
+
+  if(hint)
+    *hint = best;
+
+  return best;
+}
+
 //==============================================================================
 template <typename S>
 std::vector<Vector3<S>> Convex<S>::getBoundVertices(
@@ -40,12 +40,15 @@
 #include "fcl/config.h"
 #include "fcl/broadphase/broadphase_bruteforce.h"
 #include "fcl/broadphase/broadphase_spatialhash.h"
+#include "fcl/broadphase/broadphase_hierarchical_spatialhash.h"
 #include "fcl/broadphase/broadphase_SaP.h"
 #include "fcl/broadphase/broadphase_SSaP.h"
 #include "fcl/broadphase/broadphase_interval_tree.h"
 #include "fcl/broadphase/broadphase_dynamic_AABB_tree.h"
 #include "fcl/broadphase/broadphase_dynamic_AABB_tree_array.h"
+#include "fcl/broadphase/broadphase_snapshots.h"
 #include "fcl/broadphase/detail/sparse_hash_table.h"
+#include "fcl/broadphase/detail/flat_hash_table.h"
 #include "fcl/broadphase/detail/spatial_hash.h"
 #include "fcl/object/geometry/shape/geometric_shape_to_BVH_model.h"
 #include "test_fcl_utility.h"
@@ -57,6 +60,9 @@
 #endif
 
 #include <iostream>
+#include <map>
+#include <set>
+#include <tuple>
 #include <iomanip>
 
 using namespace fcl;
@@ -70,6 +76,64 @@ void broad_phase_duplicate_check_test(S env_scale, std::size_t env_size, bool ve
 template <typename S>
 void broad_phase_update_collision_test(S env_scale, std::size_t env_size, std::size_t query_size, std::size_t num_max_contacts = 1, bool exhaustive = false, bool use_mesh = false);
 
+/// @brief make sure the parallel self collision of the dynamic AABB tree finds
+/// the contacts of the serial one, and stops each thread at its own criterion
+template <typename S>
+void broad_phase_parallel_self_collision_test(S env_scale, std::size_t env_size, int num_threads, bool use_mesh = false);
+
+/// @brief make sure the incrementally updated overlap pairs of SaP match the
+/// pairs found by brute force over several frames of motion, and are reported
+/// in the same order by managers built up differently
+template <typename S>
+void broad_phase_SaP_incremental_update_test(S env_scale, std::size_t env_size, std::size_t num_frames);
+
+/// @brief make sure the begin/end events of the persistent overlap pairs add
+/// up to the pairs found by brute force in every frame
+template <typename S>
+void broad_phase_persistent_pairs_test(S env_scale, std::size_t env_size, std::size_t num_frames);
+
+/// @brief make sure the parallel setup and self collision of SSaP give the
+/// same pairs as the serial ones, and that each thread stops at its own
+/// criterion
+template <typename S>
+void broad_phase_SSaP_parallel_test(S env_scale, std::size_t env_size, int num_threads);
+
+/// @brief compare the timing of the hash tables of spatial hashing over
+/// several frames of update, self collision and queries
+template <typename S>
+void broad_phase_spatial_hash_table_test(S env_scale, std::size_t env_size, std::size_t query_size, std::size_t num_frames, bool use_mesh = false);
+
+/// @brief check the hierarchical spatial hashing against brute force on objects
+/// of very different sizes, and its cell sizes after the sizes drift
+template <typename S>
+void broad_phase_hierarchical_spatial_hash_test(S env_scale, std::size_t env_size, std::size_t num_frames);
+
+/// @brief check the parallel update of the array AABB tree against brute force,
+/// and that its rotations do not make the tree worse
+template <typename S>
+void broad_phase_AABB_tree_array_parallel_update_test(S env_scale, std::size_t env_size, std::size_t num_frames, int num_threads);
+
+/// @brief check the dynamic AABB trees with enlarged leaf AABBs and velocity
+/// hints against brute force, for whole and per object updates, and that
+/// without them the leaves shrink with the objects
+template <typename S>
+void broad_phase_fat_AABB_test(S env_scale, std::size_t env_size, std::size_t num_frames);
+
+/// @brief check collision between managers of different types against brute
+/// force
+template <typename S>
+void broad_phase_cross_manager_collide_test(S env_scale, std::size_t env_size);
+
+/// @brief check that concurrent queries on one manager give the same results
+/// as serial ones
+template <typename S>
+void broad_phase_concurrent_query_test(S env_scale, std::size_t env_size, std::size_t query_size, int num_threads);
+
+/// @brief check the versions read from BroadPhaseSnapshots against brute force
+/// while a writer keeps publishing new ones
+template <typename S>
+void broad_phase_snapshots_test(S env_scale, std::size_t env_size, std::size_t num_frames, int num_threads);
+
 #if USE_GOOGLEHASH
 template<typename U, typename V>
 struct GoogleSparseHashTable : public google::sparse_hash_map<U, V, std::tr1::hash<size_t>, std::equal_to<size_t> > {};
@@ -167,6 +231,124 @@ GTEST_TEST(FCL_BROADPHASE, test_core_mesh_bf_broad_phase_update_collision_mesh_e
 #endif
 }
 
+/// check the parallel self collision against the serial one
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_parallel_self_collision)
+{
+#ifdef NDEBUG
+  broad_phase_parallel_self_collision_test<double>(2000, 1000, 4);
+  broad_phase_parallel_self_collision_test<double>(2000, 5000, 7);
+  broad_phase_parallel_self_collision_test<double>(2000, 100, 4, true);
+#else
+  broad_phase_parallel_self_collision_test<double>(2000, 100, 4);
+  broad_phase_parallel_self_collision_test<double>(2000, 500, 7);
+  broad_phase_parallel_self_collision_test<double>(2000, 10, 4, true);
+#endif
+}
+
+/// check the incremental SaP update against brute force
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_SaP_incremental_update)
+{
+#ifdef NDEBUG
+  broad_phase_SaP_incremental_update_test<double>(200, 2000, 20);
+#else
+  broad_phase_SaP_incremental_update_test<double>(200, 200, 10);
+#endif
+}
+
+/// check the persistent overlap pairs against brute force
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_persistent_pairs)
+{
+#ifdef NDEBUG
+  broad_phase_persistent_pairs_test<double>(200, 2000, 20);
+#else
+  broad_phase_persistent_pairs_test<double>(200, 200, 10);
+#endif
+}
+
+/// check the parallel SSaP against the serial one
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_SSaP_parallel)
+{
+#ifdef NDEBUG
+  broad_phase_SSaP_parallel_test<double>(2000, 50000, 4);
+  broad_phase_SSaP_parallel_test<double>(2000, 10000, 7);
+#else
+  broad_phase_SSaP_parallel_test<double>(2000, 10000, 4);
+  broad_phase_SSaP_parallel_test<double>(2000, 500, 7);
+#endif
+}
+
+/// compare the hash tables of spatial hashing
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_spatial_hash_tables)
+{
+#ifdef NDEBUG
+  broad_phase_spatial_hash_table_test<double>(2000, 10000, 100, 10);
+  broad_phase_spatial_hash_table_test<double>(2000, 1000, 100, 10, true);
+#else
+  broad_phase_spatial_hash_table_test<double>(2000, 1000, 10, 3);
+  broad_phase_spatial_hash_table_test<double>(2000, 100, 10, 3, true);
+#endif
+}
+
+/// check the hierarchical spatial hashing on mixed object sizes
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_hierarchical_spatial_hash)
+{
+#ifdef NDEBUG
+  broad_phase_hierarchical_spatial_hash_test<double>(2000, 5000, 10);
+#else
+  broad_phase_hierarchical_spatial_hash_test<double>(2000, 500, 3);
+#endif
+}
+
+/// check the parallel refit and rotations of the array AABB tree
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_AABB_tree_array_parallel_update)
+{
+#ifdef NDEBUG
+  broad_phase_AABB_tree_array_parallel_update_test<double>(2000, 5000, 20, 4);
+#else
+  broad_phase_AABB_tree_array_parallel_update_test<double>(2000, 500, 5, 4);
+#endif
+}
+
+/// check the fat AABB margins of the dynamic AABB trees
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_fat_AABB)
+{
+#ifdef NDEBUG
+  broad_phase_fat_AABB_test<double>(200, 2000, 20);
+#else
+  broad_phase_fat_AABB_test<double>(200, 200, 5);
+#endif
+}
+
+/// check collision between managers of different types
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_cross_manager_collide)
+{
+#ifdef NDEBUG
+  broad_phase_cross_manager_collide_test<double>(200, 2000);
+#else
+  broad_phase_cross_manager_collide_test<double>(200, 200);
+#endif
+}
+
+/// check concurrent queries on shared managers
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_concurrent_query)
+{
+#ifdef NDEBUG
+  broad_phase_concurrent_query_test<double>(200, 2000, 200, 4);
+#else
+  broad_phase_concurrent_query_test<double>(200, 200, 20, 4);
+#endif
+}
+
+/// check reading snapshots while they are published
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_snapshots)
+{
+#ifdef NDEBUG
+  broad_phase_snapshots_test<double>(200, 1000, 20, 4);
+#else
+  broad_phase_snapshots_test<double>(200, 100, 5, 4);
+#endif
+}
+
 //==============================================================================
 template <typename S>
 struct CollisionDataForUniquenessChecking
@@ -220,6 +402,8 @@ void broad_phase_duplicate_check_test(S env_scale, std::size_t env_size, bool ve
   SpatialHashingCollisionManager<S>::computeBound(env, lower_limit, upper_limit);
   S cell_size = std::min(std::min((upper_limit[0] - lower_limit[0]) / 20, (upper_limit[1] - lower_limit[1]) / 20), (upper_limit[2] - lower_limit[2])/20);
   managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+  managers.push_back(new SpatialHashingCollisionManager<S, detail::FlatHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+  managers.push_back(new HierarchicalSpatialHashingCollisionManager<S>());
 #if USE_GOOGLEHASH
   managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>, GoogleSparseHashTable> >(cell_size, lower_limit, upper_limit));
   managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>, GoogleDenseHashTable> >(cell_size, lower_limit, upper_limit));
@@ -239,6 +423,13 @@ void broad_phase_duplicate_check_test(S env_scale, std::size_t env_size, bool ve
     managers.push_back(m);
   }
 
+  {
+    DynamicAABBTreeCollisionManager_Array<S>* m = new DynamicAABBTreeCollisionManager_Array<S>();
+    m->parallel_update = true;
+    m->num_threads = 4;
+    managers.push_back(m);
+  }
+
   ts.resize(managers.size());
   timers.resize(managers.size());
 
@@ -380,6 +571,8 @@ void broad_phase_update_collision_test(S env_scale, std::size_t env_size, std::s
   S cell_size = std::min(std::min((upper_limit[0] - lower_limit[0]) / 20, (upper_limit[1] - lower_limit[1]) / 20), (upper_limit[2] - lower_limit[2])/20);
   // managers.push_back(new SpatialHashingCollisionManager<S>(cell_size, lower_limit, upper_limit));
   managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+  managers.push_back(new SpatialHashingCollisionManager<S, detail::FlatHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+  managers.push_back(new HierarchicalSpatialHashingCollisionManager<S>());
 #if USE_GOOGLEHASH
   managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>, GoogleSparseHashTable> >(cell_size, lower_limit, upper_limit));
   managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>, GoogleDenseHashTable> >(cell_size, lower_limit, upper_limit));
@@ -399,6 +592,13 @@ void broad_phase_update_collision_test(S env_scale, std::size_t env_size, std::s
     managers.push_back(m);
   }
 
+  {
+    DynamicAABBTreeCollisionManager_Array<S>* m = new DynamicAABBTreeCollisionManager_Array<S>();
+    m->parallel_update = true;
+    m->num_threads = 4;
+    managers.push_back(m);
+  }
+
   ts.resize(managers.size());
   timers.resize(managers.size());
 
@@ -582,6 +782,945 @@ void broad_phase_update_collision_test(S env_scale, std::size_t env_size, std::s
   std::cout << std::endl;
 }
 
+//==============================================================================
+template <typename S>
+void broad_phase_parallel_self_collision_test(S env_scale, std::size_t env_size, int num_threads, bool use_mesh)
+{
+  std::vector<CollisionObject<S>*> env;
+  if(use_mesh)
+    test::generateEnvironmentsMesh(env, env_scale, env_size);
+  else
+    test::generateEnvironments(env, env_scale, env_size);
+
+  DynamicAABBTreeCollisionManager<S> manager;
+  manager.registerObjects(env);
+  manager.setup();
+
+  test::CollisionData<S> serial_data;
+  serial_data.request.num_max_contacts = 100000;
+  manager.collide(&serial_data, test::defaultCollisionFunction);
+
+  std::vector<test::CollisionData<S>> parallel_data(num_threads);
+  std::vector<void*> cdata;
+  for(auto& data : parallel_data)
+  {
+    data.request.num_max_contacts = 100000;
+    cdata.push_back(&data);
+  }
+  manager.collide(cdata, test::defaultCollisionFunction);
+
+  std::vector<Contact<S>> serial_contacts;
+  serial_data.result.getContacts(serial_contacts);
+
+  // The pairs are handed out to the threads dynamically, so the contacts of
+  // each thread are a subsequence of the serial ones and together they are
+  // all of them
+  using ContactKey = std::tuple<const CollisionGeometry<S>*, const CollisionGeometry<S>*, int, int>;
+  auto key = [](const Contact<S>& c) { return ContactKey(c.o1, c.o2, c.b1, c.b2); };
+  std::map<ContactKey, std::size_t> serial_index;
+  std::map<ContactKey, std::size_t> serial_count;
+  for(std::size_t i = 0; i < serial_contacts.size(); ++i)
+  {
+    serial_index.emplace(key(serial_contacts[i]), i);
+    ++serial_count[key(serial_contacts[i])];
+  }
+
+  std::map<ContactKey, std::size_t> parallel_count;
+  std::size_t num_parallel_contacts = 0;
+  for(auto& data : parallel_data)
+  {
+    std::vector<Contact<S>> contacts;
+    data.result.getContacts(contacts);
+    num_parallel_contacts += contacts.size();
+
+    std::size_t prev = 0;
+    for(std::size_t i = 0; i < contacts.size(); ++i)
+    {
+      ++parallel_count[key(contacts[i])];
+      const auto it = serial_index.find(key(contacts[i]));
+      ASSERT_TRUE(it != serial_index.end());
+      if(i > 0)
+      {
+        EXPECT_LE(prev, it->second);
+      }
+      prev = it->second;
+    }
+  }
+
+  EXPECT_EQ(serial_contacts.size(), num_parallel_contacts);
+  EXPECT_EQ(serial_count, parallel_count);
+
+  // With the default num_max_contacts each thread stops at its first contact,
+  // so each gets at most one, and some contact is found if there is one
+  test::CollisionData<S> first_data;
+  manager.collide(&first_data, test::defaultCollisionFunction);
+
+  std::vector<test::CollisionData<S>> first_parallel_data(num_threads);
+  cdata.clear();
+  for(auto& data : first_parallel_data)
+    cdata.push_back(&data);
+  manager.collide(cdata, test::defaultCollisionFunction);
+
+  std::size_t num_first_contacts = 0;
+  for(auto& data : first_parallel_data)
+  {
+    EXPECT_LE(data.result.numContacts(), 1u);
+    num_first_contacts += data.result.numContacts();
+    for(std::size_t i = 0; i < data.result.numContacts(); ++i)
+      EXPECT_TRUE(serial_index.count(key(data.result.getContact(i))) == 1);
+  }
+  EXPECT_EQ(first_data.result.numContacts() > 0, num_first_contacts > 0);
+  EXPECT_LE(num_first_contacts, static_cast<std::size_t>(num_threads));
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+}
+
+//==============================================================================
+template <typename S>
+bool collisionFunctionForPairCollecting(
+    CollisionObject<S>* o1, CollisionObject<S>* o2, void* cdata_)
+{
+  auto* pairs = static_cast<std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>>*>(cdata_);
+
+  if(o2 < o1)
+    std::swap(o1, o2);
+  EXPECT_TRUE(pairs->emplace(o1, o2).second);
+
+  return false;
+}
+
+//==============================================================================
+template <typename S>
+bool collisionFunctionForPairListing(
+    CollisionObject<S>* o1, CollisionObject<S>* o2, void* cdata_)
+{
+  auto* pairs = static_cast<std::vector<std::pair<CollisionObject<S>*, CollisionObject<S>*>>*>(cdata_);
+  pairs->emplace_back(o1, o2);
+
+  return false;
+}
+
+//==============================================================================
+template <typename S>
+void broad_phase_SaP_incremental_update_test(S env_scale, std::size_t env_size, std::size_t num_frames)
+{
+  std::vector<CollisionObject<S>*> env;
+  test::generateEnvironments(env, env_scale, env_size);
+
+  // One manager is built in bulk and one object by object, since the two
+  // paths set up the end point lists and the overlap pairs differently
+  SaPCollisionManager<S> bulk_manager;
+  SaPCollisionManager<S> incremental_manager;
+  NaiveCollisionManager<S> naive_manager;
+  bulk_manager.registerObjects(env);
+  naive_manager.registerObjects(env);
+  for(std::size_t i = 0; i < env.size(); ++i)
+    incremental_manager.registerObject(env[i]);
+
+  bulk_manager.setup();
+  incremental_manager.setup();
+  naive_manager.setup();
+
+  S delta = env_scale * 0.05;
+  for(std::size_t frame = 0; frame < num_frames; ++frame)
+  {
+    for(std::size_t i = 0; i < env.size(); ++i)
+    {
+      Vector3<S> t(test::rand_interval(-delta, delta),
+                   test::rand_interval(-delta, delta),
+                   test::rand_interval(-delta, delta));
+      env[i]->setTranslation(env[i]->getTranslation() + t);
+      env[i]->computeAABB();
+    }
+
+    // Drop and re-add an object now and then so the swapped in interval ids
+    // get exercised as well
+    if(frame % 3 == 1)
+    {
+      CollisionObject<S>* obj = env[frame % env.size()];
+      bulk_manager.unregisterObject(obj);
+      incremental_manager.unregisterObject(obj);
+      naive_manager.unregisterObject(obj);
+      bulk_manager.registerObject(obj);
+      incremental_manager.registerObject(obj);
+      naive_manager.registerObject(obj);
+    }
+
+    bulk_manager.update();
+    incremental_manager.update();
+    naive_manager.update();
+
+    std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> bulk_pairs;
+    std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> incremental_pairs;
+    std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> naive_pairs;
+    bulk_manager.collide(&bulk_pairs, collisionFunctionForPairCollecting);
+    incremental_manager.collide(&incremental_pairs, collisionFunctionForPairCollecting);
+    naive_manager.collide(&naive_pairs, collisionFunctionForPairCollecting);
+
+    EXPECT_EQ(naive_pairs, bulk_pairs);
+    EXPECT_EQ(naive_pairs, incremental_pairs);
+
+    // the objects have the same ids in both managers, which fix the order of
+    // the pairs however the overlap pairs were built up
+    std::vector<std::pair<CollisionObject<S>*, CollisionObject<S>*>> bulk_list;
+    std::vector<std::pair<CollisionObject<S>*, CollisionObject<S>*>> incremental_list;
+    bulk_manager.collide(&bulk_list, collisionFunctionForPairListing);
+    incremental_manager.collide(&incremental_list, collisionFunctionForPairListing);
+    EXPECT_EQ(bulk_list, incremental_list);
+  }
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+}
+
+//==============================================================================
+template <typename S>
+void overlapEventFunctionForPairTracking(
+    CollisionObject<S>* o1, CollisionObject<S>* o2, bool begin, void* cdata_)
+{
+  auto* pairs = static_cast<std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>>*>(cdata_);
+
+  EXPECT_TRUE(o1 < o2);
+  if(begin)
+    EXPECT_TRUE(pairs->emplace(o1, o2).second);
+  else
+    EXPECT_EQ(pairs->erase(std::make_pair(o1, o2)), 1u);
+}
+
+//==============================================================================
+template <typename S>
+void broad_phase_persistent_pairs_test(S env_scale, std::size_t env_size, std::size_t num_frames)
+{
+  std::vector<CollisionObject<S>*> env;
+  test::generateEnvironments(env, env_scale, env_size);
+
+  // SaP tracks the changed pairs itself, the dynamic AABB tree falls back to
+  // comparing the pairs of each frame
+  std::vector<BroadPhaseCollisionManager<S>*> managers;
+  managers.push_back(new SaPCollisionManager<S>());
+  managers.push_back(new DynamicAABBTreeCollisionManager<S>());
+  NaiveCollisionManager<S> naive_manager;
+
+  for(std::size_t i = 0; i < managers.size(); ++i)
+  {
+    managers[i]->registerObjects(env);
+    managers[i]->setup();
+    EXPECT_FALSE(managers[i]->isPersistentPairsEnabled());
+    managers[i]->enablePersistentPairs(true);
+    EXPECT_TRUE(managers[i]->isPersistentPairsEnabled());
+  }
+  naive_manager.registerObjects(env);
+  naive_manager.setup();
+
+  std::vector<std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>>> tracked_pairs(managers.size());
+
+  S delta = env_scale * 0.05;
+  for(std::size_t frame = 0; frame < num_frames; ++frame)
+  {
+    for(std::size_t i = 0; i < env.size(); ++i)
+    {
+      Vector3<S> t(test::rand_interval(-delta, delta),
+                   test::rand_interval(-delta, delta),
+                   test::rand_interval(-delta, delta));
+      env[i]->setTranslation(env[i]->getTranslation() + t);
+      env[i]->computeAABB();
+    }
+
+    // Unregistering an object ends all its pairs
+    CollisionObject<S>* obj = env[frame % env.size()];
+    if(frame % 3 == 1)
+    {
+      for(std::size_t i = 0; i < managers.size(); ++i)
+        managers[i]->unregisterObject(obj);
+      naive_manager.unregisterObject(obj);
+    }
+
+    for(std::size_t i = 0; i < managers.size(); ++i)
+      managers[i]->update();
+    naive_manager.update();
+
+    std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> naive_pairs;
+    naive_manager.collide(&naive_pairs, collisionFunctionForPairCollecting);
+
+    for(std::size_t i = 0; i < managers.size(); ++i)
+    {
+      managers[i]->collideIncremental(&tracked_pairs[i], overlapEventFunctionForPairTracking);
+      EXPECT_EQ(naive_pairs, tracked_pairs[i]);
+
+      std::vector<std::pair<CollisionObject<S>*, CollisionObject<S>*>> persistent_pairs;
+      managers[i]->getPersistentPairs(persistent_pairs);
+      std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> persistent_set(
+            persistent_pairs.begin(), persistent_pairs.end());
+      EXPECT_EQ(persistent_pairs.size(), persistent_set.size());
+      EXPECT_EQ(naive_pairs, persistent_set);
+
+      // Nothing changes without an update
+      std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> unchanged = tracked_pairs[i];
+      managers[i]->collideIncremental(&tracked_pairs[i], overlapEventFunctionForPairTracking);
+      EXPECT_EQ(unchanged, tracked_pairs[i]);
+    }
+
+    if(frame % 3 == 1)
+    {
+      for(std::size_t i = 0; i < managers.size(); ++i)
+        managers[i]->registerObject(obj);
+      naive_manager.registerObject(obj);
+    }
+  }
+
+  for(std::size_t i = 0; i < managers.size(); ++i)
+  {
+    managers[i]->enablePersistentPairs(false);
+    std::vector<std::pair<CollisionObject<S>*, CollisionObject<S>*>> persistent_pairs;
+    managers[i]->getPersistentPairs(persistent_pairs);
+    EXPECT_TRUE(persistent_pairs.empty());
+    delete managers[i];
+  }
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+}
+
+//==============================================================================
+template <typename S>
+void broad_phase_SSaP_parallel_test(S env_scale, std::size_t env_size, int num_threads)
+{
+  std::vector<CollisionObject<S>*> env;
+  test::generateEnvironments(env, env_scale, env_size);
+
+  SSaPCollisionManager<S> serial_manager;
+  serial_manager.registerObjects(env);
+  serial_manager.setup();
+
+  SSaPCollisionManager<S> parallel_manager;
+  parallel_manager.num_threads = num_threads;
+  parallel_manager.registerObjects(env);
+  parallel_manager.setup();
+
+  std::vector<CollisionObject<S>*> serial_objs;
+  std::vector<CollisionObject<S>*> parallel_objs;
+  serial_manager.getObjects(serial_objs);
+  parallel_manager.getObjects(parallel_objs);
+  EXPECT_EQ(std::set<CollisionObject<S>*>(serial_objs.begin(), serial_objs.end()),
+            std::set<CollisionObject<S>*>(parallel_objs.begin(), parallel_objs.end()));
+
+  std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> serial_pairs;
+  serial_manager.collide(&serial_pairs, collisionFunctionForPairCollecting);
+
+  // Equal lower bounds may be sorted differently, so compare the pairs
+  // regardless of their order
+  std::vector<std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>>> thread_pairs(num_threads);
+  std::vector<void*> cdata;
+  for(auto& pairs : thread_pairs)
+    cdata.push_back(&pairs);
+  parallel_manager.collide(cdata, collisionFunctionForPairCollecting);
+
+  std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> parallel_pairs;
+  std::size_t num_parallel_pairs = 0;
+  for(const auto& pairs : thread_pairs)
+  {
+    parallel_pairs.insert(pairs.begin(), pairs.end());
+    num_parallel_pairs += pairs.size();
+  }
+
+  EXPECT_EQ(num_parallel_pairs, parallel_pairs.size());
+  EXPECT_EQ(serial_pairs, parallel_pairs);
+
+  // With the default num_max_contacts each thread stops at its first contact
+  test::CollisionData<S> serial_data;
+  serial_manager.collide(&serial_data, test::defaultCollisionFunction);
+
+  std::vector<test::CollisionData<S>> parallel_data(num_threads);
+  cdata.clear();
+  for(auto& data : parallel_data)
+    cdata.push_back(&data);
+  parallel_manager.collide(cdata, test::defaultCollisionFunction);
+
+  std::size_t num_parallel_contacts = 0;
+  for(auto& data : parallel_data)
+  {
+    EXPECT_LE(data.result.numContacts(), 1u);
+    num_parallel_contacts += data.result.numContacts();
+  }
+  EXPECT_EQ(serial_data.result.numContacts() > 0, num_parallel_contacts > 0);
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+}
+
+//==============================================================================
+template <typename S>
+void broad_phase_spatial_hash_table_test(S env_scale, std::size_t env_size, std::size_t query_size, std::size_t num_frames, bool use_mesh)
+{
+  std::vector<CollisionObject<S>*> env;
+  if(use_mesh)
+    test::generateEnvironmentsMesh(env, env_scale, env_size);
+  else
+    test::generateEnvironments(env, env_scale, env_size);
+
+  std::vector<CollisionObject<S>*> query;
+  if(use_mesh)
+    test::generateEnvironmentsMesh(query, env_scale, query_size);
+  else
+    test::generateEnvironments(query, env_scale, query_size);
+
+  Vector3<S> lower_limit, upper_limit;
+  SpatialHashingCollisionManager<S>::computeBound(env, lower_limit, upper_limit);
+  S cell_size = std::min(std::min((upper_limit[0] - lower_limit[0]) / 20, (upper_limit[1] - lower_limit[1]) / 20), (upper_limit[2] - lower_limit[2])/20);
+
+  std::vector<std::string> names;
+  std::vector<BroadPhaseCollisionManager<S>*> managers;
+  names.push_back("simple");
+  managers.push_back(new SpatialHashingCollisionManager<S, detail::SimpleHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+  names.push_back("sparse");
+  managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+  names.push_back("flat");
+  managers.push_back(new SpatialHashingCollisionManager<S, detail::FlatHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+
+  // register, update, self collision and query time of each manager
+  std::vector<std::vector<double>> times(managers.size(), std::vector<double>(4, 0));
+  test::Timer timer;
+
+  for(size_t i = 0; i < managers.size(); ++i)
+  {
+    timer.start();
+    managers[i]->registerObjects(env);
+    managers[i]->setup();
+    timer.stop();
+    times[i][0] += timer.getElapsedTime();
+  }
+
+  S delta_trans_max = 0.01 * env_scale;
+  for(size_t frame = 0; frame < num_frames; ++frame)
+  {
+    for(size_t i = 0; i < env.size(); ++i)
+    {
+      Vector3<S> dT(test::rand_interval(-delta_trans_max, delta_trans_max),
+                    test::rand_interval(-delta_trans_max, delta_trans_max),
+                    test::rand_interval(-delta_trans_max, delta_trans_max));
+      env[i]->setTranslation(env[i]->getTranslation() + dT);
+      env[i]->computeAABB();
+    }
+
+    for(size_t i = 0; i < managers.size(); ++i)
+    {
+      timer.start();
+      managers[i]->update();
+      timer.stop();
+      times[i][1] += timer.getElapsedTime();
+    }
+
+    std::vector<test::CollisionData<S>> self_data(managers.size());
+    for(size_t i = 0; i < managers.size(); ++i)
+    {
+      self_data[i].request.num_max_contacts = 100000;
+      timer.start();
+      managers[i]->collide(&self_data[i], test::defaultCollisionFunction);
+      timer.stop();
+      times[i][2] += timer.getElapsedTime();
+    }
+
+    for(size_t i = 1; i < managers.size(); ++i)
+      EXPECT_EQ(self_data[i].result.numContacts(), self_data[0].result.numContacts());
+
+    for(size_t j = 0; j < query.size(); ++j)
+    {
+      std::vector<test::CollisionData<S>> query_data(managers.size());
+      for(size_t i = 0; i < managers.size(); ++i)
+      {
+        query_data[i].request.num_max_contacts = 100000;
+        timer.start();
+        managers[i]->collide(query[j], &query_data[i], test::defaultCollisionFunction);
+        timer.stop();
+        times[i][3] += timer.getElapsedTime();
+      }
+
+      for(size_t i = 1; i < managers.size(); ++i)
+        EXPECT_EQ(query_data[i].result.numContacts(), query_data[0].result.numContacts());
+    }
+  }
+
+  std::cout.setf(std::ios_base::left, std::ios_base::adjustfield);
+  size_t w = 10;
+
+  std::cout << "spatial hash table timing summary" << std::endl;
+  std::cout << env_size << " objs, " << query_size << " queries, " << num_frames << " frames" << std::endl;
+  std::cout << std::setw(w) << "table" << std::setw(w) << "register" << std::setw(w) << "update"
+            << std::setw(w) << "self" << std::setw(w) << "query" << std::endl;
+  for(size_t i = 0; i < managers.size(); ++i)
+  {
+    std::cout << std::setw(w) << names[i];
+    for(size_t j = 0; j < times[i].size(); ++j)
+      std::cout << std::setw(w) << times[i][j];
+    std::cout << std::endl;
+  }
+  std::cout << std::endl;
+
+  for(size_t i = 0; i < managers.size(); ++i)
+    delete managers[i];
+
+  for(size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+
+  for(size_t i = 0; i < query.size(); ++i)
+    delete query[i];
+}
+
+//==============================================================================
+template <typename S>
+void generateBoxesOfSize(std::vector<CollisionObject<S>*>& env, S env_scale, S min_size, S max_size, std::size_t n)
+{
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    auto box = std::make_shared<Box<S>>(test::rand_interval(min_size, max_size),
+                                        test::rand_interval(min_size, max_size),
+                                        test::rand_interval(min_size, max_size));
+    env.push_back(new CollisionObject<S>(box));
+    env.back()->setTranslation(Vector3<S>(test::rand_interval(-env_scale, env_scale),
+                                          test::rand_interval(-env_scale, env_scale),
+                                          test::rand_interval(-env_scale, env_scale)));
+    env.back()->computeAABB();
+  }
+}
+
+//==============================================================================
+template <typename S>
+void broad_phase_hierarchical_spatial_hash_test(S env_scale, std::size_t env_size, std::size_t num_frames)
+{
+  // mostly small boxes, with a few that span a large part of the scene
+  std::vector<CollisionObject<S>*> env;
+  generateBoxesOfSize(env, env_scale, env_scale * 0.001, env_scale * 0.01, env_size);
+  generateBoxesOfSize(env, env_scale, env_scale * 0.1, env_scale, env_size / 100 + 1);
+
+  HierarchicalSpatialHashingCollisionManager<S> manager;
+  NaiveCollisionManager<S> naive_manager;
+  manager.registerObjects(env);
+  naive_manager.registerObjects(env);
+  manager.setup();
+  naive_manager.setup();
+
+  EXPECT_GT(manager.numLevels(), 1u);
+  const S min_cell_size = manager.cellSize(0);
+
+  S delta = env_scale * 0.01;
+  for(std::size_t frame = 0; frame < num_frames; ++frame)
+  {
+    // move all the objects, or a few ones updated one by one
+    std::size_t step = (frame % 2 == 0) ? 1 : 10;
+    for(std::size_t i = 0; i < env.size(); i += step)
+    {
+      Vector3<S> t(test::rand_interval(-delta, delta),
+                   test::rand_interval(-delta, delta),
+                   test::rand_interval(-delta, delta));
+      env[i]->setTranslation(env[i]->getTranslation() + t);
+      env[i]->computeAABB();
+
+      if(step > 1)
+        manager.update(env[i]);
+    }
+
+    if(step == 1)
+      manager.update();
+    naive_manager.update();
+
+    std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> pairs;
+    std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> naive_pairs;
+    manager.collide(&pairs, collisionFunctionForPairCollecting);
+    naive_manager.collide(&naive_pairs, collisionFunctionForPairCollecting);
+    EXPECT_EQ(naive_pairs, pairs);
+  }
+
+  // replace the small boxes by large ones; update() has to pick coarser cells
+  std::vector<CollisionObject<S>*> drifted_env;
+  generateBoxesOfSize(drifted_env, env_scale, env_scale * 0.05, env_scale * 0.1, env_size / 10 + 1);
+  for(std::size_t i = 0; i < env_size; ++i)
+  {
+    manager.unregisterObject(env[i]);
+    naive_manager.unregisterObject(env[i]);
+  }
+  manager.registerObjects(drifted_env);
+  naive_manager.registerObjects(drifted_env);
+  manager.update();
+  naive_manager.update();
+
+  EXPECT_GT(manager.cellSize(0), min_cell_size * manager.rebuild_ratio);
+
+  std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> pairs;
+  std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> naive_pairs;
+  manager.collide(&pairs, collisionFunctionForPairCollecting);
+  naive_manager.collide(&naive_pairs, collisionFunctionForPairCollecting);
+  EXPECT_EQ(naive_pairs, pairs);
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+
+  for(std::size_t i = 0; i < drifted_env.size(); ++i)
+    delete drifted_env[i];
+}
+
+//==============================================================================
+template <typename S>
+void broad_phase_AABB_tree_array_parallel_update_test(S env_scale, std::size_t env_size, std::size_t num_frames, int num_threads)
+{
+  std::vector<CollisionObject<S>*> env;
+  test::generateEnvironments(env, env_scale, env_size);
+
+  DynamicAABBTreeCollisionManager_Array<S> manager;
+  manager.parallel_update = true;
+  manager.num_threads = num_threads;
+  NaiveCollisionManager<S> naive_manager;
+  manager.registerObjects(env);
+  naive_manager.registerObjects(env);
+  manager.setup();
+  naive_manager.setup();
+
+  S delta = env_scale * 0.01;
+  for(std::size_t frame = 0; frame < num_frames; ++frame)
+  {
+    for(std::size_t i = 0; i < env.size(); ++i)
+    {
+      Vector3<S> t(test::rand_interval(-delta, delta),
+                   test::rand_interval(-delta, delta),
+                   test::rand_interval(-delta, delta));
+      env[i]->setTranslation(env[i]->getTranslation() + t);
+      env[i]->computeAABB();
+    }
+
+    manager.update();
+    naive_manager.update();
+
+    EXPECT_LE(manager.getSAHCostAfterUpdate(), manager.getSAHCostBeforeUpdate());
+    EXPECT_NEAR(manager.getSAHCostAfterUpdate(), manager.getTree().getSAHCost(),
+                manager.getSAHCostAfterUpdate() * 1e-9);
+
+    std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> pairs;
+    std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> naive_pairs;
+    manager.collide(&pairs, collisionFunctionForPairCollecting);
+    naive_manager.collide(&naive_pairs, collisionFunctionForPairCollecting);
+    EXPECT_EQ(naive_pairs, pairs);
+  }
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+}
+
+//==============================================================================
+template <typename S>
+void broad_phase_fat_AABB_test(S env_scale, std::size_t env_size, std::size_t num_frames)
+{
+  std::vector<CollisionObject<S>*> env;
+  test::generateEnvironments(env, env_scale, env_size);
+
+  // every third object drifts steadily and gets a velocity hint, the others
+  // only jitter within the margin most of the time
+  S margin = env_scale * 0.01;
+  std::vector<Vector3<S>> drift(env.size(), Vector3<S>::Zero());
+  for(std::size_t i = 0; i < env.size(); i += 3)
+    drift[i] = Vector3<S>(margin, 0, -margin);
+
+  DynamicAABBTreeCollisionManager<S> tree_manager;
+  DynamicAABBTreeCollisionManager_Array<S> array_manager;
+  DynamicAABBTreeCollisionManager_Array<S> parallel_manager;
+  NaiveCollisionManager<S> naive_manager;
+  tree_manager.fat_aabb_margin = margin;
+  array_manager.fat_aabb_margin = margin;
+  parallel_manager.fat_aabb_margin = margin;
+  parallel_manager.parallel_update = true;
+  parallel_manager.num_threads = 4;
+
+  std::vector<BroadPhaseCollisionManager<S>*> managers
+      = {&tree_manager, &array_manager, &parallel_manager};
+  for(auto manager : managers)
+  {
+    manager->registerObjects(env);
+    manager->setup();
+  }
+  naive_manager.registerObjects(env);
+  naive_manager.setup();
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+  {
+    tree_manager.setVelocityHint(env[i], drift[i]);
+    array_manager.setVelocityHint(env[i], drift[i]);
+    parallel_manager.setVelocityHint(env[i], drift[i]);
+  }
+
+  S jitter = margin * 0.5;
+  for(std::size_t frame = 0; frame < num_frames; ++frame)
+  {
+    for(std::size_t i = 0; i < env.size(); ++i)
+    {
+      Vector3<S> t(test::rand_interval(-jitter, jitter),
+                   test::rand_interval(-jitter, jitter),
+                   test::rand_interval(-jitter, jitter));
+      env[i]->setTranslation(env[i]->getTranslation() + drift[i] + t);
+      env[i]->computeAABB();
+    }
+
+    // the tree managers alternate between whole and per object updates
+    if(frame % 2 == 0)
+    {
+      tree_manager.update();
+      array_manager.update();
+    }
+    else
+    {
+      tree_manager.update(env);
+      array_manager.update(env);
+    }
+    parallel_manager.update();
+    naive_manager.update();
+
+    std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> naive_pairs;
+    naive_manager.collide(&naive_pairs, collisionFunctionForPairCollecting);
+    for(auto manager : managers)
+    {
+      std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> pairs;
+      manager->collide(&pairs, collisionFunctionForPairCollecting);
+      EXPECT_EQ(naive_pairs, pairs);
+    }
+  }
+
+  // without a margin or velocity hints the leaves shrink with the objects
+  auto box = std::make_shared<Box<S>>(margin, margin, margin);
+  CollisionObject<S> shrinking(box);
+  shrinking.computeAABB();
+  DynamicAABBTreeCollisionManager<S> tight_tree_manager;
+  DynamicAABBTreeCollisionManager_Array<S> tight_array_manager;
+  tight_tree_manager.registerObject(&shrinking);
+  tight_tree_manager.setup();
+  tight_array_manager.registerObject(&shrinking);
+  tight_array_manager.setup();
+
+  box->side *= 0.5;
+  box->computeLocalAABB();
+  shrinking.computeAABB();
+  tight_tree_manager.update(&shrinking);
+  tight_array_manager.update(&shrinking);
+  EXPECT_TRUE(tight_tree_manager.getTree().getRoot()->bv.equal(shrinking.getAABB()));
+  const auto& array_tree = tight_array_manager.getTree();
+  EXPECT_TRUE(array_tree.getNodes()[array_tree.getRoot()].bv.equal(shrinking.getAABB()));
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+}
+
+//==============================================================================
+template <typename S>
+void broad_phase_cross_manager_collide_test(S env_scale, std::size_t env_size)
+{
+  std::vector<CollisionObject<S>*> env1, env2;
+  test::generateEnvironments(env1, env_scale, env_size);
+  test::generateEnvironments(env2, env_scale, env_size);
+
+  std::vector<CollisionObject<S>*> env(env1);
+  env.insert(env.end(), env2.begin(), env2.end());
+  Vector3<S> lower_limit, upper_limit;
+  SpatialHashingCollisionManager<S>::computeBound(env, lower_limit, upper_limit);
+  S cell_size = std::min(std::min((upper_limit[0] - lower_limit[0]) / 20, (upper_limit[1] - lower_limit[1]) / 20), (upper_limit[2] - lower_limit[2])/20);
+
+  auto createManagers = [&](const std::vector<CollisionObject<S>*>& objs)
+  {
+    std::vector<BroadPhaseCollisionManager<S>*> managers;
+    managers.push_back(new NaiveCollisionManager<S>());
+    managers.push_back(new SSaPCollisionManager<S>());
+    managers.push_back(new SaPCollisionManager<S>());
+    managers.push_back(new IntervalTreeCollisionManager<S>());
+    managers.push_back(new SpatialHashingCollisionManager<S, detail::FlatHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+    managers.push_back(new HierarchicalSpatialHashingCollisionManager<S>());
+    managers.push_back(new DynamicAABBTreeCollisionManager<S>());
+    managers.push_back(new DynamicAABBTreeCollisionManager_Array<S>());
+    for(auto manager : managers)
+    {
+      manager->registerObjects(objs);
+      manager->setup();
+    }
+    return managers;
+  };
+  std::vector<BroadPhaseCollisionManager<S>*> managers1 = createManagers(env1);
+  std::vector<BroadPhaseCollisionManager<S>*> managers2 = createManagers(env2);
+
+  std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> expected_pairs;
+  for(auto obj1 : env1)
+  {
+    for(auto obj2 : env2)
+    {
+      if(obj1->getAABB().overlap(obj2->getAABB()))
+        expected_pairs.emplace(std::min(obj1, obj2), std::max(obj1, obj2));
+    }
+  }
+
+  for(std::size_t i = 0; i < managers1.size(); ++i)
+  {
+    for(std::size_t j = 0; j < managers2.size(); ++j)
+    {
+      if(i == j) continue;
+
+      std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> pairs;
+      managers1[i]->collide(managers2[j], &pairs, collisionFunctionForPairCollecting);
+      EXPECT_EQ(expected_pairs, pairs);
+    }
+  }
+
+  for(std::size_t i = 0; i < managers1.size(); ++i)
+  {
+    delete managers1[i];
+    delete managers2[i];
+  }
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+}
+
+//==============================================================================
+template <typename S>
+bool distanceFunctionForAABBDistance(
+    CollisionObject<S>* o1, CollisionObject<S>* o2, void* cdata_, S& dist)
+{
+  auto* min_dist = static_cast<S*>(cdata_);
+  *min_dist = std::min(*min_dist, o1->getAABB().distance(o2->getAABB()));
+  dist = *min_dist;
+
+  return false;
+}
+
+//==============================================================================
+template <typename S>
+void broad_phase_concurrent_query_test(S env_scale, std::size_t env_size, std::size_t query_size, int num_threads)
+{
+  std::vector<CollisionObject<S>*> env;
+  test::generateEnvironments(env, env_scale, env_size);
+
+  std::vector<CollisionObject<S>*> query;
+  test::generateEnvironments(query, env_scale, query_size);
+
+  Vector3<S> lower_limit, upper_limit;
+  SpatialHashingCollisionManager<S>::computeBound(env, lower_limit, upper_limit);
+  S cell_size = std::min(std::min((upper_limit[0] - lower_limit[0]) / 20, (upper_limit[1] - lower_limit[1]) / 20), (upper_limit[2] - lower_limit[2])/20);
+
+  std::vector<BroadPhaseCollisionManager<S>*> managers;
+  managers.push_back(new NaiveCollisionManager<S>());
+  managers.push_back(new SSaPCollisionManager<S>());
+  managers.push_back(new SaPCollisionManager<S>());
+  managers.push_back(new IntervalTreeCollisionManager<S>());
+  managers.push_back(new SpatialHashingCollisionManager<S, detail::FlatHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+  managers.push_back(new HierarchicalSpatialHashingCollisionManager<S>());
+  managers.push_back(new DynamicAABBTreeCollisionManager<S>());
+  managers.push_back(new DynamicAABBTreeCollisionManager_Array<S>());
+
+  // a collision and a distance query per query object, and a self distance
+  // per thread
+  const std::size_t num_tasks = 2 * query.size() + num_threads;
+  using PairSet = std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>>;
+  auto runTask = [&](const BroadPhaseCollisionManager<S>* manager, std::size_t task, PairSet& pairs, S& min_dist)
+  {
+    min_dist = std::numeric_limits<S>::max();
+    if(task >= 2 * query.size())
+      manager->distance(&min_dist, distanceFunctionForAABBDistance);
+    else if(task % 2 == 0)
+      manager->collide(query[task / 2], &pairs, collisionFunctionForPairCollecting);
+    else
+      manager->distance(query[task / 2], &min_dist, distanceFunctionForAABBDistance);
+  };
+
+  for(auto manager : managers)
+  {
+    manager->registerObjects(env);
+    manager->setup();
+
+    std::vector<PairSet> serial_pairs(num_tasks), parallel_pairs(num_tasks);
+    std::vector<S> serial_dists(num_tasks), parallel_dists(num_tasks);
+    for(std::size_t i = 0; i < num_tasks; ++i)
+      runTask(manager, i, serial_pairs[i], serial_dists[i]);
+
+    detail::parallelFor(num_tasks, num_threads, [&](std::size_t i, int)
+    {
+      runTask(manager, i, parallel_pairs[i], parallel_dists[i]);
+    });
+
+    for(std::size_t i = 0; i < num_tasks; ++i)
+    {
+      EXPECT_EQ(serial_pairs[i], parallel_pairs[i]);
+      EXPECT_EQ(serial_dists[i], parallel_dists[i]);
+    }
+  }
+
+  for(auto manager : managers)
+    delete manager;
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+
+  for(std::size_t i = 0; i < query.size(); ++i)
+    delete query[i];
+}
+
+//==============================================================================
+template <typename S>
+void broad_phase_snapshots_test(S env_scale, std::size_t env_size, std::size_t num_frames, int num_threads)
+{
+  std::vector<CollisionObject<S>*> env;
+  test::generateEnvironments(env, env_scale, env_size);
+
+  BroadPhaseSnapshots<S> snapshots([]()
+  {
+    return new DynamicAABBTreeCollisionManager<S>();
+  });
+  EXPECT_TRUE(snapshots.acquire() == nullptr);
+
+  // the first task writes, the others read until the writer is done
+  std::atomic<bool> done(false);
+  std::atomic<std::size_t> num_reads(0);
+  detail::parallelFor(num_threads, num_threads, [&](std::size_t task, int)
+  {
+    if(task == 0)
+    {
+      for(std::size_t frame = 0; frame < num_frames; ++frame)
+      {
+        for(auto obj : env)
+        {
+          obj->setTranslation(obj->getTranslation() + Vector3<S>(env_scale * 0.01, 0, 0));
+          obj->computeAABB();
+        }
+        snapshots.publish(env);
+      }
+      done = true;
+      return;
+    }
+
+    while(!done || num_reads == 0)
+    {
+      auto manager = snapshots.acquire();
+      if(!manager)
+        continue;
+
+      std::vector<CollisionObject<S>*> objs;
+      manager->getObjects(objs);
+      EXPECT_EQ(env.size(), objs.size());
+
+      std::set<std::pair<CollisionObject<S>*, CollisionObject<S>*>> pairs, expected_pairs;
+      manager->collide(&pairs, collisionFunctionForPairCollecting);
+      for(std::size_t i = 0; i < objs.size(); ++i)
+      {
+        for(std::size_t j = i + 1; j < objs.size(); ++j)
+        {
+          if(objs[i]->getAABB().overlap(objs[j]->getAABB()))
+            expected_pairs.emplace(std::min(objs[i], objs[j]), std::max(objs[i], objs[j]));
+        }
+      }
+      EXPECT_EQ(expected_pairs, pairs);
+      ++num_reads;
+    }
+  });
+
+  EXPECT_EQ(num_frames, snapshots.getEpoch());
+  EXPECT_GT(num_reads.load(), 0u);
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
@@ -40,12 +40,14 @@
 #include "fcl/config.h"
 #include "fcl/broadphase/broadphase_bruteforce.h"
 #include "fcl/broadphase/broadphase_spatialhash.h"
+#include "fcl/broadphase/broadphase_hierarchical_spatialhash.h"
 #include "fcl/broadphase/broadphase_SaP.h"
 #include "fcl/broadphase/broadphase_SSaP.h"
 #include "fcl/broadphase/broadphase_interval_tree.h"
 #include "fcl/broadphase/broadphase_dynamic_AABB_tree.h"
 #include "fcl/broadphase/broadphase_dynamic_AABB_tree_array.h"
 #include "fcl/broadphase/detail/sparse_hash_table.h"
+#include "fcl/broadphase/detail/flat_hash_table.h"
 #include "fcl/broadphase/detail/spatial_hash.h"
 #include "fcl/object/geometry/shape/geometric_shape_to_BVH_model.h"
 #include "test_fcl_utility.h"
@@ -77,6 +79,15 @@ void broad_phase_distance_test(S env_scale, std::size_t env_size, std::size_t qu
 template <typename S>
 void broad_phase_self_distance_test(S env_scale, std::size_t env_size, bool use_mesh = false);
 
+/// @brief test for broad phase nearest neighbor and radius queries
+template <typename S>
+void broad_phase_nearest_test(S env_scale, std::size_t env_size, std::size_t query_size, std::size_t k, S radius);
+
+/// @brief test the batched nearest neighbor and radius queries for a single
+/// query and for queries whose centers lie on a common plane
+template <typename S>
+void broad_phase_nearest_flat_test(S env_scale, std::size_t env_size, std::size_t query_size, std::size_t k, S radius);
+
 template <typename S>
 S getDELTA() { return 0.01; }
 
@@ -124,6 +135,28 @@ GTEST_TEST(FCL_BROADPHASE, test_core_bf_broad_phase_self_distance)
 #endif
 }
 
+/// check broad phase nearest neighbor and radius queries
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_nearest)
+{
+#ifdef NDEBUG
+  broad_phase_nearest_test<double>(200, 1000, 100, 10, 20);
+  broad_phase_nearest_test<double>(2000, 1000, 100, 1, 200);
+#else
+  broad_phase_nearest_test<double>(200, 100, 10, 10, 20);
+  broad_phase_nearest_test<double>(2000, 100, 10, 1, 200);
+#endif
+}
+
+/// check the batched nearest neighbor and radius queries on flat query sets
+GTEST_TEST(FCL_BROADPHASE, test_core_broad_phase_nearest_flat)
+{
+#ifdef NDEBUG
+  broad_phase_nearest_flat_test<double>(200, 1000, 100, 10, 20);
+#else
+  broad_phase_nearest_flat_test<double>(200, 100, 10, 10, 20);
+#endif
+}
+
 /// check broad phase distance
 GTEST_TEST(FCL_BROADPHASE, test_core_mesh_bf_broad_phase_distance_mesh)
 {
@@ -340,6 +373,8 @@ void broad_phase_self_distance_test(S env_scale, std::size_t env_size, bool use_
   S cell_size = std::min(std::min((upper_limit[0] - lower_limit[0]) / 5, (upper_limit[1] - lower_limit[1]) / 5), (upper_limit[2] - lower_limit[2]) / 5);
   // managers.push_back(new SpatialHashingCollisionManager<S>(cell_size, lower_limit, upper_limit));
   managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+  managers.push_back(new SpatialHashingCollisionManager<S, detail::FlatHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+  managers.push_back(new HierarchicalSpatialHashingCollisionManager<S>());
 #if USE_GOOGLEHASH
   managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>, GoogleSparseHashTable> >(cell_size, lower_limit, upper_limit));
   managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>, GoogleDenseHashTable> >(cell_size, lower_limit, upper_limit));
@@ -483,6 +518,8 @@ void broad_phase_distance_test(S env_scale, std::size_t env_size, std::size_t qu
   S cell_size = std::min(std::min((upper_limit[0] - lower_limit[0]) / 20, (upper_limit[1] - lower_limit[1]) / 20), (upper_limit[2] - lower_limit[2])/20);
   // managers.push_back(new SpatialHashingCollisionManager<S>(cell_size, lower_limit, upper_limit));
   managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+  managers.push_back(new SpatialHashingCollisionManager<S, detail::FlatHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>> >(cell_size, lower_limit, upper_limit));
+  managers.push_back(new HierarchicalSpatialHashingCollisionManager<S>());
 #if USE_GOOGLEHASH
   managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>, GoogleSparseHashTable> >(cell_size, lower_limit, upper_limit));
   managers.push_back(new SpatialHashingCollisionManager<S, detail::SparseHashTable<AABB<S>, CollisionObject<S>*, detail::SpatialHash<S>, GoogleDenseHashTable> >(cell_size, lower_limit, upper_limit));
@@ -582,6 +619,199 @@ void broad_phase_distance_test(S env_scale, std::size_t env_size, std::size_t qu
   std::cout << std::endl;
 }
 
+//==============================================================================
+template <typename S>
+S nearestDistanceFunction(CollisionObject<S>* o1, CollisionObject<S>* o2, void* cdata)
+{
+  // the centers lie in the AABBs, so they are not nearer than the AABBs
+  return (o1->getAABB().center() - o2->getAABB().center()).norm();
+}
+
+//==============================================================================
+template <typename S>
+void broad_phase_nearest_test(S env_scale, std::size_t env_size, std::size_t query_size, std::size_t k, S radius)
+{
+  std::vector<CollisionObject<S>*> env;
+  test::generateEnvironments(env, env_scale, env_size);
+
+  // some of the queries are objects of the managers, which must not find
+  // themselves
+  std::vector<CollisionObject<S>*> query;
+  test::generateEnvironments(query, env_scale, query_size);
+  std::vector<CollisionObject<S>*> queries(query);
+  for(std::size_t i = 0; i < query_size; ++i)
+    queries.push_back(env[i]);
+
+  std::vector<BroadPhaseCollisionManager<S>*> managers;
+  managers.push_back(new NaiveCollisionManager<S>());
+  managers.push_back(new SaPCollisionManager<S>());
+  managers.push_back(new IntervalTreeCollisionManager<S>());
+  managers.push_back(new DynamicAABBTreeCollisionManager<S>());
+  managers.push_back(new DynamicAABBTreeCollisionManager_Array<S>());
+  for(auto manager : managers)
+  {
+    manager->registerObjects(env);
+    manager->setup();
+  }
+
+  using Neighbor = typename BroadPhaseCollisionManager<S>::Neighbor;
+  auto distances = [](const std::vector<Neighbor>& neighbors)
+  {
+    std::vector<S> dists;
+    for(const auto& neighbor : neighbors)
+      dists.push_back(neighbor.first);
+    return dists;
+  };
+
+  // the second round checks the managers after updating the objects one by
+  // one
+  for(int round = 0; round < 2; ++round)
+  {
+    if(round == 1)
+    {
+      for(auto obj : env)
+      {
+        obj->setTranslation(obj->getTranslation() + Vector3<S>(env_scale * 0.05, -env_scale * 0.05, 0));
+        obj->computeAABB();
+        for(auto manager : managers)
+          manager->update(obj);
+      }
+    }
+
+    for(ObjectDistanceCallBack<S> callback : {static_cast<ObjectDistanceCallBack<S>>(nullptr), nearestDistanceFunction<S>})
+    {
+      std::vector<std::vector<S>> nearest_dists(queries.size()), radius_dists(queries.size());
+      for(std::size_t i = 0; i < queries.size(); ++i)
+      {
+        std::vector<S> dists;
+        for(auto obj : env)
+        {
+          if(obj == queries[i]) continue;
+          dists.push_back(callback ? callback(queries[i], obj, nullptr)
+                                   : queries[i]->getAABB().distance(obj->getAABB()));
+        }
+        std::sort(dists.begin(), dists.end());
+
+        nearest_dists[i].assign(dists.begin(), dists.begin() + std::min(k, dists.size()));
+        radius_dists[i].assign(dists.begin(), std::upper_bound(dists.begin(), dists.end(), radius));
+      }
+
+      for(auto manager : managers)
+      {
+        std::vector<Neighbor> neighbors;
+        for(std::size_t i = 0; i < queries.size(); ++i)
+        {
+          manager->nearest(queries[i], k, neighbors, nullptr, callback);
+          EXPECT_EQ(nearest_dists[i], distances(neighbors));
+          manager->withinRadius(queries[i], radius, neighbors, nullptr, callback);
+          EXPECT_EQ(radius_dists[i], distances(neighbors));
+        }
+
+        for(int num_threads : {1, 4})
+        {
+          std::vector<std::vector<Neighbor>> batch_neighbors;
+          manager->nearest(queries, k, batch_neighbors, nullptr, callback, num_threads);
+          GTEST_ASSERT_EQ(queries.size(), batch_neighbors.size());
+          for(std::size_t i = 0; i < queries.size(); ++i)
+            EXPECT_EQ(nearest_dists[i], distances(batch_neighbors[i]));
+
+          manager->withinRadius(queries, radius, batch_neighbors, nullptr, callback, num_threads);
+          GTEST_ASSERT_EQ(queries.size(), batch_neighbors.size());
+          for(std::size_t i = 0; i < queries.size(); ++i)
+            EXPECT_EQ(radius_dists[i], distances(batch_neighbors[i]));
+        }
+      }
+    }
+  }
+
+  for(auto manager : managers)
+    delete manager;
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+
+  for(std::size_t i = 0; i < query.size(); ++i)
+    delete query[i];
+}
+
+//==============================================================================
+template <typename S>
+void broad_phase_nearest_flat_test(S env_scale, std::size_t env_size, std::size_t query_size, std::size_t k, S radius)
+{
+  std::vector<CollisionObject<S>*> env;
+  test::generateEnvironments(env, env_scale, env_size);
+
+  // the Morton order of the batched queries is taken over the bound of their
+  // centers, which is flat along z here, and along every axis for one query
+  auto sphere = std::make_shared<Sphere<S>>(env_scale * 0.01);
+  std::vector<CollisionObject<S>*> query;
+  for(std::size_t i = 0; i < query_size; ++i)
+  {
+    Transform3<S> tf = Transform3<S>::Identity();
+    tf.translation() = Vector3<S>(test::rand_interval(-env_scale, env_scale),
+                                  test::rand_interval(-env_scale, env_scale),
+                                  0);
+    query.push_back(new CollisionObject<S>(sphere, tf));
+  }
+  const std::vector<std::vector<CollisionObject<S>*>> query_sets
+      = {{query[0]}, query};
+
+  std::vector<BroadPhaseCollisionManager<S>*> managers;
+  managers.push_back(new NaiveCollisionManager<S>());
+  managers.push_back(new DynamicAABBTreeCollisionManager<S>());
+  managers.push_back(new DynamicAABBTreeCollisionManager_Array<S>());
+  for(auto manager : managers)
+  {
+    manager->registerObjects(env);
+    manager->setup();
+  }
+
+  using Neighbor = typename BroadPhaseCollisionManager<S>::Neighbor;
+  auto distances = [](const std::vector<Neighbor>& neighbors)
+  {
+    std::vector<S> dists;
+    for(const auto& neighbor : neighbors)
+      dists.push_back(neighbor.first);
+    return dists;
+  };
+
+  for(auto manager : managers)
+  {
+    for(const auto& queries : query_sets)
+    {
+      for(int num_threads : {1, 4})
+      {
+        std::vector<Neighbor> neighbors;
+        std::vector<std::vector<Neighbor>> batch_neighbors;
+        manager->nearest(queries, k, batch_neighbors, nullptr, nullptr, num_threads);
+        GTEST_ASSERT_EQ(queries.size(), batch_neighbors.size());
+        for(std::size_t i = 0; i < queries.size(); ++i)
+        {
+          manager->nearest(queries[i], k, neighbors);
+          EXPECT_EQ(distances(neighbors), distances(batch_neighbors[i]));
+        }
+
+        manager->withinRadius(queries, radius, batch_neighbors, nullptr, nullptr, num_threads);
+        GTEST_ASSERT_EQ(queries.size(), batch_neighbors.size());
+        for(std::size_t i = 0; i < queries.size(); ++i)
+        {
+          manager->withinRadius(queries[i], radius, neighbors);
+          EXPECT_EQ(distances(neighbors), distances(batch_neighbors[i]));
+        }
+      }
+    }
+  }
+
+  for(auto manager : managers)
+    delete manager;
+
+  for(std::size_t i = 0; i < env.size(); ++i)
+    delete env[i];
+
+  for(std::size_t i = 0; i < query.size(); ++i)
+    delete query[i];
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
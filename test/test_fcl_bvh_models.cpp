@@ -38,9 +38,14 @@
 
 #include "fcl/config.h"
 #include "fcl/object/geometry/bvh/BVH_model.h"
+#include "fcl/object/geometry/bvh/BVH_serialization.h"
 #include "fcl/object/geometry/shape/geometric_shapes.h"
 #include "test_fcl_utility.h"
+#include "fcl_resources/config.h"
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <sstream>
 
 using namespace fcl;
 
@@ -235,6 +240,345 @@ GTEST_TEST(FCL_BVH_MODELS, building_bvh_models)
   testBVHModel<KDOP<double, 24> >();
 }
 
+template<typename BV>
+void testBVHModelParallelBuild(detail::SplitMethodType split_method)
+{
+  using S = typename BV::S;
+
+  std::vector<Vector3<S>> points;
+  std::vector<Triangle> tri_indices;
+  test::loadOBJFile(TEST_RESOURCES_DIR"/env.obj", points, tri_indices);
+
+  BVHModel<BV> expected;
+  expected.bv_splitter.reset(new detail::BVSplitter<BV>(split_method));
+  expected.beginModel();
+  expected.addSubModel(points, tri_indices);
+  expected.endModel();
+
+  for(int num_threads : {2, 4, 0})
+  {
+    BVHModel<BV> model;
+    model.bv_splitter.reset(new detail::BVSplitter<BV>(split_method));
+    model.num_build_threads = num_threads;
+
+    EXPECT_EQ(model.beginModel(), BVH_OK);
+    EXPECT_EQ(model.addSubModel(points, tri_indices), BVH_OK);
+    EXPECT_EQ(model.endModel(), BVH_OK);
+
+    // the hierarchy must not depend on the number of threads
+    GTEST_ASSERT_EQ(model.getNumBVs(), expected.getNumBVs());
+    for(int i = 0; i < model.getNumBVs(); ++i)
+    {
+      const BVNode<BV>& node = model.getBV(i);
+      const BVNode<BV>& expected_node = expected.getBV(i);
+      EXPECT_EQ(node.first_child, expected_node.first_child);
+      EXPECT_EQ(node.first_primitive, expected_node.first_primitive);
+      EXPECT_EQ(node.num_primitives, expected_node.num_primitives);
+      EXPECT_EQ(std::memcmp(&node.bv, &expected_node.bv, sizeof(BV)), 0);
+    }
+  }
+}
+
+GTEST_TEST(FCL_BVH_MODELS, parallel_build)
+{
+  testBVHModelParallelBuild<AABB<double>>(detail::SPLIT_METHOD_MEAN);
+  testBVHModelParallelBuild<OBB<double>>(detail::SPLIT_METHOD_MEDIAN);
+  testBVHModelParallelBuild<RSS<double>>(detail::SPLIT_METHOD_BV_CENTER);
+  testBVHModelParallelBuild<OBBRSS<double>>(detail::SPLIT_METHOD_MEAN);
+  testBVHModelParallelBuild<OBBRSS<double>>(detail::SPLIT_METHOD_SAH);
+}
+
+template<typename BV>
+void testBVHModelLinearBuild(bool pointcloud)
+{
+  using S = typename BV::S;
+
+  std::vector<Vector3<S>> points;
+  std::vector<Triangle> tri_indices;
+  test::loadOBJFile(TEST_RESOURCES_DIR"/env.obj", points, tri_indices);
+
+  BVHModel<BV> model;
+  model.build_method = BVH_BUILD_METHOD_LINEAR;
+
+  EXPECT_EQ(model.beginModel(), BVH_OK);
+  if(pointcloud)
+    EXPECT_EQ(model.addSubModel(points), BVH_OK);
+  else
+    EXPECT_EQ(model.addSubModel(points, tri_indices), BVH_OK);
+  EXPECT_EQ(model.endModel(), BVH_OK);
+
+  // move the vertices and rebuild from scratch, as for a deforming mesh
+  std::vector<Vector3<S>> moved_points(points);
+  for(Vector3<S>& p : moved_points)
+    p *= 0.5;
+
+  EXPECT_EQ(model.beginUpdateModel(), BVH_OK);
+  EXPECT_EQ(model.updateSubModel(moved_points), BVH_OK);
+  EXPECT_EQ(model.endUpdateModel(false, false), BVH_OK);
+
+  const int num_primitives = pointcloud ? model.num_vertices : model.num_tris;
+  GTEST_ASSERT_EQ(model.getNumBVs(), 2 * num_primitives - 1);
+
+  // every primitive is in exactly one leaf and every node covers the
+  // primitives of its two children
+  std::vector<int> num_leaves(num_primitives, 0);
+  for(int i = 0; i < model.getNumBVs(); ++i)
+  {
+    const BVNode<BV>& node = model.getBV(i);
+    if(node.isLeaf())
+    {
+      GTEST_ASSERT_EQ(node.num_primitives, 1);
+      const int primitive_id = node.primitiveId();
+      num_leaves[primitive_id]++;
+      continue;
+    }
+
+    const BVNode<BV>& left = model.getBV(node.leftChild());
+    const BVNode<BV>& right = model.getBV(node.rightChild());
+    EXPECT_GT(node.leftChild(), i);
+    EXPECT_EQ(left.first_primitive, node.first_primitive);
+    EXPECT_EQ(right.first_primitive, node.first_primitive + left.num_primitives);
+    EXPECT_EQ(left.num_primitives + right.num_primitives, node.num_primitives);
+  }
+
+  for(int count : num_leaves)
+    EXPECT_EQ(count, 1);
+}
+
+GTEST_TEST(FCL_BVH_MODELS, linear_build)
+{
+  testBVHModelLinearBuild<AABB<double>>(false);
+  testBVHModelLinearBuild<AABB<double>>(true);
+  testBVHModelLinearBuild<OBB<double>>(false);
+  testBVHModelLinearBuild<RSS<double>>(false);
+  testBVHModelLinearBuild<OBBRSS<double>>(false);
+  testBVHModelLinearBuild<KDOP<double, 16>>(false);
+  testBVHModelLinearBuild<KDOP<double, 16>>(true);
+}
+
+template<typename BV>
+void testBVHModelSerialization(bool pointcloud)
+{
+  using S = typename BV::S;
+
+  std::vector<Vector3<S>> points;
+  std::vector<Triangle> tri_indices;
+  test::loadOBJFile(TEST_RESOURCES_DIR"/env.obj", points, tri_indices);
+
+  BVHModel<BV> expected;
+  expected.beginModel();
+  if(pointcloud)
+    expected.addSubModel(points);
+  else
+    expected.addSubModel(points, tri_indices);
+  expected.endModel();
+
+  std::stringstream stream;
+  EXPECT_EQ(saveBVHModel(expected, stream), BVH_OK);
+  const std::string data = stream.str();
+
+  BVHModel<BV> model;
+  GTEST_ASSERT_EQ(loadBVHModel(model, data.data(), data.size()), BVH_OK);
+  EXPECT_EQ(model.build_state, BVH_BUILD_STATE_PROCESSED);
+  EXPECT_EQ(model.getModelType(), expected.getModelType());
+
+  GTEST_ASSERT_EQ(model.num_vertices, expected.num_vertices);
+  for(int i = 0; i < model.num_vertices; ++i)
+    EXPECT_EQ(model.vertices[i], expected.vertices[i]);
+
+  GTEST_ASSERT_EQ(model.num_tris, expected.num_tris);
+  for(int i = 0; i < model.num_tris; ++i)
+  {
+    for(int j = 0; j < 3; ++j)
+      EXPECT_EQ(model.tri_indices[i][j], expected.tri_indices[i][j]);
+  }
+
+  GTEST_ASSERT_EQ(model.getNumBVs(), expected.getNumBVs());
+  for(int i = 0; i < model.getNumBVs(); ++i)
+    EXPECT_EQ(std::memcmp(&model.getBV(i), &expected.getBV(i), sizeof(BVNode<BV>)), 0);
+
+  // a loaded model can be updated like a built one
+  EXPECT_EQ(model.beginReplaceModel(), BVH_OK);
+  EXPECT_EQ(model.replaceSubModel(points), BVH_OK);
+  EXPECT_EQ(model.endReplaceModel(), BVH_OK);
+
+  // truncated data
+  EXPECT_EQ(loadBVHModel(model, data.data(), data.size() - 1), BVH_ERR_INCORRECT_DATA);
+  EXPECT_EQ(model.build_state, BVH_BUILD_STATE_EMPTY);
+  EXPECT_EQ(model.getNumBVs(), 0);
+
+  // corrupted data
+  std::string corrupted = data;
+  corrupted[0] = 'X';
+  EXPECT_EQ(loadBVHModel(model, corrupted.data(), corrupted.size()), BVH_ERR_INCORRECT_DATA);
+
+  // indices out of range, which only the check catches
+  detail::BVHFileHeader header;
+  std::memcpy(&header, data.data(), sizeof(header));
+
+  BVNode<BV> root;
+  corrupted = data;
+  std::memcpy(&root, &corrupted[header.bvs_offset], sizeof(root));
+  root.first_child = 0;
+  std::memcpy(&corrupted[header.bvs_offset], &root, sizeof(root));
+  EXPECT_EQ(loadBVHModel(model, corrupted.data(), corrupted.size()), BVH_ERR_INCORRECT_DATA);
+  EXPECT_EQ(model.build_state, BVH_BUILD_STATE_EMPTY);
+
+  unsigned int primitive_id = static_cast<unsigned int>(header.num_primitives);
+  corrupted = data;
+  std::memcpy(&corrupted[header.primitive_indices_offset], &primitive_id, sizeof(primitive_id));
+  EXPECT_EQ(loadBVHModel(model, corrupted.data(), corrupted.size()), BVH_ERR_INCORRECT_DATA);
+
+  if(!pointcloud)
+  {
+    Triangle tri(0, 1, header.num_vertices);
+    corrupted = data;
+    std::memcpy(&corrupted[header.tri_indices_offset], &tri, sizeof(tri));
+    EXPECT_EQ(loadBVHModel(model, corrupted.data(), corrupted.size()), BVH_ERR_INCORRECT_DATA);
+  }
+
+  // trusted data skips the check
+  EXPECT_EQ(loadBVHModel(model, data.data(), data.size(), true), BVH_OK);
+  EXPECT_EQ(model.getNumBVs(), expected.getNumBVs());
+
+  // another BV type
+  BVHModel<KDOP<S, 18>> other;
+  EXPECT_EQ(loadBVHModel(other, data.data(), data.size()), BVH_ERR_INCORRECT_DATA);
+
+  // a file is read in place, and stays readable once removed
+  const std::string filename = "test_fcl_bvh_models.bvh";
+  EXPECT_EQ(saveBVHModel(expected, filename), BVH_OK);
+  BVHModel<BV> loaded;
+  GTEST_ASSERT_EQ(loadBVHModel(loaded, filename), BVH_OK);
+  std::remove(filename.c_str());
+
+  const BVHModel<BV>& file_model = loaded;
+  GTEST_ASSERT_EQ(file_model.getNumBVs(), expected.getNumBVs());
+  for(int i = 0; i < file_model.getNumBVs(); ++i)
+    EXPECT_EQ(std::memcmp(&file_model.getBV(i), &expected.getBV(i), sizeof(BVNode<BV>)), 0);
+
+  EXPECT_EQ(loaded.beginReplaceModel(), BVH_OK);
+  EXPECT_EQ(loaded.replaceSubModel(points), BVH_OK);
+  EXPECT_EQ(loaded.endReplaceModel(), BVH_OK);
+
+  EXPECT_EQ(loadBVHModel(loaded, filename), BVH_ERR_UNKNOWN);
+}
+
+GTEST_TEST(FCL_BVH_MODELS, serialization)
+{
+  testBVHModelSerialization<AABB<double>>(false);
+  testBVHModelSerialization<AABB<double>>(true);
+  testBVHModelSerialization<OBB<double>>(false);
+  testBVHModelSerialization<RSS<double>>(false);
+  testBVHModelSerialization<OBBRSS<double>>(false);
+  testBVHModelSerialization<KDOP<double, 24>>(false);
+  testBVHModelSerialization<KDOP<double, 16>>(true);
+}
+
+template<typename BV>
+void testBVHModelSharedData()
+{
+  using S = typename BV::S;
+
+  std::vector<Vector3<S>> points;
+  std::vector<Triangle> tri_indices;
+  test::loadOBJFile(TEST_RESOURCES_DIR"/env.obj", points, tri_indices);
+
+  std::shared_ptr<BVHModel<BV>> original(new BVHModel<BV>);
+  original->beginModel();
+  original->addSubModel(points, tri_indices);
+  original->endModel();
+
+  const BVHModel<BV>& expected = *original;
+  std::vector<BVNode<BV>> expected_bvs(&expected.getBV(0), &expected.getBV(0) + expected.getNumBVs());
+
+  // copies of a built model share its arrays
+  BVHModel<BV> copy(expected);
+  BVHModel<BV> deformed(expected);
+  EXPECT_EQ(copy.vertices, expected.vertices);
+  EXPECT_EQ(copy.tri_indices, expected.tri_indices);
+  EXPECT_EQ(&static_cast<const BVHModel<BV>&>(copy).getBV(0), &expected.getBV(0));
+  EXPECT_EQ(deformed.vertices, expected.vertices);
+
+  // until asked for arrays of their own
+  BVHModel<BV> unique(expected);
+  unique.makeUnique();
+  EXPECT_NE(unique.vertices, expected.vertices);
+  EXPECT_NE(&unique.getBV(0), &expected.getBV(0));
+  EXPECT_EQ(std::memcmp(&unique.getBV(0), &expected.getBV(0), sizeof(BVNode<BV>)), 0);
+
+  // and copy them before they change
+  std::vector<Vector3<S>> moved_points(points);
+  for(Vector3<S>& p : moved_points)
+    p *= 0.5;
+
+  EXPECT_EQ(deformed.beginReplaceModel(), BVH_OK);
+  EXPECT_NE(deformed.vertices, expected.vertices);
+  EXPECT_EQ(deformed.replaceSubModel(moved_points), BVH_OK);
+  EXPECT_EQ(deformed.endReplaceModel(true, false), BVH_OK);
+
+  for(int i = 0; i < expected.num_vertices; ++i)
+  {
+    EXPECT_EQ(expected.vertices[i], points[i]);
+    EXPECT_EQ(deformed.vertices[i], moved_points[i]);
+  }
+
+  for(int i = 0; i < expected.getNumBVs(); ++i)
+    EXPECT_EQ(std::memcmp(&expected.getBV(i), &expected_bvs[i], sizeof(BVNode<BV>)), 0);
+
+  // the arrays outlive the model that built them
+  original.reset();
+  for(int i = 0; i < copy.num_vertices; ++i)
+    EXPECT_EQ(copy.vertices[i], points[i]);
+
+  // a model that is the only user of the arrays takes them back without
+  // copying them
+  const Vector3<S>* vertices = copy.vertices;
+  EXPECT_EQ(copy.beginReplaceModel(), BVH_OK);
+  EXPECT_EQ(copy.vertices, vertices);
+  EXPECT_EQ(copy.replaceSubModel(points), BVH_OK);
+  EXPECT_EQ(copy.endReplaceModel(), BVH_OK);
+
+  // a loaded model reads its arrays from the buffer until it changes
+  const BVHModel<BV>& saved = copy;
+  std::vector<BVNode<BV>> saved_bvs(&saved.getBV(0), &saved.getBV(0) + saved.getNumBVs());
+
+  std::stringstream stream;
+  EXPECT_EQ(saveBVHModel(copy, stream), BVH_OK);
+  const std::string data = stream.str();
+
+  std::shared_ptr<char> buffer(new char[data.size() + 64], std::default_delete<char[]>());
+  char* aligned = buffer.get() + (64 - reinterpret_cast<std::uintptr_t>(buffer.get()) % 64) % 64;
+  std::memcpy(aligned, data.data(), data.size());
+
+  BVHModel<BV> loaded;
+  GTEST_ASSERT_EQ(loadBVHModel(loaded, std::shared_ptr<const void>(buffer, aligned), data.size()), BVH_OK);
+  const char* first_bv = reinterpret_cast<const char*>(&static_cast<const BVHModel<BV>&>(loaded).getBV(0));
+  EXPECT_TRUE(first_bv > aligned && first_bv < aligned + data.size());
+
+  BVHModel<BV> loaded_copy(loaded);
+  buffer.reset();
+
+  EXPECT_EQ(loaded.beginUpdateModel(), BVH_OK);
+  EXPECT_EQ(loaded.updateSubModel(moved_points), BVH_OK);
+  EXPECT_EQ(loaded.endUpdateModel(), BVH_OK);
+
+  for(int i = 0; i < loaded_copy.num_vertices; ++i)
+  {
+    EXPECT_EQ(loaded_copy.vertices[i], points[i]);
+    EXPECT_EQ(loaded.vertices[i], moved_points[i]);
+  }
+
+  for(int i = 0; i < loaded_copy.getNumBVs(); ++i)
+    EXPECT_EQ(std::memcmp(&static_cast<const BVHModel<BV>&>(loaded_copy).getBV(i), &saved_bvs[i], sizeof(BVNode<BV>)), 0);
+}
+
+GTEST_TEST(FCL_BVH_MODELS, shared_data)
+{
+  testBVHModelSharedData<AABB<double>>();
+  testBVHModelSharedData<OBBRSS<double>>();
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
@@ -295,6 +295,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test<OBB<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test<RSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -319,6 +327,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test<RSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test<AABB<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -343,6 +359,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test<AABB<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test<KDOP<S, 24> >(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -367,6 +391,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test<KDOP<S, 24> >(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test<KDOP<S, 18> >(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -391,6 +423,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test<KDOP<S, 18> >(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test<KDOP<S, 16> >(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -415,6 +455,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test<KDOP<S, 16> >(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test2<OBB<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -439,6 +487,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test2<OBB<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test2<RSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -463,6 +519,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test2<RSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test2<AABB<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -487,6 +551,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test2<AABB<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test2<KDOP<S, 24> >(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -511,6 +583,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test2<KDOP<S, 24> >(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test2<KDOP<S, 18> >(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -535,6 +615,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test2<KDOP<S, 18> >(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test2<KDOP<S, 16> >(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -559,6 +647,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test2<KDOP<S, 16> >(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test_Oriented<OBB<S>, detail::MeshCollisionTraversalNodeOBB<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
 
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
@@ -585,6 +681,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test_Oriented<OBB<S>, detail::MeshCollisionTraversalNodeOBB<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test_Oriented<RSS<S>, detail::MeshCollisionTraversalNodeRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -609,6 +713,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test_Oriented<RSS<S>, detail::MeshCollisionTraversalNodeRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     test_collide_func<RSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEDIAN);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -650,6 +762,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test<kIOS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test<kIOS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_BV_CENTER, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -674,6 +794,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test2<kIOS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test2<kIOS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_BV_CENTER, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -698,6 +826,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test_Oriented<kIOS<S>, detail::MeshCollisionTraversalNodekIOS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test_Oriented<kIOS<S>, detail::MeshCollisionTraversalNodekIOS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_BV_CENTER, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -746,6 +882,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test<OBBRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test<OBBRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_BV_CENTER, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -770,6 +914,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test2<OBBRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test2<OBBRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_BV_CENTER, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -794,6 +946,14 @@ void test_mesh_mesh()
       EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
     }
 
+    collide_Test_Oriented<OBBRSS<S>, detail::MeshCollisionTraversalNodeOBBRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, verbose);
+    EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
+    for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
+    {
+      EXPECT_TRUE(global_pairs<S>()[j].b1 == global_pairs_now<S>()[j].b1);
+      EXPECT_TRUE(global_pairs<S>()[j].b2 == global_pairs_now<S>()[j].b2);
+    }
+
     collide_Test_Oriented<OBBRSS<S>, detail::MeshCollisionTraversalNodeOBBRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_BV_CENTER, verbose);
     EXPECT_TRUE(global_pairs<S>().size() == global_pairs_now<S>().size());
     for(std::size_t j = 0; j < global_pairs<S>().size(); ++j)
@@ -828,6 +988,353 @@ void test_mesh_mesh()
   }
 }
 
+template <typename S>
+void test_collide_batch()
+{
+  std::vector<Vector3<S>> p1, p2;
+  std::vector<Triangle> t1, t2;
+
+  test::loadOBJFile(TEST_RESOURCES_DIR"/env.obj", p1, t1);
+  test::loadOBJFile(TEST_RESOURCES_DIR"/rob.obj", p2, t2);
+
+  std::vector<std::shared_ptr<CollisionGeometry<S>>> geometries;
+  geometries.push_back(std::make_shared<Box<S>>(500, 1000, 500));
+  geometries.push_back(std::make_shared<Sphere<S>>(500));
+  geometries.push_back(std::make_shared<Capsule<S>>(200, 1000));
+  // Pairs of these go through the generic GJK of the GST_INDEP solver
+  geometries.push_back(std::make_shared<Cylinder<S>>(300, 1000));
+  geometries.push_back(std::make_shared<Cone<S>>(400, 1000));
+  geometries.push_back(std::make_shared<Ellipsoid<S>>(300, 500, 400));
+
+  auto model1 = std::make_shared<BVHModel<OBBRSS<S>>>();
+  model1->beginModel();
+  model1->addSubModel(p1, t1);
+  model1->endModel();
+  geometries.push_back(model1);
+
+  auto model2 = std::make_shared<BVHModel<OBBRSS<S>>>();
+  model2->beginModel();
+  model2->addSubModel(p2, t2);
+  model2->endModel();
+  geometries.push_back(model2);
+
+  Eigen::aligned_vector<Transform3<S>> transforms;
+  S extents[] = {-3000, -3000, 0, 3000, 3000, 3000};
+#ifdef NDEBUG
+  std::size_t n = 1000;
+#else
+  std::size_t n = 50;
+#endif
+
+  test::generateRandomTransforms(extents, transforms, 2 * n);
+
+  Eigen::aligned_vector<CollisionQuery<S>> queries;
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    const auto* o1 = geometries[i % geometries.size()].get();
+    const auto* o2 = geometries[(i / geometries.size()) % geometries.size()].get();
+    queries.emplace_back(o1, transforms[2 * i], o2, transforms[2 * i + 1]);
+  }
+
+  for(const auto solver_type : {GST_LIBCCD, GST_INDEP})
+  {
+    CollisionRequest<S> request(10, true);
+    request.gjk_solver_type = solver_type;
+
+    std::vector<CollisionResult<S>> expected(n);
+    std::size_t num_collisions = 0;
+    for(std::size_t i = 0; i < n; ++i)
+    {
+      collide(queries[i].o1, queries[i].tf1, queries[i].o2, queries[i].tf2, request, expected[i]);
+      if(expected[i].isCollision())
+        ++num_collisions;
+    }
+
+    for(const int num_threads : {1, 4})
+    {
+      std::vector<CollisionResult<S>> results(n);
+      EXPECT_EQ(collide(queries.data(), n, request, results.data(), num_threads), num_collisions);
+      for(std::size_t i = 0; i < n; ++i)
+      {
+        GTEST_ASSERT_EQ(results[i].numContacts(), expected[i].numContacts());
+        for(std::size_t j = 0; j < results[i].numContacts(); ++j)
+        {
+          EXPECT_EQ(results[i].getContact(j).b1, expected[i].getContact(j).b1);
+          EXPECT_EQ(results[i].getContact(j).b2, expected[i].getContact(j).b2);
+        }
+      }
+    }
+  }
+}
+
+template <typename S, int N>
+void test_mesh_mesh_packet_N(const BVHModel<OBB<S>>& m1, const BVHModel<OBB<S>>& m2,
+                             const Eigen::aligned_vector<Transform3<S>>& transforms)
+{
+  detail::WideBVH<OBB<S>, N> wide_m2;
+  wide_m2.build(m2);
+  EXPECT_FALSE(wide_m2.empty());
+
+  CollisionRequest<S> request(std::numeric_limits<int>::max(), false);
+  const Transform3<S> pose2 = Transform3<S>::Identity();
+
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+  {
+    CollisionResult<S> expected;
+    detail::MeshCollisionTraversalNodeOBB<S> node;
+    EXPECT_TRUE(detail::initialize(node, m1, transforms[i], m2, pose2, request, expected));
+    collide(&node);
+
+    CollisionResult<S> result;
+    detail::MeshCollisionTraversalNodeOBB<S> packet_node;
+    EXPECT_TRUE(detail::initialize(packet_node, m1, transforms[i], m2, pose2, request, result));
+    collide(&packet_node, wide_m2);
+
+    std::vector<Contact<S>> expected_contacts, contacts;
+    expected.getContacts(expected_contacts);
+    result.getContacts(contacts);
+    std::sort(expected_contacts.begin(), expected_contacts.end());
+    std::sort(contacts.begin(), contacts.end());
+
+    GTEST_ASSERT_EQ(contacts.size(), expected_contacts.size());
+    for(std::size_t j = 0; j < contacts.size(); ++j)
+    {
+      EXPECT_EQ(contacts[j].b1, expected_contacts[j].b1);
+      EXPECT_EQ(contacts[j].b2, expected_contacts[j].b2);
+    }
+  }
+}
+
+template <typename S>
+void test_mesh_mesh_packet()
+{
+  std::vector<Vector3<S>> p1, p2;
+  std::vector<Triangle> t1, t2;
+
+  test::loadOBJFile(TEST_RESOURCES_DIR"/env.obj", p1, t1);
+  test::loadOBJFile(TEST_RESOURCES_DIR"/rob.obj", p2, t2);
+
+  BVHModel<OBB<S>> m1;
+  m1.beginModel();
+  m1.addSubModel(p1, t1);
+  m1.endModel();
+
+  BVHModel<OBB<S>> m2;
+  m2.beginModel();
+  m2.addSubModel(p2, t2);
+  m2.endModel();
+
+  Eigen::aligned_vector<Transform3<S>> transforms;
+  S extents[] = {-3000, -3000, 0, 3000, 3000, 3000};
+#ifdef NDEBUG
+  std::size_t n = 100;
+#else
+  std::size_t n = 5;
+#endif
+
+  test::generateRandomTransforms(extents, transforms, n);
+
+  // the packet test agrees with the scalar test on every lane
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+  {
+    const Matrix3<S> R = transforms[i].linear();
+    const Vector3<S> T = transforms[i].translation();
+    const OBB<S>& bv1 = m1.getBV(i % m1.getNumBVs()).bv;
+
+    detail::OBBPacket<S, 4> packet;
+    for(int k = 0; k < 4; ++k)
+      packet.set(k, m2.getBV((i + k) % m2.getNumBVs()).bv);
+
+    const unsigned int mask = detail::overlapPacket(R, T, bv1, packet);
+    for(int k = 0; k < 4; ++k)
+    {
+      const OBB<S>& bv2 = m2.getBV((i + k) % m2.getNumBVs()).bv;
+      EXPECT_EQ(((mask >> k) & 1u) != 0, overlap(R, T, bv1, bv2));
+    }
+  }
+
+  test_mesh_mesh_packet_N<S, 4>(m1, m2, transforms);
+  test_mesh_mesh_packet_N<S, 8>(m1, m2, transforms);
+}
+
+template <typename BV, typename TraversalNode>
+void test_mesh_mesh_split_methods_BV(const std::string& name,
+                                     const std::vector<Vector3<typename BV::S>>& p1, const std::vector<Triangle>& t1,
+                                     const std::vector<Vector3<typename BV::S>>& p2, const std::vector<Triangle>& t2,
+                                     const Eigen::aligned_vector<Transform3<typename BV::S>>& transforms)
+{
+  using S = typename BV::S;
+
+  const detail::SplitMethodType methods[] = {detail::SPLIT_METHOD_MEAN, detail::SPLIT_METHOD_MEDIAN, detail::SPLIT_METHOD_BV_CENTER, detail::SPLIT_METHOD_SAH};
+  const char* method_names[] = {"mean", "median", "bv center", "sah", "lbvh"};
+
+  std::vector<std::size_t> expected_num_contacts;
+
+  for(int m = 0; m < 5; ++m)
+  {
+    BVHModel<BV> m1;
+    BVHModel<BV> m2;
+    if(m < 4)
+    {
+      m1.bv_splitter.reset(new detail::BVSplitter<BV>(methods[m]));
+      m2.bv_splitter.reset(new detail::BVSplitter<BV>(methods[m]));
+    }
+    else
+    {
+      m1.build_method = BVH_BUILD_METHOD_LINEAR;
+      m2.build_method = BVH_BUILD_METHOD_LINEAR;
+    }
+
+    m1.beginModel();
+    m1.addSubModel(p1, t1);
+    m1.endModel();
+
+    m2.beginModel();
+    m2.addSubModel(p2, t2);
+    m2.endModel();
+
+    CollisionRequest<S> request(std::numeric_limits<int>::max(), false);
+
+    int num_bv_tests = 0;
+    int num_leaf_tests = 0;
+    double time = 0;
+
+    for(std::size_t i = 0; i < transforms.size(); ++i)
+    {
+      CollisionResult<S> result;
+      TraversalNode node;
+      EXPECT_TRUE(detail::initialize(node, m1, transforms[i], m2, Transform3<S>::Identity(), request, result));
+      node.enable_statistics = true;
+
+      test::Timer timer;
+      timer.start();
+      collide(&node);
+      timer.stop();
+      time += timer.getElapsedTimeInSec();
+
+      num_bv_tests += node.num_bv_tests;
+      num_leaf_tests += node.num_leaf_tests;
+
+      if(m == 0)
+        expected_num_contacts.push_back(result.numContacts());
+      else
+        EXPECT_EQ(result.numContacts(), expected_num_contacts[i]);
+    }
+
+    std::cout << name << " " << method_names[m] << ": " << num_bv_tests << " BV tests, "
+              << num_leaf_tests << " leaf tests, " << time << " sec" << std::endl;
+  }
+}
+
+template <typename S>
+void test_mesh_mesh_split_methods()
+{
+  std::vector<Vector3<S>> p1, p2;
+  std::vector<Triangle> t1, t2;
+
+  test::loadOBJFile(TEST_RESOURCES_DIR"/env.obj", p1, t1);
+  test::loadOBJFile(TEST_RESOURCES_DIR"/rob.obj", p2, t2);
+
+  Eigen::aligned_vector<Transform3<S>> transforms;
+  S extents[] = {-3000, -3000, 0, 3000, 3000, 3000};
+#ifdef NDEBUG
+  std::size_t n = 1000;
+#else
+  std::size_t n = 10;
+#endif
+
+  test::generateRandomTransforms(extents, transforms, n);
+
+  test_mesh_mesh_split_methods_BV<OBB<S>, detail::MeshCollisionTraversalNodeOBB<S>>("OBB", p1, t1, p2, t2, transforms);
+  test_mesh_mesh_split_methods_BV<RSS<S>, detail::MeshCollisionTraversalNodeRSS<S>>("RSS", p1, t1, p2, t2, transforms);
+  test_mesh_mesh_split_methods_BV<OBBRSS<S>, detail::MeshCollisionTraversalNodeOBBRSS<S>>("OBBRSS", p1, t1, p2, t2, transforms);
+}
+
+template <typename BV>
+void test_mesh_mesh_wide_BV(const std::vector<Vector3<typename BV::S>>& p1, const std::vector<Triangle>& t1,
+                            const std::vector<Vector3<typename BV::S>>& p2, const std::vector<Triangle>& t2,
+                            const Eigen::aligned_vector<Transform3<typename BV::S>>& transforms)
+{
+  using S = typename BV::S;
+
+  BVHModel<BV> m1;
+  m1.beginModel();
+  m1.addSubModel(p1, t1);
+  m1.endModel();
+
+  BVHModel<BV> m2;
+  m2.beginModel();
+  m2.addSubModel(p2, t2);
+  m2.endModel();
+  EXPECT_TRUE(m2.getWideBVH() == nullptr);
+
+  BVHModel<BV> m2_wide(m2);
+  EXPECT_EQ(m2_wide.buildWideBVH(), BVH_OK);
+  ASSERT_TRUE(m2_wide.getWideBVH() != nullptr);
+  EXPECT_FALSE(m2_wide.getWideBVH()->empty());
+
+  CollisionRequest<S> request(std::numeric_limits<int>::max(), false);
+
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+  {
+    CollisionResult<S> expected;
+    collide(&m1, transforms[i], &m2, Transform3<S>::Identity(), request, expected);
+
+    CollisionResult<S> result;
+    collide(&m1, transforms[i], &m2_wide, Transform3<S>::Identity(), request, result);
+
+    std::vector<Contact<S>> expected_contacts, contacts;
+    expected.getContacts(expected_contacts);
+    result.getContacts(contacts);
+    std::sort(expected_contacts.begin(), expected_contacts.end());
+    std::sort(contacts.begin(), contacts.end());
+
+    GTEST_ASSERT_EQ(contacts.size(), expected_contacts.size());
+    for(std::size_t j = 0; j < contacts.size(); ++j)
+    {
+      EXPECT_EQ(contacts[j].b1, expected_contacts[j].b1);
+      EXPECT_EQ(contacts[j].b2, expected_contacts[j].b2);
+    }
+  }
+
+  // refitting keeps the wide hierarchy only on request
+  m2_wide.beginReplaceModel();
+  m2_wide.replaceSubModel(p2);
+  m2_wide.endReplaceModel();
+  EXPECT_TRUE(m2_wide.getWideBVH() == nullptr);
+
+  m2_wide.build_wide_bvh = true;
+  m2_wide.beginReplaceModel();
+  m2_wide.replaceSubModel(p2);
+  m2_wide.endReplaceModel();
+  EXPECT_TRUE(m2_wide.getWideBVH() != nullptr);
+}
+
+template <typename S>
+void test_mesh_mesh_wide()
+{
+  std::vector<Vector3<S>> p1, p2;
+  std::vector<Triangle> t1, t2;
+
+  test::loadOBJFile(TEST_RESOURCES_DIR"/env.obj", p1, t1);
+  test::loadOBJFile(TEST_RESOURCES_DIR"/rob.obj", p2, t2);
+
+  Eigen::aligned_vector<Transform3<S>> transforms;
+  S extents[] = {-3000, -3000, 0, 3000, 3000, 3000};
+#ifdef NDEBUG
+  std::size_t n = 100;
+#else
+  std::size_t n = 5;
+#endif
+
+  test::generateRandomTransforms(extents, transforms, n);
+
+  test_mesh_mesh_wide_BV<OBB<S>>(p1, t1, p2, t2, transforms);
+  test_mesh_mesh_wide_BV<RSS<S>>(p1, t1, p2, t2, transforms);
+  test_mesh_mesh_wide_BV<kIOS<S>>(p1, t1, p2, t2, transforms);
+  test_mesh_mesh_wide_BV<OBBRSS<S>>(p1, t1, p2, t2, transforms);
+}
+
 GTEST_TEST(FCL_COLLISION, OBB_Box_test)
 {
 //  test_OBB_Box_test<float>();
@@ -852,6 +1359,30 @@ GTEST_TEST(FCL_COLLISION, mesh_mesh)
   test_mesh_mesh<double>();
 }
 
+GTEST_TEST(FCL_COLLISION, collide_batch)
+{
+//  test_collide_batch<float>();
+  test_collide_batch<double>();
+}
+
+GTEST_TEST(FCL_COLLISION, mesh_mesh_packet)
+{
+//  test_mesh_mesh_packet<float>();
+  test_mesh_mesh_packet<double>();
+}
+
+GTEST_TEST(FCL_COLLISION, mesh_mesh_wide)
+{
+//  test_mesh_mesh_wide<float>();
+  test_mesh_mesh_wide<double>();
+}
+
+GTEST_TEST(FCL_COLLISION, mesh_mesh_split_methods)
+{
+//  test_mesh_mesh_split_methods<float>();
+  test_mesh_mesh_split_methods<double>();
+}
+
 template<typename BV>
 bool collide_Test2(const Transform3<typename BV::S>& tf,
                    const std::vector<Vector3<typename BV::S>>& vertices1, const std::vector<Triangle>& triangles1,
@@ -37,6 +37,7 @@
 
 #include <gtest/gtest.h>
 
+#include "fcl/narrowphase/distance.h"
 #include "fcl/narrowphase/detail/traversal/collision_node.h"
 #include "test_fcl_utility.h"
 #include "fcl_resources/config.h"
@@ -125,6 +126,11 @@ void test_mesh_distance()
     EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
     EXPECT_TRUE(fabs(res.distance) < DELTA<S>() || (res.distance > 0 && nearlyEqual(res.p1, res_now.p1) && nearlyEqual(res.p2, res_now.p2)));
 
+    distance_Test_Oriented<RSS<S>, detail::MeshDistanceTraversalNodeRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, 2, res_now, verbose);
+
+    EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
+    EXPECT_TRUE(fabs(res.distance) < DELTA<S>() || (res.distance > 0 && nearlyEqual(res.p1, res_now.p1) && nearlyEqual(res.p2, res_now.p2)));
+
     distance_Test_Oriented<RSS<S>, detail::MeshDistanceTraversalNodeRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, 20, res_now, verbose);
 
     EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
@@ -150,6 +156,11 @@ void test_mesh_distance()
     EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
     EXPECT_TRUE(fabs(res.distance) < DELTA<S>() || (res.distance > 0 && nearlyEqual(res.p1, res_now.p1) && nearlyEqual(res.p2, res_now.p2)));
 
+    distance_Test_Oriented<kIOS<S>, detail::MeshDistanceTraversalNodekIOS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, 2, res_now, verbose);
+
+    EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
+    EXPECT_TRUE(fabs(res.distance) < DELTA<S>() || (res.distance > 0 && nearlyEqual(res.p1, res_now.p1) && nearlyEqual(res.p2, res_now.p2)));
+
     distance_Test_Oriented<kIOS<S>, detail::MeshDistanceTraversalNodekIOS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_BV_CENTER, 2, res_now, verbose);
 
     EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
@@ -180,6 +191,11 @@ void test_mesh_distance()
     EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
     EXPECT_TRUE(fabs(res.distance) < DELTA<S>() || (res.distance > 0 && nearlyEqual(res.p1, res_now.p1) && nearlyEqual(res.p2, res_now.p2)));
 
+    distance_Test_Oriented<OBBRSS<S>, detail::MeshDistanceTraversalNodeOBBRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, 2, res_now, verbose);
+
+    EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
+    EXPECT_TRUE(fabs(res.distance) < DELTA<S>() || (res.distance > 0 && nearlyEqual(res.p1, res_now.p1) && nearlyEqual(res.p2, res_now.p2)));
+
     distance_Test_Oriented<OBBRSS<S>, detail::MeshDistanceTraversalNodeOBBRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_BV_CENTER, 2, res_now, verbose);
 
     EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
@@ -217,6 +233,11 @@ void test_mesh_distance()
     EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
     EXPECT_TRUE(fabs(res.distance) < DELTA<S>() || (res.distance > 0 && nearlyEqual(res.p1, res_now.p1) && nearlyEqual(res.p2, res_now.p2)));
 
+    distance_Test<RSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, 2, res_now, verbose);
+
+    EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
+    EXPECT_TRUE(fabs(res.distance) < DELTA<S>() || (res.distance > 0 && nearlyEqual(res.p1, res_now.p1) && nearlyEqual(res.p2, res_now.p2)));
+
     distance_Test<RSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_MEAN, 20, res_now, verbose);
 
     EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
@@ -242,6 +263,11 @@ void test_mesh_distance()
     EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
     EXPECT_TRUE(fabs(res.distance) < DELTA<S>() || (res.distance > 0 && nearlyEqual(res.p1, res_now.p1) && nearlyEqual(res.p2, res_now.p2)));
 
+    distance_Test<kIOS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, 2, res_now, verbose);
+
+    EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
+    EXPECT_TRUE(fabs(res.distance) < DELTA<S>() || (res.distance > 0 && nearlyEqual(res.p1, res_now.p1) && nearlyEqual(res.p2, res_now.p2)));
+
     distance_Test<kIOS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_BV_CENTER, 2, res_now, verbose);
 
     EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
@@ -273,6 +299,11 @@ void test_mesh_distance()
     EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
     EXPECT_TRUE(fabs(res.distance) < DELTA<S>() || (res.distance > 0 && nearlyEqual(res.p1, res_now.p1) && nearlyEqual(res.p2, res_now.p2)));
 
+    distance_Test<OBBRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_SAH, 2, res_now, verbose);
+
+    EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
+    EXPECT_TRUE(fabs(res.distance) < DELTA<S>() || (res.distance > 0 && nearlyEqual(res.p1, res_now.p1) && nearlyEqual(res.p2, res_now.p2)));
+
     distance_Test<OBBRSS<S>>(transforms[i], p1, t1, p2, t2, detail::SPLIT_METHOD_BV_CENTER, 2, res_now, verbose);
 
     EXPECT_TRUE(fabs(res.distance - res_now.distance) < DELTA<S>());
@@ -305,6 +336,94 @@ GTEST_TEST(FCL_DISTANCE, mesh_distance)
   test_mesh_distance<double>();
 }
 
+template <typename BV>
+void test_mesh_distance_wide_BV(const std::vector<Vector3<typename BV::S>>& p1, const std::vector<Triangle>& t1,
+                                const std::vector<Vector3<typename BV::S>>& p2, const std::vector<Triangle>& t2,
+                                const Eigen::aligned_vector<Transform3<typename BV::S>>& transforms)
+{
+  using S = typename BV::S;
+
+  auto m1 = std::make_shared<BVHModel<BV>>();
+  m1->beginModel();
+  m1->addSubModel(p1, t1);
+  m1->endModel();
+
+  auto m2 = std::make_shared<BVHModel<BV>>();
+  m2->beginModel();
+  m2->addSubModel(p2, t2);
+  m2->endModel();
+
+  auto m2_wide = std::make_shared<BVHModel<BV>>();
+  m2_wide->build_wide_bvh = true;
+  m2_wide->beginModel();
+  m2_wide->addSubModel(p2, t2);
+  m2_wide->endModel();
+  EXPECT_TRUE(m2_wide->getWideBVH() != nullptr);
+
+  if(verbose)
+    m2_wide->memUsage(1);
+
+  S binary_time = 0;
+  S wide_time = 0;
+
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+  {
+    DistanceRequest<S> request(true);
+
+    DistanceResult<S> res;
+    test::Timer timer_binary;
+    timer_binary.start();
+    distance(m1.get(), transforms[i], m2.get(), Transform3<S>::Identity(), request, res);
+    timer_binary.stop();
+    binary_time += timer_binary.getElapsedTimeInSec();
+
+    DistanceResult<S> res_wide;
+    test::Timer timer_wide;
+    timer_wide.start();
+    distance(m1.get(), transforms[i], m2_wide.get(), Transform3<S>::Identity(), request, res_wide);
+    timer_wide.stop();
+    wide_time += timer_wide.getElapsedTimeInSec();
+
+    EXPECT_NEAR(res.min_distance, res_wide.min_distance, DELTA<S>());
+  }
+
+  if(verbose)
+  {
+    std::cout << "binary distance timing: " << binary_time << " sec" << std::endl;
+    std::cout << "wide distance timing: " << wide_time << " sec" << std::endl;
+  }
+}
+
+template <typename S>
+void test_mesh_distance_wide()
+{
+  std::vector<Vector3<S>> p1, p2;
+  std::vector<Triangle> t1, t2;
+
+  test::loadOBJFile(TEST_RESOURCES_DIR"/env.obj", p1, t1);
+  test::loadOBJFile(TEST_RESOURCES_DIR"/rob.obj", p2, t2);
+
+  Eigen::aligned_vector<Transform3<S>> transforms;
+  S extents[] = {-3000, -3000, 0, 3000, 3000, 3000};
+#ifdef NDEBUG
+  std::size_t n = 10;
+#else
+  std::size_t n = 1;
+#endif
+
+  test::generateRandomTransforms(extents, transforms, n);
+
+  test_mesh_distance_wide_BV<RSS<S>>(p1, t1, p2, t2, transforms);
+  test_mesh_distance_wide_BV<kIOS<S>>(p1, t1, p2, t2, transforms);
+  test_mesh_distance_wide_BV<OBBRSS<S>>(p1, t1, p2, t2, transforms);
+}
+
+GTEST_TEST(FCL_DISTANCE, mesh_distance_wide)
+{
+//  test_mesh_distance_wide<float>();
+  test_mesh_distance_wide<double>();
+}
+
 template<typename BV, typename TraversalNode>
 void distance_Test_Oriented(const Transform3<typename BV::S>& tf,
                             const std::vector<Vector3<typename BV::S>>& vertices1, const std::vector<Triangle>& triangles1,
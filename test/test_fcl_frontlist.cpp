@@ -371,6 +371,95 @@ bool collide_Test(const Transform3<typename BV::S>& tf,
     return false;
 }
 
+template<typename BV, typename TraversalNode>
+void test_front_list_contacts()
+{
+  using S = typename BV::S;
+
+  std::vector<Vector3<S>> p1, p2;
+  std::vector<Triangle> t1, t2;
+
+  test::loadOBJFile(TEST_RESOURCES_DIR"/env.obj", p1, t1);
+  test::loadOBJFile(TEST_RESOURCES_DIR"/rob.obj", p2, t2);
+
+  BVHModel<BV> m1;
+  BVHModel<BV> m2;
+
+  m1.beginModel();
+  m1.addSubModel(p1, t1);
+  m1.endModel();
+
+  m2.beginModel();
+  m2.addSubModel(p2, t2);
+  m2.endModel();
+
+  Eigen::aligned_vector<Transform3<S>> transforms;
+  Eigen::aligned_vector<Transform3<S>> transforms2;
+  S extents[] = {-3000, -3000, 0, 3000, 3000, 3000};
+  S delta_trans[] = {1, 1, 1};
+#ifdef NDEBUG
+  std::size_t n = 10;
+#else
+  std::size_t n = 1;
+#endif
+
+  test::generateRandomTransforms<S>(extents, delta_trans, 0.005 * 2 * 3.1415, transforms, transforms2, n);
+
+  const Transform3<S> pose2 = Transform3<S>::Identity();
+  const CollisionRequest<S> request(std::numeric_limits<int>::max(), false);
+
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+  {
+    detail::BVHFrontList front_list;
+    detail::BVHFlatFrontList flat_front_list;
+    CollisionResult<S> result;
+    CollisionResult<S> flat_result;
+    TraversalNode node;
+    TraversalNode flat_node;
+
+    ASSERT_TRUE(detail::initialize(node, m1, transforms[i], m2, pose2, request, result));
+    collide(&node, &front_list);
+    ASSERT_TRUE(detail::initialize(flat_node, m1, transforms[i], m2, pose2, request, flat_result));
+    collide(&flat_node, &flat_front_list);
+    EXPECT_EQ(flat_front_list.size(), front_list.size());
+
+    // the front list finds the same contacts as a full traversal
+    CollisionResult<S> expected_result;
+    TraversalNode expected_node;
+    ASSERT_TRUE(detail::initialize(expected_node, m1, transforms2[i], m2, pose2, request, expected_result));
+    collide(&expected_node);
+
+    result.clear();
+    ASSERT_TRUE(detail::initialize(node, m1, transforms2[i], m2, pose2, request, result));
+    collide(&node, &front_list);
+    EXPECT_EQ(result.numContacts(), expected_result.numContacts());
+
+    flat_result.clear();
+    ASSERT_TRUE(detail::initialize(flat_node, m1, transforms2[i], m2, pose2, request, flat_result));
+    collide(&flat_node, &flat_front_list);
+    EXPECT_EQ(flat_result.numContacts(), expected_result.numContacts());
+
+    // once the front is settled, reusing the flat list does not reallocate it
+    flat_result.clear();
+    collide(&flat_node, &flat_front_list);
+    const detail::BVHFrontNode* data = flat_front_list.data();
+    const std::size_t size = flat_front_list.size();
+
+    flat_result.clear();
+    collide(&flat_node, &flat_front_list);
+    EXPECT_EQ(flat_result.numContacts(), expected_result.numContacts());
+    EXPECT_EQ(flat_front_list.size(), size);
+    EXPECT_EQ(flat_front_list.data(), data);
+  }
+}
+
+GTEST_TEST(FCL_FRONT_LIST, front_list_contacts)
+{
+//  test_front_list_contacts<OBB<float>, detail::MeshCollisionTraversalNodeOBB<float>>();
+  test_front_list_contacts<OBB<double>, detail::MeshCollisionTraversalNodeOBB<double>>();
+  test_front_list_contacts<RSS<double>, detail::MeshCollisionTraversalNodeRSS<double>>();
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
@@ -36,12 +36,16 @@
 /** @author Jia Pan */
 
 #include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 
 #include <gtest/gtest.h>
 
 #include "fcl/narrowphase/detail/gjk_solver_indep.h"
 #include "fcl/narrowphase/detail/gjk_solver_libccd.h"
 #include "fcl/narrowphase/collision.h"
+#include "fcl/narrowphase/distance.h"
 #include "test_fcl_utility.h"
 #include "fcl/math/motion/translation_motion.h"
 #include <iostream>
@@ -49,6 +53,23 @@
 
 using namespace fcl;
 
+/// @brief the number of calls to the global operator new, which is replaced
+/// below to count the heap allocations of the queries
+static std::atomic<std::size_t> num_allocations(0);
+
+void* operator new(std::size_t size)
+{
+  ++num_allocations;
+  if(void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
 template <typename S>
 std::array<S, 6>& extents()
 {
@@ -5246,6 +5267,570 @@ GTEST_TEST(FCL_GEOMETRIC_SHAPES, reversibleShapeDistance_allshapes)
   test_reversibleShapeDistance_allshapes<double>();
 }
 
+/// @brief run GJK between s1 at the origin and s2 at each of the transforms,
+/// with the support functions of the shape types Shape1 and Shape2, and return
+/// the time taken in micro-seconds
+template <typename S, typename Shape1, typename Shape2>
+double runGJKSupportDispatch(const Shape1& s1, const Shape2& s2,
+                             const Eigen::aligned_vector<Transform3<S>>& transforms,
+                             std::vector<S>& distances,
+                             std::size_t& num_iterations)
+{
+  detail::MinkowskiDiff<S, Shape1, Shape2> shape;
+  shape.shapes[0] = &s1;
+  shape.shapes[1] = &s2;
+  detail::GJK<S, Shape1, Shape2> gjk(solver2<S>().gjk_max_iterations, solver2<S>().gjk_tolerance);
+
+  distances.resize(transforms.size());
+  num_iterations = 0;
+
+  test::Timer timer;
+  timer.start();
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+  {
+    shape.toshape1 = transforms[i].linear().transpose();
+    shape.toshape0 = transforms[i];
+    gjk.evaluate(shape, Vector3<S>(1, 0, 0));
+    distances[i] = gjk.distance;
+    num_iterations += gjk.getNumIterations();
+  }
+  timer.stop();
+
+  return timer.getElapsedTimeInMicroSec();
+}
+
+template <typename S, typename Shape1, typename Shape2>
+void testGJKSupportDispatch(const std::string& name, const Shape1& s1, const Shape2& s2)
+{
+  Eigen::aligned_vector<Transform3<S>> transforms;
+  test::generateRandomTransforms(extents<S>().data(), transforms, 10000);
+
+  std::vector<S> dynamic_distances;
+  std::vector<S> static_distances;
+  std::size_t dynamic_iterations;
+  std::size_t static_iterations;
+
+  // keep the best of a few runs of each: before, the support functions
+  // dispatch on the node types at run time; after, the support functions of
+  // the static shape types are inlined
+  double dynamic_time = std::numeric_limits<double>::max();
+  double static_time = std::numeric_limits<double>::max();
+  for(int i = 0; i < 3; ++i)
+  {
+    dynamic_time = std::min(dynamic_time, runGJKSupportDispatch<S, ShapeBase<S>, ShapeBase<S>>(
+                              s1, s2, transforms, dynamic_distances, dynamic_iterations));
+    static_time = std::min(static_time, runGJKSupportDispatch<S, Shape1, Shape2>(
+                             s1, s2, transforms, static_distances, static_iterations));
+  }
+
+  EXPECT_EQ(dynamic_iterations, static_iterations);
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+    EXPECT_NEAR(dynamic_distances[i], static_distances[i], tolerance<S>());
+
+  std::cout << name << ": " << static_iterations << " GJK iterations, "
+            << 1000 * dynamic_time / dynamic_iterations << " ns per iteration dispatched at run time, "
+            << 1000 * static_time / static_iterations << " ns per iteration resolved at compile time"
+            << std::endl;
+}
+
+template <typename S>
+void test_gjk_support_dispatch()
+{
+  Box<S> box(2, 3, 4);
+  Capsule<S> capsule(1.5, 4);
+  Cylinder<S> cylinder(2, 3);
+
+  // the box [-1, 1]^3 as a convex polytope
+  Vector3<S> points[8];
+  for(int i = 0; i < 8; ++i)
+    points[i] = Vector3<S>((i & 1) ? 1 : -1, (i & 2) ? 1 : -1, (i & 4) ? 1 : -1);
+  Vector3<S> plane_normals[6] = {-Vector3<S>::UnitX(), Vector3<S>::UnitX(),
+                                 -Vector3<S>::UnitY(), Vector3<S>::UnitY(),
+                                 -Vector3<S>::UnitZ(), Vector3<S>::UnitZ()};
+  S plane_dis[6] = {1, 1, 1, 1, 1, 1};
+  int polygons[30] = {4, 0, 4, 6, 2,
+                      4, 1, 3, 7, 5,
+                      4, 0, 1, 5, 4,
+                      4, 2, 6, 7, 3,
+                      4, 0, 2, 3, 1,
+                      4, 4, 5, 7, 6};
+  Convex<S> convex(plane_normals, plane_dis, 6, points, 8, polygons);
+
+  testGJKSupportDispatch<S>("box-box", box, box);
+  testGJKSupportDispatch<S>("box-capsule", box, capsule);
+  testGJKSupportDispatch<S>("capsule-cylinder", capsule, cylinder);
+  testGJKSupportDispatch<S>("cylinder-cylinder", cylinder, cylinder);
+  testGJKSupportDispatch<S>("convex-box", convex, box);
+  testGJKSupportDispatch<S>("convex-cylinder", convex, cylinder);
+}
+
+GTEST_TEST(FCL_GEOMETRIC_SHAPES, gjk_support_dispatch)
+{
+//  test_gjk_support_dispatch<float>();
+  test_gjk_support_dispatch<double>();
+}
+
+/// @brief the vertices and faces of a UV sphere of the given radius, with
+/// poles on the z axis, as the data of a Convex
+template <typename S>
+struct UVSphereConvexData
+{
+  std::vector<Vector3<S>> points;
+  std::vector<Vector3<S>> plane_normals;
+  std::vector<S> plane_dis;
+  std::vector<int> polygons;
+
+  UVSphereConvexData(S radius, int num_rings, int num_segments)
+  {
+    const S pi = constants<S>::pi();
+    points.push_back(Vector3<S>(0, 0, radius));
+    for(int i = 1; i <= num_rings; ++i)
+    {
+      const S theta = pi * i / (num_rings + 1);
+      for(int j = 0; j < num_segments; ++j)
+      {
+        const S phi = 2 * pi * j / num_segments;
+        points.push_back(radius * Vector3<S>(std::sin(theta) * std::cos(phi),
+                                             std::sin(theta) * std::sin(phi),
+                                             std::cos(theta)));
+      }
+    }
+    points.push_back(Vector3<S>(0, 0, -radius));
+
+    const int bottom = static_cast<int>(points.size()) - 1;
+    auto ring = [num_segments](int i, int j) { return 1 + i * num_segments + j % num_segments; };
+    for(int j = 0; j < num_segments; ++j)
+    {
+      addPolygon({0, ring(0, j), ring(0, j + 1)});
+      for(int i = 0; i + 1 < num_rings; ++i)
+        addPolygon({ring(i, j), ring(i + 1, j), ring(i + 1, j + 1), ring(i, j + 1)});
+      addPolygon({bottom, ring(num_rings - 1, j + 1), ring(num_rings - 1, j)});
+    }
+  }
+
+  void addPolygon(const std::vector<int>& indices)
+  {
+    const Vector3<S>& a = points[indices[0]];
+    Vector3<S> normal = (points[indices[1]] - a).cross(points[indices[2]] - a).normalized();
+    if(normal.dot(a) < 0)
+      normal = -normal;
+    plane_normals.push_back(normal);
+    plane_dis.push_back(normal.dot(a));
+
+    polygons.push_back(static_cast<int>(indices.size()));
+    polygons.insert(polygons.end(), indices.begin(), indices.end());
+  }
+
+  int numPlanes() const { return static_cast<int>(plane_dis.size()); }
+  int numPoints() const { return static_cast<int>(points.size()); }
+};
+
+template <typename S>
+void test_convex_extreme_vertex()
+{
+  UVSphereConvexData<S> data(2, 40, 50);
+  // the same vertices with and without the faces, which give the adjacency
+  Convex<S> convex(data.plane_normals.data(), data.plane_dis.data(), data.numPlanes(),
+                   data.points.data(), data.numPoints(), data.polygons.data());
+  Convex<S> scanned_convex(nullptr, nullptr, 0, data.points.data(), data.numPoints(), nullptr);
+
+  // hill climbing reaches a vertex as far along the direction as the scan,
+  // from the last vertex found, from the hint, and from a hint that is not a
+  // vertex
+  Eigen::aligned_vector<Transform3<S>> transforms;
+  test::generateRandomTransforms(extents<S>().data(), transforms, 1000);
+  int hint = -1;
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+  {
+    const Vector3<S> dir = transforms[i].linear().col(0);
+    const S maxdot = dir.dot(data.points[scanned_convex.findExtremeVertex(dir)]);
+    EXPECT_EQ(maxdot, dir.dot(data.points[convex.findExtremeVertex(dir)]));
+    EXPECT_EQ(maxdot, dir.dot(data.points[convex.findExtremeVertex(dir, &hint)]));
+    EXPECT_EQ(maxdot, dir.dot(data.points[hint]));
+    int bad_hint = data.numPoints();
+    EXPECT_EQ(maxdot, dir.dot(data.points[convex.findExtremeVertex(dir, &bad_hint)]));
+  }
+
+  // GJK gives the same distances with either, and the time per iteration
+  // no longer grows with the number of vertices
+  Box<S> box(1, 2, 3);
+  std::vector<S> scanned_distances;
+  std::vector<S> distances;
+  std::size_t scanned_iterations;
+  std::size_t iterations;
+  const double scanned_time = runGJKSupportDispatch<S, Convex<S>, Box<S>>(
+        scanned_convex, box, transforms, scanned_distances, scanned_iterations);
+  const double time = runGJKSupportDispatch<S, Convex<S>, Box<S>>(
+        convex, box, transforms, distances, iterations);
+
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+    EXPECT_NEAR(scanned_distances[i], distances[i], 1e-6);
+
+  std::cout << data.numPoints() << " vertex convex-box: "
+            << 1000 * scanned_time / scanned_iterations << " ns per GJK iteration scanning the vertices, "
+            << 1000 * time / iterations << " ns per GJK iteration climbing the vertex adjacency"
+            << std::endl;
+}
+
+GTEST_TEST(FCL_GEOMETRIC_SHAPES, convex_extreme_vertex)
+{
+//  test_convex_extreme_vertex<float>();
+  test_convex_extreme_vertex<double>();
+}
+
+/// @brief run GJK and EPA between s1 at the origin and s2 at each of the
+/// transforms, with EPA on the storage of workspace, or on storage of its own
+/// for each query if workspace is null, and return the time taken in
+/// micro-seconds
+template <typename S, typename Shape1, typename Shape2>
+double runEPAWorkspace(const Shape1& s1, const Shape2& s2,
+                       const Eigen::aligned_vector<Transform3<S>>& transforms,
+                       detail::EPAWorkspace<S>* workspace,
+                       std::vector<S>& depths,
+                       std::size_t& allocations)
+{
+  const detail::GJKSolver_indep<S>& solver = solver2<S>();
+  detail::MinkowskiDiff<S, Shape1, Shape2> shape;
+  shape.shapes[0] = &s1;
+  shape.shapes[1] = &s2;
+
+  depths.assign(transforms.size(), 0);
+  const std::size_t start_allocations = num_allocations;
+
+  test::Timer timer;
+  timer.start();
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+  {
+    shape.toshape1 = transforms[i].linear().transpose();
+    shape.toshape0 = transforms[i];
+
+    detail::GJK<S, Shape1, Shape2> gjk(solver.gjk_max_iterations, solver.gjk_tolerance);
+    if(gjk.evaluate(shape, Vector3<S>(-1, 0, 0)) != detail::GJK<S, Shape1, Shape2>::Inside)
+      continue;
+
+    detail::EPAWorkspace<S> query_workspace;
+    detail::EPA<S, Shape1, Shape2> epa(solver.epa_max_face_num, solver.epa_max_vertex_num, solver.epa_max_iterations, solver.epa_tolerance,
+                                       workspace ? *workspace : query_workspace);
+    epa.evaluate(gjk, Vector3<S>(-1, 0, 0));
+    depths[i] = epa.depth;
+  }
+  timer.stop();
+
+  allocations = num_allocations - start_allocations;
+  return timer.getElapsedTimeInMicroSec();
+}
+
+template <typename S>
+void test_epa_workspace()
+{
+  Cylinder<S> cylinder(2, 4);
+  Capsule<S> capsule(1, 3);
+
+  // near enough for most of the poses to penetrate
+  Eigen::aligned_vector<Transform3<S>> transforms;
+  test::generateRandomTransforms(extents<S>().data(), transforms, 1000);
+  for(auto& tf : transforms)
+    tf.translation() *= 0.2;
+
+  std::vector<S> query_depths;
+  std::vector<S> depths;
+  std::size_t query_allocations;
+  std::size_t allocations;
+  detail::EPAWorkspace<S> workspace;
+  const double query_time = runEPAWorkspace<S>(
+        cylinder, capsule, transforms, nullptr, query_depths, query_allocations);
+  const double time = runEPAWorkspace<S>(
+        cylinder, capsule, transforms, &workspace, depths, allocations);
+
+  // the workspace only allocates to grow once
+  EXPECT_EQ(allocations, 2u);
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+    EXPECT_EQ(query_depths[i], depths[i]);
+
+  std::cout << transforms.size() << " cylinder-capsule GJK and EPA queries: "
+            << query_allocations << " allocations in " << query_time << " us with storage for each query, "
+            << allocations << " allocations in " << time << " us with a workspace" << std::endl;
+
+  // the penetration queries of the solver allocate nothing once the storage
+  // of the thread, or the workspace it is given, has grown
+  std::vector<ContactPoint<S>> contacts;
+  contacts.reserve(1);
+  detail::GJKSolver_indep<S> solver;
+  for(int i = 0; i < 2; ++i)
+  {
+    std::size_t start_allocations = 0;
+    for(int pass = 0; pass < 2; ++pass)
+    {
+      start_allocations = num_allocations;
+      for(const auto& tf : transforms)
+      {
+        contacts.clear();
+        solver.shapeIntersect(cylinder, Transform3<S>::Identity(), capsule, tf, &contacts);
+      }
+    }
+    EXPECT_EQ(num_allocations - start_allocations, 0u);
+
+    solver.epa_workspace = &workspace;
+  }
+}
+
+GTEST_TEST(FCL_GEOMETRIC_SHAPES, epa_workspace)
+{
+//  test_epa_workspace<float>();
+  test_epa_workspace<double>();
+}
+
+/// @brief check the single precision solver, and collide() and distance() in
+/// single precision, against the double precision solver between s1 at the
+/// origin and s2 at each of the transforms, and print the time taken by the
+/// distance queries in both precisions
+template <template <typename> class Shape1, template <typename> class Shape2>
+void testGJKSinglePrecision(
+    const std::string& name,
+    const Shape1<float>& s1f, const Shape2<float>& s2f,
+    const Shape1<double>& s1d, const Shape2<double>& s2d,
+    const Eigen::aligned_vector<Transform3<double>>& transforms)
+{
+  const detail::GJKSolver_indep<float> solverf;
+  const detail::GJKSolver_indep<double> solverd;
+  CollisionRequest<float> request;
+  request.gjk_solver_type = GST_INDEP;
+  DistanceRequest<float> distance_request(false, 0, 0, GST_INDEP);
+
+  // rounding the transforms to float moves the shapes by about 1e-7, and GJK
+  // stops within its tolerance, so the precisions may disagree near contact
+  const double margin = 1e-3;
+
+  Eigen::aligned_vector<Transform3<float>> transformsf;
+  for(const auto& tf : transforms)
+    transformsf.push_back(tf.cast<float>());
+  std::vector<double> distancesd(transforms.size());
+  std::vector<float> distancesf(transforms.size());
+
+  test::Timer timerd;
+  timerd.start();
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+    solverd.shapeDistance(s1d, Transform3<double>::Identity(), s2d, transforms[i], &distancesd[i]);
+  timerd.stop();
+
+  test::Timer timerf;
+  timerf.start();
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+    solverf.shapeDistance(s1f, Transform3<float>::Identity(), s2f, transformsf[i], &distancesf[i]);
+  timerf.stop();
+
+  for(std::size_t i = 0; i < transforms.size(); ++i)
+  {
+    const bool separated = distancesd[i] >= 0;
+    if(separated && distancesd[i] < margin)
+      continue;
+
+    EXPECT_EQ(distancesf[i] >= 0, separated);
+    EXPECT_EQ(solverf.shapeIntersect(s1f, Transform3<float>::Identity(), s2f, transformsf[i], nullptr), !separated);
+
+    CollisionResult<float> result;
+    EXPECT_EQ(collide(&s1f, Transform3<float>::Identity(), &s2f, transformsf[i], request, result) > 0, !separated);
+
+    if(separated)
+    {
+      EXPECT_NEAR(distancesf[i], distancesd[i], margin);
+
+      DistanceResult<float> distance_result;
+      EXPECT_NEAR(distance(&s1f, Transform3<float>::Identity(), &s2f, transformsf[i], distance_request, distance_result), distancesd[i], margin);
+    }
+  }
+
+  std::cout << name << ": " << transforms.size() << " distance queries in "
+            << timerf.getElapsedTimeInMicroSec() << " us in single precision, "
+            << timerd.getElapsedTimeInMicroSec() << " us in double precision" << std::endl;
+}
+
+void test_gjk_single_precision()
+{
+  std::array<double, 6> extents{ {-3, -3, -3, 3, 3, 3} };
+  Eigen::aligned_vector<Transform3<double>> transforms;
+  test::generateRandomTransforms(extents.data(), transforms, 1000);
+
+  testGJKSinglePrecision("capsule-cylinder",
+                         Capsule<float>(1, 2), Cylinder<float>(1, 2),
+                         Capsule<double>(1, 2), Cylinder<double>(1, 2), transforms);
+  testGJKSinglePrecision("ellipsoid-cone",
+                         Ellipsoid<float>(1, 0.5, 2), Cone<float>(1, 2),
+                         Ellipsoid<double>(1, 0.5, 2), Cone<double>(1, 2), transforms);
+  testGJKSinglePrecision("ellipsoid-ellipsoid",
+                         Ellipsoid<float>(1, 0.5, 2), Ellipsoid<float>(1, 1, 0.3),
+                         Ellipsoid<double>(1, 0.5, 2), Ellipsoid<double>(1, 1, 0.3), transforms);
+  testGJKSinglePrecision("box-cylinder",
+                         Box<float>(1, 2, 1.5), Cylinder<float>(1, 2),
+                         Box<double>(1, 2, 1.5), Cylinder<double>(1, 2), transforms);
+}
+
+GTEST_TEST(FCL_GEOMETRIC_SHAPES, gjk_single_precision)
+{
+  test_gjk_single_precision();
+}
+
+/// @brief how each GJK query along a trajectory starts
+enum class GJKStart { Cold, CachedGuess, CachedSimplex };
+
+/// @brief run GJK between s1 at the origin and s2 at each pose of the
+/// trajectory, starting each query as given by start from the last, and
+/// return the time taken in micro-seconds
+template <typename S, typename Shape1, typename Shape2>
+double runGJKWarmStart(const Shape1& s1, const Shape2& s2,
+                       const Eigen::aligned_vector<Transform3<S>>& trajectory,
+                       GJKStart start,
+                       std::vector<S>& distances,
+                       std::size_t& num_iterations)
+{
+  detail::MinkowskiDiff<S, Shape1, Shape2> shape;
+  shape.shapes[0] = &s1;
+  shape.shapes[1] = &s2;
+
+  distances.resize(trajectory.size());
+  num_iterations = 0;
+  Vector3<S> guess(1, 0, 0);
+  GJKSimplexCache<S> cache;
+
+  test::Timer timer;
+  timer.start();
+  for(std::size_t i = 0; i < trajectory.size(); ++i)
+  {
+    shape.toshape1 = trajectory[i].linear().transpose();
+    shape.toshape0 = trajectory[i];
+
+    detail::GJK<S, Shape1, Shape2> gjk(solver2<S>().gjk_max_iterations, solver2<S>().gjk_tolerance);
+    const typename detail::GJK<S, Shape1, Shape2>::Status status
+        = gjk.evaluate(shape, -guess, start == GJKStart::CachedSimplex ? &cache : nullptr);
+    if(start == GJKStart::CachedGuess)
+      guess = gjk.getGuessFromSimplex();
+    if(start == GJKStart::CachedSimplex)
+      gjk.getSimplexCache(cache);
+
+    distances[i] = (status == detail::GJK<S, Shape1, Shape2>::Valid) ? gjk.distance : -1;
+    num_iterations += gjk.getNumIterations();
+  }
+  timer.stop();
+
+  return timer.getElapsedTimeInMicroSec();
+}
+
+/// @brief check that GJK queries between s1 and s2 along the trajectory agree
+/// whichever way they start, and print the iterations and time per query
+template <typename S, typename Shape1, typename Shape2>
+void testGJKWarmStart(const std::string& name, const Shape1& s1, const Shape2& s2,
+                      const Eigen::aligned_vector<Transform3<S>>& trajectory)
+{
+  const GJKStart starts[] = {GJKStart::Cold, GJKStart::CachedGuess, GJKStart::CachedSimplex};
+  const char* start_names[] = {"cold", "from the cached guess", "from the cached simplex"};
+  std::vector<S> distances[3];
+  std::size_t num_iterations[3];
+  double times[3];
+  for(int i = 0; i < 3; ++i)
+  {
+    // best of three, as the queries are short
+    times[i] = std::numeric_limits<double>::max();
+    for(int j = 0; j < 3; ++j)
+      times[i] = std::min(times[i], runGJKWarmStart<S>(s1, s2, trajectory, starts[i], distances[i], num_iterations[i]));
+  }
+
+  // the queries that start cold may stop a little early where the support
+  // vertices of a polytope tie
+  for(std::size_t i = 0; i < trajectory.size(); ++i)
+  {
+    EXPECT_EQ(distances[2][i] < 0, distances[0][i] < 0);
+    EXPECT_NEAR(distances[2][i], distances[0][i], 1e-3);
+  }
+
+  // between slowly moving shapes, the cached simplex is nearly the terminal one
+  EXPECT_LT(2 * num_iterations[2], num_iterations[0]);
+
+  std::cout << name << ": " << trajectory.size() << " GJK queries along a trajectory";
+  for(int i = 0; i < 3; ++i)
+    std::cout << (i ? ", " : " ") << static_cast<double>(num_iterations[i]) / trajectory.size() << " iterations in "
+              << times[i] / trajectory.size() << " us per query " << start_names[i];
+  std::cout << std::endl;
+}
+
+template <typename S>
+void test_gjk_simplex_cache()
+{
+  // s2 passes s1 in small steps, turning as it goes
+  const std::size_t n = 1000;
+  const Quaternion<S> q1(AngleAxis<S>(0.3, Vector3<S>(1, 2, 3).normalized()));
+  const Quaternion<S> q2(AngleAxis<S>(2.5, Vector3<S>(-2, 1, 1).normalized()));
+  Eigen::aligned_vector<Transform3<S>> trajectory(n);
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    const S t = static_cast<S>(i) / (n - 1);
+    trajectory[i].setIdentity();
+    trajectory[i].linear() = q1.slerp(t, q2).toRotationMatrix();
+    trajectory[i].translation() = Vector3<S>(-6 + 12 * t, 1 - 2 * t, 0.5 - t);
+  }
+
+  UVSphereConvexData<S> data(2, 40, 50);
+  Convex<S> convex(data.plane_normals.data(), data.plane_dis.data(), data.numPlanes(),
+                   data.points.data(), data.numPoints(), data.polygons.data());
+  testGJKWarmStart<S>("convex-box", convex, Box<S>(1, 2, 3), trajectory);
+  testGJKWarmStart<S>("cylinder-cone", Cylinder<S>(1, 3), Cone<S>(1, 2), trajectory);
+  testGJKWarmStart<S>("capsule-ellipsoid", Capsule<S>(1, 3), Ellipsoid<S>(1, 0.5, 2), trajectory);
+
+  // collide() returns the simplex to start the next query from, and agrees
+  // with the queries that start cold
+  Cylinder<S> s1(1, 3);
+  Cone<S> s2(1, 2);
+  CollisionRequest<S> request;
+  request.gjk_solver_type = GST_INDEP;
+  request.enable_cached_gjk_guess = true;
+  CollisionRequest<S> cold_request;
+  cold_request.gjk_solver_type = GST_INDEP;
+  for(const auto& tf : trajectory)
+  {
+    CollisionResult<S> result;
+    collide(&s1, Transform3<S>::Identity(), &s2, tf, request, result);
+    EXPECT_GT(result.cached_gjk_simplex.rank, 0u);
+    request.cached_gjk_guess = result.cached_gjk_guess;
+    request.cached_gjk_simplex = result.cached_gjk_simplex;
+
+    CollisionResult<S> cold_result;
+    collide(&s1, Transform3<S>::Identity(), &s2, tf, cold_request, cold_result);
+    EXPECT_EQ(result.isCollision(), cold_result.isCollision());
+  }
+
+  // Without enable_cached_gjk_guess a solver that is reused across pairs
+  // gives the same results as a fresh one
+  Capsule<S> s3(1, 3);
+  Ellipsoid<S> s4(1, 0.5, 2);
+  CollisionRequest<S> contact_request(1, true);
+  contact_request.gjk_solver_type = GST_INDEP;
+  detail::GJKSolver_indep<S> reused_solver;
+  for(const auto& tf : trajectory)
+  {
+    CollisionResult<S> other_result;
+    collide(&s1, Transform3<S>::Identity(), &s2, tf, &reused_solver, contact_request, other_result);
+
+    CollisionResult<S> result;
+    collide(&s3, Transform3<S>::Identity(), &s4, tf, &reused_solver, contact_request, result);
+
+    detail::GJKSolver_indep<S> fresh_solver;
+    CollisionResult<S> fresh_result;
+    collide(&s3, Transform3<S>::Identity(), &s4, tf, &fresh_solver, contact_request, fresh_result);
+
+    GTEST_ASSERT_EQ(result.numContacts(), fresh_result.numContacts());
+    if(result.isCollision())
+    {
+      EXPECT_EQ(result.getContact(0).penetration_depth, fresh_result.getContact(0).penetration_depth);
+      EXPECT_TRUE(result.getContact(0).normal == fresh_result.getContact(0).normal);
+    }
+  }
+}
+
+GTEST_TEST(FCL_GEOMETRIC_SHAPES, gjk_simplex_cache)
+{
+//  test_gjk_simplex_cache<float>();
+  test_gjk_simplex_cache<double>();
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
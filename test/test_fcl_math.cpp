@@ -36,7 +36,7 @@
 
 #include <gtest/gtest.h>
 
-#include "fcl/broadphase/detail/morton.h"
+#include "fcl/math/detail/morton.h"
 #include "fcl/config.h"
 
 using namespace fcl;
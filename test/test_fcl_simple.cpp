@@ -389,6 +389,40 @@ GTEST_TEST(FCL_SIMPLE, projection_test_tetrahedron)
   test_projection_test_tetrahedron<double>();
 }
 
+template <typename S>
+void test_projection_test_flat_tetrahedron()
+{
+  // the vertices are coplanar, and the origin projects onto the edge v1-v3 of
+  // their hull
+  Vector3<S> v1(1, -1, 1);
+  Vector3<S> v2(3, -1, 1);
+  Vector3<S> v3(2, 1, 1);
+  Vector3<S> v4(2, 0, 1);
+
+  auto res = detail::Project<S>::projectTetrahedraOrigin(v1, v2, v3, v4);
+  EXPECT_TRUE(res.encode == 5);
+  EXPECT_TRUE(approx(res.sqr_distance, (S)2.8));
+  EXPECT_TRUE(approx(res.parameterization[0], (S)0.8));
+  EXPECT_TRUE(approx(res.parameterization[1], (S)0));
+  EXPECT_TRUE(approx(res.parameterization[2], (S)0.2));
+  EXPECT_TRUE(approx(res.parameterization[3], (S)0));
+
+  // flat in single precision only: v4 is off the plane by less than the
+  // rounding error of the volume of the tetrahedron
+  v4 = Vector3<S>(2, 0, 1 + 1e-7);
+  res = detail::Project<S>::projectTetrahedraOrigin(v1, v2, v3, v4);
+  EXPECT_TRUE(res.encode == 5);
+  EXPECT_TRUE(approx(res.sqr_distance, (S)2.8));
+  EXPECT_TRUE(approx(res.parameterization[0], (S)0.8));
+  EXPECT_TRUE(approx(res.parameterization[2], (S)0.2));
+}
+
+GTEST_TEST(FCL_SIMPLE, projection_test_flat_tetrahedron)
+{
+  test_projection_test_flat_tetrahedron<float>();
+  test_projection_test_flat_tetrahedron<double>();
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {